@@ -0,0 +1,336 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include "benchclients.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QSocketNotifier>
+#include <QTimer>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusConnectionInterface>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusMetaType>
+#include <QtDBus/QDBusServiceWatcher>
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define WATCHER_SERVICE         "org.kde.StatusNotifierWatcher"
+#define TRAY_POLL_INTERVAL      100
+#define ICON_SIZE               24
+#define SNI_ICON_SIZE           32
+#define SYSTEM_TRAY_REQUEST_DOCK 0
+#define XEMBED_MAPPED           (1 << 0)
+#define APP_CLASSES             5
+
+namespace
+{
+    //固定的几种颜色轮流用，保证每帧的内容都变
+    const quint32 colors[] = { 0xffe53935, 0xff43a047, 0xff1e88e5, 0xfffdd835, 0xff8e24aa, 0xff00acc1 };
+    const int colorCount = sizeof(colors) / sizeof(colors[0]);
+}
+
+X11Clients::X11Clients(int windows, int churnInterval, int trayIcons, int trayFps, QObject *parent)
+    : QObject(parent),
+      mConn(nullptr),
+      mScreen(nullptr),
+      mScreenNumber(0),
+      mNotifier(nullptr),
+      mTrayTimer(new QTimer(this)),
+      mWindowCount(windows),
+      mOpened(0),
+      mIconCount(trayIcons),
+      mTrayFps(qMax(1, trayFps)),
+      mFrame(0)
+{
+    xcb_connection_t *conn = xcb_connect(nullptr, &mScreenNumber);
+    if (xcb_connection_has_error(conn))
+    {
+        xcb_disconnect(conn);
+        return;
+    }
+    mConn = conn;
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(xcb_get_setup(mConn));
+    for (int i = 0; i < mScreenNumber; ++i)
+        xcb_screen_next(&it);
+    mScreen = it.data;
+
+    //不处理事件，但要读走，否则缓冲区一直涨
+    mNotifier = new QSocketNotifier(xcb_get_file_descriptor(mConn), QSocketNotifier::Read, this);
+    connect(mNotifier, &QSocketNotifier::activated, this, &X11Clients::drainEvents);
+
+    for (int i = 0; i < mWindowCount; ++i)
+        openWindow();
+    xcb_flush(mConn);
+
+    if (churnInterval > 0 && mWindowCount > 0)
+    {
+        QTimer *churnTimer = new QTimer(this);
+        connect(churnTimer, &QTimer::timeout, this, &X11Clients::churn);
+        churnTimer->start(churnInterval);
+    }
+
+    if (mIconCount > 0)
+    {
+        connect(mTrayTimer, &QTimer::timeout, this, &X11Clients::findTray);
+        mTrayTimer->start(TRAY_POLL_INTERVAL);
+    }
+}
+
+X11Clients::~X11Clients()
+{
+    if (mConn)
+        xcb_disconnect(mConn);
+}
+
+xcb_atom_t X11Clients::atom(const char *name)
+{
+    xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(mConn, xcb_intern_atom(mConn, 0, strlen(name), name), nullptr);
+    const xcb_atom_t result = reply ? reply->atom : xcb_atom_t(XCB_ATOM_NONE);
+    free(reply);
+    return result;
+}
+
+void X11Clients::openWindow()
+{
+    const int serial = ++mOpened;
+    const xcb_window_t window = xcb_generate_id(mConn);
+    const uint32_t values[] = { colors[serial % colorCount] };
+    xcb_create_window(mConn, XCB_COPY_FROM_PARENT, window, mScreen->root,
+                      (serial * 37) % 600, (serial * 23) % 400, 320, 240, 0,
+                      XCB_WINDOW_CLASS_INPUT_OUTPUT, mScreen->root_visual, XCB_CW_BACK_PIXEL, values);
+
+    //同一个 WM_CLASS 的窗口在任务栏里会合成一组，几个类轮流用
+    const QByteArray title = QString("bench window %1").arg(serial).toUtf8();
+    const QByteArray app = QString("bench-app-%1").arg(serial % APP_CLASSES).toLatin1();
+    const QByteArray wmClass = app + '\0' + app + '\0';
+    const uint32_t pid = getpid();
+    xcb_change_property(mConn, XCB_PROP_MODE_REPLACE, window, XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8,
+                        title.size(), title.constData());
+    xcb_change_property(mConn, XCB_PROP_MODE_REPLACE, window, atom("_NET_WM_NAME"), atom("UTF8_STRING"), 8,
+                        title.size(), title.constData());
+    xcb_change_property(mConn, XCB_PROP_MODE_REPLACE, window, XCB_ATOM_WM_CLASS, XCB_ATOM_STRING, 8,
+                        wmClass.size(), wmClass.constData());
+    xcb_change_property(mConn, XCB_PROP_MODE_REPLACE, window, atom("_NET_WM_PID"), XCB_ATOM_CARDINAL, 32,
+                        1, &pid);
+    xcb_map_window(mConn, window);
+    mWindows.enqueue(window);
+}
+
+void X11Clients::churn()
+{
+    if (!mWindows.isEmpty())
+        xcb_destroy_window(mConn, mWindows.dequeue());
+    openWindow();
+    xcb_flush(mConn);
+}
+
+void X11Clients::findTray()
+{
+    const QByteArray selection = QString("_NET_SYSTEM_TRAY_S%1").arg(mScreenNumber).toLatin1();
+    xcb_get_selection_owner_reply_t *reply = xcb_get_selection_owner_reply(
+                mConn, xcb_get_selection_owner(mConn, atom(selection.constData())), nullptr);
+    const xcb_window_t owner = reply ? reply->owner : xcb_window_t(XCB_WINDOW_NONE);
+    free(reply);
+    if (owner == XCB_WINDOW_NONE)
+        return;
+
+    mTrayTimer->stop();
+    disconnect(mTrayTimer, nullptr, this, nullptr);
+    dockIcons(owner);
+    connect(mTrayTimer, &QTimer::timeout, this, &X11Clients::animateTray);
+    mTrayTimer->start(1000 / mTrayFps);
+}
+
+void X11Clients::dockIcons(xcb_window_t tray)
+{
+    const xcb_atom_t opcode = atom("_NET_SYSTEM_TRAY_OPCODE");
+    const xcb_atom_t xembedInfo = atom("_XEMBED_INFO");
+    const uint32_t info[2] = { 0, XEMBED_MAPPED };
+
+    for (int i = 0; i < mIconCount; ++i)
+    {
+        const xcb_window_t icon = xcb_generate_id(mConn);
+        const uint32_t values[] = { colors[i % colorCount] };
+        xcb_create_window(mConn, XCB_COPY_FROM_PARENT, icon, mScreen->root, 0, 0, ICON_SIZE, ICON_SIZE, 0,
+                          XCB_WINDOW_CLASS_INPUT_OUTPUT, mScreen->root_visual, XCB_CW_BACK_PIXEL, values);
+        xcb_change_property(mConn, XCB_PROP_MODE_REPLACE, icon, xembedInfo, xembedInfo, 32, 2, info);
+
+        xcb_client_message_event_t event;
+        memset(&event, 0, sizeof(event));
+        event.response_type = XCB_CLIENT_MESSAGE;
+        event.format = 32;
+        event.window = tray;
+        event.type = opcode;
+        event.data.data32[0] = XCB_CURRENT_TIME;
+        event.data.data32[1] = SYSTEM_TRAY_REQUEST_DOCK;
+        event.data.data32[2] = icon;
+        xcb_send_event(mConn, 0, tray, XCB_EVENT_MASK_NO_EVENT, reinterpret_cast<const char *>(&event));
+        mIcons << icon;
+    }
+    xcb_flush(mConn);
+}
+
+void X11Clients::animateTray()
+{
+    ++mFrame;
+    for (int i = 0; i < mIcons.size(); ++i)
+    {
+        const uint32_t values[] = { colors[(mFrame + i) % colorCount] };
+        xcb_change_window_attributes(mConn, mIcons.at(i), XCB_CW_BACK_PIXEL, values);
+        xcb_clear_area(mConn, 1, mIcons.at(i), 0, 0, 0, 0);
+    }
+    xcb_flush(mConn);
+}
+
+void X11Clients::drainEvents()
+{
+    while (xcb_generic_event_t *event = xcb_poll_for_event(mConn))
+        free(event);
+}
+
+SniItem::SniItem(int index, QObject *parent)
+    : QObject(parent),
+      mIndex(index),
+      mFrame(index)
+{
+}
+
+void SniItem::animate()
+{
+    ++mFrame;
+    Q_EMIT NewIcon();
+}
+
+IconPixmapList SniItem::iconPixmap() const
+{
+    //ARGB32，网络字节序
+    const quint32 color = colors[mFrame % colorCount];
+    IconPixmap pixmap;
+    pixmap.width = SNI_ICON_SIZE;
+    pixmap.height = SNI_ICON_SIZE;
+    pixmap.bytes.resize(SNI_ICON_SIZE * SNI_ICON_SIZE * 4);
+    char *data = pixmap.bytes.data();
+    for (int i = 0; i < SNI_ICON_SIZE * SNI_ICON_SIZE; ++i)
+    {
+        data[i * 4] = char(color >> 24);
+        data[i * 4 + 1] = char(color >> 16);
+        data[i * 4 + 2] = char(color >> 8);
+        data[i * 4 + 3] = char(color);
+    }
+    return IconPixmapList() << pixmap;
+}
+
+ToolTip SniItem::toolTip() const
+{
+    ToolTip tip;
+    tip.title = id();
+    return tip;
+}
+
+SniClients::SniClients(int items, int fps, QObject *parent)
+    : QObject(parent),
+      mTimer(new QTimer(this)),
+      mRegistered(false)
+{
+    qRegisterMetaType<IconPixmap>("IconPixmap");
+    qDBusRegisterMetaType<IconPixmap>();
+    qRegisterMetaType<IconPixmapList>("IconPixmapList");
+    qDBusRegisterMetaType<IconPixmapList>();
+    qRegisterMetaType<ToolTip>("ToolTip");
+    qDBusRegisterMetaType<ToolTip>();
+
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    for (int i = 0; i < items; ++i)
+    {
+        SniItem *item = new SniItem(i, this);
+        bus.registerObject(item->path(), item, QDBusConnection::ExportAllProperties
+                           | QDBusConnection::ExportAllSignals | QDBusConnection::ExportAllSlots);
+        mItems << item;
+    }
+
+    connect(mTimer, &QTimer::timeout, this, &SniClients::animate);
+    mTimer->setInterval(1000 / qMax(1, fps));
+
+    QDBusServiceWatcher *watcher = new QDBusServiceWatcher(WATCHER_SERVICE, bus,
+                                                           QDBusServiceWatcher::WatchForRegistration, this);
+    connect(watcher, &QDBusServiceWatcher::serviceRegistered, this, &SniClients::registerItems);
+    if (bus.interface()->isServiceRegistered(WATCHER_SERVICE))
+        registerItems();
+}
+
+void SniClients::registerItems()
+{
+    if (mRegistered || mItems.isEmpty())
+        return;
+    mRegistered = true;
+
+    //路径形式的参数：服务名取调用者自己的连接名
+    for (SniItem *item : qAsConst(mItems))
+    {
+        QDBusMessage msg = QDBusMessage::createMethodCall(WATCHER_SERVICE, "/StatusNotifierWatcher",
+                                                          WATCHER_SERVICE, "RegisterStatusNotifierItem");
+        msg << item->path();
+        QDBusConnection::sessionBus().call(msg, QDBus::NoBlock);
+    }
+    mTimer->start();
+}
+
+void SniClients::animate()
+{
+    for (SniItem *item : qAsConst(mItems))
+        item->animate();
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    app.setApplicationName("ukui-panel-bench-clients");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Synthetic X11, XEmbed and StatusNotifierItem clients for the panel benchmark");
+    parser.addHelpOption();
+    QCommandLineOption windowsOption("windows", "Number of open windows.", "N", "20");
+    QCommandLineOption churnOption("churn-ms", "Replace the oldest window every MS milliseconds, 0 keeps them.", "MS", "500");
+    QCommandLineOption trayOption("tray-icons", "Number of XEmbed tray icons.", "M", "5");
+    QCommandLineOption trayFpsOption("tray-fps", "Tray icon repaints per second.", "FPS", "10");
+    QCommandLineOption sniOption("sni-items", "Number of StatusNotifierItems.", "K", "5");
+    QCommandLineOption sniFpsOption("sni-fps", "StatusNotifierItem icon changes per second.", "FPS", "2");
+    parser.addOption(windowsOption);
+    parser.addOption(churnOption);
+    parser.addOption(trayOption);
+    parser.addOption(trayFpsOption);
+    parser.addOption(sniOption);
+    parser.addOption(sniFpsOption);
+    parser.process(app);
+
+    X11Clients x11(parser.value(windowsOption).toInt(), parser.value(churnOption).toInt(),
+                   parser.value(trayOption).toInt(), parser.value(trayFpsOption).toInt());
+    if (!x11.isValid())
+    {
+        qCritical() << "cannot open the display";
+        return 1;
+    }
+    SniClients sni(parser.value(sniOption).toInt(), parser.value(sniFpsOption).toInt());
+
+    return app.exec();
+}
@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#ifndef BENCHCLIENTS_H
+#define BENCHCLIENTS_H
+
+#include <QObject>
+#include <QList>
+#include <QQueue>
+#include <QString>
+#include <QtDBus/QDBusObjectPath>
+#include <xcb/xcb.h>
+
+#include "../plugin-statusnotifier/dbustypes.h"
+
+class QSocketNotifier;
+class QTimer;
+
+/*
+ * 基准测试的 X11 客户端：N 个普通窗口按固定间隔轮换（关掉最旧的、再开一个），
+ * M 个 XEmbed 托盘图标按固定帧率换颜色重绘。
+ */
+class X11Clients : public QObject
+{
+    Q_OBJECT
+public:
+    X11Clients(int windows, int churnInterval, int trayIcons, int trayFps, QObject *parent = nullptr);
+    ~X11Clients();
+
+    bool isValid() const { return mConn != nullptr; }
+
+private Q_SLOTS:
+    void churn();
+    void findTray();
+    void animateTray();
+    void drainEvents();
+
+private:
+    xcb_atom_t atom(const char *name);
+    void openWindow();
+    void dockIcons(xcb_window_t tray);
+
+    xcb_connection_t *mConn;
+    xcb_screen_t *mScreen;
+    int mScreenNumber;
+    QSocketNotifier *mNotifier;
+    QTimer *mTrayTimer;
+
+    QQueue<xcb_window_t> mWindows;
+    int mWindowCount;
+    int mOpened;
+
+    QList<xcb_window_t> mIcons;
+    int mIconCount;
+    int mTrayFps;
+    int mFrame;
+};
+
+/*
+ * 一个最简单的 StatusNotifierItem，图标是纯色方块，按固定帧率换颜色并发出 NewIcon，
+ * 让面板走完整的 属性获取 → 解码 → 重绘 流程。
+ */
+class SniItem : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.StatusNotifierItem")
+    Q_PROPERTY(QString AttentionIconName READ emptyString)
+    Q_PROPERTY(IconPixmapList AttentionIconPixmap READ emptyPixmaps)
+    Q_PROPERTY(QString AttentionMovieName READ emptyString)
+    Q_PROPERTY(QString Category READ category)
+    Q_PROPERTY(QString IconName READ emptyString)
+    Q_PROPERTY(IconPixmapList IconPixmap READ iconPixmap)
+    Q_PROPERTY(QString IconThemePath READ emptyString)
+    Q_PROPERTY(QString Id READ id)
+    Q_PROPERTY(bool ItemIsMenu READ itemIsMenu)
+    Q_PROPERTY(QDBusObjectPath Menu READ menu)
+    Q_PROPERTY(QString OverlayIconName READ emptyString)
+    Q_PROPERTY(IconPixmapList OverlayIconPixmap READ emptyPixmaps)
+    Q_PROPERTY(QString Status READ status)
+    Q_PROPERTY(QString Title READ id)
+    Q_PROPERTY(ToolTip ToolTip READ toolTip)
+    Q_PROPERTY(int WindowId READ windowId)
+
+public:
+    explicit SniItem(int index, QObject *parent = nullptr);
+
+    QString path() const { return QString("/StatusNotifierItem/%1").arg(mIndex); }
+    void animate();
+
+    QString emptyString() const { return QString(); }
+    IconPixmapList emptyPixmaps() const { return IconPixmapList(); }
+    QString category() const { return QStringLiteral("ApplicationStatus"); }
+    QString id() const { return QString("bench-sni-%1").arg(mIndex); }
+    IconPixmapList iconPixmap() const;
+    bool itemIsMenu() const { return false; }
+    QDBusObjectPath menu() const { return QDBusObjectPath("/NO_DBUSMENU"); }
+    QString status() const { return QStringLiteral("Active"); }
+    ToolTip toolTip() const;
+    int windowId() const { return 0; }
+
+public Q_SLOTS:
+    void Activate(int x, int y) { Q_UNUSED(x) Q_UNUSED(y) }
+    void SecondaryActivate(int x, int y) { Q_UNUSED(x) Q_UNUSED(y) }
+    void ContextMenu(int x, int y) { Q_UNUSED(x) Q_UNUSED(y) }
+    void Scroll(int delta, const QString &orientation) { Q_UNUSED(delta) Q_UNUSED(orientation) }
+
+Q_SIGNALS:
+    void NewAttentionIcon();
+    void NewIcon();
+    void NewOverlayIcon();
+    void NewStatus(const QString &status);
+    void NewTitle();
+    void NewToolTip();
+
+private:
+    int mIndex;
+    int mFrame;
+};
+
+//等到面板的 StatusNotifierWatcher 出现后注册所有条目，然后按帧率动画
+class SniClients : public QObject
+{
+    Q_OBJECT
+public:
+    SniClients(int items, int fps, QObject *parent = nullptr);
+
+private Q_SLOTS:
+    void registerItems();
+    void animate();
+
+private:
+    QList<SniItem *> mItems;
+    QTimer *mTimer;
+    bool mRegistered;
+};
+
+#endif // BENCHCLIENTS_H
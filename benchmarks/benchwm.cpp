@@ -0,0 +1,255 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+/*
+ * 基准测试用的最小 EWMH 窗口管理器。
+ * 只做面板依赖的那部分：转发映射和配置请求，维护 _NET_CLIENT_LIST、
+ * _NET_ACTIVE_WINDOW 和单个桌面的属性，让 KWindowSystem 把它当成正常的窗口管理器。
+ */
+
+#include <xcb/xcb.h>
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+    enum Atom
+    {
+        NetSupported,
+        NetSupportingWmCheck,
+        NetWmName,
+        Utf8String,
+        NetClientList,
+        NetClientListStacking,
+        NetActiveWindow,
+        NetNumberOfDesktops,
+        NetCurrentDesktop,
+        NetDesktopGeometry,
+        NetWorkarea,
+        NetWmDesktop,
+        NetCloseWindow,
+        AtomCount
+    };
+
+    const char *const atomNames[AtomCount] = {
+        "_NET_SUPPORTED",
+        "_NET_SUPPORTING_WM_CHECK",
+        "_NET_WM_NAME",
+        "UTF8_STRING",
+        "_NET_CLIENT_LIST",
+        "_NET_CLIENT_LIST_STACKING",
+        "_NET_ACTIVE_WINDOW",
+        "_NET_NUMBER_OF_DESKTOPS",
+        "_NET_CURRENT_DESKTOP",
+        "_NET_DESKTOP_GEOMETRY",
+        "_NET_WORKAREA",
+        "_NET_WM_DESKTOP",
+        "_NET_CLOSE_WINDOW"
+    };
+
+    xcb_connection_t *conn;
+    xcb_window_t root;
+    xcb_atom_t atoms[AtomCount];
+    std::vector<xcb_window_t> clients;      // 映射顺序即叠放顺序
+
+    void internAtoms()
+    {
+        xcb_intern_atom_cookie_t cookies[AtomCount];
+        for (int i = 0; i < AtomCount; ++i)
+            cookies[i] = xcb_intern_atom(conn, 0, strlen(atomNames[i]), atomNames[i]);
+        for (int i = 0; i < AtomCount; ++i)
+        {
+            xcb_intern_atom_reply_t *reply = xcb_intern_atom_reply(conn, cookies[i], nullptr);
+            atoms[i] = reply ? reply->atom : xcb_atom_t(XCB_ATOM_NONE);
+            free(reply);
+        }
+    }
+
+    void setCardinals(xcb_window_t window, Atom property, const uint32_t *values, uint32_t count)
+    {
+        xcb_change_property(conn, XCB_PROP_MODE_REPLACE, window, atoms[property], XCB_ATOM_CARDINAL, 32, count, values);
+    }
+
+    void setWindows(xcb_window_t window, Atom property, const xcb_window_t *values, uint32_t count)
+    {
+        xcb_change_property(conn, XCB_PROP_MODE_REPLACE, window, atoms[property], XCB_ATOM_WINDOW, 32, count, values);
+    }
+
+    void updateClientList()
+    {
+        setWindows(root, NetClientList, clients.data(), clients.size());
+        setWindows(root, NetClientListStacking, clients.data(), clients.size());
+    }
+
+    void setActive(xcb_window_t window)
+    {
+        setWindows(root, NetActiveWindow, &window, 1);
+        if (window == XCB_WINDOW_NONE)
+            return;
+        const uint32_t above = XCB_STACK_MODE_ABOVE;
+        xcb_configure_window(conn, window, XCB_CONFIG_WINDOW_STACK_MODE, &above);
+        xcb_set_input_focus(conn, XCB_INPUT_FOCUS_POINTER_ROOT, window, XCB_CURRENT_TIME);
+    }
+
+    void removeClient(xcb_window_t window)
+    {
+        auto it = std::find(clients.begin(), clients.end(), window);
+        if (it == clients.end())
+            return;
+        clients.erase(it);
+        updateClientList();
+        setActive(clients.empty() ? xcb_window_t(XCB_WINDOW_NONE) : clients.back());
+    }
+
+    void announce(xcb_screen_t *screen)
+    {
+        // _NET_SUPPORTING_WM_CHECK 要指向一个自己也带着同一属性的子窗口
+        const xcb_window_t check = xcb_generate_id(conn);
+        xcb_create_window(conn, XCB_COPY_FROM_PARENT, check, root, -1, -1, 1, 1, 0,
+                          XCB_WINDOW_CLASS_INPUT_ONLY, XCB_COPY_FROM_PARENT, 0, nullptr);
+        setWindows(root, NetSupportingWmCheck, &check, 1);
+        setWindows(check, NetSupportingWmCheck, &check, 1);
+        const char name[] = "ukui-panel-bench-wm";
+        xcb_change_property(conn, XCB_PROP_MODE_REPLACE, check, atoms[NetWmName], atoms[Utf8String], 8,
+                            strlen(name), name);
+
+        xcb_change_property(conn, XCB_PROP_MODE_REPLACE, root, atoms[NetSupported], XCB_ATOM_ATOM, 32,
+                            AtomCount, atoms);
+
+        const uint32_t one = 1, zero = 0;
+        const uint32_t geometry[2] = { screen->width_in_pixels, screen->height_in_pixels };
+        const uint32_t workarea[4] = { 0, 0, screen->width_in_pixels, screen->height_in_pixels };
+        setCardinals(root, NetNumberOfDesktops, &one, 1);
+        setCardinals(root, NetCurrentDesktop, &zero, 1);
+        setCardinals(root, NetDesktopGeometry, geometry, 2);
+        setCardinals(root, NetWorkarea, workarea, 4);
+        updateClientList();
+        setActive(XCB_WINDOW_NONE);
+    }
+
+    void configureRequest(const xcb_configure_request_event_t *event)
+    {
+        // 原样照办，值的顺序与掩码位的顺序一致
+        uint32_t values[7];
+        int n = 0;
+        if (event->value_mask & XCB_CONFIG_WINDOW_X)
+            values[n++] = event->x;
+        if (event->value_mask & XCB_CONFIG_WINDOW_Y)
+            values[n++] = event->y;
+        if (event->value_mask & XCB_CONFIG_WINDOW_WIDTH)
+            values[n++] = event->width;
+        if (event->value_mask & XCB_CONFIG_WINDOW_HEIGHT)
+            values[n++] = event->height;
+        if (event->value_mask & XCB_CONFIG_WINDOW_BORDER_WIDTH)
+            values[n++] = event->border_width;
+        if (event->value_mask & XCB_CONFIG_WINDOW_SIBLING)
+            values[n++] = event->sibling;
+        if (event->value_mask & XCB_CONFIG_WINDOW_STACK_MODE)
+            values[n++] = event->stack_mode;
+        xcb_configure_window(conn, event->window, event->value_mask, values);
+    }
+
+    void mapRequest(const xcb_map_request_event_t *event)
+    {
+        xcb_map_window(conn, event->window);
+        const uint32_t desktop = 0;
+        setCardinals(event->window, NetWmDesktop, &desktop, 1);
+        if (std::find(clients.begin(), clients.end(), event->window) == clients.end())
+        {
+            clients.push_back(event->window);
+            updateClientList();
+        }
+        setActive(event->window);
+    }
+
+    void clientMessage(const xcb_client_message_event_t *event)
+    {
+        if (event->type == atoms[NetActiveWindow])
+        {
+            if (std::find(clients.begin(), clients.end(), event->window) != clients.end())
+                setActive(event->window);
+        }
+        else if (event->type == atoms[NetCloseWindow])
+        {
+            xcb_kill_client(conn, event->window);
+        }
+    }
+}
+
+int main()
+{
+    int screenNumber = 0;
+    conn = xcb_connect(nullptr, &screenNumber);
+    if (xcb_connection_has_error(conn))
+    {
+        fprintf(stderr, "ukui-panel-bench-wm: cannot open the display\n");
+        return 1;
+    }
+
+    xcb_screen_iterator_t it = xcb_setup_roots_iterator(xcb_get_setup(conn));
+    for (int i = 0; i < screenNumber; ++i)
+        xcb_screen_next(&it);
+    xcb_screen_t *screen = it.data;
+    root = screen->root;
+
+    const uint32_t mask = XCB_EVENT_MASK_SUBSTRUCTURE_REDIRECT | XCB_EVENT_MASK_SUBSTRUCTURE_NOTIFY;
+    xcb_generic_error_t *error = xcb_request_check(conn,
+            xcb_change_window_attributes_checked(conn, root, XCB_CW_EVENT_MASK, &mask));
+    if (error)
+    {
+        fprintf(stderr, "ukui-panel-bench-wm: another window manager is running\n");
+        free(error);
+        return 1;
+    }
+
+    internAtoms();
+    announce(screen);
+    xcb_flush(conn);
+
+    while (xcb_generic_event_t *event = xcb_wait_for_event(conn))
+    {
+        switch (event->response_type & ~0x80)
+        {
+        case XCB_MAP_REQUEST:
+            mapRequest(reinterpret_cast<xcb_map_request_event_t *>(event));
+            break;
+        case XCB_CONFIGURE_REQUEST:
+            configureRequest(reinterpret_cast<xcb_configure_request_event_t *>(event));
+            break;
+        case XCB_UNMAP_NOTIFY:
+            removeClient(reinterpret_cast<xcb_unmap_notify_event_t *>(event)->window);
+            break;
+        case XCB_DESTROY_NOTIFY:
+            removeClient(reinterpret_cast<xcb_destroy_notify_event_t *>(event)->window);
+            break;
+        case XCB_CLIENT_MESSAGE:
+            clientMessage(reinterpret_cast<xcb_client_message_event_t *>(event));
+            break;
+        default:
+            break;
+        }
+        free(event);
+        xcb_flush(conn);
+    }
+    return 0;
+}
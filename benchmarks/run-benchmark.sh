@@ -0,0 +1,165 @@
+#!/bin/sh
+#
+# Runs ukui-panel headless against Xvfb with synthetic clients and writes the
+# panel's --stats snapshots as one JSON document.
+#
+#   run-benchmark.sh --panel PATH --wm PATH --clients PATH --source DIR --output FILE
+#                    [--windows N] [--churn-ms MS] [--tray-icons M] [--tray-fps FPS]
+#                    [--sni-items K] [--sni-fps FPS] [--warmup S] [--duration S]
+#
+# The panel gets a private session bus, an in-memory GSettings backend, the
+# schemas from the source tree and an isolated -c config, so the result does
+# not depend on the desktop it is run from.
+
+set -e
+
+windows=20
+churn=500
+tray=5
+trayfps=10
+sni=5
+snifps=2
+warmup=5
+duration=30
+geometry=1920x1080
+
+while [ $# -gt 0 ]; do
+    case "$1" in
+        --panel) panel="$2" ;;
+        --wm) wm="$2" ;;
+        --clients) clients="$2" ;;
+        --source) source="$2" ;;
+        --output) output="$2" ;;
+        --windows) windows="$2" ;;
+        --churn-ms) churn="$2" ;;
+        --tray-icons) tray="$2" ;;
+        --tray-fps) trayfps="$2" ;;
+        --sni-items) sni="$2" ;;
+        --sni-fps) snifps="$2" ;;
+        --warmup) warmup="$2" ;;
+        --duration) duration="$2" ;;
+        *) echo "unknown option $1" >&2; exit 2 ;;
+    esac
+    shift 2
+done
+
+if [ -z "$panel" ] || [ -z "$wm" ] || [ -z "$clients" ] || [ -z "$source" ] || [ -z "$output" ]; then
+    echo "usage: $0 --panel PATH --wm PATH --clients PATH --source DIR --output FILE [options]" >&2
+    exit 2
+fi
+
+# everything below runs on its own session bus
+if [ -z "$UKUI_PANEL_BENCH_BUS" ]; then
+    UKUI_PANEL_BENCH_BUS=1 exec dbus-run-session -- "$0" --panel "$panel" --wm "$wm" --clients "$clients" \
+        --source "$source" --output "$output" --windows "$windows" --churn-ms "$churn" --tray-icons "$tray" \
+        --tray-fps "$trayfps" --sni-items "$sni" --sni-fps "$snifps" --warmup "$warmup" --duration "$duration"
+fi
+
+work=$(mktemp -d)
+pids=
+cleanup() {
+    for pid in $pids; do
+        kill "$pid" 2>/dev/null || true
+    done
+    wait 2>/dev/null || true
+    rm -rf "$work"
+}
+trap cleanup EXIT INT TERM
+
+wait_for_file() {
+    n=0
+    while [ ! -s "$1" ]; do
+        n=$((n + 1))
+        if [ $n -gt $(($2 * 10)) ]; then
+            echo "timed out waiting for $1" >&2
+            exit 1
+        fi
+        sleep 0.1
+    done
+}
+
+# Xvfb picks a free display and reports it on fd 3 once it accepts clients
+Xvfb -displayfd 3 -screen 0 ${geometry}x24 -nolisten tcp 3>"$work/display" 2>"$work/xvfb.log" &
+pids="$pids $!"
+wait_for_file "$work/display" 10
+DISPLAY=":$(cat "$work/display")"
+export DISPLAY
+
+mkdir "$work/schemas" "$work/config" "$work/cache"
+find "$source" -name '*.gschema.xml' -exec cp {} "$work/schemas" \;
+glib-compile-schemas "$work/schemas"
+GSETTINGS_SCHEMA_DIR="$work/schemas"
+GSETTINGS_BACKEND=memory
+XDG_CONFIG_HOME="$work/config"
+XDG_CACHE_HOME="$work/cache"
+QT_QPA_PLATFORM=xcb
+# the wakeup, paint, hang, x11 and plugins sections stay empty unless these are on
+UKUI_PANEL_AUDIT_WAKEUPS=1
+UKUI_PANEL_TRACE_PAINT=1
+UKUI_PANEL_WATCHDOG=1
+UKUI_PANEL_METER_X11=1
+UKUI_PANEL_PROFILE_PLUGINS=1
+export GSETTINGS_SCHEMA_DIR GSETTINGS_BACKEND XDG_CONFIG_HOME XDG_CACHE_HOME QT_QPA_PLATFORM
+export UKUI_PANEL_AUDIT_WAKEUPS UKUI_PANEL_TRACE_PAINT UKUI_PANEL_WATCHDOG UKUI_PANEL_METER_X11 \
+    UKUI_PANEL_PROFILE_PLUGINS
+
+"$wm" 2>"$work/wm.log" &
+pids="$pids $!"
+
+cat >"$work/panel.conf" <<CONF
+panels=panel1
+
+[panel1]
+alignment=-1
+animation-duration=0
+desktop=0
+hidable=false
+lineCount=1
+lockPanel=false
+plugins=taskbar,spacer,tray,statusnotifier
+position=Bottom
+reserve-space=true
+show-delay=0
+width=100
+width-percent=true
+
+[taskbar]
+type=taskbar
+
+[spacer]
+type=spacer
+
+[tray]
+type=tray
+
+[statusnotifier]
+type=statusnotifier
+CONF
+
+"$panel" -c "$work/panel.conf" --stats "$work/stats.json" >"$work/panel.log" 2>&1 &
+pids="$pids $!"
+# the first snapshot is written once the panels are up
+wait_for_file "$work/stats.json" 30
+
+"$clients" --windows "$windows" --churn-ms "$churn" --tray-icons "$tray" --tray-fps "$trayfps" \
+    --sni-items "$sni" --sni-fps "$snifps" 2>"$work/clients.log" &
+pids="$pids $!"
+
+sleep "$warmup"
+cp "$work/stats.json" "$work/warmup.json"
+sleep "$duration"
+cp "$work/stats.json" "$work/final.json"
+
+# CPU and counters are cumulative, so steady state is final minus warmup
+{
+    printf '{\n"parameters": {"windows": %d, "churnMs": %d, "trayIcons": %d, "trayFps": %d, ' \
+        "$windows" "$churn" "$tray" "$trayfps"
+    printf '"sniItems": %d, "sniFps": %d, "warmupSeconds": %d, "durationSeconds": %d},\n' \
+        "$sni" "$snifps" "$warmup" "$duration"
+    printf '"afterWarmup": '
+    cat "$work/warmup.json"
+    printf ',\n"final": '
+    cat "$work/final.json"
+    printf '}\n'
+} >"$output"
+echo "benchmark results written to $output"
@@ -72,7 +72,11 @@ static FILE* open_driver_file(const char *file, const char *driver, const char *
 static int read_backlight(const char *driver);
 static int read_max_backlight(const char *driver);
 static int read_bl_power(const char *driver);
-static const char *sysfs_backlight_dir = "/sys/class/backlight";
+/* Only the unit tests define this, to point the library at a fake sysfs tree. */
+#ifndef UKUI_BACKLIGHT_SYSFS_DIR
+#define UKUI_BACKLIGHT_SYSFS_DIR "/sys/class/backlight"
+#endif
+static const char *sysfs_backlight_dir = UKUI_BACKLIGHT_SYSFS_DIR;
 
 int ukui_backlight_backend_get()
 {
@@ -27,23 +27,51 @@ extern "C" {
 #endif
 
 #include "linuxbackend.h"
-#include <QTimer>
+#include <QFile>
 #include <QDebug>
 
+// one write per frame while a slider is dragged
+#define FLUSH_INTERVAL  16
+// the helper exits once nothing has been written for a minute
+#ifndef HELPER_IDLE
+#define HELPER_IDLE     60000
+#endif
+// the tests run a fake helper instead of pkexec
+#ifndef UKUI_BACKLIGHT_HELPER
+#define UKUI_BACKLIGHT_HELPER "pkexec"
+#endif
+
 namespace UKUi {
 
 LinuxBackend::LinuxBackend(QObject *parent):VirtualBackEnd(parent)
 {
     maxBacklight = ukui_backlight_backend_get_max();
-    backlightStream = NULL;
+    actualBacklight = -1;
+    blPower = 0;
+    fileSystemWatcher = NULL;
+    pendingBacklight = -1;
+    helperProcess = NULL;
+
+    flushTimer = new QTimer(this);
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(FLUSH_INTERVAL);
+    connect(flushTimer, &QTimer::timeout, this, &LinuxBackend::flushBacklight);
+
+    idleTimer = new QTimer(this);
+    idleTimer->setSingleShot(true);
+    idleTimer->setInterval(HELPER_IDLE);
+    connect(idleTimer, &QTimer::timeout, this, &LinuxBackend::closeBacklightStream);
+
     if( isBacklightAvailable() ) {
         char *driver = ukui_backlight_backend_get_driver();
-        fileSystemWatcher = new QFileSystemWatcher(this);
-        fileSystemWatcher->addPath(QString::fromLatin1("/sys/class/backlight/%1/actual_brightness").arg(QL1S(driver)));
-        fileSystemWatcher->addPath(QString::fromLatin1("/sys/class/backlight/%1/brightness").arg(QL1S(driver)));
-        fileSystemWatcher->addPath(QString::fromLatin1("/sys/class/backlight/%1/bl_power").arg(QL1S(driver)));
+        driverPath = QString::fromLatin1("%1/%2").arg(QL1S(sysfs_backlight_dir), QL1S(driver));
         free(driver);
-        actualBacklight = ukui_backlight_backend_get();
+        fileSystemWatcher = new QFileSystemWatcher(this);
+        fileSystemWatcher->addPath(driverPath + QL1S("/actual_brightness"));
+        fileSystemWatcher->addPath(driverPath + QL1S("/brightness"));
+        fileSystemWatcher->addPath(driverPath + QL1S("/bl_power"));
+        actualBacklight = readDriverFile("actual_brightness");
+        blPower = readDriverFile("bl_power");
         connect(fileSystemWatcher, &QFileSystemWatcher::fileChanged,
             this, &LinuxBackend::fileSystemChanged);
     }
@@ -51,12 +79,19 @@ LinuxBackend::LinuxBackend(QObject *parent):VirtualBackEnd(parent)
 
 LinuxBackend::~LinuxBackend()
 {
-    delete backlightStream;
+    if( pendingBacklight >= 0 )
+        flushBacklight();
+    if( helperProcess != NULL ) {
+        // the helper runs as root and cannot be killed, let it see EOF instead
+        helperProcess->disconnect(this);
+        helperProcess->closeWriteChannel();
+        helperProcess->waitForFinished(1000);
+    }
 }
 
 int LinuxBackend::getBacklight()
 {
-    actualBacklight = ukui_backlight_backend_get();
+    // kept up to date by fileSystemChanged()
     return actualBacklight;
 }
 
@@ -72,36 +107,89 @@ bool LinuxBackend::isBacklightAvailable()
 
 bool LinuxBackend::isBacklightOff()
 {
-    return ukui_backlight_is_backlight_off() > 0;
+    return blPower > 0;
 }
 
 void LinuxBackend::setBacklight(int value)
 {
     if( ! isBacklightAvailable() )
         return;
-    if( backlightStream == NULL ) {
-        FILE *stream = ukui_backlight_backend_get_write_stream();
-        backlightStream = new QTextStream(stream);
-        // Close stream after 60 seconds
-        QTimer::singleShot(60000, this, SLOT(closeBacklightStream()));
-    }
     // normalize the value (to work around an issue in QSlider)
-    value = qBound(0, value, maxBacklight);
-    *backlightStream << value << endl;
+    pendingBacklight = qBound(0, value, maxBacklight);
+    if( ! flushTimer->isActive() )
+        flushTimer->start();
+}
+
+void LinuxBackend::flushBacklight()
+{
+    if( pendingBacklight < 0 )
+        return;
+
+    if( helperProcess == NULL ) {
+        helperProcess = new QProcess(this);
+        connect(helperProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+            this, &LinuxBackend::helperFinished);
+        connect(helperProcess, &QProcess::errorOccurred, this, [this] (QProcess::ProcessError error) {
+            if( error == QProcess::FailedToStart )
+                helperFinished();
+        });
+        // written values are buffered until pkexec is up
+        helperProcess->start(QL1S(UKUI_BACKLIGHT_HELPER), QStringList() << QL1S("ukui-backlight_backend") << QL1S("--stdin"));
+    }
+
+    helperProcess->write(QByteArray::number(pendingBacklight) + '\n');
+    pendingBacklight = -1;
+    idleTimer->start();
 }
 
 void LinuxBackend::closeBacklightStream()
 {
-    if( backlightStream != NULL ) {
-        delete backlightStream;
-        backlightStream = NULL;
+    if( helperProcess == NULL )
+        return;
+    // detach the closing helper, the next write starts a new one instead of
+    // writing into a closed channel while this one is still exiting
+    QProcess *closing = helperProcess;
+    helperProcess = NULL;
+    closing->disconnect(this);
+    connect(closing, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),
+        closing, &QObject::deleteLater);
+    closing->closeWriteChannel();
+}
+
+void LinuxBackend::helperFinished()
+{
+    // pkexec was refused or the helper exited, start a new one on the next write
+    if( helperProcess != NULL ) {
+        helperProcess->deleteLater();
+        helperProcess = NULL;
     }
+    idleTimer->stop();
 }
 
-void LinuxBackend::fileSystemChanged(const QString & /*path*/)
+int LinuxBackend::readDriverFile(const char *file) const
 {
-    int value = actualBacklight;
-    if( value != getBacklight() ) {
+    QFile in(driverPath + QL1C('/') + QL1S(file));
+    if( ! in.open(QIODevice::ReadOnly) )
+        return -1;
+    bool ok = false;
+    int value = in.readAll().trimmed().toInt(&ok);
+    return ok ? value : 0;
+}
+
+void LinuxBackend::fileSystemChanged(const QString & path)
+{
+    // the watcher forgets files that went away, add them back once they are there again
+    if( ! fileSystemWatcher->files().contains(path) && QFile::exists(path) )
+        fileSystemWatcher->addPath(path);
+
+    if( path.endsWith(QL1S("/bl_power")) ) {
+        blPower = readDriverFile("bl_power");
+        return;
+    }
+
+    int value = readDriverFile("actual_brightness");
+    if( value != actualBacklight ) {
+        actualBacklight = value;
         emit backlightChanged(actualBacklight);
     }
 }
@@ -20,7 +20,8 @@
 
 #include "../virtual_backend.h"
 #include <QFileSystemWatcher>
-#include <QTextStream>
+#include <QProcess>
+#include <QTimer>
 
 namespace UKUi
 {
@@ -38,19 +39,29 @@ public:
     void setBacklight(int value);
     int getBacklight();
     int getMaxBacklight();
-    
-signals:
-    void backlightChanged(int value);
 
 private slots:
     void closeBacklightStream();
     void fileSystemChanged(const QString & path);
+    void flushBacklight();
+    void helperFinished();
 
 private:
-    QTextStream *backlightStream;
+    int readDriverFile(const char *file) const;
+
+    // /sys/class/backlight/<driver>, resolved once
+    QString driverPath;
     int maxBacklight;
     int actualBacklight;
+    int blPower;
     QFileSystemWatcher *fileSystemWatcher;
+
+    // values written while dragging a slider are merged, at most one per frame
+    // goes to the long-lived "ukui-backlight_backend --stdin" helper
+    int pendingBacklight;
+    QTimer *flushTimer;
+    QTimer *idleTimer;
+    QProcess *helperProcess;
 };
 
 } // namespace UKUi
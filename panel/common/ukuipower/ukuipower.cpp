@@ -44,6 +44,9 @@ Power::Power(bool useUkuiSessionProvider, QObject * parent /*= nullptr*/) :
     mProviders.append(new UPowerProvider(this));
     mProviders.append(new ConsoleKitProvider(this));
     mProviders.append(new LxSessionProvider(this));
+
+    for (PowerProvider* provider : qAsConst(mProviders))
+        connect(provider, &PowerProvider::capabilitiesChanged, this, &Power::capabilitiesChanged);
 }
 
 Power::Power(QObject * parent /*= nullptr*/)
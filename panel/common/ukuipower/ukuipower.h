@@ -72,7 +72,12 @@ public:
     /// Destroys the object.
     virtual ~Power();
 
-    /// Returns true if the Power can perform action.
+    /*!
+     * Returns true if the Power can perform action.
+     * The answers of the DBus services are probed asynchronously and cached,
+     * so this never blocks. Right after construction an action may be reported
+     * as unavailable until its probe is answered, see capabilitiesChanged().
+     */
     bool canAction(Action action) const;
 
     //! This function is provided for convenience. It's equivalent to calling canAction(PowerLogout).
@@ -115,6 +120,10 @@ public slots:
     //! This function is provided for convenience. It's equivalent to calling doAction(PowerMonitorOff).
     bool monitorOff();
 
+signals:
+    /// Emitted when the result of canAction() may have changed.
+    void capabilitiesChanged();
+
 private:
     QList<PowerProvider*> mProviders;
 };
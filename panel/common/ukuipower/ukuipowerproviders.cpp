@@ -30,6 +30,9 @@
 
 #include "ukuipowerproviders.h"
 #include <QDBusInterface>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusServiceWatcher>
 #include <QProcess>
 #include <QDebug>
 #include "ukuinotification.h"
@@ -167,56 +170,128 @@ static bool dbusCallSystemd(const QString &service,
 
 
 /************************************************
- Helper func
+ PowerProvider
  ************************************************/
-bool dbusGetProperty(const QString &service,
-                     const QString &path,
-                     const QString &interface,
-                     const QDBusConnection &connection,
-                     const QString & property
-                    )
+PowerProvider::PowerProvider(QObject *parent):
+    QObject(parent)
 {
-    QDBusInterface dbus(service, path, interface, connection);
-    if (!dbus.isValid())
-    {
-        qWarning() << "dbusGetProperty: QDBusInterface is invalid" << service << path << interface << property;
-//        Notification::notify(QObject::tr("UKUi Power Manager"),
-//                                  "ukui-logo.png",
-//                                  QObject::tr("Power Manager Error"),
-//                                  QObject::tr("QDBusInterface is invalid")+ "\n\n" + service +" " + path +" " + interface +" " + property);
+}
 
-        return false;
-    }
 
-    QDBusMessage msg = dbus.call(QL1S("Get"), dbus.interface(), property);
+PowerProvider::~PowerProvider()
+{
+}
+
 
-    if (!msg.errorName().isEmpty())
-    {
-        printDBusMsg(msg);
-//        Notification::notify(QObject::tr("UKUi Power Manager"),
-//                                  "ukui-logo.png",
-//                                  QObject::tr("Power Manager Error (Get Property)"),
-//                                  msg.errorName() + "\n\n" + msg.errorMessage());
-    }
 
-    return !msg.arguments().isEmpty() &&
-            msg.arguments().constFirst().value<QDBusVariant>().variant().toBool();
+/************************************************
+ DBusPowerProvider
+ ************************************************/
+DBusPowerProvider::DBusPowerProvider(const QString &service, const QDBusConnection &connection, QObject *parent):
+    PowerProvider(parent),
+    mConnection(connection),
+    mGeneration(0)
+{
+    // NameOwnerChanged: the service was started, restarted or went away
+    QDBusServiceWatcher *watcher = new QDBusServiceWatcher(service, mConnection,
+                                                           QDBusServiceWatcher::WatchForOwnerChange, this);
+    connect(watcher, &QDBusServiceWatcher::serviceOwnerChanged, this, &DBusPowerProvider::refresh);
+
+    // e.g. swap space for hibernation may have changed while sleeping
+    QDBusConnection::systemBus().connect(QL1S(SYSTEMD_SERVICE),
+                                         QL1S(SYSTEMD_PATH),
+                                         QL1S(SYSTEMD_INTERFACE),
+                                         QL1S("PrepareForSleep"),
+                                         this, SLOT(prepareForSleep(bool)));
 }
 
 
+DBusPowerProvider::~DBusPowerProvider()
+{
+}
 
 
-/************************************************
- PowerProvider
- ************************************************/
-PowerProvider::PowerProvider(QObject *parent):
-    QObject(parent)
+bool DBusPowerProvider::canAction(Power::Action action) const
 {
+    return mCapabilities.value(action, false);
 }
 
 
-PowerProvider::~PowerProvider()
+void DBusPowerProvider::refresh()
 {
+    // answers of the previous round are ignored when they come in
+    ++mGeneration;
+    mPending.clear();
+    probeAll();
+}
+
+
+void DBusPowerProvider::prepareForSleep(bool active)
+{
+    if (!active)
+        refresh();
+}
+
+
+void DBusPowerProvider::probe(Power::Action action, const QDBusMessage &message, ReplyType type)
+{
+    ++mPending[action].outstanding;
+
+    const quint64 generation = mGeneration;
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(mConnection.asyncCall(message), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this,
+            [this, action, type, generation] (QDBusPendingCallWatcher *call) {
+                call->deleteLater();
+                probeFinished(action, type, generation, call->reply());
+            });
+}
+
+
+void DBusPowerProvider::probeFinished(Power::Action action, ReplyType type, quint64 generation, const QDBusMessage &reply)
+{
+    if (generation != mGeneration)
+        return;
+
+    auto it = mPending.find(action);
+    if (it == mPending.end())
+        return;
+
+    bool result = false;
+    if (reply.type() == QDBusMessage::ReplyMessage)
+    {
+        const QList<QVariant> args = reply.arguments();
+        switch (type)
+        {
+        case ReplyBool:
+            // If the method no returns value, we believe that it was successful.
+            result = args.isEmpty() || args.constFirst().isNull() || args.constFirst().toBool();
+            break;
+
+        case ReplyYesNo:
+            result = !args.isEmpty() &&
+                     (args.constFirst().toString() == QL1S("yes") ||
+                      args.constFirst().toString() == QL1S("challenge"));
+            break;
+
+        case ReplyProperty:
+            result = !args.isEmpty() && args.constFirst().value<QDBusVariant>().variant().toBool();
+            break;
+        }
+    }
+
+    it->result = it->result && result;
+    if (--it->outstanding > 0)
+        return;
+
+    result = it->result;
+    mPending.erase(it);
+
+    auto cached = mCapabilities.constFind(action);
+    if (cached != mCapabilities.constEnd() && cached.value() == result)
+        return;
+
+    mCapabilities.insert(action, result);
+    emit capabilitiesChanged();
 }
 
 
@@ -225,8 +300,9 @@ PowerProvider::~PowerProvider()
  UPowerProvider
  ************************************************/
 UPowerProvider::UPowerProvider(QObject *parent):
-    PowerProvider(parent)
+    DBusPowerProvider(QL1S(UPOWER_SERVICE), QDBusConnection::systemBus(), parent)
 {
+    refresh();
 }
 
 
@@ -235,48 +311,41 @@ UPowerProvider::~UPowerProvider()
 }
 
 
-bool UPowerProvider::canAction(Power::Action action) const
+void UPowerProvider::probeAll()
 {
-    QString command;
-    QString property;
-    switch (action)
+    const Power::Action actions[] = { Power::PowerHibernate, Power::PowerSuspend };
+    for (Power::Action action : actions)
     {
-    case Power::PowerHibernate:
-        property = QL1S("CanHibernate");
-        command  = QL1S("HibernateAllowed");
-        break;
-
-    case Power::PowerSuspend:
-        property = QL1S("CanSuspend");
-        command  = QL1S("SuspendAllowed");
-        break;
+        QString command;
+        QString property;
+        if (action == Power::PowerHibernate)
+        {
+            property = QL1S("CanHibernate");
+            command  = QL1S("HibernateAllowed");
+        }
+        else
+        {
+            property = QL1S("CanSuspend");
+            command  = QL1S("SuspendAllowed");
+        }
 
-    default:
-        return false;
+        // Whether the system is able to hibernate.
+        QDBusMessage get = QDBusMessage::createMethodCall(QL1S(UPOWER_SERVICE),
+                                                          QL1S(UPOWER_PATH),
+                                                          QL1S(PROPERTIES_INTERFACE),
+                                                          QL1S("Get"));
+        get << QL1S(UPOWER_INTERFACE) << property;
+        probe(action, get, ReplyProperty);
+
+        // Check if the caller has (or can get) the PolicyKit privilege to call command.
+        probe(action, QDBusMessage::createMethodCall(QL1S(UPOWER_SERVICE),
+                                                     QL1S(UPOWER_PATH),
+                                                     QL1S(UPOWER_INTERFACE),
+                                                     command),
+              ReplyBool);
     }
-
-    return  dbusGetProperty(  // Whether the system is able to hibernate.
-                QL1S(UPOWER_SERVICE),
-                QL1S(UPOWER_PATH),
-                QL1S(PROPERTIES_INTERFACE),
-                QDBusConnection::systemBus(),
-                property
-            )
-            &&
-            dbusCall( // Check if the caller has (or can get) the PolicyKit privilege to call command.
-                QL1S(UPOWER_SERVICE),
-                QL1S(UPOWER_PATH),
-                QL1S(UPOWER_INTERFACE),
-                QDBusConnection::systemBus(),
-                command,
-                // canAction should be always silent because it can freeze
-                // g_main_context_iteration Qt event loop in QMessageBox
-                // on panel startup if there is no DBUS running.
-                PowerProvider::DontCheckDBUS
-            );
 }
 
-
 bool UPowerProvider::doAction(Power::Action action)
 {
     QString command;
@@ -309,8 +378,9 @@ bool UPowerProvider::doAction(Power::Action action)
  ConsoleKitProvider
  ************************************************/
 ConsoleKitProvider::ConsoleKitProvider(QObject *parent):
-    PowerProvider(parent)
+    DBusPowerProvider(QL1S(CONSOLEKIT_SERVICE), QDBusConnection::systemBus(), parent)
 {
+    refresh();
 }
 
 
@@ -319,45 +389,22 @@ ConsoleKitProvider::~ConsoleKitProvider()
 }
 
 
-bool ConsoleKitProvider::canAction(Power::Action action) const
+void ConsoleKitProvider::probeAll()
 {
-    QString command;
-    switch (action)
-    {
-    case Power::PowerReboot:
-        command = QL1S("CanReboot");
-        break;
-
-    case Power::PowerShutdown:
-        command = QL1S("CanPowerOff");
-        break;
-
-    case Power::PowerHibernate:
-        command  = QL1S("CanHibernate");
-        break;
-
-    case Power::PowerSuspend:
-        command  = QL1S("CanSuspend");
-        break;
-
-    default:
-        return false;
-    }
-
-    return dbusCallSystemd(QL1S(CONSOLEKIT_SERVICE),
-                    QL1S(CONSOLEKIT_PATH),
-                    QL1S(CONSOLEKIT_INTERFACE),
-                    QDBusConnection::systemBus(),
-                    command,
-                    false,
-                    // canAction should be always silent because it can freeze
-                    // g_main_context_iteration Qt event loop in QMessageBox
-                    // on panel startup if there is no DBUS running.
-                    PowerProvider::DontCheckDBUS
-                   );
+    probe(Power::PowerReboot,
+          QDBusMessage::createMethodCall(QL1S(CONSOLEKIT_SERVICE), QL1S(CONSOLEKIT_PATH), QL1S(CONSOLEKIT_INTERFACE), QL1S("CanReboot")),
+          ReplyYesNo);
+    probe(Power::PowerShutdown,
+          QDBusMessage::createMethodCall(QL1S(CONSOLEKIT_SERVICE), QL1S(CONSOLEKIT_PATH), QL1S(CONSOLEKIT_INTERFACE), QL1S("CanPowerOff")),
+          ReplyYesNo);
+    probe(Power::PowerHibernate,
+          QDBusMessage::createMethodCall(QL1S(CONSOLEKIT_SERVICE), QL1S(CONSOLEKIT_PATH), QL1S(CONSOLEKIT_INTERFACE), QL1S("CanHibernate")),
+          ReplyYesNo);
+    probe(Power::PowerSuspend,
+          QDBusMessage::createMethodCall(QL1S(CONSOLEKIT_SERVICE), QL1S(CONSOLEKIT_PATH), QL1S(CONSOLEKIT_INTERFACE), QL1S("CanSuspend")),
+          ReplyYesNo);
 }
 
-
 bool ConsoleKitProvider::doAction(Power::Action action)
 {
     QString command;
@@ -399,8 +446,9 @@ bool ConsoleKitProvider::doAction(Power::Action action)
  ************************************************/
 
 SystemdProvider::SystemdProvider(QObject *parent):
-    PowerProvider(parent)
+    DBusPowerProvider(QL1S(SYSTEMD_SERVICE), QDBusConnection::systemBus(), parent)
 {
+    refresh();
 }
 
 
@@ -409,46 +457,22 @@ SystemdProvider::~SystemdProvider()
 }
 
 
-bool SystemdProvider::canAction(Power::Action action) const
+void SystemdProvider::probeAll()
 {
-    QString command;
-
-    switch (action)
-    {
-    case Power::PowerReboot:
-        command = QL1S("CanReboot");
-        break;
-
-    case Power::PowerShutdown:
-        command = QL1S("CanPowerOff");
-        break;
-
-    case Power::PowerSuspend:
-        command = QL1S("CanSuspend");
-        break;
-
-    case Power::PowerHibernate:
-        command = QL1S("CanHibernate");
-        break;
-
-    default:
-        return false;
-    }
-
-    return dbusCallSystemd(QL1S(SYSTEMD_SERVICE),
-                    QL1S(SYSTEMD_PATH),
-                    QL1S(SYSTEMD_INTERFACE),
-                    QDBusConnection::systemBus(),
-                    command,
-                    false,
-                    // canAction should be always silent because it can freeze
-                    // g_main_context_iteration Qt event loop in QMessageBox
-                    // on panel startup if there is no DBUS running.
-                    PowerProvider::DontCheckDBUS
-                   );
+    probe(Power::PowerReboot,
+          QDBusMessage::createMethodCall(QL1S(SYSTEMD_SERVICE), QL1S(SYSTEMD_PATH), QL1S(SYSTEMD_INTERFACE), QL1S("CanReboot")),
+          ReplyYesNo);
+    probe(Power::PowerShutdown,
+          QDBusMessage::createMethodCall(QL1S(SYSTEMD_SERVICE), QL1S(SYSTEMD_PATH), QL1S(SYSTEMD_INTERFACE), QL1S("CanPowerOff")),
+          ReplyYesNo);
+    probe(Power::PowerSuspend,
+          QDBusMessage::createMethodCall(QL1S(SYSTEMD_SERVICE), QL1S(SYSTEMD_PATH), QL1S(SYSTEMD_INTERFACE), QL1S("CanSuspend")),
+          ReplyYesNo);
+    probe(Power::PowerHibernate,
+          QDBusMessage::createMethodCall(QL1S(SYSTEMD_SERVICE), QL1S(SYSTEMD_PATH), QL1S(SYSTEMD_INTERFACE), QL1S("CanHibernate")),
+          ReplyYesNo);
 }
 
-
 bool SystemdProvider::doAction(Power::Action action)
 {
     QString command;
@@ -489,8 +513,9 @@ bool SystemdProvider::doAction(Power::Action action)
   UKUiProvider
  ************************************************/
 UKUiProvider::UKUiProvider(QObject *parent):
-    PowerProvider(parent)
+    DBusPowerProvider(QL1S(UKUI_SERVICE), QDBusConnection::sessionBus(), parent)
 {
+    refresh();
 }
 
 
@@ -499,31 +524,20 @@ UKUiProvider::~UKUiProvider()
 }
 
 
-bool UKUiProvider::canAction(Power::Action action) const
+void UKUiProvider::probeAll()
 {
-    QString command;
-    switch (action)
-    {
-        case Power::PowerLogout:
-            command = QL1S("canLogout");
-            break;
-        case Power::PowerReboot:
-            command = QL1S("canReboot");
-            break;
-        case Power::PowerShutdown:
-            command = QL1S("canPowerOff");
-            break;
-        default:
-            return false;
-    }
-
     // there can be case when ukuisession-session does not run
-    return dbusCall(QL1S(UKUI_SERVICE), QL1S(UKUI_PATH), QL1S(UKUI_SERVICE),
-            QDBusConnection::sessionBus(), command,
-            PowerProvider::DontCheckDBUS);
+    probe(Power::PowerLogout,
+          QDBusMessage::createMethodCall(QL1S(UKUI_SERVICE), QL1S(UKUI_PATH), QL1S(UKUI_INTERFACE), QL1S("canLogout")),
+          ReplyBool);
+    probe(Power::PowerReboot,
+          QDBusMessage::createMethodCall(QL1S(UKUI_SERVICE), QL1S(UKUI_PATH), QL1S(UKUI_INTERFACE), QL1S("canReboot")),
+          ReplyBool);
+    probe(Power::PowerShutdown,
+          QDBusMessage::createMethodCall(QL1S(UKUI_SERVICE), QL1S(UKUI_PATH), QL1S(UKUI_INTERFACE), QL1S("canPowerOff")),
+          ReplyBool);
 }
 
-
 bool UKUiProvider::doAction(Power::Action action)
 {
     QString command;
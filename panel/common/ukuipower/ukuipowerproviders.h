@@ -31,6 +31,9 @@
 #define UKUIPOWER_PROVIDERS_H
 
 #include <QObject>
+#include <QHash>
+#include <QDBusConnection>
+#include <QDBusMessage>
 #include <../../ukuisettings.h>
 #include "ukuipower.h"
 #include <QProcess> // for PID_T
@@ -60,58 +63,121 @@ public slots:
     /*! Performs the requested action.
         This is a pure virtual function, and must be reimplemented in subclasses. */
     virtual bool doAction(Power::Action action) = 0;
+
+signals:
+    /*! Emitted when the result of canAction() changed for some action. */
+    void capabilitiesChanged();
+};
+
+
+/*! Base class of the providers that ask a DBus service for their capabilities.
+    The answers are probed asynchronously and cached, so canAction() never
+    blocks. Until the first answer arrives an action is reported as unavailable.
+    The cache is probed again when the service owner changes and after resume. */
+class DBusPowerProvider: public PowerProvider
+{
+    Q_OBJECT
+public:
+    DBusPowerProvider(const QString &service, const QDBusConnection &connection, QObject *parent = 0);
+    ~DBusPowerProvider();
+    bool canAction(Power::Action action) const;
+
+public slots:
+    /*! Drops the pending probes and asks the service again. */
+    void refresh();
+
+protected:
+    enum ReplyType {
+        ReplyBool,      /// the method returns a bool
+        ReplyYesNo,     /// the method returns "yes", "no", "challenge" or "na"
+        ReplyProperty   /// the reply of Properties.Get holding a bool
+    };
+
+    /*! Sends one probe for action. The action is available when all of its
+        probes of the same refresh() answer positively. */
+    void probe(Power::Action action, const QDBusMessage &message, ReplyType type);
+
+    /*! Sends the probes of all the supported actions, called from refresh().
+        This is a pure virtual function, and must be reimplemented in subclasses. */
+    virtual void probeAll() = 0;
+
+private slots:
+    void prepareForSleep(bool active);
+
+private:
+    struct Pending
+    {
+        Pending() : outstanding(0), result(true) {}
+        int outstanding;
+        bool result;
+    };
+
+    void probeFinished(Power::Action action, ReplyType type, quint64 generation, const QDBusMessage &reply);
+
+    QDBusConnection mConnection;
+    QHash<int, bool> mCapabilities;
+    QHash<int, Pending> mPending;
+    quint64 mGeneration;
 };
 
 
-class UPowerProvider: public PowerProvider
+class UPowerProvider: public DBusPowerProvider
 {
     Q_OBJECT
 public:
     UPowerProvider(QObject *parent = 0);
     ~UPowerProvider();
-    bool canAction(Power::Action action) const;
 
 public slots:
     bool doAction(Power::Action action);
+
+protected:
+    void probeAll();
 };
 
 
-class ConsoleKitProvider: public PowerProvider
+class ConsoleKitProvider: public DBusPowerProvider
 {
     Q_OBJECT
 public:
     ConsoleKitProvider(QObject *parent = 0);
     ~ConsoleKitProvider();
-    bool canAction(Power::Action action) const;
 
 public slots:
     bool doAction(Power::Action action);
+
+protected:
+    void probeAll();
 };
 
 
-class SystemdProvider: public PowerProvider
+class SystemdProvider: public DBusPowerProvider
 {
     Q_OBJECT
 public:
     SystemdProvider(QObject *parent = 0);
     ~SystemdProvider();
-    bool canAction(Power::Action action) const;
 
 public slots:
     bool doAction(Power::Action action);
+
+protected:
+    void probeAll();
 };
 
 
-class UKUiProvider: public PowerProvider
+class UKUiProvider: public DBusPowerProvider
 {
     Q_OBJECT
 public:
     UKUiProvider(QObject *parent = 0);
     ~UKUiProvider();
-    bool canAction(Power::Action action) const;
 
 public slots:
     bool doAction(Power::Action action);
+
+protected:
+    void probeAll();
 };
 
 class LxSessionProvider: public PowerProvider
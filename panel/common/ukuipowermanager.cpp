@@ -92,6 +92,7 @@ PowerManager::PowerManager(QObject * parent, bool skipWarning)
         m_skipWarning(skipWarning)
 {
     m_power = new Power(this);
+    connect(m_power, &Power::capabilitiesChanged, this, &PowerManager::availableActionsChanged);
 //    connect(m_power, SIGNAL(suspendFail()), this, SLOT(suspendFailed()));
 //    connect(m_power, SIGNAL(hibernateFail()), this, SLOT(hibernateFailed()));
 //    connect(m_power, SIGNAL(monitoring(const QString &)),
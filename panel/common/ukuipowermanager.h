@@ -57,6 +57,10 @@ public slots:
     // ukui session
     void logout();
 
+signals:
+    //! the DBus services answered, availableActions() may return other actions now
+    void availableActionsChanged();
+
 public:
     bool skipWarning() const { return m_skipWarning; }
 
@@ -21,21 +21,178 @@
  * END_COMMON_COPYRIGHT_HEADER */
 
 #include "ukuiprogramfinder.h"
+#include <errno.h>
 #include <wordexp.h>
+#include <unistd.h>
+#include <sys/inotify.h>
 #include <QDir>
 #include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QSet>
 
 using namespace UKUi;
 
+namespace
+{
+/*
+ * Names of all executables found in the directories of $PATH.
+ *
+ * The index is built once per PATH value. Every PATH directory is watched
+ * with inotify, and any pending event drops the index, so an existence
+ * check costs one hash lookup plus a non-blocking read() on the inotify fd.
+ * A PATH directory that doesn't exist yet (e.g. ~/.local/bin) is covered by
+ * watching its nearest existing parent; there only the creation of the next
+ * path component drops the index. Relative PATH entries depend on the
+ * working directory and are still checked on every call.
+ */
+class ExecutableIndex
+{
+public:
+    ExecutableIndex() : mNotify(-1), mValid(false) {}
+    ~ExecutableIndex() { closeNotify(); }
+
+    bool contains(const QString& program)
+    {
+        QMutexLocker locker(&mMutex);
+        const QByteArray path = qgetenv("PATH");
+        if (!mValid || path != mPath || changed())
+            rebuild(path);
+
+        if (mPrograms.contains(program))
+            return true;
+        for (const QString& dirName : qAsConst(mRelativeDirs))
+        {
+            const QFileInfo fi(QDir(dirName), program);
+            if (fi.isExecutable() && fi.isFile())
+                return true;
+        }
+        return false;
+    }
+
+private:
+    bool changed()
+    {
+        if (mNotify < 0)
+            return false;
+
+        alignas(struct inotify_event) char buf[4096];
+        bool any = false;
+        ssize_t len;
+        while ((len = read(mNotify, buf, sizeof(buf))) > 0)
+        {
+            for (char *p = buf; p < buf + len; )
+            {
+                const struct inotify_event *event = reinterpret_cast<const struct inotify_event *>(p);
+                p += sizeof(struct inotify_event) + event->len;
+                // parents of missing dirs only matter when the missing component appears
+                auto parent = mParentWatches.constFind(event->wd);
+                if (parent == mParentWatches.constEnd() || mDirWatches.contains(event->wd)
+                        || (event->len > 0 && parent.value().contains(QFile::decodeName(event->name)))
+                        || (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF)))
+                    any = true;
+            }
+        }
+        return any;
+    }
+
+    void watchMissing(const QString& dirName)
+    {
+        // walk up to the nearest existing ancestor and watch it for the next component
+        QString child = QDir::cleanPath(dirName);
+        QString parent = QFileInfo(child).path();
+        while (!QFileInfo(parent).isDir() && parent != child)
+        {
+            child = parent;
+            parent = QFileInfo(child).path();
+        }
+        // IN_MASK_ADD: the parent may be a PATH dir with a wider mask of its own
+        const int wd = inotify_add_watch(mNotify, QFile::encodeName(parent).constData(),
+                                         IN_CREATE | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR | IN_MASK_ADD);
+        if (wd >= 0)
+            mParentWatches[wd] << QFileInfo(child).fileName();
+    }
+
+    void rebuild(const QByteArray& path)
+    {
+        closeNotify();
+        mPrograms.clear();
+        mRelativeDirs.clear();
+        mParentWatches.clear();
+        mDirWatches.clear();
+        mPath = path;
+        mValid = true;
+        mNotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+        const QStringList dirs = QFile::decodeName(path).split(QL1C(':'), QString::SkipEmptyParts);
+        for (const QString& dirName : dirs)
+        {
+            if (QDir::isRelativePath(dirName))
+            {
+                mRelativeDirs << dirName;
+                continue;
+            }
+            // watch before listing so nothing added in between is missed
+            if (mNotify >= 0)
+            {
+                const int wd = inotify_add_watch(mNotify, QFile::encodeName(dirName).constData(),
+                                                 IN_CREATE | IN_DELETE | IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO
+                                                 | IN_DELETE_SELF | IN_MOVE_SELF | IN_MASK_ADD);
+                if (wd >= 0)
+                    mDirWatches.insert(wd);
+                else if (errno == ENOENT)
+                    watchMissing(dirName);
+            }
+            // a shell finds dot-files in PATH too
+            const QStringList entries = QDir(dirName).entryList(QDir::Files | QDir::Executable | QDir::Hidden);
+            for (const QString& entry : entries)
+                mPrograms.insert(entry);
+        }
+    }
+
+    void closeNotify()
+    {
+        if (mNotify >= 0)
+            close(mNotify);
+        mNotify = -1;
+    }
+
+    QMutex mMutex;
+    QByteArray mPath;
+    QSet<QString> mPrograms;
+    QStringList mRelativeDirs;
+    QSet<int> mDirWatches;
+    QHash<int, QSet<QString> > mParentWatches;     // watch of an existing parent -> missing child names
+    int mNotify;
+    bool mValid;
+};
+
+Q_GLOBAL_STATIC(ExecutableIndex, executableIndex)
+
+// argv[0] of the commands seen so far; commands whose expansion depends on
+// the environment ($VAR, ~) or on the file system (glob patterns) are not memoized
+const int ProgramNameCacheSize = 1024;
+QMutex programNameMutex;
+QHash<QString, QString> programNameCache;
+}
+
 UKUI_API bool ProgramFinder::programExists(const QString& command)
 {
     const QString program = programName(command);
+    if (program.isEmpty())
+        return false;
+
     if (program[0] == QL1C('/'))
     {
         QFileInfo fi(program);
         return fi.isExecutable() && fi.isFile();
     }
 
+    if (!program.contains(QL1C('/')))
+        return executableIndex()->contains(program);
+
     const QString path = QFile::decodeName(qgetenv("PATH"));
     const QStringList dirs = path.split(QL1C(':'), QString::SkipEmptyParts);
     for (const QString& dirName : dirs)
@@ -58,9 +215,31 @@ UKUI_API QStringList ProgramFinder::findPrograms(const QStringList& commands)
 
 UKUI_API QString ProgramFinder::programName(const QString& command)
 {
+    static const QRegularExpression volatileChars(QSL("[$~*?[]"));
+    const bool cacheable = !command.contains(volatileChars);
+    if (cacheable)
+    {
+        QMutexLocker locker(&programNameMutex);
+        auto it = programNameCache.constFind(command);
+        if (it != programNameCache.constEnd())
+            return it.value();
+    }
+
+    QString name;
     wordexp_t we;
     if (wordexp(command.toLocal8Bit().constData(), &we, WRDE_NOCMD) == 0)
+    {
         if (we.we_wordc > 0)
-            return QString::fromLocal8Bit(we.we_wordv[0]);
-    return QString();
+            name = QString::fromLocal8Bit(we.we_wordv[0]);
+        wordfree(&we);
+    }
+
+    if (cacheable)
+    {
+        QMutexLocker locker(&programNameMutex);
+        if (programNameCache.size() >= ProgramNameCacheSize)
+            programNameCache.clear();
+        programNameCache.insert(command, name);
+    }
+    return name;
 }
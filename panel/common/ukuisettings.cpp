@@ -32,6 +32,7 @@
 #include <QStringList>
 #include <QMutex>
 #include <QFileSystemWatcher>
+#include <QHash>
 #include <QSharedData>
 #include <QTimerEvent>
 
@@ -42,6 +43,9 @@
 
 using namespace UKUi;
 
+#define SETTINGS_SAVE_DELAY 250
+#define SETTINGS_RELOAD_DELAY 200
+
 class UKUi::SettingsPrivate
 {
 public:
@@ -49,6 +53,8 @@ public:
         mFileChangeTimer(0),
         mAppChangeTimer(0),
         mAddWatchTimer(0),
+        mSaveTimer(0),
+        mNotifyTimer(0),
         mParent(parent)
     {
         // HACK: we need to ensure that the user (~/.config/ukui/<module>.conf)
@@ -88,24 +94,39 @@ public:
                 }
             }
 #endif
-            mParent->sync();
+            mParent->QSettings::sync();
         }
         mWatcher.addPath(mParent->fileName());
         QObject::connect(&(mWatcher), &QFileSystemWatcher::fileChanged, mParent, &Settings::_fileChanged);
     }
 
     QString localizedKey(const QString& key) const;
+    //! all values below the current group
+    QHash<QString, QVariant> values() const;
 
     QFileSystemWatcher mWatcher;
     int mFileChangeTimer;
     int mAppChangeTimer;
     int mAddWatchTimer;
+    int mSaveTimer;
+    int mNotifyTimer;
+    QStringList mExternalKeys;
 
 private:
     Settings* mParent;
 };
 
 
+QHash<QString, QVariant> SettingsPrivate::values() const
+{
+    QHash<QString, QVariant> values;
+    const QStringList keys = mParent->allKeys();
+    for (const QString &key : keys)
+        values.insert(key, mParent->value(key));
+    return values;
+}
+
+
 UKUiTheme* UKUiTheme::mInstance = 0;
 
 class UKUi::UKUiThemeData: public QSharedData {
@@ -205,6 +226,12 @@ bool Settings::event(QEvent *event)
         if(d_ptr->mAppChangeTimer)
             killTimer(d_ptr->mAppChangeTimer);
         d_ptr->mAppChangeTimer = startTimer(100);
+
+        // QSettings would write the whole file right now, collect all the
+        // changes of the following SETTINGS_SAVE_DELAY ms into one save instead
+        if (0 == d_ptr->mSaveTimer)
+            d_ptr->mSaveTimer = startTimer(SETTINGS_SAVE_DELAY);
+        return true;
     }
     else if (event->type() == QEvent::Timer)
     {
@@ -225,32 +252,76 @@ bool Settings::event(QEvent *event)
             d_ptr->mAddWatchTimer = 0;
             //try to re-add filename for watching
             addWatchedFile(fileName());
+        } else if (timer == d_ptr->mSaveTimer)
+        {
+            d_ptr->mSaveTimer = 0;
+            sync();
+        } else if (timer == d_ptr->mNotifyTimer)
+        {
+            d_ptr->mNotifyTimer = 0;
+            QStringList keys;
+            keys.swap(d_ptr->mExternalKeys);
+            emit keysChangedFromExternal(keys);
+            emit settingsChangedFromExternal();
+            emit settingsChanged();
         }
     }
 
     return QSettings::event(event);
 }
 
+void Settings::sync()
+{
+    if (d_ptr->mSaveTimer)
+    {
+        killTimer(d_ptr->mSaveTimer);
+        d_ptr->mSaveTimer = 0;
+    }
+
+    // QSettings::sync() writes our pending changes and merges in what other
+    // processes wrote, so whatever differs afterwards came from outside
+    const QHash<QString, QVariant> before = d_ptr->values();
+    QSettings::sync();
+    const QHash<QString, QVariant> after = d_ptr->values();
+
+    QStringList changed;
+    for (auto it = after.constBegin(); it != after.constEnd(); ++it)
+    {
+        auto old = before.constFind(it.key());
+        if (old == before.constEnd() || old.value() != it.value())
+            changed << it.key();
+    }
+    for (auto it = before.constBegin(); it != before.constEnd(); ++it)
+    {
+        if (!after.contains(it.key()))
+            changed << it.key();
+    }
+    if (changed.isEmpty())
+        return;
+
+    // notify from the event loop, sync() may be called in the middle of an update
+    for (const QString &key : qAsConst(changed))
+    {
+        if (!d_ptr->mExternalKeys.contains(key))
+            d_ptr->mExternalKeys << key;
+    }
+    if (0 == d_ptr->mNotifyTimer)
+        d_ptr->mNotifyTimer = startTimer(0);
+}
+
 void Settings::fileChanged()
 {
     sync();
-    emit settingsChangedFromExternal();
-    emit settingsChanged();
 }
 
 void Settings::_fileChanged(QString path)
 {
-    // check if the file isn't changed by our logic
-    // FIXME: this is poor implementation; should we rather compute some hash of values if changed by external?
-    if (0 == d_ptr->mAppChangeTimer)
-    {
-        // delay the change notification for 100 ms to avoid
-        // unnecessary repeated loading of the same config file if
-        // the file is changed for several times rapidly.
-        if(d_ptr->mFileChangeTimer)
-            killTimer(d_ptr->mFileChangeTimer);
-        d_ptr->mFileChangeTimer = startTimer(1000);
-    }
+    // our own saves come back here too, they are filtered out by the diff in sync();
+    // delay the reload to avoid unnecessary repeated loading of the same
+    // config file if the file is changed for several times rapidly.
+    if(d_ptr->mFileChangeTimer)
+        killTimer(d_ptr->mFileChangeTimer);
+    d_ptr->mFileChangeTimer = startTimer(SETTINGS_RELOAD_DELAY);
 
     addWatchedFile(path);
 }
@@ -78,6 +78,14 @@ public:
         overwritten. Otherwise, it overwrites the the un-localized version. */
     void setLocalizedValue(const QString &key, const QVariant &value);
 
+    /*! Writes the pending changes and reloads the file right now.
+        Changes made with setValue() are otherwise written behind, in one save
+        a short time after the first of them. Values that differ after the reload
+        were changed by another process and are reported by keysChangedFromExternal().
+        Note: this hides QSettings::sync(), calling it through a QSettings pointer
+        bypasses the change detection. */
+    void sync();
+
 signals:
     /*! /brief signal for backward compatibility (emitted whenever settingsChangedFromExternal() or settingsChangedByApp() is emitted)
      */
@@ -85,6 +93,10 @@ signals:
     /*! /brief signal emitted when the settings file is changed by external application
      */
     void settingsChangedFromExternal();
+    /*! /brief signal emitted together with settingsChangedFromExternal() with the keys (relative to the current group)
+        whose values were changed, added or removed by the external application
+     */
+    void keysChangedFromExternal(const QStringList &keys);
     /*! /brief signal emitted when any setting is changed by this object
      */
     void settingsChangedByApp();
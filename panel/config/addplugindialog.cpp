@@ -29,6 +29,7 @@
 #include "addplugindialog.h"
 #include "plugin.h"
 #include "../ukuipanelapplication.h"
+#include "../pluginregistry.h"
 
 //#include <UKUi/HtmlDelegate>
 #include "common/ukuihtmldelegate.h"
@@ -54,7 +55,8 @@ AddPluginDialog::AddPluginDialog(QWidget *parent):
     desktopFilesDirs << QString("%1/%2").arg(XdgDirs::dataHome(), "/ukui/ukui-panel");
     desktopFilesDirs << PLUGIN_DESKTOPS_DIR;
 
-    mPlugins = UKUi::PluginInfo::search(desktopFilesDirs, QLatin1String("UKUIPanel/Plugin"), QLatin1String("*"));
+    PluginRegistry::instance()->scan(desktopFilesDirs);
+    mPlugins = PluginRegistry::instance()->plugins();
     std::sort(mPlugins.begin(), mPlugins.end(), [](const UKUi::PluginInfo &p1, const UKUi::PluginInfo &p2) {
         return p1.name() < p2.name() || (p1.name() == p2.name() && p1.comment() < p2.comment());
     });
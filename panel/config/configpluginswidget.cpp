@@ -111,7 +111,7 @@ void ConfigPluginsWidget::resetButtons()
     {
         Plugin const * plugin
             = ui->listView_plugins->model()->data(selectionModel->currentIndex(), Qt::UserRole).value<Plugin const *>();
-        if (nullptr != plugin)
+        if (nullptr != plugin && nullptr != plugin->iPlugin())
             hasConfigDialog = plugin->iPlugin()->flags().testFlag(IUKUIPanelPlugin::HaveConfigDialog);
     }
 
@@ -0,0 +1,188 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#include "gsettingsregistry.h"
+#include <QGSettings>
+#include <QElapsedTimer>
+#include <QDebug>
+
+GSettingsRegistry *GSettingsRegistry::instance()
+{
+    static GSettingsRegistry *registry = new GSettingsRegistry;
+    return registry;
+}
+
+GSettingsRegistry::GSettingsRegistry(QObject *parent) :
+    QObject(parent)
+{
+}
+
+bool GSettingsRegistry::isInstalled(const QByteArray &schema)
+{
+    auto it = mInstalled.constFind(schema);
+    if (it != mInstalled.constEnd())
+        return it.value();
+    const bool installed = QGSettings::isSchemaInstalled(schema);
+    mInstalled.insert(schema, installed);
+    return installed;
+}
+
+GSettingsRegistry::Schema *GSettingsRegistry::open(const QByteArray &schema, const QByteArray &path)
+{
+    const QByteArray key = id(schema, path);
+    auto it = mSchemas.constFind(key);
+    if (it != mSchemas.constEnd())
+        return it.value();
+    if (!isInstalled(schema))
+        return nullptr;
+
+    Schema *s = new Schema;
+    s->settings = new QGSettings(schema, path, this);
+    s->names = s->settings->keys();
+    connect(s->settings, &QGSettings::changed, this, &GSettingsRegistry::keyChanged);
+    mSchemas.insert(key, s);
+    mIds.insert(s->settings, key);
+    return s;
+}
+
+QGSettings *GSettingsRegistry::settings(const QByteArray &schema, const QByteArray &path)
+{
+    Schema *s = open(schema, path);
+    return s ? s->settings : nullptr;
+}
+
+QVariant GSettingsRegistry::value(const QByteArray &schema, const QByteArray &path, const QString &key,
+                                  const QVariant &defaultValue)
+{
+    Schema *s = open(schema, path);
+    if (!s)
+        return defaultValue;
+
+    const QString name = dconfKey(key);
+    auto it = s->values.constFind(name);
+    if (it != s->values.constEnd())
+        return it.value();
+    if (!s->names.contains(camelKey(name)))
+        return defaultValue;
+    const QVariant v = s->settings->get(name);
+    s->values.insert(name, v);
+    return v;
+}
+
+void GSettingsRegistry::setValue(const QByteArray &schema, const QString &key, const QVariant &value)
+{
+    Schema *s = open(schema, QByteArray());
+    if (s)
+        s->settings->set(dconfKey(key), value);
+}
+
+GSettingsKey *GSettingsRegistry::watch(const QByteArray &schema, const QByteArray &path, const QString &key)
+{
+    Schema *s = open(schema, path);
+    if (!s)
+        return nullptr;
+
+    const QString name = dconfKey(key);
+    GSettingsKey *watched = s->keys.value(name);
+    if (!watched)
+    {
+        watched = new GSettingsKey(this);
+        s->keys.insert(name, watched);
+    }
+    return watched;
+}
+
+/*每个键在变化时只从dconf读一次,再分发给所有订阅者*/
+void GSettingsRegistry::keyChanged(const QString &key)
+{
+    QGSettings *settings = qobject_cast<QGSettings *>(sender());
+    Schema *s = mSchemas.value(mIds.value(settings));
+    if (!s)
+        return;
+
+    const QString name = dconfKey(key);
+    s->values.remove(name);
+    GSettingsKey *watched = s->keys.value(name);
+    if (!watched || !watched->subscribers())
+        return;
+
+    const QVariant v = s->settings->get(name);
+    s->values.insert(name, v);
+
+    QElapsedTimer timer;
+    timer.start();
+    emit watched->changed(v);
+    ++watched->mDispatches;
+    watched->mDispatchNsecs += timer.nsecsElapsed();
+}
+
+QString GSettingsRegistry::report() const
+{
+    QString out;
+    for (auto it = mSchemas.constBegin(); it != mSchemas.constEnd(); ++it)
+    {
+        const QString schema = QString::fromUtf8(it.key()).replace('\n', ' ').trimmed();
+        const Schema *s = it.value();
+        for (auto k = s->keys.constBegin(); k != s->keys.constEnd(); ++k)
+        {
+            out += QString("%1 %2: %3 subscribers, %4 dispatches, %5 us\n")
+                    .arg(schema, k.key())
+                    .arg(k.value()->subscribers())
+                    .arg(k.value()->mDispatches)
+                    .arg(k.value()->mDispatchNsecs / 1000);
+        }
+    }
+    return out;
+}
+
+QString GSettingsRegistry::dconfKey(const QString &key)
+{
+    QString name;
+    name.reserve(key.size() + 4);
+    for (const QChar c : key)
+    {
+        if (c.isUpper())
+        {
+            name += '-';
+            name += c.toLower();
+        }
+        else
+        {
+            name += c;
+        }
+    }
+    return name;
+}
+
+QString GSettingsRegistry::camelKey(const QString &key)
+{
+    QString name;
+    name.reserve(key.size());
+    bool upper = false;
+    for (const QChar c : key)
+    {
+        if (c == '-')
+        {
+            upper = true;
+            continue;
+        }
+        name += upper ? c.toUpper() : c;
+        upper = false;
+    }
+    return name;
+}
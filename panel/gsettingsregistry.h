@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#ifndef GSETTINGSREGISTRY_H
+#define GSETTINGSREGISTRY_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include "ukuipanelglobals.h"
+
+class QGSettings;
+
+/*! \brief One watched key of a shared schema, see GSettingsRegistry::subscribe() */
+class UKUI_PANEL_API GSettingsKey : public QObject
+{
+    Q_OBJECT
+public:
+    explicit GSettingsKey(QObject *parent = nullptr) : QObject(parent), mDispatches(0), mDispatchNsecs(0) {}
+
+    int subscribers() const { return receivers(SIGNAL(changed(QVariant))); }
+
+signals:
+    void changed(const QVariant &value);
+
+private:
+    friend class GSettingsRegistry;
+    qint64 mDispatches;
+    qint64 mDispatchNsecs;
+};
+
+/*! \brief Process wide owner of the QGSettings objects.
+ *
+ * Every schema/path pair is opened once and its values are cached; a change
+ * notification re-reads only the changed key, once, no matter how many
+ * widgets use it. Consumers subscribe to single keys instead of connecting
+ * to QGSettings::changed and filtering the key names themselves.
+ *
+ * Keys can be given in the dconf form ("style-name") or in the camel case
+ * form used by QGSettings::changed ("styleName").
+ */
+class UKUI_PANEL_API GSettingsRegistry : public QObject
+{
+    Q_OBJECT
+public:
+    static GSettingsRegistry *instance();
+
+    bool isInstalled(const QByteArray &schema);
+    //! the shared object, nullptr if the schema is not installed; don't delete it
+    QGSettings *settings(const QByteArray &schema, const QByteArray &path = QByteArray());
+
+    QVariant value(const QByteArray &schema, const QString &key, const QVariant &defaultValue = QVariant())
+    {
+        return value(schema, QByteArray(), key, defaultValue);
+    }
+    //! relocatable schemas; no default argument, value(schema, key, default) would be ambiguous
+    QVariant value(const QByteArray &schema, const QByteArray &path, const QString &key,
+                   const QVariant &defaultValue);
+    void setValue(const QByteArray &schema, const QString &key, const QVariant &value);
+
+    /*! Calls func(const QVariant &newValue) in the context's thread whenever the key changes,
+        the subscription ends with the context object. */
+    template <typename Func>
+    QMetaObject::Connection subscribe(const QByteArray &schema, const QString &key, const QObject *context, Func func)
+    {
+        return subscribe(schema, QByteArray(), key, context, func);
+    }
+    template <typename Func>
+    QMetaObject::Connection subscribe(const QByteArray &schema, const QByteArray &path, const QString &key,
+                                      const QObject *context, Func func)
+    {
+        GSettingsKey *watched = watch(schema, path, key);
+        if (!watched)
+            return QMetaObject::Connection();
+        return connect(watched, &GSettingsKey::changed, context, func);
+    }
+
+    //! subscriptions, dispatches and dispatch time per key, one line each
+    QString report() const;
+
+    //! "styleName" -> "style-name"
+    static QString dconfKey(const QString &key);
+    //! "style-name" -> "styleName"
+    static QString camelKey(const QString &key);
+
+private slots:
+    void keyChanged(const QString &key);
+
+private:
+    explicit GSettingsRegistry(QObject *parent = nullptr);
+    GSettingsKey *watch(const QByteArray &schema, const QByteArray &path, const QString &key);
+
+    struct Schema
+    {
+        QGSettings *settings;
+        QStringList names;                  //!< camel case, as QGSettings::keys()
+        QHash<QString, QVariant> values;
+        QHash<QString, GSettingsKey *> keys;
+    };
+    static QByteArray id(const QByteArray &schema, const QByteArray &path) { return schema + '\n' + path; }
+    Schema *open(const QByteArray &schema, const QByteArray &path);
+
+    QHash<QByteArray, Schema *> mSchemas;
+    QHash<QGSettings *, QByteArray> mIds;
+    QHash<QByteArray, bool> mInstalled;
+};
+
+#endif // GSETTINGSREGISTRY_H
@@ -0,0 +1,388 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include "hangwatchdog.h"
+#include "pluginprofiler.h"
+#include "pluginregistry.h"
+
+#include <QAbstractEventDispatcher>
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QPair>
+#include <QThread>
+#include <QVector>
+#include <errno.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WATCHDOG_DBUS_PATH      "/watchdog"
+#define WATCHDOG_THRESHOLD      1000    // ms
+#define WATCHDOG_KEPT_STALLS    16
+#define WATCHDOG_REPORT_FRAMES  4
+#define WATCHDOG_MAX_FRAMES     64
+#define WATCHDOG_STACK_SIGNAL   SIGUSR2
+// how much of the GUI thread stack is copied, in words
+#define WATCHDOG_STACK_WORDS    16384
+// how long the watchdog waits for the signal handler, ms
+#define WATCHDOG_STACK_TIMEOUT  100
+
+bool HangWatchdog::sEnabled = false;
+QAtomicPointer<QObject> HangWatchdog::sReceiver;
+QAtomicPointer<const char> HangWatchdog::sReceiverClass;
+QAtomicPointer<QObject> HangWatchdog::sStalledReceiver;
+QAtomicInt HangWatchdog::sActivity;
+
+namespace
+{
+const char *stackTop = nullptr;
+quintptr stackCopy[WATCHDOG_STACK_WORDS];
+QAtomicInt stackWords(-1);
+
+// 信号处理里只拷贝栈，不调用任何不可重入的函数
+void stackSignalHandler(int)
+{
+    const int savedErrno = errno;
+    quintptr here = 0;
+    const quintptr *from = &here;
+    int words = 0;
+    while (words < WATCHDOG_STACK_WORDS
+           && reinterpret_cast<const char *>(from + words + 1) <= stackTop)
+    {
+        stackCopy[words] = from[words];
+        ++words;
+    }
+    stackWords.storeRelease(words);
+    errno = savedErrno;
+}
+
+// the upper end of the calling thread's stack, stacks grow down
+const char *currentStackTop()
+{
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) != 0)
+        return nullptr;
+    void *addr = nullptr;
+    size_t size = 0;
+    const int ret = pthread_attr_getstack(&attr, &addr, &size);
+    pthread_attr_destroy(&attr);
+    return ret == 0 ? static_cast<const char *>(addr) + size : nullptr;
+}
+
+QVector<QPair<quintptr, quintptr> > executableMappings()
+{
+    QVector<QPair<quintptr, quintptr> > ranges;
+    QFile maps(QStringLiteral("/proc/self/maps"));
+    if (!maps.open(QIODevice::ReadOnly))
+        return ranges;
+    // "7f5c8a000000-7f5c8a1b0000 r-xp 00000000 08:01 1234 /usr/lib/libfoo.so"
+    for (const QByteArray &line : maps.readAll().split('\n'))
+    {
+        const QList<QByteArray> fields = line.simplified().split(' ');
+        if (fields.size() < 2 || fields.at(1).size() < 3 || fields.at(1).at(2) != 'x')
+            continue;
+        const QList<QByteArray> bounds = fields.at(0).split('-');
+        if (bounds.size() == 2)
+            ranges << qMakePair(quintptr(bounds.at(0).toULongLong(nullptr, 16)),
+                                quintptr(bounds.at(1).toULongLong(nullptr, 16)));
+    }
+    return ranges;
+}
+}
+
+class HangWatchdog::Thread : public QThread
+{
+public:
+    explicit Thread(HangWatchdog *watchdog) : mWatchdog(watchdog) {}
+
+protected:
+    void run() override { mWatchdog->watch(); }
+
+private:
+    HangWatchdog *mWatchdog;
+};
+
+HangWatchdog *HangWatchdog::instance()
+{
+    static HangWatchdog *watchdog = new HangWatchdog;
+    return watchdog;
+}
+
+HangWatchdog::HangWatchdog(QObject *parent)
+    : QObject(parent),
+      mThreshold(WATCHDOG_THRESHOLD),
+      mTick(0),
+      mGuiThread(pthread_self()),
+      mThread(nullptr),
+      mStopping(false),
+      mPingSent(-1),
+      mSeenActivity(0),
+      mStalled(false),
+      mStallCount(0)
+{
+    QDBusConnection::sessionBus().registerObject(QStringLiteral(WATCHDOG_DBUS_PATH), this,
+                                                 QDBusConnection::ExportScriptableSlots);
+
+    bool ok = false;
+    const int threshold = qEnvironmentVariableIntValue("UKUI_PANEL_WATCHDOG_MS", &ok);
+    if (ok && threshold > 0)
+        mThreshold = threshold;
+    mTick = qMax(mThreshold / 4, 10);
+
+    // wakeups outside of event deliveries (X events, glib sources) count as activity too
+    if (QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance())
+        connect(dispatcher, &QAbstractEventDispatcher::awake, this, [] { sActivity.ref(); },
+                Qt::DirectConnection);
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &HangWatchdog::stop);
+
+    if (qgetenv("UKUI_PANEL_WATCHDOG") == "1")
+        setEnabled(true);
+}
+
+HangWatchdog::~HangWatchdog()
+{
+    stop();
+}
+
+void HangWatchdog::setEnabled(bool enabled)
+{
+    if (!enabled)
+    {
+        stop();
+        return;
+    }
+    if (mThread)
+        return;
+
+    if (mLibraryDirs.isEmpty())
+        mLibraryDirs = PluginRegistry::instance()->libraryDirs();
+    stackTop = currentStackTop();
+    if (!stackTop)
+    {
+        qWarning() << "HangWatchdog: can't find the GUI thread stack";
+        return;
+    }
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = stackSignalHandler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(WATCHDOG_STACK_SIGNAL, &action, nullptr);
+
+    mStopping = false;
+    mPingSent = -1;
+    mStalled = false;
+    mSeenActivity = sActivity.loadAcquire();
+    mClock.start();
+    sEnabled = true;
+    mThread = new Thread(this);
+    mThread->setObjectName(QStringLiteral("HangWatchdog"));
+    mThread->start(QThread::LowPriority);
+}
+
+void HangWatchdog::stop()
+{
+    if (!mThread)
+        return;
+
+    {
+        QMutexLocker locker(&mMutex);
+        mStopping = true;
+        mWake.wakeAll();
+    }
+    mThread->wait();
+    delete mThread;
+    mThread = nullptr;
+    sEnabled = false;
+    sReceiver.storeRelease(nullptr);
+    sReceiverClass.storeRelease(nullptr);
+    sStalledReceiver.storeRelease(nullptr);
+}
+
+void HangWatchdog::watch()
+{
+    QMutexLocker locker(&mMutex);
+    while (!mStopping)
+    {
+        mWake.wait(&mMutex, mTick);
+        if (mStopping)
+            break;
+
+        const qint64 now = mClock.elapsed();
+        if (mPingSent < 0)
+        {
+            const int activity = sActivity.loadAcquire();
+            if (activity != mSeenActivity)
+            {
+                mSeenActivity = activity;
+                mPingSent = now;
+                QMetaObject::invokeMethod(this, "pong", Qt::QueuedConnection);
+            }
+        }
+        else if (!mStalled && now - mPingSent >= mThreshold)
+        {
+            mStalled = true;
+            captureStall(now - mPingSent);
+        }
+    }
+}
+
+void HangWatchdog::pong()
+{
+    QMutexLocker locker(&mMutex);
+    // the wakeup for this ping is not activity
+    mSeenActivity = sActivity.loadAcquire();
+    const qint64 msecs = mClock.elapsed() - mPingSent;
+    mPingSent = -1;
+    if (!mStalled)
+        return;
+
+    mStalled = false;
+    sStalledReceiver.storeRelease(nullptr);
+    mCurrent.msecs = msecs;
+    if (mCurrent.plugin.isEmpty())
+        mCurrent.plugin = QStringLiteral("panel");
+    qWarning().noquote() << QString("GUI thread was stalled for %1 ms by %2 (%3)")
+                            .arg(msecs).arg(mCurrent.plugin)
+                            .arg(mCurrent.receiver.isEmpty() ? QStringLiteral("no event") : mCurrent.receiver);
+
+    ++mStallCount;
+    mStalls.append(mCurrent);
+    if (mStalls.size() > WATCHDOG_KEPT_STALLS)
+        mStalls.removeFirst();
+    mCurrent = Stall();
+}
+
+// on the watchdog thread, with mMutex held
+void HangWatchdog::captureStall(qint64 msecs)
+{
+    const char *receiverClass = sReceiverClass.loadAcquire();
+    sStalledReceiver.storeRelease(sReceiver.loadAcquire());
+
+    mCurrent = Stall();
+    mCurrent.when = QDateTime::currentDateTime();
+    // class names are static strings of the loaded libraries
+    if (receiverClass)
+        mCurrent.receiver = QString::fromLatin1(receiverClass);
+    mCurrent.frames = guiThreadStack();
+    mCurrent.plugin = pluginOfStack(mCurrent.frames);
+
+    qWarning().noquote() << QString("GUI thread stalled for %1 ms so far, in %2 (%3):")
+                            .arg(msecs)
+                            .arg(mCurrent.plugin.isEmpty() ? QStringLiteral("?") : mCurrent.plugin)
+                            .arg(mCurrent.receiver.isEmpty() ? QStringLiteral("no event") : mCurrent.receiver)
+                         << "\n  " + mCurrent.frames.join(QStringLiteral("\n  "));
+}
+
+void HangWatchdog::stallFinished(QObject *receiver)
+{
+    QMutexLocker locker(&mMutex);
+    sStalledReceiver.storeRelease(nullptr);
+    if (mStalled && mCurrent.plugin.isEmpty())
+        mCurrent.plugin = PluginProfiler::instance()->pluginOf(receiver);
+}
+
+QStringList HangWatchdog::guiThreadStack()
+{
+    stackWords.storeRelease(-1);
+    int error;
+    do
+        error = pthread_kill(mGuiThread, WATCHDOG_STACK_SIGNAL);
+    while (error == EINTR);
+    if (error != 0)
+    {
+        qWarning() << "HangWatchdog: can't signal the GUI thread:" << strerror(error);
+        return QStringList();
+    }
+    for (int i = 0; i < WATCHDOG_STACK_TIMEOUT && stackWords.loadAcquire() < 0; ++i)
+        QThread::msleep(1);
+
+    const int words = stackWords.loadAcquire();
+    if (words <= 0)
+        return QStringList();
+
+    // 栈上指向可执行映射的值，大多是返回地址
+    const QVector<QPair<quintptr, quintptr> > code = executableMappings();
+    void *addresses[WATCHDOG_MAX_FRAMES];
+    int count = 0;
+    for (int i = 0; i < words && count < WATCHDOG_MAX_FRAMES; ++i)
+    {
+        const quintptr word = stackCopy[i];
+        if (count > 0 && addresses[count - 1] == reinterpret_cast<void *>(word))
+            continue;
+        for (const auto &range : code)
+        {
+            if (word >= range.first && word < range.second)
+            {
+                addresses[count++] = reinterpret_cast<void *>(word);
+                break;
+            }
+        }
+    }
+
+    QStringList frames;
+    char **symbols = count ? backtrace_symbols(addresses, count) : nullptr;
+    if (!symbols)
+        return frames;
+    for (int i = 0; i < count; ++i)
+        frames << QString::fromLocal8Bit(symbols[i]);
+    free(symbols);
+    return frames;
+}
+
+// the innermost frame in a dynamically loaded plugin, "/path/libtaskbar.so(sym+0x1f) [0x..]"
+QString HangWatchdog::pluginOfStack(const QStringList &frames) const
+{
+    for (const QString &frame : frames)
+    {
+        const QString module = frame.left(frame.indexOf(QLatin1Char('(')));
+        for (const QString &dir : mLibraryDirs)
+        {
+            if (!module.startsWith(dir))
+                continue;
+            QString name = QFileInfo(module).completeBaseName();
+            if (name.startsWith(QLatin1String("lib")))
+                name.remove(0, 3);
+            return name;
+        }
+    }
+    return QString();
+}
+
+QString HangWatchdog::report() const
+{
+    QMutexLocker locker(&mMutex);
+    QString result = QStringLiteral("watchdog %1, threshold %2 ms, %3 stalls\n")
+            .arg(mThread ? QStringLiteral("on") : QStringLiteral("off"))
+            .arg(mThreshold).arg(mStallCount);
+    for (const Stall &stall : mStalls)
+    {
+        result += QStringLiteral("%1 %2 ms %3 (%4): %5\n")
+                .arg(stall.when.toString(Qt::ISODate))
+                .arg(stall.msecs)
+                .arg(stall.plugin)
+                .arg(stall.receiver.isEmpty() ? QStringLiteral("no event") : stall.receiver)
+                .arg(stall.frames.mid(0, WATCHDOG_REPORT_FRAMES).join(QStringLiteral(" < ")));
+    }
+    return result;
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#ifndef HANGWATCHDOG_H
+#define HANGWATCHDOG_H
+
+#include <QObject>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QStringList>
+#include <QWaitCondition>
+#include <pthread.h>
+#include "ukuipanelglobals.h"
+
+/*! \brief Detects stalls of the GUI thread event loop.
+ *
+ * A separate thread watches the event loop. When the loop has done something
+ * since the last check it queues a ping to the GUI thread; a ping that is not
+ * answered within the threshold is a stall. The watchdog thread then samples
+ * the stack of the GUI thread and logs it, and logs the whole length once the
+ * loop answers. While the panel is idle no ping is sent, so the watchdog
+ * doesn't wake it.
+ *
+ * The sample is taken by a signal whose handler only copies the live part of
+ * the GUI thread stack into a static buffer. The watchdog thread keeps the
+ * words that point into executable mappings and symbolizes them, so the
+ * frames are return addresses found on the stack, not an exact unwind.
+ *
+ * A stall is attributed to the plugin library found on the stack, otherwise
+ * to the plugin of the object that was receiving an event, as known to the
+ * PluginProfiler. The GUI thread saves the class name of the receiver before
+ * the delivery, the watchdog thread never touches the receiver itself.
+ *
+ * The watchdog is off by default. It is enabled by UKUI_PANEL_WATCHDOG=1 or
+ * setEnabled() on the session bus as com.ukui.panel.debug.HangWatchdog at
+ * /watchdog, next to report(). The threshold is UKUI_PANEL_WATCHDOG_MS,
+ * 1000 ms by default.
+ */
+class UKUI_PANEL_API HangWatchdog : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "com.ukui.panel.debug.HangWatchdog")
+public:
+    static HangWatchdog *instance();
+    ~HangWatchdog();
+
+    //! called by UKUIPanelApplication::notify() around the outermost deliveries
+    static void eventStarted(QObject *receiver)
+    {
+        if (!sEnabled)
+            return;
+        sReceiverClass.storeRelease(receiver->metaObject()->className());
+        sReceiver.storeRelease(receiver);
+        sActivity.ref();
+    }
+    static void eventFinished(QObject *receiver)
+    {
+        if (!sEnabled)
+            return;
+        sReceiver.storeRelease(nullptr);
+        sReceiverClass.storeRelease(nullptr);
+        if (Q_UNLIKELY(sStalledReceiver.loadAcquire() == receiver))
+            instance()->stallFinished(receiver);
+    }
+
+    bool isEnabled() const { return mThread; }
+
+public slots:
+    //! the last stalls, newest last, with the top of their stacks
+    Q_SCRIPTABLE QString report() const;
+    Q_SCRIPTABLE void setEnabled(bool enabled);
+
+private slots:
+    void pong();
+    void stop();
+
+private:
+    explicit HangWatchdog(QObject *parent = nullptr);
+
+    class Thread;
+
+    struct Stall
+    {
+        Stall() : msecs(0) {}
+        QDateTime when;
+        qint64 msecs;
+        QString plugin;
+        QString receiver;
+        QStringList frames;
+    };
+
+    void watch();
+    void captureStall(qint64 msecs);
+    void stallFinished(QObject *receiver);
+    QStringList guiThreadStack();
+    QString pluginOfStack(const QStringList &frames) const;
+
+    static bool sEnabled;
+    // 只用来比较，看门狗线程不解引用
+    static QAtomicPointer<QObject> sReceiver;
+    static QAtomicPointer<const char> sReceiverClass;
+    static QAtomicPointer<QObject> sStalledReceiver;
+    static QAtomicInt sActivity;
+
+    int mThreshold;
+    int mTick;
+    pthread_t mGuiThread;
+    QStringList mLibraryDirs;
+    Thread *mThread;
+
+    // below: shared with the watchdog thread
+    mutable QMutex mMutex;
+    QWaitCondition mWake;
+    bool mStopping;
+    QElapsedTimer mClock;
+    qint64 mPingSent;       // -1 while no ping is queued
+    int mSeenActivity;
+    bool mStalled;
+    Stall mCurrent;
+    QList<Stall> mStalls;
+    int mStallCount;
+};
+
+#endif // HANGWATCHDOG_H
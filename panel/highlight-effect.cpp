@@ -29,7 +29,7 @@
 
 #include <QPixmap>
 #include <QPainter>
-#include <QGSettings>
+#include "gsettingsregistry.h"
 #include <QImage>
 #include <QtMath>
 
@@ -386,15 +386,9 @@ QPixmap HighLightEffect::drawSymbolicColoredPixmap(const QPixmap &source)
 QIcon HighLightEffect::drawSymbolicColoredIcon(const QIcon &source)
 {
     QColor standard (31,32,34);
-    QGSettings *style_settings;
-    bool dark_style;
-    const QByteArray style_id(ORG_UKUI_STYLE);
     QStringList stylelist;
     stylelist<<STYLE_NAME_KEY_DARK<<STYLE_NAME_KEY_BLACK<<STYLE_NAME_KEY_DEFAULT;
-    if(QGSettings::isSchemaInstalled(style_id)){
-        style_settings = new QGSettings(style_id);
-        dark_style=stylelist.contains(style_settings->get(STYLE_NAME).toString());
-    }
+    bool dark_style = stylelist.contains(GSettingsRegistry::instance()->value(ORG_UKUI_STYLE, STYLE_NAME).toString());
 
     QImage img = source.pixmap(64,64).toImage();
     for (int x = 0; x < img.width(); x++) {
@@ -412,7 +406,6 @@ QIcon HighLightEffect::drawSymbolicColoredIcon(const QIcon &source)
         }
     }
     return QPixmap::fromImage(img);
-    style_settings->deleteLater();
 }
 
 void HighLightEffect::getBackGroundColor(int bg_red,int bg_green,int bg_blue)
@@ -29,6 +29,7 @@
 #define IUKUIPANELPLUGIN_H
 
 #include <QtPlugin>
+#include <QVariantMap>
 #include "iukuipanel.h"
 #include "ukuipanelglobals.h"
 #include <QDebug>
@@ -257,4 +258,34 @@ public:
 Q_DECLARE_INTERFACE(IUKUIPanelPluginLibrary,
                     "ukui.org/Panel/PluginInterface/3.0")
 
+/**
+Optional second interface of the plugin library for plugins marked with
+X-UKUI-Panel-Deferred=true in their .desktop file. Such plugins are created
+after the panel is shown; prepare() is called before instance() on a worker
+thread to do the expensive non GUI work (reading desktop files, parsing
+configs, DBus queries) so instance() only has to build the widgets.
+
+prepare() must not create widgets or QObjects that outlive the call, settings
+is a read only snapshot of the plugin settings group.
+@code
+class UKUiClockPluginLibrary: public QObject, public IUKUIPanelPluginLibrary, public IUKUIPanelPluginPreparer
+{
+    Q_OBJECT
+    Q_INTERFACES(IUKUIPanelPluginLibrary IUKUIPanelPluginPreparer)
+    ...
+};
+@endcode
+**/
+class UKUI_PANEL_API IUKUIPanelPluginPreparer
+{
+public:
+    virtual ~IUKUIPanelPluginPreparer() {}
+
+    virtual void prepare(const UKUi::PluginInfo &desktopFile, const QVariantMap &settings) const = 0;
+};
+
+
+Q_DECLARE_INTERFACE(IUKUIPanelPluginPreparer,
+                    "ukui.org/Panel/PluginPreparer/1.0")
+
 #endif // IUKUIPANELPLUGIN_H
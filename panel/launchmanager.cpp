@@ -0,0 +1,392 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#include "launchmanager.h"
+#include "pluginprofiler.h"
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QProcess>
+#include <QRunnable>
+#include <QStandardPaths>
+#include <QThreadPool>
+#include <QTimer>
+#include <XdgIcon>
+#include <KWindowSystem/KWindowSystem>
+#include <KWindowSystem/KWindowInfo>
+#include <KWindowSystem/KStartupInfo>
+#include <KWindowSystem/NETWM>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+/* 从点击到窗口出现的最长等待时间，超时后允许再次启动。
+ * 进程退出或已有窗口被激活时会更早结束等待，这里只兜底 */
+#define LAUNCH_TIMEOUT 5000
+/* 桌面文件和其中 action 组成启动 id 时的分隔，命令行本身可以含有 '#' */
+#define LAUNCH_ACTION_MARKER "#action:"
+
+/* 直方图的桶上限(ms)，最后一个桶收集所有更慢的启动 */
+static const int LatencyBounds[] = { 250, 500, 1000, 2000, 4000, 8000 };
+static const int LatencyBuckets = sizeof(LatencyBounds) / sizeof(LatencyBounds[0]) + 1;
+
+class LaunchJob : public QRunnable
+{
+public:
+    enum Kind { Launch, Prewarm };
+
+    LaunchJob(LaunchManager *manager, Kind kind, const QString &id, const QString &desktopFile,
+              const QString &action, const QString &command, const QByteArray &startupId = QByteArray()) :
+        mManager(manager), mKind(kind), mId(id),
+        mDesktopFile(desktopFile), mAction(action), mCommand(command), mStartupId(startupId)
+    {
+    }
+
+    void run() override
+    {
+        if (mKind == Prewarm)
+            prewarm();
+        else
+            launch();
+    }
+
+private:
+    // 带上启动通知 id，应用的第一个窗口会把它设置到 _NET_STARTUP_ID
+    bool startDetached(QStringList args, const QString &workingDirectory, qint64 *pid)
+    {
+#if (QT_VERSION >= QT_VERSION_CHECK(5,10,0))
+        QProcess process;
+        process.setProgram(args.takeFirst());
+        process.setArguments(args);
+        process.setWorkingDirectory(workingDirectory);
+        QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+        env.remove(QStringLiteral("DESKTOP_STARTUP_ID"));
+        if (!mStartupId.isEmpty())
+            env.insert(QStringLiteral("DESKTOP_STARTUP_ID"), QString::fromLatin1(mStartupId));
+        process.setProcessEnvironment(env);
+        return process.startDetached(pid);
+#else
+        const QString program = args.takeFirst();
+        return QProcess::startDetached(program, args, workingDirectory, pid);
+#endif
+    }
+
+    void launch()
+    {
+        bool ok = false;
+        qint64 pid = 0;
+        QStringList classes;
+
+        if (!mCommand.isEmpty())
+        {
+            classes << QFileInfo(mCommand.section(' ', 0, 0, QString::SectionSkipEmpty)).fileName();
+            ok = QProcess::startDetached(mCommand);
+        }
+        else
+        {
+            const XdgDesktopFile xdg = mManager->entry(mDesktopFile);
+            if (xdg.isValid())
+            {
+                classes << xdg.value("StartupWMClass").toString()
+                        << QFileInfo(mDesktopFile).completeBaseName();
+                QStringList args = xdg.expandExecString();
+                if (!args.isEmpty())
+                    classes << QFileInfo(args.first()).fileName();
+
+                if (!mAction.isEmpty())
+                    ok = xdg.actionActivate(mAction, QStringList());
+                else if (args.isEmpty() || xdg.type() != XdgDesktopFile::ApplicationType
+                         || xdg.value("Terminal").toBool() || xdg.value("DBusActivatable").toBool())
+                    ok = xdg.startDetached();
+                else
+                    // 与 XdgDesktopFile::startDetached 相同，但能拿到 pid 用于匹配窗口
+                    ok = startDetached(args, xdg.value("Path").toString(), &pid);
+            }
+        }
+
+        QMetaObject::invokeMethod(mManager, "spawned", Qt::QueuedConnection,
+                                  Q_ARG(QString, mId), Q_ARG(bool, ok),
+                                  Q_ARG(qint64, pid), Q_ARG(QStringList, classes));
+    }
+
+    void prewarm()
+    {
+        const XdgDesktopFile xdg = mManager->entry(mDesktopFile);
+        if (!xdg.isValid())
+            return;
+        // 图标主题的查找不是线程安全的，交给 GUI 线程
+        const QString iconName = xdg.iconName();
+        if (!iconName.isEmpty())
+            QMetaObject::invokeMethod(mManager, "prewarmIcon", Qt::QueuedConnection, Q_ARG(QString, iconName));
+
+        const QStringList args = xdg.expandExecString();
+        if (args.isEmpty())
+            return;
+        const QString program = QFileInfo(args.first()).isAbsolute()
+                ? args.first() : QStandardPaths::findExecutable(args.first());
+        if (program.isEmpty())
+            return;
+        // 提前把可执行文件读入页缓存
+        int fd = ::open(QFile::encodeName(program).constData(), O_RDONLY | O_CLOEXEC);
+        if (fd >= 0)
+        {
+            posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+            ::close(fd);
+        }
+    }
+
+    LaunchManager *mManager;
+    Kind mKind;
+    QString mId;
+    QString mDesktopFile;
+    QString mAction;
+    QString mCommand;
+    QByteArray mStartupId;
+};
+
+LaunchManager *LaunchManager::instance()
+{
+    static LaunchManager *manager = new LaunchManager;
+    return manager;
+}
+
+LaunchManager::LaunchManager(QObject *parent) :
+    QObject(parent),
+    mExpireTimer(new QTimer(this))
+{
+    mExpireTimer->setInterval(1000);
+    connect(mExpireTimer, &QTimer::timeout, this, &LaunchManager::expire);
+    connect(KWindowSystem::self(), &KWindowSystem::windowAdded, this, &LaunchManager::windowAdded);
+    connect(KWindowSystem::self(), &KWindowSystem::activeWindowChanged, this, &LaunchManager::windowActivated);
+
+    PluginProfiler::instance()->addCache(QStringLiteral("panel"), QStringLiteral("desktop entries"), [this] {
+        QMutexLocker locker(&mEntriesMutex);
+        return PluginProfiler::CacheSize(mEntries.size());
+    });
+}
+
+bool LaunchManager::launch(const QString &desktopFile, const QString &action, QObject *requester)
+{
+    const QString id = action.isEmpty() ? desktopFile : desktopFile + LAUNCH_ACTION_MARKER + action;
+    return start(id, desktopFile, desktopFile, action, QString(), requester);
+}
+
+bool LaunchManager::launchCommand(const QString &command, QObject *requester)
+{
+    return start(command, command, QString(), QString(), command, requester);
+}
+
+bool LaunchManager::start(const QString &id, const QString &app, const QString &desktopFile,
+                          const QString &action, const QString &command, QObject *requester)
+{
+    if (mPending.contains(id))
+    {
+        qDebug() << "Launch of" << id << "is still pending, ignoring";
+        return false;
+    }
+
+    Pending &pending = mPending[id];
+    pending.clock.start();
+    pending.app = app;
+    pending.requester = requester;
+    // 命令行由 QProcess 自己拆分，无法带上环境变量，只能靠 pid 和 WM_CLASS 匹配
+    if (command.isEmpty())
+        pending.startupId = KStartupInfo::createNewStartupId();
+    pending.pid = 0;
+    if (!mExpireTimer->isActive())
+        mExpireTimer->start();
+
+    QThreadPool::globalInstance()->start(new LaunchJob(this, LaunchJob::Launch, id, desktopFile,
+                                                       action, command, pending.startupId));
+    return true;
+}
+
+void LaunchManager::prewarm(const QString &desktopFile)
+{
+    if (desktopFile.isEmpty() || mPrewarmed.contains(desktopFile))
+        return;
+    mPrewarmed.insert(desktopFile);
+    QThreadPool::globalInstance()->start(new LaunchJob(this, LaunchJob::Prewarm, desktopFile, desktopFile, QString(), QString()));
+}
+
+/* 按名字在图标主题里找一遍，结果留在 QIcon 的缓存里，按钮之后直接用 */
+void LaunchManager::prewarmIcon(const QString &iconName)
+{
+    if (QFileInfo(iconName).isAbsolute())
+        return;
+    XdgIcon::fromTheme(iconName).availableSizes();
+}
+
+XdgDesktopFile LaunchManager::entry(const QString &desktopFile)
+{
+    const QDateTime modified = QFileInfo(desktopFile).lastModified();
+    {
+        QMutexLocker locker(&mEntriesMutex);
+        auto it = mEntries.constFind(desktopFile);
+        if (it != mEntries.constEnd() && it->modified == modified)
+            return it->xdg;
+    }
+
+    Entry entry;
+    entry.modified = modified;
+    entry.xdg.load(desktopFile);
+
+    QMutexLocker locker(&mEntriesMutex);
+    mEntries.insert(desktopFile, entry);
+    return entry.xdg;
+}
+
+void LaunchManager::spawned(const QString &id, bool ok, qint64 pid, const QStringList &classes)
+{
+    auto it = mPending.find(id);
+    if (it == mPending.end())
+        return;
+
+    if (!ok)
+    {
+        qWarning() << "Failed to launch" << id;
+        const QPointer<QObject> requester = it->requester;
+        mPending.erase(it);
+        if (requester)
+            QMetaObject::invokeMethod(requester, "launchFailed", Q_ARG(QString, id));
+        emit launchFailed(id);
+        return;
+    }
+
+    it->pid = pid;
+    for (const QString &cls : classes)
+    {
+        if (!cls.isEmpty())
+            it->classes.insert(cls.toLower());
+    }
+}
+
+QHash<QString, LaunchManager::Pending>::iterator LaunchManager::findPending(WId window)
+{
+    KWindowInfo info(window, NET::WMPid, NET::WM2WindowClass | NET::WM2StartupId);
+    const QByteArray startupId = info.startupId();
+    const QString className = QString::fromUtf8(info.windowClassClass()).toLower();
+    const QString resourceName = QString::fromUtf8(info.windowClassName()).toLower();
+
+    // 启动通知 id 是确定的匹配，优先于 pid 和 WM_CLASS 的猜测
+    auto match = mPending.end();
+    for (auto it = mPending.begin(); it != mPending.end(); ++it)
+    {
+        if (!startupId.isEmpty() && it->startupId == startupId)
+        {
+            match = it;
+            break;
+        }
+        if (match == mPending.end()
+                && ((it->pid > 0 && it->pid == info.pid())
+                    || it->classes.contains(className) || it->classes.contains(resourceName)))
+            match = it;
+    }
+    return match;
+}
+
+void LaunchManager::windowAdded(WId window)
+{
+    if (mPending.isEmpty())
+        return;
+
+    auto match = findPending(window);
+    if (match == mPending.end())
+        return;
+
+    const QString id = match.key();
+    const QString app = match->app;
+    const qint64 msecs = match->clock.elapsed();
+    mPending.erase(match);
+    record(app, id, msecs);
+    emit launchFinished(id, msecs);
+}
+
+/* 单实例应用只把已有的窗口提到前面，没有新窗口；不计入启动耗时 */
+void LaunchManager::windowActivated(WId window)
+{
+    if (mPending.isEmpty() || window == 0)
+        return;
+
+    auto match = findPending(window);
+    if (match == mPending.end())
+        return;
+
+    const QString id = match.key();
+    const qint64 msecs = match->clock.elapsed();
+    mPending.erase(match);
+    qDebug() << "Launch of" << id << "raised an existing window";
+    emit launchFinished(id, msecs);
+}
+
+void LaunchManager::expire()
+{
+    for (auto it = mPending.begin(); it != mPending.end();)
+    {
+        if (it->clock.hasExpired(LAUNCH_TIMEOUT))
+        {
+            qDebug() << "No window showed up for" << it.key() << "within" << LAUNCH_TIMEOUT << "ms";
+            it = mPending.erase(it);
+        }
+        // 进程把请求交给已运行的实例后就退出了
+        else if (it->pid > 0 && ::kill(pid_t(it->pid), 0) != 0 && errno == ESRCH)
+        {
+            qDebug() << "Launched process of" << it.key() << "exited without a window";
+            it = mPending.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+    if (mPending.isEmpty())
+        mExpireTimer->stop();
+}
+
+void LaunchManager::record(const QString &app, const QString &id, qint64 msecs)
+{
+    QVector<int> &histogram = mHistograms[app];
+    if (histogram.isEmpty())
+        histogram.fill(0, LatencyBuckets);
+
+    int bucket = 0;
+    while (bucket < LatencyBuckets - 1 && msecs >= LatencyBounds[bucket])
+        ++bucket;
+    ++histogram[bucket];
+    qDebug() << "Launched" << id << "in" << msecs << "ms";
+}
+
+QString LaunchManager::report() const
+{
+    QStringList lines;
+    for (auto it = mHistograms.constBegin(); it != mHistograms.constEnd(); ++it)
+    {
+        QStringList buckets;
+        for (int i = 0; i < LatencyBuckets; ++i)
+        {
+            const QString label = i < LatencyBuckets - 1
+                    ? QString("<%1ms").arg(LatencyBounds[i])
+                    : QString(">=%1ms").arg(LatencyBounds[LatencyBuckets - 2]);
+            buckets << QString("%1:%2").arg(label).arg(it.value().at(i));
+        }
+        lines << it.key() + ' ' + buckets.join(' ');
+    }
+    return lines.join('\n');
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#ifndef LAUNCHMANAGER_H
+#define LAUNCHMANAGER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QPointer>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <QWidget>
+#include <QDateTime>
+#include <XdgDesktopFile>
+#include "ukuipanelglobals.h"
+
+class QTimer;
+
+/*! \brief Starts applications for the quicklaunch and the taskbar.
+ *
+ * Spawning runs on the global thread pool so a slow exec (NFS home, cold
+ * page cache) can't stall the panel. Each launch stays pending from the
+ * click until the first window that belongs to it is mapped, matched by
+ * its startup notification id (DESKTOP_STARTUP_ID / _NET_STARTUP_ID), by
+ * pid or by WM_CLASS against StartupWMClass / the exec name / the desktop
+ * file name. A second click on the same entry while it is pending is
+ * dropped, which is what users double clicking a slow application expect.
+ * A launch also stops pending when its process exits (it handed off to a
+ * running instance) or when a matching existing window is activated, and
+ * after a few seconds at the latest.
+ *
+ * Click-to-window latency is recorded per application into a small
+ * histogram, see report().
+ */
+class UKUI_PANEL_API LaunchManager : public QObject
+{
+    Q_OBJECT
+public:
+    static LaunchManager *instance();
+
+    /*! returns false if the entry is already starting. If the spawn fails
+     * the slot launchFailed(QString) of requester is invoked, so only the
+     * button that was clicked reports it.
+     */
+    bool launch(const QString &desktopFile, const QString &action = QString(), QObject *requester = nullptr);
+    bool launchCommand(const QString &command, QObject *requester = nullptr);
+    bool isPending(const QString &id) const { return mPending.contains(id); }
+
+    //! parse the desktop entry, look up its icon in the theme and pull the executable
+    //! into the page cache ahead of a click
+    void prewarm(const QString &desktopFile);
+
+    //! parsed desktop entry, thread safe, reparses the entry only when the file changed
+    XdgDesktopFile entry(const QString &desktopFile);
+
+    //! human readable latency histograms, one line per application
+    QString report() const;
+
+signals:
+    void launchFailed(const QString &id);
+    void launchFinished(const QString &id, qint64 msecs);
+
+private slots:
+    void spawned(const QString &id, bool ok, qint64 pid, const QStringList &classes);
+    void prewarmIcon(const QString &iconName);
+    void windowAdded(WId window);
+    void windowActivated(WId window);
+    void expire();
+
+private:
+    explicit LaunchManager(QObject *parent = nullptr);
+    bool start(const QString &id, const QString &app, const QString &desktopFile,
+               const QString &action, const QString &command, QObject *requester);
+    void record(const QString &app, const QString &id, qint64 msecs);
+
+    friend class LaunchJob;
+
+    struct Pending
+    {
+        QElapsedTimer clock;
+        QString app;                    // histogram key: desktop file or command
+        QPointer<QObject> requester;
+        QByteArray startupId;
+        qint64 pid;
+        QSet<QString> classes;
+    };
+    QHash<QString, Pending>::iterator findPending(WId window);
+
+    QHash<QString, Pending> mPending;
+    QTimer *mExpireTimer;
+    QMap<QString, QVector<int> > mHistograms;
+    QSet<QString> mPrewarmed;
+
+    struct Entry
+    {
+        QDateTime modified;
+        XdgDesktopFile xdg;
+    };
+    QMutex mEntriesMutex;
+    QHash<QString, Entry> mEntries;
+};
+
+#endif // LAUNCHMANAGER_H
@@ -25,6 +25,7 @@
 
 
 #include "ukuipanelapplication.h"
+#include "pluginhostprocess.h"
 #include <QTranslator>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -85,6 +86,10 @@ int main(int argc, char *argv[])
     #endif
     }
 
+    // a helper process running one isolated plugin, see PluginHost
+    if (argc > 1 && qstrcmp(argv[1], "--plugin-host") == 0)
+        return PluginHostProcess::exec(argc, argv);
+
     UKUIPanelApplication app(argc, argv);
 
     //Singleton
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include "painttracer.h"
+
+#include <QDBusConnection>
+#include <QStringList>
+#include <QWidget>
+
+#define TRACER_DBUS_PATH        "/painttracer"
+// a stamp older than this is not waiting for a paint anymore
+#define TRACER_STALE_NSECS      (1000LL * 1000 * 1000)
+
+static const int TraceBounds[] = { 1, 2, 4, 8, 16, 33, 66, 133, 266, 533 };     // ms
+static const int TraceBuckets = sizeof(TraceBounds) / sizeof(TraceBounds[0]) + 1;
+
+bool PaintTracer::sEnabled = false;
+
+PaintTracer *PaintTracer::instance()
+{
+    static PaintTracer *tracer = new PaintTracer;
+    return tracer;
+}
+
+PaintTracer::PaintTracer(QObject *parent)
+    : QObject(parent)
+{
+    mClock.start();
+    QDBusConnection::sessionBus().registerObject(QStringLiteral(TRACER_DBUS_PATH), this,
+                                                 QDBusConnection::ExportScriptableSlots);
+    if (qgetenv("UKUI_PANEL_TRACE_PAINT") == "1")
+        sEnabled = true;
+}
+
+void PaintTracer::setEnabled(bool enabled)
+{
+    sEnabled = enabled;
+    if (!enabled)
+        mPending.clear();
+}
+
+void PaintTracer::stamp(QWidget *widget, const char *source)
+{
+    if (!widget)
+        return;
+
+    const qint64 now = mClock.nsecsElapsed();
+    auto it = mPending.find(widget);
+    if (it == mPending.end())
+    {
+        mPending.insert(widget, Stamp{source, now});
+        if (!mWatched.contains(widget))
+        {
+            mWatched.insert(widget);
+            connect(widget, &QObject::destroyed, this, [this, widget] {
+                mPending.remove(widget);
+                mWatched.remove(widget);
+            });
+        }
+        return;
+    }
+
+    // an older unpainted stamp is kept, the paint answers both events
+    if (now - it->nsecs > TRACER_STALE_NSECS)
+    {
+        ++mHistograms[it->source].dropped;
+        *it = Stamp{source, now};
+    }
+}
+
+void PaintTracer::painted(QWidget *widget)
+{
+    auto it = mPending.find(widget);
+    if (it == mPending.end())
+        return;
+
+    const qint64 nsecs = mClock.nsecsElapsed() - it->nsecs;
+    Histogram &histogram = mHistograms[it->source];
+    mPending.erase(it);
+
+    if (nsecs > TRACER_STALE_NSECS)
+    {
+        ++histogram.dropped;
+        return;
+    }
+
+    if (histogram.buckets.isEmpty())
+        histogram.buckets.fill(0, TraceBuckets);
+    const qint64 msecs = nsecs / 1000000;
+    int bucket = 0;
+    while (bucket < TraceBuckets - 1 && msecs >= TraceBounds[bucket])
+        ++bucket;
+    ++histogram.buckets[bucket];
+    ++histogram.count;
+    histogram.maxUsecs = qMax(histogram.maxUsecs, nsecs / 1000);
+}
+
+QString PaintTracer::report() const
+{
+    QString result = QStringLiteral("tracing %1, %2 stamps waiting for a paint\n")
+            .arg(sEnabled ? QStringLiteral("on") : QStringLiteral("off"))
+            .arg(mPending.size());
+    for (auto it = mHistograms.constBegin(); it != mHistograms.constEnd(); ++it)
+    {
+        const Histogram &histogram = it.value();
+        QStringList buckets;
+        for (int i = 0; i < histogram.buckets.size(); ++i)
+        {
+            const QString label = i < TraceBuckets - 1
+                    ? QString("<%1ms").arg(TraceBounds[i])
+                    : QString(">=%1ms").arg(TraceBounds[TraceBuckets - 2]);
+            buckets << QString("%1:%2").arg(label).arg(histogram.buckets.at(i));
+        }
+        result += QStringLiteral("%1: %2 painted, %3 dropped, max %4 us %5\n")
+                .arg(QString::fromLatin1(it.key()))
+                .arg(histogram.count)
+                .arg(histogram.dropped)
+                .arg(histogram.maxUsecs)
+                .arg(buckets.join(QLatin1Char(' ')));
+    }
+    return result;
+}
+
+void PaintTracer::reset()
+{
+    mPending.clear();
+    mHistograms.clear();
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#ifndef PAINTTRACER_H
+#define PAINTTRACER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include "ukuipanelglobals.h"
+
+class QWidget;
+
+/*! \brief Latency from an event to the paint it causes.
+ *
+ * The code handling an event (an X damage event, a window property change,
+ * a StatusNotifierItem signal, a clock tick) calls trace() for the widget
+ * that will repaint because of it. UKUIPanelApplication::notify() reports
+ * every finished paint event, and the time since the oldest stamp of that
+ * widget goes into a histogram of the stamp's source.
+ *
+ * Stamps that are not painted within a second (the widget was hidden, or
+ * the change didn't need a repaint) are counted as dropped and replaced by
+ * the next stamp.
+ *
+ * Disabled by default, trace() then only tests a flag. It is enabled by
+ * UKUI_PANEL_TRACE_PAINT=1 or setEnabled() on the session bus
+ * (com.ukui.panel.debug.PaintTracer at /painttracer), report() dumps the
+ * histograms.
+ */
+class UKUI_PANEL_API PaintTracer : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "com.ukui.panel.debug.PaintTracer")
+public:
+    static PaintTracer *instance();
+
+    static bool isEnabled() { return sEnabled; }
+
+    //! stamps widget with an event of source, source must be a string literal
+    static void trace(QWidget *widget, const char *source)
+    {
+        if (sEnabled)
+            instance()->stamp(widget, source);
+    }
+
+    //! called after widget handled a paint event
+    void painted(QWidget *widget);
+
+public slots:
+    Q_SCRIPTABLE void setEnabled(bool enabled);
+    //! one line per source: count, dropped stamps, histogram, worst case
+    Q_SCRIPTABLE QString report() const;
+    Q_SCRIPTABLE void reset();
+
+private:
+    explicit PaintTracer(QObject *parent = nullptr);
+
+    struct Stamp
+    {
+        const char *source;
+        qint64 nsecs;
+    };
+    struct Histogram
+    {
+        Histogram() : count(0), dropped(0), maxUsecs(0) {}
+        qint64 count;
+        qint64 dropped;
+        qint64 maxUsecs;
+        QVector<qint64> buckets;
+    };
+
+    void stamp(QWidget *widget, const char *source);
+
+    static bool sEnabled;
+    QElapsedTimer mClock;
+    QHash<QWidget *, Stamp> mPending;
+    QSet<QWidget *> mWatched;       // widgets whose destruction is connected
+    QMap<QByteArray, Histogram> mHistograms;
+};
+
+#endif // PAINTTRACER_H
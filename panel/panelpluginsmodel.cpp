@@ -25,6 +25,8 @@
 
 #include "panelpluginsmodel.h"
 #include "plugin.h"
+#include "pluginregistry.h"
+#include "stagedpluginloader.h"
 #include "iukuipanelplugin.h"
 #include "ukuipanel.h"
 #include "ukuipanelapplication.h"
@@ -40,13 +42,18 @@ PanelPluginsModel::PanelPluginsModel(UKUIPanel * panel,
                                      QObject * parent/* = nullptr*/)
     : QAbstractListModel{parent},
     mNamesKey(namesKey),
-    mPanel(panel)
+    mPanel(panel),
+    mLoader(new StagedPluginLoader(panel, this))
 {
+    connect(mLoader, &StagedPluginLoader::pluginLoaded, this, [this] (Plugin *plugin) { deferredPluginFinished(plugin, true); });
+    connect(mLoader, &StagedPluginLoader::pluginFailed, this, [this] (Plugin *plugin) { deferredPluginFinished(plugin, false); });
     loadPlugins(desktopDirs);
 }
 
 PanelPluginsModel::~PanelPluginsModel()
 {
+    //先等待还在准备中的插件
+    delete mLoader;
     qDeleteAll(plugins());
 }
 
@@ -216,6 +223,9 @@ void PanelPluginsModel::movePlugin(Plugin * plugin, QString const & nameAfter)
 void PanelPluginsModel::loadPlugins(QStringList const & desktopDirs)
 {
     QStringList plugin_names = mPanel->settings()->value(mNamesKey).toStringList();
+    //所有插件共用一次目录扫描的结果
+    PluginRegistry *registry = PluginRegistry::instance();
+    registry->scan(desktopDirs);
 #ifdef DEBUG_PLUGIN_LOADTIME
     QElapsedTimer timer;
     timer.start();
@@ -250,14 +260,14 @@ void PanelPluginsModel::loadPlugins(QStringList const & desktopDirs)
         }
 #endif
 
-        UKUi::PluginInfoList list = UKUi::PluginInfo::search(desktopDirs, "UKUIPanel/Plugin", QString("%1.desktop").arg(type));
-        if( !list.count())
+        if (!registry->contains(type))
         {
             qWarning() << QString("Plugin \"%1\" not found.").arg(type);
             continue;
         }
 
-        i->second = loadPlugin(list.first(), name);
+        const UKUi::PluginInfo info = registry->info(type);
+        i->second = loadPlugin(info, name, info.value("X-UKUI-Panel-Deferred").toBool());
 #ifdef DEBUG_PLUGIN_LOADTIME
         qDebug() << "load plugin" << type << "takes" << (timer.elapsed() - lastTime) << "ms";
         lastTime = timer.elapsed();
@@ -265,10 +275,12 @@ void PanelPluginsModel::loadPlugins(QStringList const & desktopDirs)
     }
 }
 
-QPointer<Plugin> PanelPluginsModel::loadPlugin(UKUi::PluginInfo const & desktopFile, QString const & settingsGroup)
+QPointer<Plugin> PanelPluginsModel::loadPlugin(UKUi::PluginInfo const & desktopFile, QString const & settingsGroup, bool deferred)
 {
-    std::unique_ptr<Plugin> plugin(new Plugin(desktopFile, mPanel->settings(), settingsGroup, mPanel));
-    if (plugin->isLoaded())
+    std::unique_ptr<Plugin> plugin(new Plugin(desktopFile, mPanel->settings(), settingsGroup, mPanel, deferred));
+    if (plugin->isPending())
+        mLoader->enqueue(plugin.get());
+    if (plugin->isLoaded() || plugin->isPending())
     {
         connect(mPanel, &UKUIPanel::realigned, plugin.get(), &Plugin::realign);
         connect(plugin.get(), &Plugin::remove,
@@ -279,6 +291,23 @@ QPointer<Plugin> PanelPluginsModel::loadPlugin(UKUi::PluginInfo const & desktopF
     return nullptr;
 }
 
+void PanelPluginsModel::deferredPluginFinished(Plugin * plugin, bool loaded)
+{
+    for (int row = 0; row < mPlugins.size(); ++row)
+    {
+        if (mPlugins[row].second != plugin)
+            continue;
+
+        if (!loaded)
+        {
+            mPlugins[row].second = nullptr;
+            plugin->deleteLater();
+        }
+        emit dataChanged(index(row), index(row));
+        return;
+    }
+}
+
 QString PanelPluginsModel::findNewPluginSettingsGroup(const QString &pluginType) const
 {
     QStringList groups = mPanel->settings()->childGroups();
@@ -357,7 +386,7 @@ void PanelPluginsModel::onConfigurePlugin(QModelIndex const & index)
         return;
 
     Plugin * const plugin = mPlugins[index.row()].second.data();
-    if (nullptr != plugin && (IUKUIPanelPlugin::HaveConfigDialog & plugin->iPlugin()->flags()))
+    if (nullptr != plugin && nullptr != plugin->iPlugin() && (IUKUIPanelPlugin::HaveConfigDialog & plugin->iPlugin()->flags()))
         plugin->showConfigureDialog();
 }
 
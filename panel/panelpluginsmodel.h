@@ -37,6 +37,7 @@ namespace UKUi
 
 class UKUIPanel;
 class Plugin;
+class StagedPluginLoader;
 
 /*!
  * \brief The PanelPluginsModel class implements the Model part of the
@@ -280,9 +281,11 @@ private:
      * \param settingsGroup QString which specifies the settings group. This
      * will only be redirected to the Plugin so that it knows how to read
      * its settings.
+     * \param deferred Create only a placeholder and hand the Plugin to the
+     * StagedPluginLoader.
      * \return A QPointer to the Plugin that was loaded.
      */
-    QPointer<Plugin> loadPlugin(UKUi::PluginInfo const & desktopFile, QString const & settingsGroup);
+    QPointer<Plugin> loadPlugin(UKUi::PluginInfo const & desktopFile, QString const & settingsGroup, bool deferred = false);
     /*!
      * \brief findNewPluginSettingsGroup Creates a name for a new Plugin
      * that is not yet present in the settings file. Whenever multiple
@@ -310,6 +313,11 @@ private:
      * \brief removePlugin Removes a given Plugin from the model.
      */
     void removePlugin(pluginslist_t::iterator plugin);
+    /*!
+     * \brief deferredPluginFinished Updates the row of a Plugin that was
+     * loaded by the StagedPluginLoader, drops it if loading failed.
+     */
+    void deferredPluginFinished(Plugin * plugin, bool loaded);
 
     /*!
      * \brief mNamesKey The key to the settings-entry that stores the
@@ -335,6 +343,11 @@ private:
      * \brief mPanel Stores a reference to the UKUIPanel.
      */
     UKUIPanel * mPanel;
+    /*!
+     * \brief mLoader Loads the Plugins marked as deferred after the panel
+     * is shown.
+     */
+    StagedPluginLoader * mLoader;
 };
 
 Q_DECLARE_METATYPE(Plugin const *)
@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include "panelstats.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QTimer>
+
+#include <unistd.h>
+#include <sys/resource.h>
+
+PanelStats *PanelStats::instance()
+{
+    static PanelStats *stats = new PanelStats;
+    return stats;
+}
+
+PanelStats::PanelStats(QObject *parent)
+    : QObject(parent),
+      mTimer(new QTimer(this)),
+      mColdStart(-1),
+      mLastCpu(0)
+{
+    connect(mTimer, &QTimer::timeout, this, &PanelStats::write);
+}
+
+void PanelStats::start(const QString &path, int interval)
+{
+    mPath = path;
+    mLastCpu = cpuTime(nullptr, nullptr);
+    mLastSnapshot.start();
+    mTimer->start(interval);
+    connect(qApp, &QCoreApplication::aboutToQuit, this, &PanelStats::write, Qt::UniqueConnection);
+}
+
+void PanelStats::startupFinished()
+{
+    if (mColdStart >= 0)
+        return;
+    mColdStart = processAge();
+    if (isEnabled())
+        write();
+}
+
+void PanelStats::addSection(const QString &name, Section section)
+{
+    mSections.insert(name, section);
+}
+
+void PanelStats::removeSection(const QString &name)
+{
+    mSections.remove(name);
+}
+
+QJsonObject PanelStats::snapshot()
+{
+    qint64 user = 0;
+    qint64 system = 0;
+    const qint64 cpu = cpuTime(&user, &system);
+    const qint64 wall = mLastSnapshot.isValid() ? mLastSnapshot.restart() : 0;
+
+    QJsonObject cpuObject;
+    cpuObject.insert(QStringLiteral("userMs"), user);
+    cpuObject.insert(QStringLiteral("systemMs"), system);
+    // since the previous snapshot, 100 is one core fully busy
+    cpuObject.insert(QStringLiteral("percent"), wall > 0 ? 100.0 * (cpu - mLastCpu) / wall : 0.0);
+    mLastCpu = cpu;
+
+    QJsonObject sections;
+    for (auto it = mSections.constBegin(); it != mSections.constEnd(); ++it)
+        sections.insert(it.key(), it.value()());
+
+    QJsonObject result;
+    result.insert(QStringLiteral("pid"), QCoreApplication::applicationPid());
+    result.insert(QStringLiteral("uptimeMs"), processAge());
+    result.insert(QStringLiteral("coldStartMs"), mColdStart);
+    result.insert(QStringLiteral("cpu"), cpuObject);
+    result.insert(QStringLiteral("rssKb"), residentSize());
+    result.insert(QStringLiteral("sections"), sections);
+    return result;
+}
+
+void PanelStats::write()
+{
+    if (!isEnabled())
+        return;
+
+    // readers never see a half written file
+    QSaveFile file(mPath);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "PanelStats: can't write" << mPath << file.errorString();
+        return;
+    }
+    file.write(QJsonDocument(snapshot()).toJson(QJsonDocument::Indented));
+    file.commit();
+}
+
+qint64 PanelStats::processAge()
+{
+    // field 22 of /proc/self/stat is the start time in clock ticks since boot
+    QFile stat(QStringLiteral("/proc/self/stat"));
+    QFile uptime(QStringLiteral("/proc/uptime"));
+    if (!stat.open(QIODevice::ReadOnly) || !uptime.open(QIODevice::ReadOnly))
+        return -1;
+
+    const QByteArray line = stat.readAll();
+    const QList<QByteArray> fields = line.mid(line.lastIndexOf(')') + 2).split(' ');
+    if (fields.size() < 20)
+        return -1;
+
+    const double started = fields.at(19).toLongLong() / double(sysconf(_SC_CLK_TCK));
+    const double now = uptime.readAll().split(' ').value(0).toDouble();
+    return qint64((now - started) * 1000);
+}
+
+qint64 PanelStats::cpuTime(qint64 *user, qint64 *system)
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return 0;
+
+    const qint64 u = usage.ru_utime.tv_sec * 1000 + usage.ru_utime.tv_usec / 1000;
+    const qint64 s = usage.ru_stime.tv_sec * 1000 + usage.ru_stime.tv_usec / 1000;
+    if (user)
+        *user = u;
+    if (system)
+        *system = s;
+    return u + s;
+}
+
+qint64 PanelStats::residentSize()
+{
+    // the second field of /proc/self/statm is the resident set in pages
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly))
+        return -1;
+    const qint64 pages = statm.readAll().split(' ').value(1).toLongLong();
+    return pages * sysconf(_SC_PAGESIZE) / 1024;
+}
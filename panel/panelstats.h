@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#ifndef PANELSTATS_H
+#define PANELSTATS_H
+
+#include <functional>
+#include <QObject>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QMap>
+#include <QString>
+#include "ukuipanelglobals.h"
+
+class QTimer;
+
+/*! \brief Machine-readable performance snapshots of the running panel.
+ *
+ * Disabled unless the panel is started with --stats FILE. Then a JSON object
+ * with the cold start time, the CPU usage since the previous snapshot, the
+ * resident set size and one entry per registered section is written to FILE
+ * every second and on quit. This is meant for an external benchmark harness
+ * (a nested X server, scripted clients and an isolated -c config) that reads
+ * the file for regression tracking.
+ *
+ * Subsystems register sections with addSection(); a section is only
+ * evaluated while writing a snapshot.
+ */
+class UKUI_PANEL_API PanelStats : public QObject
+{
+    Q_OBJECT
+public:
+    typedef std::function<QJsonValue ()> Section;
+
+    static PanelStats *instance();
+
+    //! starts writing snapshots to path every interval ms
+    void start(const QString &path, int interval = 1000);
+    bool isEnabled() const { return !mPath.isEmpty(); }
+
+    //! ends the cold start measurement, only the first call counts
+    void startupFinished();
+
+    //! adds or replaces the section name of every snapshot
+    void addSection(const QString &name, Section section);
+    void removeSection(const QString &name);
+
+    QJsonObject snapshot();
+
+    //! resident set size of the panel process in kB
+    static qint64 residentSize();
+
+public slots:
+    void write();
+
+private:
+    explicit PanelStats(QObject *parent = nullptr);
+
+    static qint64 processAge();
+    static qint64 cpuTime(qint64 *user, qint64 *system);
+
+    QString mPath;
+    QTimer *mTimer;
+    QMap<QString, Section> mSections;
+    qint64 mColdStart;
+    qint64 mLastCpu;
+    QElapsedTimer mLastSnapshot;
+};
+
+#endif // PANELSTATS_H
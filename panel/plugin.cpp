@@ -28,6 +28,9 @@
 #include "iukuipanelplugin.h"
 #include "pluginsettings_p.h"
 #include "ukuipanel.h"
+#include "pluginregistry.h"
+#include "pluginprofiler.h"
+#include "pluginhost.h"
 #include <QDebug>
 #include <QProcessEnvironment>
 #include <QStringList>
@@ -119,61 +122,84 @@ QColor Plugin::mMoveMarkerColor= QColor(255, 0, 0, 255);
 /************************************************
 
  ************************************************/
-Plugin::Plugin(const UKUi::PluginInfo &desktopFile, UKUi::Settings *settings, const QString &settingsGroup,UKUIPanel *panel) :
+Plugin::Plugin(const UKUi::PluginInfo &desktopFile, UKUi::Settings *settings, const QString &settingsGroup,UKUIPanel *panel, bool deferred) :
     QFrame(panel),
     mDesktopFile(desktopFile),
     mPluginLoader(0),
     mPlugin(0),
     mPluginWidget(0),
     mAlignment(AlignLeft),
-    mPanel(panel)
+    mPanel(panel),
+    mPending(false)
 {
     mSettings = PluginSettingsFactory::create(settings, settingsGroup);
 
     setWindowTitle(desktopFile.name());
     mName = desktopFile.name();
 
-    QStringList dirs;
-    dirs << QProcessEnvironment::systemEnvironment().value("UKUIPanel_PLUGIN_PATH").split(":");
-    dirs << PLUGIN_DIR;
+    // 没有保存过对齐方式时要等实例化后才知道默认值,只能立即加载
+    const QString s = mSettings->value("alignment").toString();
+    if (deferred && !s.isEmpty())
+    {
+        mPending = true;
+        mAlignment = (s.toUpper() == "RIGHT") ?
+                    Plugin::AlignRight :
+                    Plugin::AlignLeft;
+        setObjectName(desktopFile.id() + "Placeholder");
+        setMinimumSize(mPanel->panelSize(), mPanel->panelSize());
+        return;
+    }
+
+    load();
+}
+
+
+/************************************************
 
+ ************************************************/
+bool Plugin::load()
+{
+    mPending = false;
+
+    PluginRegistry *registry = PluginRegistry::instance();
     bool found = false;
-    if(IUKUIPanelPluginLibrary const * pluginLib = findStaticPlugin(desktopFile.id()))
+    switch (registry->origin(mDesktopFile.id()))
     {
+    case PluginRegistry::OriginStatic:
         // this is a static plugin
         found = true;
-        loadLib(pluginLib);
-    }
-    else {
+        loadLib(findStaticPlugin(mDesktopFile.id()));
+        break;
+    case PluginRegistry::OriginDynamic:
+    {
         // this plugin is a dynamically loadable module
-        QString baseName = QString("lib%1.so").arg(desktopFile.id());
-#if (QT_VERSION < QT_VERSION_CHECK(5,7,0))
-        for(int i=0;i<dirs.size();i++){
-            const QString &dirName=dirs.at(i);
-#endif
-#if (QT_VERSION >= QT_VERSION_CHECK(5,7,0))
-        for(const QString &dirName : qAsConst(dirs)){
-#endif
-
-            QFileInfo fi(QDir(dirName), baseName);
-            if (fi.exists())
-            {
-                found = true;
-                if (loadModule(fi.absoluteFilePath()))
-                    break;
-            }
+        found = true;
+        const QString cached = registry->libraryPath(mDesktopFile.id());
+        if (loadModule(cached))
+            break;
+        // like before the index: try the same module in the other library dirs
+        const QStringList paths = registry->libraryPaths(mDesktopFile.id());
+        for (const QString &path : paths)
+        {
+            if (path != cached && loadModule(path))
+                break;
         }
+        break;
+    }
+    default:
+        break;
     }
 
     if (!isLoaded())
     {
         if (!found)
-            qWarning() << QString("Plugin %1 not found in the").arg(desktopFile.id()) << dirs;
+            qWarning() << QString("Plugin %1 not found in the").arg(mDesktopFile.id()) << registry->libraryDirs();
 
-        return;
+        return false;
     }
 
     setObjectName(mPlugin->themeId() + "Plugin");
+    setMinimumSize(0, 0);
 
     // plugin handle for easy context menu
     setProperty("NeedsHandle", mPlugin->flags().testFlag(IUKUIPanelPlugin::NeedsHandle));
@@ -210,6 +236,7 @@ Plugin::Plugin(const UKUi::PluginInfo &desktopFile, UKUi::Settings *settings, co
     // while the plugin is still being initialized
     connect(mSettings, &PluginSettings::settingsChanged,
             this, &Plugin::settingsChanged);
+    return true;
 }
 
 
@@ -340,6 +367,13 @@ bool Plugin::loadLib(IUKUIPanelPluginLibrary const * pluginLib)
         mPluginWidget->setObjectName(mPlugin->themeId());
         watchWidgets(mPluginWidget);
     }
+
+    // event loop time below these objects belongs to this plugin
+    PluginProfiler *profiler = PluginProfiler::instance();
+    profiler->addRoot(this, mDesktopFile.id());
+    profiler->addRoot(mPluginWidget, mDesktopFile.id());
+    profiler->addRoot(dynamic_cast<QObject *>(mPlugin), mDesktopFile.id());
+
     this->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     return true;
 }
@@ -347,6 +381,13 @@ bool Plugin::loadLib(IUKUIPanelPluginLibrary const * pluginLib)
 // load dynamic plugin from a *.so module
 bool Plugin::loadModule(const QString &libraryName)
 {
+    // runs in a helper process, a crash there doesn't take the panel down
+    PluginHost *host = PluginHost::instance();
+    if (host->isIsolated(mDesktopFile.id(), libraryName, mSettings))
+        return loadLib(host->library(libraryName));
+
+    // a failed attempt from another library dir
+    delete mPluginLoader;
     mPluginLoader = new QPluginLoader(libraryName);
 
     if (!mPluginLoader->load())
@@ -406,7 +447,8 @@ void Plugin::unwatchWidgets(QObject * const widget)
  ************************************************/
 void Plugin::settingsChanged()
 {
-    mPlugin->settingsChanged();
+    if (mPlugin)
+        mPlugin->settingsChanged();
 }
 
 
@@ -417,7 +459,6 @@ void Plugin::saveSettings()
 {
     mSettings->setValue("alignment", (mAlignment == AlignLeft) ? "Left" : "Right");
     mSettings->setValue("type", mDesktopFile.id());
-    mSettings->sync();
 
 }
 
@@ -436,6 +477,9 @@ void Plugin::contextMenuEvent(QContextMenuEvent *event)
  ************************************************/
 void Plugin::mousePressEvent(QMouseEvent *event)
 {
+    if (!mPlugin)
+        return;
+
     switch (event->button())
     {
     case Qt::LeftButton:
@@ -457,7 +501,8 @@ void Plugin::mousePressEvent(QMouseEvent *event)
  ************************************************/
 void Plugin::mouseDoubleClickEvent(QMouseEvent*)
 {
-    mPlugin->activated(IUKUIPanelPlugin::DoubleClick);
+    if (mPlugin)
+        mPlugin->activated(IUKUIPanelPlugin::DoubleClick);
 }
 
 
@@ -511,7 +556,7 @@ QMenu *Plugin::popupMenu() const
  ************************************************/
 bool Plugin::isSeparate() const
 {
-   return mPlugin->isSeparate();
+   return mPlugin && mPlugin->isSeparate();
 }
 
 
@@ -520,7 +565,7 @@ bool Plugin::isSeparate() const
  ************************************************/
 bool Plugin::isExpandable() const
 {
-    return mPlugin->isExpandable();
+    return mPlugin && mPlugin->isExpandable();
 }
 
 
@@ -561,7 +606,7 @@ void Plugin::realign()
  ************************************************/
 void Plugin::showConfigureDialog()
 {
-    if (!mConfigDialog)
+    if (!mConfigDialog && mPlugin)
         mConfigDialog = mPlugin->configureDialog();
 
     if (!mConfigDialog)
@@ -58,14 +58,22 @@ public:
     };
 
 
-    explicit Plugin(const UKUi::PluginInfo &desktopFile, UKUi::Settings *settings, const QString &settingsGroup, UKUIPanel *panel);
+    /*!
+     * A deferred plugin is only a placeholder of the panel size until load()
+     * is called by the StagedPluginLoader.
+     */
+    explicit Plugin(const UKUi::PluginInfo &desktopFile, UKUi::Settings *settings, const QString &settingsGroup, UKUIPanel *panel, bool deferred = false);
     ~Plugin();
 
     bool isLoaded() const { return mPlugin != 0; }
+    bool isPending() const { return mPending; }
+    //! instantiate the plugin of a placeholder, false if it can't be loaded
+    bool load();
     Alignment alignment() const { return mAlignment; }
     void setAlignment(Alignment alignment);
 
     QString settingsGroup() const { return mSettings->group(); }
+    PluginSettings *settings() const { return mSettings; }
 
     void saveSettings();
 
@@ -87,6 +95,9 @@ public:
     static QColor moveMarkerColor() { return mMoveMarkerColor; }
     static void setMoveMarkerColor(QColor color) { mMoveMarkerColor = color; }
 
+    //! the library of a plugin linked into the panel, nullptr for *.so modules
+    static IUKUIPanelPluginLibrary const * findStaticPlugin(const QString &libraryName);
+
 public slots:
     void realign();
     void showConfigureDialog();
@@ -110,7 +121,6 @@ protected:
 private:
     bool loadLib(IUKUIPanelPluginLibrary const * pluginLib);
     bool loadModule(const QString &libraryName);
-    IUKUIPanelPluginLibrary const * findStaticPlugin(const QString &libraryName);
     void watchWidgets(QObject * const widget);
     void unwatchWidgets(QObject * const widget);
 
@@ -123,6 +133,7 @@ private:
     UKUIPanel *mPanel;
     static QColor mMoveMarkerColor;
     QString mName;
+    bool mPending;
     QPointer<QDialog> mConfigDialog; //!< plugin's config dialog (if any)
 
 private slots:
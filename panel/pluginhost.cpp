@@ -0,0 +1,484 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include "pluginhost.h"
+#include "pluginsettings.h"
+#include "common/ukuiplugininfo.h"
+
+#include <QApplication>
+#include <QDataStream>
+#include <QDebug>
+#include <QDBusConnection>
+#include <QDesktopWidget>
+#include <QEvent>
+#include <QHBoxLayout>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QProcess>
+#include <QStringList>
+#include <QTimer>
+#include <QWindow>
+#include <QtEndian>
+#include <algorithm>
+#include <sys/socket.h>
+#include <sys/types.h>
+
+#define HOST_DBUS_PATH          "/pluginhost"
+// restart delay after a crash, doubled up to the maximum while the host keeps crashing
+#define HOST_MIN_BACKOFF        1000
+#define HOST_MAX_BACKOFF        (60 * 1000)
+// a host running this long was not crash looping
+#define HOST_STABLE_MSECS       (60 * 1000)
+// a call not acknowledged within this time means the host hangs, it is killed and restarted
+#define HOST_ACK_TIMEOUT        5000
+
+void PluginHostProtocol::send(QLocalSocket *socket, const QString &command, const QVariantList &args)
+{
+    QByteArray message;
+    QDataStream stream(&message, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream << quint32(0) << command << args;
+    stream.device()->seek(0);
+    stream << quint32(message.size() - sizeof(quint32));
+    socket->write(message);
+}
+
+bool PluginHostProtocol::receive(QLocalSocket *socket, QString *command, QVariantList *args)
+{
+    quint32 size = 0;
+    if (socket->bytesAvailable() < qint64(sizeof(size)))
+        return false;
+    socket->peek(reinterpret_cast<char *>(&size), sizeof(size));
+    size = qFromBigEndian(size);
+    if (socket->bytesAvailable() < qint64(sizeof(size) + size))
+        return false;
+
+    socket->read(sizeof(size));
+    QDataStream stream(socket->read(size));
+    stream.setVersion(QDataStream::Qt_5_0);
+    stream >> *command >> *args;
+    return stream.status() == QDataStream::Ok;
+}
+
+// the size hint of an embedded plugin is the one its host reports
+class RemotePluginWidget : public QWidget
+{
+public:
+    RemotePluginWidget() : mHint(0, 0)
+    {
+        QHBoxLayout *layout = new QHBoxLayout(this);
+        layout->setContentsMargins(0, 0, 0, 0);
+        layout->setSpacing(0);
+    }
+
+    QSize sizeHint() const override { return mHint; }
+    void setHint(const QSize &hint)
+    {
+        if (hint == mHint)
+            return;
+        mHint = hint;
+        updateGeometry();
+    }
+
+private:
+    QSize mHint;
+};
+
+class RemotePluginLibrary : public IUKUIPanelPluginLibrary
+{
+public:
+    explicit RemotePluginLibrary(const QString &libraryPath) : mLibraryPath(libraryPath) {}
+
+    IUKUIPanelPlugin *instance(const IUKUIPanelPluginStartupInfo &startupInfo) const override
+    {
+        return new RemotePlugin(startupInfo, mLibraryPath);
+    }
+
+private:
+    QString mLibraryPath;
+};
+
+PluginHost *PluginHost::instance()
+{
+    static PluginHost *host = new PluginHost;
+    return host;
+}
+
+PluginHost::PluginHost(QObject *parent)
+    : QObject(parent)
+{
+    QDBusConnection::sessionBus().registerObject(QStringLiteral(HOST_DBUS_PATH), this,
+                                                 QDBusConnection::ExportScriptableSlots);
+}
+
+bool PluginHost::isIsolated(const QString &id, const QString &libraryPath, PluginSettings *settings) const
+{
+    if (settings && settings->value(QStringLiteral("isolated"), false).toBool())
+        return true;
+
+    const QStringList isolated = QString::fromLocal8Bit(qgetenv("UKUI_PANEL_ISOLATE_PLUGINS"))
+            .split(QLatin1Char(','), QString::SkipEmptyParts);
+    if (isolated.contains(id))
+        return true;
+    return isolated.contains(QStringLiteral("third-party"))
+            && !libraryPath.startsWith(QStringLiteral(PLUGIN_DIR));
+}
+
+const IUKUIPanelPluginLibrary *PluginHost::library(const QString &libraryPath)
+{
+    RemotePluginLibrary *&library = mLibraries[libraryPath];
+    if (!library)
+        library = new RemotePluginLibrary(libraryPath);
+    return library;
+}
+
+QString PluginHost::report() const
+{
+    QString result;
+    for (const RemotePlugin *plugin : mPlugins)
+        result += plugin->report() + QLatin1Char('\n');
+    return result;
+}
+
+RemotePlugin::RemotePlugin(const IUKUIPanelPluginStartupInfo &startupInfo, const QString &libraryPath)
+    : QObject(),
+      IUKUIPanelPlugin(startupInfo),
+      mId(startupInfo.desktopFile->id()),
+      mLibraryPath(libraryPath),
+      mThemeId(mId),
+      mFlags(NoFlags),
+      mSeparate(false),
+      mExpandable(false),
+      mWidget(new RemotePluginWidget),
+      mServer(new QLocalServer(this)),
+      mSocket(nullptr),
+      mProcess(nullptr),
+      mStopping(false),
+      mBackoff(HOST_MIN_BACKOFF),
+      mRestarts(0),
+      mHangs(0),
+      mEmbedMsecs(-1),
+      mSeq(0),
+      mCalls(0),
+      mCallNsecs(0),
+      mMaxCallNsecs(0),
+      mAckTimer(new QTimer(this))
+{
+    mClock.start();
+    mAckTimer->setSingleShot(true);
+    connect(mAckTimer, &QTimer::timeout, this, &RemotePlugin::ackTimeout);
+
+    static int serial = 0;
+    const QString name = QString("ukui-panel-%1-%2-%3")
+            .arg(QCoreApplication::applicationPid()).arg(mId).arg(++serial);
+    QLocalServer::removeServer(name);
+    mServer->setSocketOptions(QLocalServer::UserAccessOption);
+    connect(mServer, &QLocalServer::newConnection, this, &RemotePlugin::hostConnected);
+    if (!mServer->listen(name))
+        qWarning() << "Can't listen for the plugin host of" << mId << mServer->errorString();
+
+    // 插件位置变化时把新位置告诉宿主进程，弹窗才能摆对
+    mWidget->installEventFilter(this);
+
+    PluginHost::instance()->addPlugin(this);
+    start();
+}
+
+RemotePlugin::~RemotePlugin()
+{
+    PluginHost::instance()->removePlugin(this);
+    mStopping = true;
+    if (mProcess)
+    {
+        // 不在这里等宿主退出，结束后再回收
+        disconnect(mProcess, nullptr, this, nullptr);
+        mProcess->setParent(nullptr);
+        connect(mProcess, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+                mProcess, &QObject::deleteLater);
+        mProcess->kill();
+    }
+    delete mWidget;
+}
+
+bool RemotePlugin::eventFilter(QObject *watched, QEvent *event)
+{
+    switch (event->type())
+    {
+    case QEvent::Move:
+    case QEvent::Resize:
+        sendPanelState();
+        break;
+    case QEvent::Show:
+    case QEvent::ParentChange:
+        if (watched == mWidget && mWidget->window() != mWindow)
+        {
+            if (mWindow)
+                mWindow->removeEventFilter(this);
+            mWindow = mWidget->window();
+            if (mWindow != mWidget)
+                mWindow->installEventFilter(this);
+        }
+        if (event->type() == QEvent::Show)
+            sendPanelState();
+        break;
+    default:
+        break;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+QWidget *RemotePlugin::widget()
+{
+    return mWidget;
+}
+
+void RemotePlugin::start()
+{
+    if (mStopping)
+        return;
+
+    mProcess = new QProcess(this);
+    mProcess->setProcessChannelMode(QProcess::ForwardedChannels);
+    connect(mProcess, static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
+            this, &RemotePlugin::hostFinished);
+    connect(mProcess, &QProcess::errorOccurred, this, [this] (QProcess::ProcessError error) {
+        if (error == QProcess::FailedToStart)
+            hostFinished(-1);
+    });
+
+    mStarted.start();
+    mProcess->start(QCoreApplication::applicationFilePath(), QStringList()
+                    << QStringLiteral("--plugin-host")
+                    << mServer->serverName()
+                    << mLibraryPath
+                    << desktopFile()->fileName()
+                    << settings()->fileName()
+                    << settings()->group());
+}
+
+void RemotePlugin::hostConnected()
+{
+    QLocalSocket *socket = mServer->nextPendingConnection();
+    if (mSocket || !socket)
+    {
+        delete socket;
+        return;
+    }
+    if (!isHostProcess(socket))
+    {
+        qWarning() << "Rejected a connection to the plugin host socket of" << mId << "from another process";
+        delete socket;
+        return;
+    }
+
+    mSocket = socket;
+    connect(mSocket, &QLocalSocket::readyRead, this, &RemotePlugin::readMessages);
+    // the host creates the plugin once it knows the panel
+    sendPanelState();
+}
+
+bool RemotePlugin::isHostProcess(QLocalSocket *socket) const
+{
+    if (!mProcess || mProcess->processId() <= 0)
+        return false;
+
+    struct ucred cred;
+    socklen_t length = sizeof(cred);
+    if (getsockopt(int(socket->socketDescriptor()), SOL_SOCKET, SO_PEERCRED, &cred, &length) != 0)
+        return false;
+    return cred.pid == pid_t(mProcess->processId());
+}
+
+void RemotePlugin::readMessages()
+{
+    QString command;
+    QVariantList args;
+    while (mSocket && PluginHostProtocol::receive(mSocket, &command, &args))
+    {
+        if (command == QLatin1String("ack") && args.size() == 1)
+        {
+            const auto it = mPendingCalls.find(args.at(0).toUInt());
+            if (it == mPendingCalls.end())
+                continue;
+            const qint64 nsecs = mClock.nsecsElapsed() - it.value();
+            mPendingCalls.erase(it);
+            ++mCalls;
+            mCallNsecs += nsecs;
+            mMaxCallNsecs = qMax(mMaxCallNsecs, nsecs);
+            scheduleAckTimeout();
+        }
+        else if (command == QLatin1String("size") && args.size() == 1)
+        {
+            if (mWidget)
+                mWidget->setHint(args.at(0).toSize());
+        }
+        else if (command == QLatin1String("flags") && args.size() == 3)
+        {
+            setFlags(args);
+        }
+        else if (command == QLatin1String("embed") && args.size() == 6)
+        {
+            mEmbedMsecs = mStarted.elapsed();
+            mThemeId = args.at(1).toString();
+            embed(args.at(0).toULongLong());
+            if (mWidget)
+                mWidget->setHint(args.at(5).toSize());
+            setFlags(args.mid(2, 3));
+        }
+    }
+}
+
+void RemotePlugin::setFlags(const QVariantList &args)
+{
+    mFlags = Flags(args.at(0).toInt());
+    mSeparate = args.at(1).toBool();
+    mExpandable = args.at(2).toBool();
+    pluginFlagsChanged();
+}
+
+void RemotePlugin::embed(qulonglong window)
+{
+    if (!mWidget)
+        return;
+
+    // 窗口属于宿主进程，这里只是把它重新设置父窗口，没有 XEmbed 的焦点协议：
+    // 键盘焦点和 Tab 切换不会在面板和插件之间传递，插件弹出的输入框要自己抢焦点
+    delete mContainer;
+    QWindow *foreign = QWindow::fromWinId(WId(window));
+    mContainer = QWidget::createWindowContainer(foreign, mWidget);
+    mWidget->layout()->addWidget(mContainer);
+}
+
+void RemotePlugin::hostFinished(int exitCode)
+{
+    if (mSocket)
+    {
+        mSocket->deleteLater();
+        mSocket = nullptr;
+    }
+    mPendingCalls.clear();
+    mAckTimer->stop();
+    delete mContainer;
+    if (mProcess)
+    {
+        mProcess->deleteLater();
+        mProcess = nullptr;
+    }
+    if (mStopping)
+        return;
+
+    if (mStarted.elapsed() > HOST_STABLE_MSECS)
+        mBackoff = HOST_MIN_BACKOFF;
+    ++mRestarts;
+    qWarning() << "Plugin host of" << mId << "exited with" << exitCode << ", restarting in" << mBackoff << "ms";
+    QTimer::singleShot(mBackoff, this, &RemotePlugin::start);
+    mBackoff = qMin(mBackoff * 2, HOST_MAX_BACKOFF);
+}
+
+void RemotePlugin::call(const QString &command, QVariantList args)
+{
+    if (!mSocket)
+        return;
+
+    const quint32 seq = ++mSeq;
+    mPendingCalls.insert(seq, mClock.nsecsElapsed());
+    args.prepend(seq);
+    PluginHostProtocol::send(mSocket, command, args);
+    if (!mAckTimer->isActive())
+        scheduleAckTimeout();
+}
+
+// fires when the oldest unacknowledged call runs out of time
+void RemotePlugin::scheduleAckTimeout()
+{
+    if (mPendingCalls.isEmpty())
+    {
+        mAckTimer->stop();
+        return;
+    }
+    const qint64 oldest = *std::min_element(mPendingCalls.constBegin(), mPendingCalls.constEnd());
+    const qint64 waited = (mClock.nsecsElapsed() - oldest) / 1000000;
+    mAckTimer->start(int(qMax<qint64>(0, HOST_ACK_TIMEOUT - waited)));
+}
+
+void RemotePlugin::ackTimeout()
+{
+    if (!mProcess || mPendingCalls.isEmpty())
+        return;
+    const qint64 oldest = *std::min_element(mPendingCalls.constBegin(), mPendingCalls.constEnd());
+    if ((mClock.nsecsElapsed() - oldest) / 1000000 < HOST_ACK_TIMEOUT)
+    {
+        scheduleAckTimeout();
+        return;
+    }
+
+    // hostFinished() restarts it with the crash backoff
+    ++mHangs;
+    qWarning() << "Plugin host of" << mId << "did not answer" << mPendingCalls.size()
+               << "calls within" << HOST_ACK_TIMEOUT << "ms, killing it";
+    mProcess->kill();
+}
+
+void RemotePlugin::sendPanelState()
+{
+    if (!mSocket)
+        return;
+
+    IUKUIPanel *ukuiPanel = panel();
+    const QPoint pos = mWidget ? mWidget->mapToGlobal(QPoint(0, 0)) : QPoint();
+    const QRect screen = QApplication::desktop()->screenGeometry(mWidget);
+    PluginHostProtocol::send(mSocket, QStringLiteral("panel"), QVariantList()
+                             << int(ukuiPanel->position())
+                             << ukuiPanel->iconSize()
+                             << ukuiPanel->panelSize()
+                             << ukuiPanel->opacity()
+                             << ukuiPanel->lineCount()
+                             << ukuiPanel->globalGeometry()
+                             << pos
+                             << screen);
+}
+
+void RemotePlugin::settingsChanged()
+{
+    call(QStringLiteral("settingsChanged"));
+}
+
+void RemotePlugin::activated(ActivationReason reason)
+{
+    call(QStringLiteral("activated"), QVariantList() << int(reason));
+}
+
+void RemotePlugin::realign()
+{
+    sendPanelState();
+    call(QStringLiteral("realign"));
+}
+
+QString RemotePlugin::report() const
+{
+    return QStringLiteral("%1: pid %2, %3 restarts, %4 hangs, embedded after %5 ms, %6 calls avg %7 us max %8 us")
+            .arg(mId)
+            .arg(mProcess ? mProcess->processId() : 0)
+            .arg(mRestarts)
+            .arg(mHangs)
+            .arg(mEmbedMsecs)
+            .arg(mCalls)
+            .arg(mCalls ? mCallNsecs / mCalls / 1000 : 0)
+            .arg(mMaxCallNsecs / 1000);
+}
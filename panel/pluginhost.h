@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#ifndef PLUGINHOST_H
+#define PLUGINHOST_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QVariantList>
+#include "iukuipanelplugin.h"
+#include "ukuipanelglobals.h"
+
+class QLocalServer;
+class QLocalSocket;
+class QProcess;
+class QTimer;
+class RemotePlugin;
+class RemotePluginLibrary;
+class RemotePluginWidget;
+
+/*! Messages between the panel and a plugin host: a QString command and a
+ * QVariantList of arguments, framed by their length.
+ *
+ * panel -> host: "panel" (position, iconSize, panelSize, opacity, lineCount,
+ * globalGeometry, plugin position, screen geometry), "realign",
+ * "settingsChanged" and "activated" (reason), calls start with a sequence
+ * number the host acknowledges with "ack".
+ * host -> panel: "embed" (window, themeId, flags, separate, expandable,
+ * sizeHint), "size" (sizeHint), "flags" (flags, separate, expandable).
+ */
+namespace PluginHostProtocol
+{
+    void send(QLocalSocket *socket, const QString &command, const QVariantList &args = QVariantList());
+    //! takes the next complete message, false if there is none yet
+    bool receive(QLocalSocket *socket, QString *command, QVariantList *args);
+}
+
+/*! \brief Runs dynamic plugins in helper processes.
+ *
+ * An isolated plugin is not loaded into the panel. A RemotePlugin stands in
+ * for it, starts "ukui-panel --plugin-host" (PluginHostProcess) which loads
+ * the library, and embeds the window of the plugin widget. The window stays
+ * owned by the host and is only reparented, without XEmbed, so keyboard focus
+ * is not handed between the panel and the plugin. realign(),
+ * settingsChanged() and activated() are forwarded over a local socket. A
+ * crashed host is restarted with a growing delay, and so is a host that
+ * doesn't acknowledge a call within a few seconds, after it is killed. Only the current user can
+ * connect to the socket, and only the process the panel started is accepted.
+ *
+ * A plugin is isolated if its settings group has isolated=true, or its id is
+ * listed in UKUI_PANEL_ISOLATE_PLUGINS (comma separated; "third-party" means
+ * every library outside PLUGIN_DIR). report() is exported on the session bus
+ * as com.ukui.panel.debug.PluginHost at /pluginhost.
+ */
+class UKUI_PANEL_API PluginHost : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "com.ukui.panel.debug.PluginHost")
+public:
+    static PluginHost *instance();
+
+    bool isIsolated(const QString &id, const QString &libraryPath, PluginSettings *settings) const;
+    //! stands in for the library of an isolated plugin
+    const IUKUIPanelPluginLibrary *library(const QString &libraryPath);
+
+    void addPlugin(RemotePlugin *plugin) { mPlugins << plugin; }
+    void removePlugin(RemotePlugin *plugin) { mPlugins.removeAll(plugin); }
+
+public slots:
+    //! per isolated plugin: host pid, restarts, embedding time and call round trips
+    Q_SCRIPTABLE QString report() const;
+
+private:
+    explicit PluginHost(QObject *parent = nullptr);
+
+    QHash<QString, RemotePluginLibrary *> mLibraries;
+    QList<RemotePlugin *> mPlugins;
+};
+
+/*! \brief The panel side of a plugin running in a PluginHostProcess.
+ *
+ * Until the host has sent its first "embed" the flags are unknown, the
+ * configuration dialog of isolated plugins is not available.
+ */
+class RemotePlugin : public QObject, public IUKUIPanelPlugin
+{
+    Q_OBJECT
+public:
+    RemotePlugin(const IUKUIPanelPluginStartupInfo &startupInfo, const QString &libraryPath);
+    ~RemotePlugin();
+
+    QString themeId() const override { return mThemeId; }
+    Flags flags() const override { return mFlags; }
+    QWidget *widget() override;
+    void settingsChanged() override;
+    void activated(ActivationReason reason) override;
+    void realign() override;
+    bool isSeparate() const override { return mSeparate; }
+    bool isExpandable() const override { return mExpandable; }
+
+    QString report() const;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void start();
+    void hostConnected();
+    void readMessages();
+    void hostFinished(int exitCode);
+    void ackTimeout();
+
+private:
+    void call(const QString &command, QVariantList args = QVariantList());
+    void scheduleAckTimeout();
+    void sendPanelState();
+    void embed(qulonglong window);
+    void setFlags(const QVariantList &args);
+    bool isHostProcess(QLocalSocket *socket) const;
+
+    QString mId;
+    QString mLibraryPath;
+    QString mThemeId;
+    Flags mFlags;
+    bool mSeparate;
+    bool mExpandable;
+
+    QPointer<RemotePluginWidget> mWidget;
+    QPointer<QWidget> mContainer;
+    QPointer<QWidget> mWindow;  // the panel window, its moves change the plugin position
+    QLocalServer *mServer;
+    QLocalSocket *mSocket;
+    QProcess *mProcess;
+    bool mStopping;
+
+    QElapsedTimer mStarted;
+    int mBackoff;
+    int mRestarts;
+    int mHangs;                 // hosts killed for not acknowledging calls
+    qint64 mEmbedMsecs;         // -1 until the first embed
+
+    QElapsedTimer mClock;
+    quint32 mSeq;
+    QHash<quint32, qint64> mPendingCalls;
+    qint64 mCalls;
+    qint64 mCallNsecs;
+    qint64 mMaxCallNsecs;
+    QTimer *mAckTimer;
+};
+
+#endif // PLUGINHOST_H
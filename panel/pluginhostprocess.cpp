@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include "pluginhostprocess.h"
+#include "pluginhost.h"
+#include "iukuipanelplugin.h"
+#include "pluginsettings_p.h"
+#include "common/ukuiapplication.h"
+#include "common/ukuisettings.h"
+
+#include <QApplication>
+#include <QDebug>
+#include <QEvent>
+#include <QHBoxLayout>
+#include <QLocalSocket>
+#include <QPluginLoader>
+#include <QWidget>
+
+#define HOST_CONNECT_TIMEOUT    5000
+
+int PluginHostProcess::exec(int argc, char *argv[])
+{
+    UKUi::Application app(argc, argv);
+    app.setQuitOnLastWindowClosed(false);
+
+    const QStringList arguments = app.arguments();
+    if (arguments.size() < 7)
+    {
+        qWarning() << "Usage: ukui-panel --plugin-host SERVER LIBRARY DESKTOP_FILE SETTINGS_FILE GROUP";
+        return 1;
+    }
+
+    PluginHostProcess host(arguments.mid(2));
+    if (!host.connectToPanel())
+        return 1;
+    return app.exec();
+}
+
+PluginHostProcess::PluginHostProcess(const QStringList &arguments, QObject *parent)
+    : QObject(parent),
+      mServer(arguments.at(0)),
+      mLibraryPath(arguments.at(1)),
+      mDesktopFilePath(arguments.at(2)),
+      mSettingsPath(arguments.at(3)),
+      mGroup(arguments.at(4)),
+      mSocket(new QLocalSocket(this)),
+      mSettings(nullptr),
+      mPlugin(nullptr),
+      mPosition(PositionBottom),
+      mIconSize(0),
+      mPanelSize(0),
+      mOpacity(100),
+      mLineCount(1)
+{
+}
+
+bool PluginHostProcess::connectToPanel()
+{
+    mSocket->connectToServer(mServer);
+    if (!mSocket->waitForConnected(HOST_CONNECT_TIMEOUT))
+    {
+        qWarning() << "Plugin host can't connect to the panel:" << mSocket->errorString();
+        return false;
+    }
+
+    connect(mSocket, &QLocalSocket::readyRead, this, &PluginHostProcess::readMessages);
+    connect(mSocket, &QLocalSocket::disconnected, qApp, &QCoreApplication::quit);
+    return true;
+}
+
+void PluginHostProcess::readMessages()
+{
+    QString command;
+    QVariantList args;
+    while (PluginHostProtocol::receive(mSocket, &command, &args))
+    {
+        if (command == QLatin1String("panel"))
+        {
+            setPanelState(args);
+            if (!mPlugin && !createPlugin())
+            {
+                qApp->exit(1);
+                return;
+            }
+            continue;
+        }
+
+        if (args.isEmpty() || !mPlugin)
+            continue;
+        const quint32 seq = args.at(0).toUInt();
+        if (command == QLatin1String("realign"))
+        {
+            mPlugin->realign();
+        }
+        else if (command == QLatin1String("settingsChanged"))
+        {
+            // the panel wrote them, the cached values are stale
+            mSettings->sync();
+            mPlugin->settingsChanged();
+        }
+        else if (command == QLatin1String("activated") && args.size() == 2)
+        {
+            mPlugin->activated(IUKUIPanelPlugin::ActivationReason(args.at(1).toInt()));
+        }
+        PluginHostProtocol::send(mSocket, QStringLiteral("ack"), QVariantList() << seq);
+    }
+}
+
+void PluginHostProcess::setPanelState(const QVariantList &args)
+{
+    if (args.size() != 8)
+        return;
+
+    mPosition = Position(args.at(0).toInt());
+    mIconSize = args.at(1).toInt();
+    mPanelSize = args.at(2).toInt();
+    mOpacity = args.at(3).toInt();
+    mLineCount = args.at(4).toInt();
+    mGeometry = args.at(5).toRect();
+    mPluginPos = args.at(6).toPoint();
+    mScreen = args.at(7).toRect();
+}
+
+bool PluginHostProcess::createPlugin()
+{
+    if (!mDesktopFile.load(mDesktopFilePath))
+    {
+        qWarning() << "Plugin host can't read" << mDesktopFilePath;
+        return false;
+    }
+
+    QPluginLoader *loader = new QPluginLoader(mLibraryPath, this);
+    IUKUIPanelPluginLibrary *library = qobject_cast<IUKUIPanelPluginLibrary *>(loader->instance());
+    if (!library)
+    {
+        qWarning() << "Plugin host can't load" << mLibraryPath << loader->errorString();
+        return false;
+    }
+
+    UKUi::Settings *settings = new UKUi::Settings(mSettingsPath, QSettings::IniFormat, this);
+    mSettings = PluginSettingsFactory::create(settings, mGroup, this);
+
+    IUKUIPanelPluginStartupInfo startupInfo;
+    startupInfo.ukuiPanel = this;
+    startupInfo.settings = mSettings;
+    startupInfo.desktopFile = &mDesktopFile;
+    mPlugin = library->instance(startupInfo);
+    if (!mPlugin || !mPlugin->widget())
+    {
+        qWarning() << "Plugin host can't create the plugin of" << mLibraryPath;
+        return false;
+    }
+
+    // shown before the panel reparents it, it must not be managed or seen meanwhile
+    mWindow = new QWidget;
+    mWindow->setWindowFlags(Qt::FramelessWindowHint | Qt::BypassWindowManagerHint | Qt::Tool);
+    QHBoxLayout *layout = new QHBoxLayout(mWindow);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->setSpacing(0);
+    layout->addWidget(mPlugin->widget());
+    mWindow->installEventFilter(this);
+    mWindow->move(-mScreen.width() - mWindow->width(), -mScreen.height() - mWindow->height());
+    mWindow->show();
+
+    PluginHostProtocol::send(mSocket, QStringLiteral("embed"), QVariantList()
+                             << qulonglong(mWindow->winId())
+                             << mPlugin->themeId()
+                             << flagsOf()
+                             << mPlugin->widget()->sizeHint());
+    return true;
+}
+
+// the configuration dialog can't be shown by the panel
+QVariantList PluginHostProcess::flagsOf() const
+{
+    return QVariantList() << int(mPlugin->flags() & ~IUKUIPanelPlugin::HaveConfigDialog)
+                          << mPlugin->isSeparate()
+                          << mPlugin->isExpandable();
+}
+
+bool PluginHostProcess::eventFilter(QObject *watched, QEvent *event)
+{
+    // the size hint of the plugin widget changed
+    if (watched == mWindow && event->type() == QEvent::LayoutRequest && mPlugin)
+        PluginHostProtocol::send(mSocket, QStringLiteral("size"), QVariantList() << mPlugin->widget()->sizeHint());
+    return QObject::eventFilter(watched, event);
+}
+
+void PluginHostProcess::pluginFlagsChanged(const IUKUIPanelPlugin *plugin)
+{
+    Q_UNUSED(plugin)
+    if (mPlugin)
+        PluginHostProtocol::send(mSocket, QStringLiteral("flags"), flagsOf());
+}
+
+QRect PluginHostProcess::calculatePopupWindowPos(const QPoint &absolutePos, const QSize &windowSize) const
+{
+    // same placement as UKUIPanel
+    int x = absolutePos.x(), y = absolutePos.y();
+    switch (mPosition)
+    {
+    case PositionTop:
+        y = mGeometry.bottom();
+        break;
+    case PositionBottom:
+        y = mGeometry.top() - windowSize.height();
+        break;
+    case PositionLeft:
+        x = mGeometry.right();
+        break;
+    case PositionRight:
+        x = mGeometry.left() - windowSize.width();
+        break;
+    }
+
+    QRect res(QPoint(x, y), windowSize);
+    if (res.right() > mScreen.right())
+        res.moveRight(mScreen.right());
+    if (res.bottom() > mScreen.bottom())
+        res.moveBottom(mScreen.bottom());
+    if (res.left() < mScreen.left())
+        res.moveLeft(mScreen.left());
+    if (res.top() < mScreen.top())
+        res.moveTop(mScreen.top());
+    return res;
+}
+
+QRect PluginHostProcess::calculatePopupWindowPos(const IUKUIPanelPlugin *plugin, const QSize &windowSize) const
+{
+    Q_UNUSED(plugin)
+    return calculatePopupWindowPos(mPluginPos, windowSize);
+}
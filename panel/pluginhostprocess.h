@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#ifndef PLUGINHOSTPROCESS_H
+#define PLUGINHOSTPROCESS_H
+
+#include <QObject>
+#include <QPointer>
+#include <QRect>
+#include <QStringList>
+#include "iukuipanel.h"
+#include "common/ukuiplugininfo.h"
+
+class IUKUIPanelPlugin;
+class PluginSettings;
+class QLocalSocket;
+class QWidget;
+
+/*! \brief The helper process hosting one isolated plugin, see PluginHost.
+ *
+ * Started as "ukui-panel --plugin-host SERVER LIBRARY DESKTOP_FILE
+ * SETTINGS_FILE GROUP". It connects to the panel, mirrors the panel state it
+ * is sent as its IUKUIPanel, loads the library once that state is known and
+ * hands the window holding the plugin widget to the panel for embedding. It
+ * quits when the panel goes away.
+ */
+class PluginHostProcess : public QObject, public IUKUIPanel
+{
+    Q_OBJECT
+public:
+    static int exec(int argc, char *argv[]);
+
+    Position position() const override { return mPosition; }
+    int iconSize() const override { return mIconSize; }
+    int panelSize() const override { return mPanelSize; }
+    int opacity() const override { return mOpacity; }
+    int lineCount() const override { return mLineCount; }
+    QRect globalGeometry() const override { return mGeometry; }
+    QRect calculatePopupWindowPos(const QPoint &absolutePos, const QSize &windowSize) const override;
+    QRect calculatePopupWindowPos(const IUKUIPanelPlugin *plugin, const QSize &windowSize) const override;
+    //! the panel can't watch windows of another process, nothing to do
+    void willShowWindow(QWidget *w) override { Q_UNUSED(w) }
+    void pluginFlagsChanged(const IUKUIPanelPlugin *plugin) override;
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void readMessages();
+
+private:
+    explicit PluginHostProcess(const QStringList &arguments, QObject *parent = nullptr);
+
+    bool connectToPanel();
+    void setPanelState(const QVariantList &args);
+    bool createPlugin();
+    QVariantList flagsOf() const;
+
+    QString mServer;
+    QString mLibraryPath;
+    QString mDesktopFilePath;
+    QString mSettingsPath;
+    QString mGroup;
+
+    QLocalSocket *mSocket;
+    UKUi::PluginInfo mDesktopFile;
+    PluginSettings *mSettings;
+    IUKUIPanelPlugin *mPlugin;
+    QPointer<QWidget> mWindow;
+
+    Position mPosition;
+    int mIconSize;
+    int mPanelSize;
+    int mOpacity;
+    int mLineCount;
+    QRect mGeometry;
+    QPoint mPluginPos;
+    QRect mScreen;
+};
+
+#endif // PLUGINHOSTPROCESS_H
@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include "pluginprofiler.h"
+#include "panelstats.h"
+
+#include <algorithm>
+#include <QAbstractEventDispatcher>
+#include <QApplication>
+#include <QDBusConnection>
+#include <QDesktopWidget>
+#include <QLabel>
+#include <QStringList>
+#include <QTimer>
+
+#define PROFILER_DBUS_PATH      "/plugins"
+#define PROFILER_OVERLAY_UPDATE 1000
+#define PROFILER_PANEL          "panel"
+
+bool PluginProfiler::sEnabled = false;
+
+PluginProfiler *PluginProfiler::instance()
+{
+    static PluginProfiler *profiler = new PluginProfiler;
+    return profiler;
+}
+
+PluginProfiler::PluginProfiler(QObject *parent)
+    : QObject(parent),
+      mLoopDepth(0),
+      mOverlayTimer(new QTimer(this))
+{
+    mSince.start();
+    mClock.start();
+    connect(mOverlayTimer, &QTimer::timeout, this, &PluginProfiler::updateOverlay);
+
+    QDBusConnection::sessionBus().registerObject(QStringLiteral(PROFILER_DBUS_PATH), this,
+                                                 QDBusConnection::ExportScriptableSlots);
+
+    if (qgetenv("UKUI_PANEL_PROFILE_PLUGINS") == "1")
+        setEnabled(true);
+}
+
+void PluginProfiler::setEnabled(bool enabled)
+{
+    if (enabled == sEnabled)
+        return;
+
+    sEnabled = enabled;
+    // 分发器的活动说明有事件循环在跑，分发中出现就是嵌套循环
+    QAbstractEventDispatcher *dispatcher = QAbstractEventDispatcher::instance(thread());
+    if (enabled)
+    {
+        if (mStats.isEmpty())
+            mSince.restart();
+        if (dispatcher)
+        {
+            connect(dispatcher, &QAbstractEventDispatcher::aboutToBlock, this, &PluginProfiler::loopActivity, Qt::DirectConnection);
+            connect(dispatcher, &QAbstractEventDispatcher::awake, this, &PluginProfiler::loopActivity, Qt::DirectConnection);
+        }
+    }
+    else
+    {
+        if (dispatcher)
+            disconnect(dispatcher, nullptr, this, nullptr);
+        // deliveries still open are not measured to their end
+        mDeliveries.clear();
+        mLoopDepth = 0;
+        setOverlayVisible(false);
+    }
+}
+
+void PluginProfiler::addRoot(QObject *root, const QString &plugin)
+{
+    if (!root || mRoots.contains(root))
+        return;
+    mRoots.insert(root, plugin);
+    connect(root, &QObject::destroyed, this, [this, root] { mRoots.remove(root); });
+}
+
+void PluginProfiler::addCache(const QString &owner, const QString &name, CacheProbe probe, QObject *context)
+{
+    const QString key = owner + QLatin1Char('/') + name;
+    mCaches.insert(key, probe);
+    if (context)
+        connect(context, &QObject::destroyed, this, [this, key] { mCaches.remove(key); });
+}
+
+QString PluginProfiler::pluginOf(QObject *receiver) const
+{
+    for (QObject *o = receiver; o; o = o->parent())
+    {
+        auto it = mRoots.constFind(o);
+        if (it != mRoots.constEnd())
+            return it.value();
+    }
+    return QStringLiteral(PROFILER_PANEL);
+}
+
+void PluginProfiler::deliveryStarted(QObject *receiver)
+{
+    Delivery delivery;
+    if (mDeliveries.size() == mLoopDepth)
+        delivery.plugin = pluginOf(receiver);
+    delivery.start = mClock.nsecsElapsed();
+    delivery.loopDepth = mLoopDepth;
+    delivery.excluded = 0;
+    delivery.loopStart = -1;
+    delivery.loopEnd = -1;
+    mDeliveries.append(delivery);
+}
+
+void PluginProfiler::deliveryFinished()
+{
+    if (mDeliveries.isEmpty())
+        return;
+
+    const qint64 now = mClock.nsecsElapsed();
+    const Delivery delivery = mDeliveries.takeLast();
+    mLoopDepth = delivery.loopDepth;
+    if (delivery.plugin.isEmpty())
+        return;
+
+    qint64 nsecs = now - delivery.start - delivery.excluded;
+    if (delivery.loopStart >= 0)
+        nsecs -= delivery.loopEnd - delivery.loopStart;
+    eventDelivered(delivery.plugin, qMax<qint64>(0, nsecs));
+
+    // 嵌套循环分发的事件，延长外层的循环区间
+    if (Delivery *outer = measuredDelivery())
+        if (outer->loopStart >= 0)
+            outer->loopEnd = now;
+}
+
+PluginProfiler::Delivery *PluginProfiler::measuredDelivery()
+{
+    for (int i = mDeliveries.size() - 1; i >= 0; --i)
+        if (!mDeliveries.at(i).plugin.isEmpty())
+            return &mDeliveries[i];
+    return nullptr;
+}
+
+void PluginProfiler::loopActivity()
+{
+    Delivery *delivery = measuredDelivery();
+    if (!delivery)
+        return;
+
+    const qint64 now = mClock.nsecsElapsed();
+    if (mLoopDepth != mDeliveries.size())
+    {
+        // 新的嵌套循环，之前的循环区间先记下
+        if (delivery->loopStart >= 0)
+            delivery->excluded += delivery->loopEnd - delivery->loopStart;
+        delivery->loopStart = now;
+        mLoopDepth = mDeliveries.size();
+    }
+    delivery->loopEnd = now;
+}
+
+void PluginProfiler::eventDelivered(const QString &plugin, qint64 nsecs)
+{
+    Stats &stats = mStats[plugin];
+    ++stats.events;
+    stats.nsecs += nsecs;
+    stats.maxNsecs = qMax(stats.maxNsecs, nsecs);
+}
+
+QString PluginProfiler::report() const
+{
+    QVector<QMap<QString, Stats>::const_iterator> plugins;
+    qint64 loop = 0;
+    for (auto it = mStats.constBegin(); it != mStats.constEnd(); ++it)
+    {
+        plugins << it;
+        loop += it.value().nsecs;
+    }
+    std::sort(plugins.begin(), plugins.end(), [] (QMap<QString, Stats>::const_iterator a,
+                                                QMap<QString, Stats>::const_iterator b) {
+        return a.value().nsecs > b.value().nsecs;
+    });
+
+    const qint64 wall = qMax<qint64>(1, mSince.nsecsElapsed());
+    QString result = QStringLiteral("profiling %1, event loop busy %2 ms of %3 s (%4%), rss %5 kB\n")
+            .arg(sEnabled ? QStringLiteral("on") : QStringLiteral("off"))
+            .arg(loop / 1000000)
+            .arg(wall / 1000000000)
+            .arg(100.0 * loop / wall, 0, 'f', 2)
+            .arg(PanelStats::residentSize());
+    for (auto it : qAsConst(plugins))
+    {
+        const Stats &stats = it.value();
+        result += QStringLiteral("%1: %2 events, %3 ms (%4% of loop, %5% of wall), avg %6 us, max %7 us\n")
+                .arg(it.key())
+                .arg(stats.events)
+                .arg(stats.nsecs / 1000000)
+                .arg(loop ? 100.0 * stats.nsecs / loop : 0.0, 0, 'f', 1)
+                .arg(100.0 * stats.nsecs / wall, 0, 'f', 2)
+                .arg(stats.events ? stats.nsecs / stats.events / 1000 : 0)
+                .arg(stats.maxNsecs / 1000);
+    }
+    for (auto it = mCaches.constBegin(); it != mCaches.constEnd(); ++it)
+    {
+        const CacheSize size = it.value()();
+        result += QStringLiteral("cache %1: %2 entries").arg(it.key()).arg(size.entries);
+        if (size.bytes >= 0)
+            result += QStringLiteral(", %1 kB").arg(size.bytes / 1024);
+        result += QLatin1Char('\n');
+    }
+    return result;
+}
+
+void PluginProfiler::reset()
+{
+    mStats.clear();
+    mSince.restart();
+    mOverlaySince.restart();
+}
+
+void PluginProfiler::setOverlayVisible(bool visible)
+{
+    if (!visible)
+    {
+        mOverlayTimer->stop();
+        delete mOverlay;
+        return;
+    }
+
+    setEnabled(true);
+    if (!mOverlay)
+    {
+        mOverlay = new QLabel;
+        mOverlay->setWindowFlags(Qt::ToolTip | Qt::FramelessWindowHint | Qt::WindowStaysOnTopHint);
+        mOverlay->setAttribute(Qt::WA_TransparentForMouseEvents);
+        mOverlay->setAttribute(Qt::WA_ShowWithoutActivating);
+        mOverlay->setMargin(4);
+    }
+    for (auto it = mStats.begin(); it != mStats.end(); ++it)
+        it.value().shownNsecs = it.value().nsecs;
+    mOverlaySince.restart();
+    mOverlayTimer->start(PROFILER_OVERLAY_UPDATE);
+    updateOverlay();
+}
+
+void PluginProfiler::updateOverlay()
+{
+    if (!mOverlay)
+        return;
+
+    // share of the last interval, busiest first
+    const qint64 wall = qMax<qint64>(1, mOverlaySince.nsecsElapsed());
+    mOverlaySince.restart();
+    QVector<QPair<qint64, QString> > rows;
+    for (auto it = mStats.begin(); it != mStats.end(); ++it)
+    {
+        Stats &stats = it.value();
+        rows << qMakePair(stats.nsecs - stats.shownNsecs, it.key());
+        stats.shownNsecs = stats.nsecs;
+    }
+    std::sort(rows.begin(), rows.end(), [] (const QPair<qint64, QString> &a, const QPair<qint64, QString> &b) {
+        return a.first > b.first;
+    });
+
+    QStringList lines;
+    for (const auto &row : qAsConst(rows))
+        lines << QStringLiteral("%1 %2%").arg(row.second).arg(100.0 * row.first / wall, 0, 'f', 1);
+    lines << QStringLiteral("rss %1 MB").arg(PanelStats::residentSize() / 1024);
+    mOverlay->setText(lines.join(QLatin1Char('\n')));
+    mOverlay->adjustSize();
+
+    const QRect screen = QApplication::desktop()->availableGeometry();
+    mOverlay->move(screen.right() - mOverlay->width(), screen.top());
+    if (!mOverlay->isVisible())
+        mOverlay->show();
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#ifndef PLUGINPROFILER_H
+#define PLUGINPROFILER_H
+
+#include <functional>
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <QPointer>
+#include <QString>
+#include <QVector>
+#include "ukuipanelglobals.h"
+
+class QLabel;
+class QTimer;
+
+/*! \brief Event loop time and cache sizes per plugin.
+ *
+ * UKUIPanelApplication::notify() brackets every event the GUI thread delivers
+ * with deliveryStarted() and deliveryFinished(). The receiver is attributed
+ * to the plugin whose root object (the Plugin frame, the plugin widget or the
+ * plugin object, registered by Plugin) is found up its parent chain;
+ * everything else is counted as "panel".
+ *
+ * Events sent from inside a delivery are part of the outer one. A nested
+ * event loop (drag->exec(), QMessageBox::exec(), a menu) is different: the
+ * event dispatcher reports activity while a delivery is open, and from then
+ * on the events that loop dispatches are counted on their own receivers.
+ * The span from the first to the last activity of the nested loop, waiting
+ * included, is taken off the delivery that started it.
+ *
+ * Caches register a callback that returns their current size, it is only
+ * called for a report.
+ *
+ * report() and setOverlayVisible() are exported on the session bus as
+ * com.ukui.panel.debug.PluginProfiler at /plugins. The overlay is a small
+ * window showing the share of the last second each plugin used.
+ *
+ * Timing is disabled by default, notify() then only tests a flag. It is
+ * enabled by UKUI_PANEL_PROFILE_PLUGINS=1, setEnabled() on the session bus
+ * or by showing the overlay. Roots and caches are registered either way,
+ * pluginOf() and the cache sizes don't need the timing.
+ */
+class UKUI_PANEL_API PluginProfiler : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "com.ukui.panel.debug.PluginProfiler")
+public:
+    struct CacheSize
+    {
+        CacheSize(int entries = 0, qint64 bytes = -1) : entries(entries), bytes(bytes) {}
+        int entries;
+        qint64 bytes;       //!< -1 if unknown
+    };
+    typedef std::function<CacheSize ()> CacheProbe;
+
+    static PluginProfiler *instance();
+
+    static bool isEnabled() { return sEnabled; }
+
+    //! objects in the tree below root are attributed to plugin, until root is destroyed
+    void addRoot(QObject *root, const QString &plugin);
+    //! the probe is dropped when context is destroyed
+    void addCache(const QString &owner, const QString &name, CacheProbe probe, QObject *context = nullptr);
+
+    void deliveryStarted(QObject *receiver);
+    void deliveryFinished();
+    //! the plugin receiver belongs to, "panel" if none
+    QString pluginOf(QObject *receiver) const;
+
+public slots:
+    Q_SCRIPTABLE void setEnabled(bool enabled);
+    //! per plugin: events, loop time and its share, then the caches
+    Q_SCRIPTABLE QString report() const;
+    Q_SCRIPTABLE void reset();
+    Q_SCRIPTABLE void setOverlayVisible(bool visible);
+
+private slots:
+    void updateOverlay();
+    void loopActivity();
+
+private:
+    explicit PluginProfiler(QObject *parent = nullptr);
+
+    struct Stats
+    {
+        Stats() : events(0), nsecs(0), maxNsecs(0), shownNsecs(0) {}
+        qint64 events;
+        qint64 nsecs;
+        qint64 maxNsecs;
+        qint64 shownNsecs;  //!< nsecs at the last overlay update
+    };
+
+    // 一次正在进行的事件分发
+    struct Delivery
+    {
+        QString plugin;     //!< empty if part of the outer delivery
+        qint64 start;
+        int loopDepth;      //!< mLoopDepth before this delivery
+        qint64 excluded;    //!< nested loop time taken off so far
+        qint64 loopStart;   //!< -1 if no nested loop is running below
+        qint64 loopEnd;
+    };
+
+    void eventDelivered(const QString &plugin, qint64 nsecs);
+    Delivery *measuredDelivery();
+
+    static bool sEnabled;
+    QHash<QObject *, QString> mRoots;
+    QMap<QString, Stats> mStats;
+    QMap<QString, CacheProbe> mCaches;      // "owner/name"
+    QElapsedTimer mSince;
+    QElapsedTimer mClock;
+    QVector<Delivery> mDeliveries;
+    int mLoopDepth;                         // deliveries at this depth come from an event loop
+    QPointer<QLabel> mOverlay;
+    QTimer *mOverlayTimer;
+    QElapsedTimer mOverlaySince;
+};
+
+#endif // PLUGINPROFILER_H
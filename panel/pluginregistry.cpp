@@ -0,0 +1,346 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#include "pluginregistry.h"
+#include "plugin.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcessEnvironment>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#define PLUGIN_SERVICE_TYPE "UKUIPanel/Plugin"
+#define REGISTRY_CACHE_VERSION 2
+
+PluginRegistry *PluginRegistry::instance()
+{
+    static PluginRegistry *registry = new PluginRegistry;
+    return registry;
+}
+
+PluginRegistry::PluginRegistry() :
+    mScanned(false)
+{
+    mLibraryDirs << QProcessEnvironment::systemEnvironment().value("UKUIPanel_PLUGIN_PATH").split(":", QString::SkipEmptyParts);
+    mLibraryDirs << PLUGIN_DIR;
+}
+
+void PluginRegistry::scan(const QStringList &desktopDirs)
+{
+    if (mScanned && desktopDirs == mDesktopDirs && filesUnchanged())
+        return;
+
+    mScanned = true;
+    mDesktopDirs = desktopDirs;
+    if (loadCache())
+        return;
+
+    mIds.clear();
+    mEntries.clear();
+    mDirsModified.clear();
+    mFilesModified.clear();
+    for (const QString &dirName : desktopDirs)
+    {
+        mDirsModified.insert(dirName, modifiedOf(dirName));
+        const QFileInfoList files = QDir(dirName).entryInfoList(QStringList("*.desktop"), QDir::Files | QDir::Readable);
+        for (const QFileInfo &file : files)
+        {
+            //同名的desktop文件以先出现的目录为准
+            const QString id = file.completeBaseName();
+            if (mEntries.contains(id))
+                continue;
+
+            Entry entry;
+            entry.desktopFile = file.canonicalFilePath();
+            entry.modified = file.lastModified().toMSecsSinceEpoch();
+            //不是插件的文件也记下,原地改成插件时目录的时间不变
+            mFilesModified.insert(entry.desktopFile, entry.modified);
+            entry.parsed = true;
+            entry.info.load(entry.desktopFile);
+            const bool usable = entry.info.isValid() && entry.info.serviceType() == QLatin1String(PLUGIN_SERVICE_TYPE);
+            if (usable)
+                mIds << id;
+            else
+                entry.desktopFile.clear();
+            mEntries.insert(id, entry);
+        }
+    }
+    saveCache();
+}
+
+bool PluginRegistry::contains(const QString &id) const
+{
+    auto it = mEntries.constFind(id);
+    return it != mEntries.constEnd() && !it->desktopFile.isEmpty();
+}
+
+UKUi::PluginInfo PluginRegistry::info(const QString &id)
+{
+    auto it = mEntries.find(id);
+    if (it == mEntries.end() || it->desktopFile.isEmpty())
+        return UKUi::PluginInfo();
+    if (!it->parsed)
+    {
+        it->parsed = true;
+        it->info.load(it->desktopFile);
+    }
+    return it->info;
+}
+
+UKUi::PluginInfoList PluginRegistry::plugins()
+{
+    UKUi::PluginInfoList list;
+    for (const QString &id : qAsConst(mIds))
+        list << info(id);
+    return list;
+}
+
+PluginRegistry::Origin PluginRegistry::origin(const QString &id)
+{
+    resolveLibrary(id);
+    return mLibraries.value(id).origin;
+}
+
+QString PluginRegistry::libraryPath(const QString &id)
+{
+    resolveLibrary(id);
+    return mLibraries.value(id).path;
+}
+
+QStringList PluginRegistry::libraryPaths(const QString &id) const
+{
+    QStringList paths;
+    const QString baseName = QString("lib%1.so").arg(id);
+    for (const QString &dirName : qAsConst(mLibraryDirs))
+    {
+        QFileInfo fi(QDir(dirName), baseName);
+        if (fi.exists())
+            paths << fi.absoluteFilePath();
+    }
+    return paths;
+}
+
+void PluginRegistry::resolveLibrary(const QString &id)
+{
+    //链接进面板的插件总是优先，缓存里的模块路径不能遮住它
+    if (Plugin::findStaticPlugin(id))
+    {
+        Library &library = mLibraries[id];
+        if (library.origin != OriginStatic)
+            library = {OriginStatic, QString(), -1};
+        return;
+    }
+
+    //缓存里的模块被删除或替换后重新查找，没找到的也每次重新查找
+    auto it = mLibraries.constFind(id);
+    if (it != mLibraries.constEnd() && it->origin == OriginDynamic
+            && modifiedOf(it->path) == it->modified)
+        return;
+
+    Library library = {OriginUnknown, QString(), -1};
+    const QStringList paths = libraryPaths(id);
+    if (!paths.isEmpty())
+    {
+        library.origin = OriginDynamic;
+        library.path = paths.first();
+        library.modified = modifiedOf(library.path);
+    }
+    mLibraries.insert(id, library);
+    if (library.origin == OriginDynamic)
+        saveCache();
+}
+
+/*缓存中记录的目录或文件的修改时间有任何变化都视为失效,重新扫描*/
+bool PluginRegistry::loadCache()
+{
+    QFile file(cachePath());
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    const QJsonObject root = QJsonDocument::fromJson(file.readAll()).object();
+    if (root.value("version").toInt() != REGISTRY_CACHE_VERSION)
+        return false;
+
+    QStringList dirs;
+    for (const QJsonValue &value : root.value("desktopDirs").toArray())
+        dirs << value.toString();
+    if (dirs != mDesktopDirs)
+        return false;
+
+    QHash<QString, qint64> dirsModified;
+    const QJsonObject dirTimes = root.value("dirs").toObject();
+    for (auto it = dirTimes.constBegin(); it != dirTimes.constEnd(); ++it)
+    {
+        const qint64 modified = static_cast<qint64>(it.value().toDouble());
+        if (modifiedOf(it.key()) != modified)
+            return false;
+        dirsModified.insert(it.key(), modified);
+    }
+
+    //每个扫描过的desktop文件,包括不是插件的
+    QHash<QString, qint64> filesModified;
+    const QJsonObject fileTimes = root.value("files").toObject();
+    for (auto it = fileTimes.constBegin(); it != fileTimes.constEnd(); ++it)
+    {
+        const qint64 modified = static_cast<qint64>(it.value().toDouble());
+        if (modifiedOf(it.key()) != modified)
+            return false;
+        filesModified.insert(it.key(), modified);
+    }
+
+    QStringList ids;
+    QHash<QString, Entry> entries;
+    for (const QJsonValue &value : root.value("plugins").toArray())
+    {
+        const QJsonObject plugin = value.toObject();
+        Entry entry;
+        entry.desktopFile = plugin.value("desktop").toString();
+        entry.modified = static_cast<qint64>(plugin.value("modified").toDouble());
+        entry.parsed = false;
+        if (modifiedOf(entry.desktopFile) != entry.modified)
+            return false;
+        const QString id = plugin.value("id").toString();
+        ids << id;
+        entries.insert(id, entry);
+    }
+
+    //模块目录变化时只丢弃模块路径
+    bool librariesValid = true;
+    QStringList libraryDirs;
+    for (const QJsonValue &value : root.value("libraryDirs").toArray())
+    {
+        const QJsonObject dir = value.toObject();
+        libraryDirs << dir.value("path").toString();
+        if (modifiedOf(libraryDirs.last()) != static_cast<qint64>(dir.value("modified").toDouble()))
+            librariesValid = false;
+    }
+    if (libraryDirs != mLibraryDirs)
+        librariesValid = false;
+
+    mLibraries.clear();
+    if (librariesValid)
+    {
+        const QJsonObject libraries = root.value("libraries").toObject();
+        for (auto it = libraries.constBegin(); it != libraries.constEnd(); ++it)
+        {
+            const QJsonObject object = it.value().toObject();
+            Library library = {OriginDynamic, object.value("path").toString(),
+                               static_cast<qint64>(object.value("modified").toDouble())};
+            mLibraries.insert(it.key(), library);
+        }
+    }
+
+    mIds = ids;
+    mEntries = entries;
+    mDirsModified = dirsModified;
+    mFilesModified = filesModified;
+    return true;
+}
+
+void PluginRegistry::saveCache() const
+{
+    QJsonObject root;
+    root.insert("version", REGISTRY_CACHE_VERSION);
+    root.insert("desktopDirs", QJsonArray::fromStringList(mDesktopDirs));
+
+    QJsonObject dirTimes;
+    for (auto it = mDirsModified.constBegin(); it != mDirsModified.constEnd(); ++it)
+        dirTimes.insert(it.key(), static_cast<double>(it.value()));
+    root.insert("dirs", dirTimes);
+
+    QJsonObject fileTimes;
+    for (auto it = mFilesModified.constBegin(); it != mFilesModified.constEnd(); ++it)
+        fileTimes.insert(it.key(), static_cast<double>(it.value()));
+    root.insert("files", fileTimes);
+
+    QJsonArray plugins;
+    for (const QString &id : qAsConst(mIds))
+    {
+        const Entry entry = mEntries.value(id);
+        QJsonObject plugin;
+        plugin.insert("id", id);
+        plugin.insert("desktop", entry.desktopFile);
+        plugin.insert("modified", static_cast<double>(entry.modified));
+        plugins.append(plugin);
+    }
+    root.insert("plugins", plugins);
+
+    QJsonArray libraryDirs;
+    for (const QString &dirName : mLibraryDirs)
+    {
+        QJsonObject dir;
+        dir.insert("path", dirName);
+        dir.insert("modified", static_cast<double>(modifiedOf(dirName)));
+        libraryDirs.append(dir);
+    }
+    root.insert("libraryDirs", libraryDirs);
+
+    QJsonObject libraries;
+    for (auto it = mLibraries.constBegin(); it != mLibraries.constEnd(); ++it)
+    {
+        if (it->origin != OriginDynamic)
+            continue;
+        QJsonObject library;
+        library.insert("path", it->path);
+        library.insert("modified", static_cast<double>(it->modified));
+        libraries.insert(it.key(), library);
+    }
+    root.insert("libraries", libraries);
+
+    const QString path = cachePath();
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "Can't write plugin registry cache" << path;
+        return;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    file.commit();
+}
+
+bool PluginRegistry::filesUnchanged() const
+{
+    for (auto it = mDirsModified.constBegin(); it != mDirsModified.constEnd(); ++it)
+    {
+        if (modifiedOf(it.key()) != it.value())
+            return false;
+    }
+    for (auto it = mFilesModified.constBegin(); it != mFilesModified.constEnd(); ++it)
+    {
+        if (modifiedOf(it.key()) != it.value())
+            return false;
+    }
+    return true;
+}
+
+qint64 PluginRegistry::modifiedOf(const QString &path)
+{
+    QFileInfo fi(path);
+    return fi.exists() ? fi.lastModified().toMSecsSinceEpoch() : -1;
+}
+
+QString PluginRegistry::cachePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericCacheLocation)
+            + QLatin1String("/ukui-panel/plugin-registry.json");
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#ifndef PLUGINREGISTRY_H
+#define PLUGINREGISTRY_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include "common/ukuiplugininfo.h"
+#include "ukuipanelglobals.h"
+
+/*! \brief Index of the installed panel plugins.
+ *
+ * The plugin desktop dirs are listed once per start and every plugin id is
+ * mapped to its .desktop file, its origin (linked into the panel or a *.so
+ * module) and the module path. The index is kept in the user cache dir and
+ * reused as long as the mtimes of the scanned dirs and of every desktop file
+ * in them are unchanged, so a normal start only stats them; a file edited in
+ * place doesn't change the mtime of its dir. Desktop files are parsed
+ * on the first info() of their id.
+ */
+class UKUI_PANEL_API PluginRegistry
+{
+public:
+    enum Origin { OriginUnknown, OriginStatic, OriginDynamic };
+
+    static PluginRegistry *instance();
+
+    //! (re)build the desktop file index, a few stats if the dirs did not change since the last scan
+    void scan(const QStringList &desktopDirs);
+
+    bool contains(const QString &id) const;
+    //! parsed desktop file of the plugin, invalid PluginInfo if not indexed
+    UKUi::PluginInfo info(const QString &id);
+    //! all indexed plugins, in the order of the desktop dirs
+    UKUi::PluginInfoList plugins();
+
+    //! where the plugin code lives, resolved on the first call for the id
+    Origin origin(const QString &id);
+    //! absolute path of the lib<id>.so module, empty for static plugins
+    QString libraryPath(const QString &id);
+    //! every lib<id>.so in the library dirs, in search order, without using the cache
+    QStringList libraryPaths(const QString &id) const;
+    QStringList libraryDirs() const { return mLibraryDirs; }
+
+private:
+    PluginRegistry();
+    Q_DISABLE_COPY(PluginRegistry)
+
+    struct Entry
+    {
+        QString desktopFile;
+        qint64 modified;
+        bool parsed;
+        UKUi::PluginInfo info;
+    };
+
+    struct Library
+    {
+        Origin origin;
+        QString path;
+        qint64 modified;
+    };
+
+    void resolveLibrary(const QString &id);
+    bool loadCache();
+    void saveCache() const;
+    //! the scanned dirs and every desktop file in them keep their mtimes
+    bool filesUnchanged() const;
+    static qint64 modifiedOf(const QString &path);
+    static QString cachePath();
+
+    QStringList mDesktopDirs;
+    QStringList mIds;                   //!< indexed ids in scan order
+    QHash<QString, Entry> mEntries;
+    QHash<QString, Library> mLibraries;
+    QHash<QString, qint64> mDirsModified;
+    QHash<QString, qint64> mFilesModified;    //!< every scanned desktop file, plugin or not
+    QStringList mLibraryDirs;
+    bool mScanned;
+};
+
+#endif // PLUGINREGISTRY_H
@@ -63,7 +63,25 @@ PluginSettings::PluginSettings(UKUi::Settings* settings, const QString &group, Q
     , d_ptr(new PluginSettingsPrivate{settings, group})
 {
     Q_D(PluginSettings);
-    connect(d->mSettings, &UKUi::Settings::settingsChangedFromExternal, this, &PluginSettings::settingsChanged);
+    connect(d->mSettings, &UKUi::Settings::keysChangedFromExternal, this, &PluginSettings::externalKeysChanged);
+}
+
+/*只转发本插件分组内的改动*/
+void PluginSettings::externalKeysChanged(const QStringList &keys)
+{
+    Q_D(PluginSettings);
+    const QString prefix = d->mGroup + '/';
+    QStringList own;
+    for (const QString &key : keys)
+    {
+        if (key.startsWith(prefix))
+            own << key.mid(prefix.length());
+    }
+    if (own.isEmpty())
+        return;
+
+    emit keysChangedFromExternal(own);
+    emit settingsChanged();
 }
 
 QString PluginSettings::group() const
@@ -72,6 +90,12 @@ QString PluginSettings::group() const
     return d->mGroup;
 }
 
+QString PluginSettings::fileName() const
+{
+    Q_D(const PluginSettings);
+    return d->mSettings->fileName();
+}
+
 PluginSettings::~PluginSettings()
 {
 }
@@ -165,8 +189,9 @@ void PluginSettings::clear()
 void PluginSettings::sync()
 {
     Q_D(PluginSettings);
-    d->mSettings->beginGroup(d->mGroup);
+    // sync the whole file, the external changes are detected for all the groups
     d->mSettings->sync();
+    d->mSettings->beginGroup(d->mGroup);
     d->mOldSettings.loadFromSettings();
     d->mSettings->endGroup();
     emit settingsChanged();
@@ -60,6 +60,7 @@ public:
     ~PluginSettings();
 
     QString group() const;
+    QString fileName() const;
 
     QVariant value(const QString &key, const QVariant &defaultValue = QVariant()) const;
     void setValue(const QString &key, const QVariant &value);
@@ -83,6 +84,11 @@ public:
 
 Q_SIGNALS:
     void settingsChanged();
+    //! keys of this plugin (relative to its group) changed by another process
+    void keysChangedFromExternal(const QStringList &keys);
+
+private Q_SLOTS:
+    void externalKeysChanged(const QStringList &keys);
 
 private:
     explicit PluginSettings(UKUi::Settings *settings, const QString &group, QObject *parent = nullptr);
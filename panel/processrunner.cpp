@@ -0,0 +1,272 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#include "processrunner.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QProcess>
+#include <QRunnable>
+#include <QVector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+#define PROCESS_MAX_THREADS     8
+#define PROCESS_MAX_OUTPUT      (1024 * 1024)
+#define PROCESS_WAIT_STEP       10
+
+namespace
+{
+    class ProcessJob : public QRunnable
+    {
+    public:
+        ProcessJob(ProcessRunner *runner, qint64 id, const QString &program, const QStringList &arguments,
+                   bool capture, int timeout)
+            : mRunner(runner), mId(id), mProgram(program), mArguments(arguments),
+              mCapture(capture), mTimeout(timeout)
+        {
+        }
+
+        void run() override
+        {
+            QElapsedTimer timer;
+            timer.start();
+            QByteArray output;
+            bool timedOut = false;
+            const int exitCode = exec(timer, output, timedOut);
+            QMetaObject::invokeMethod(mRunner, "finished", Qt::QueuedConnection,
+                                      Q_ARG(qint64, mId), Q_ARG(int, exitCode), Q_ARG(QByteArray, output),
+                                      Q_ARG(bool, timedOut), Q_ARG(qint64, timer.elapsed()));
+        }
+
+    private:
+        int exec(const QElapsedTimer &timer, QByteArray &output, bool &timedOut)
+        {
+            QList<QByteArray> args;
+            args << QFile::encodeName(mProgram);
+            for (const QString &arg : qAsConst(mArguments))
+                args << arg.toLocal8Bit();
+            QVector<char *> argv;
+            for (QByteArray &arg : args)
+                argv << arg.data();
+            argv << nullptr;
+
+            int pipefd[2] = { -1, -1 };
+            if (mCapture && pipe2(pipefd, O_CLOEXEC) != 0)
+                return -1;
+
+            posix_spawn_file_actions_t actions;
+            posix_spawn_file_actions_init(&actions);
+            posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+            if (mCapture)
+                posix_spawn_file_actions_adddup2(&actions, pipefd[1], STDOUT_FILENO);
+
+            pid_t pid;
+            const int rc = posix_spawnp(&pid, argv.at(0), &actions, nullptr, argv.data(), environ);
+            posix_spawn_file_actions_destroy(&actions);
+            if (mCapture)
+                close(pipefd[1]);
+            if (rc != 0)
+            {
+                qWarning() << "Failed to start" << mProgram << strerror(rc);
+                if (mCapture)
+                    close(pipefd[0]);
+                return -1;
+            }
+
+            if (mCapture)
+            {
+                //读到管道关闭或者超时
+                char buf[4096];
+                for (;;)
+                {
+                    int wait = -1;
+                    if (mTimeout > 0)
+                    {
+                        wait = mTimeout - timer.elapsed();
+                        if (wait <= 0)
+                        {
+                            timedOut = true;
+                            break;
+                        }
+                    }
+                    struct pollfd fd = { pipefd[0], POLLIN, 0 };
+                    const int ready = poll(&fd, 1, wait);
+                    if (ready < 0 && errno == EINTR)
+                        continue;
+                    if (ready == 0)
+                    {
+                        timedOut = true;
+                        break;
+                    }
+                    const ssize_t n = read(pipefd[0], buf, sizeof(buf));
+                    if (n < 0 && errno == EINTR)
+                        continue;
+                    if (n <= 0)
+                        break;
+                    if (output.size() < PROCESS_MAX_OUTPUT)
+                        output.append(buf, n);
+                }
+                close(pipefd[0]);
+            }
+
+            int status = 0;
+            for (;;)
+            {
+                if (timedOut)
+                {
+                    kill(pid, SIGKILL);
+                    waitpid(pid, &status, 0);
+                    return -1;
+                }
+                const int flags = mTimeout > 0 ? WNOHANG : 0;
+                const pid_t done = waitpid(pid, &status, flags);
+                if (done == pid)
+                    break;
+                if (done < 0 && errno != EINTR)
+                    return -1;
+                if (done == 0)
+                {
+                    if (timer.elapsed() >= mTimeout)
+                        timedOut = true;
+                    else
+                        usleep(PROCESS_WAIT_STEP * 1000);
+                }
+            }
+            return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+        }
+
+        ProcessRunner *mRunner;
+        qint64 mId;
+        QString mProgram;
+        QStringList mArguments;
+        bool mCapture;
+        int mTimeout;
+    };
+
+    class DetachJob : public QRunnable
+    {
+    public:
+        DetachJob(const QString &program, const QStringList &arguments)
+            : mProgram(program), mArguments(arguments)
+        {
+        }
+
+        void run() override
+        {
+            // 应用一直运行，不能占着线程等它退出；由 QProcess 两次 fork 后交给 init 回收
+            if (!QProcess::startDetached(mProgram, mArguments))
+                qWarning() << "Failed to start" << mProgram;
+        }
+
+    private:
+        QString mProgram;
+        QStringList mArguments;
+    };
+}
+
+ProcessRunner *ProcessRunner::instance()
+{
+    static ProcessRunner *runner = new ProcessRunner;
+    return runner;
+}
+
+ProcessRunner::ProcessRunner(QObject *parent)
+    : QObject(parent),
+      mNextId(0)
+{
+    mPool.setMaxThreadCount(PROCESS_MAX_THREADS);
+}
+
+ProcessRunner::~ProcessRunner()
+{
+    mPool.clear();
+    mPool.waitForDone();
+}
+
+qint64 ProcessRunner::run(const QString &program, const QStringList &arguments,
+                          const QObject *context, Callback callback, int timeout)
+{
+    const qint64 id = ++mNextId;
+    Pending &pending = mPending[id];
+    pending.program = QFileInfo(program).fileName();
+    pending.hasContext = context;
+    pending.context = const_cast<QObject *>(context);
+    pending.callback = callback;
+
+    mPool.start(new ProcessJob(this, id, program, arguments, bool(callback), timeout));
+    return id;
+}
+
+bool ProcessRunner::startDetached(const QString &program, const QStringList &arguments)
+{
+    if (program.isEmpty())
+        return false;
+    ++mStats[QFileInfo(program).fileName()].runs;
+    mPool.start(new DetachJob(program, arguments));
+    return true;
+}
+
+void ProcessRunner::finished(qint64 id, int exitCode, const QByteArray &output, bool timedOut, qint64 msecs)
+{
+    const Pending pending = mPending.take(id);
+
+    Stats &stats = mStats[pending.program];
+    ++stats.runs;
+    if (exitCode != 0)
+        ++stats.failures;
+    if (timedOut)
+        ++stats.timeouts;
+    stats.msecs += msecs;
+    stats.maxMsecs = qMax(stats.maxMsecs, msecs);
+
+    if (exitCode != 0)
+        qDebug() << pending.program << "exited with" << exitCode << (timedOut ? "(timed out)" : "");
+
+    if (!pending.callback || (pending.hasContext && !pending.context))
+        return;
+    pending.callback(exitCode, output);
+}
+
+QString ProcessRunner::report() const
+{
+    QString result;
+    for (auto it = mStats.constBegin(); it != mStats.constEnd(); ++it)
+    {
+        const Stats &stats = it.value();
+        result += QStringLiteral("%1: runs %2, failures %3, timeouts %4, avg %5 ms, max %6 ms\n")
+                .arg(it.key())
+                .arg(stats.runs)
+                .arg(stats.failures)
+                .arg(stats.timeouts)
+                .arg(stats.runs ? stats.msecs / stats.runs : 0)
+                .arg(stats.maxMsecs);
+    }
+    return result;
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#ifndef PROCESSRUNNER_H
+#define PROCESSRUNNER_H
+
+#include <functional>
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QPointer>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include "ukuipanelglobals.h"
+
+/*! \brief Runs helper programs for the panel and its plugins.
+ *
+ * Programs are started with posix_spawn() and an argument vector, never
+ * through a shell, and are waited for on a private thread pool, so neither
+ * the spawn nor a slow program can block input or painting. The exit code
+ * and, if a callback is given, the standard output are handed back on the
+ * GUI thread. A timeout kills programs that hang, so run() is meant for short
+ * commands; programs that stay open (dialogs, applications) are started with
+ * startDetached().
+ *
+ * The number of runs, failures, timeouts and the run time are recorded per
+ * program, see report().
+ */
+class UKUI_PANEL_API ProcessRunner : public QObject
+{
+    Q_OBJECT
+public:
+    //! exitCode is -1 if the program couldn't be started, crashed or was killed by the timeout
+    typedef std::function<void (int exitCode, const QByteArray &output)> Callback;
+
+    //! ms a short command may take before it is killed
+    enum { DefaultTimeout = 5000 };
+
+    static ProcessRunner *instance();
+
+    /*! Runs program (looked up in PATH) with arguments. The callback, if any, is called in
+        the GUI thread unless the context object is gone by then; timeout is in ms, 0 waits
+        as long as the program runs. Returns an id for the run. */
+    qint64 run(const QString &program, const QStringList &arguments = QStringList(),
+               const QObject *context = nullptr, Callback callback = Callback(), int timeout = DefaultTimeout);
+
+    //! starts a program that keeps running on its own (an application), nothing is waited for
+    bool startDetached(const QString &program, const QStringList &arguments = QStringList());
+
+    //! runs, failures, timeouts, average and worst time per program, one line each
+    QString report() const;
+
+private slots:
+    void finished(qint64 id, int exitCode, const QByteArray &output, bool timedOut, qint64 msecs);
+
+private:
+    explicit ProcessRunner(QObject *parent = nullptr);
+    ~ProcessRunner();
+
+    struct Pending
+    {
+        QString program;
+        bool hasContext;
+        QPointer<QObject> context;
+        Callback callback;
+    };
+    struct Stats
+    {
+        Stats() : runs(0), failures(0), timeouts(0), msecs(0), maxMsecs(0) {}
+        int runs;
+        int failures;
+        int timeouts;
+        qint64 msecs;
+        qint64 maxMsecs;
+    };
+
+    QThreadPool mPool;
+    qint64 mNextId;
+    QHash<qint64, Pending> mPending;
+    QHash<QString, Stats> mStats;
+};
+
+#endif // PROCESSRUNNER_H
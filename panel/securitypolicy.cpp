@@ -0,0 +1,189 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#include "securitypolicy.h"
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+#include <algorithm>
+
+#define SECURITY_CONFIG_FILE "/.config/ukui-panel-security-config.json"
+
+void SecurityPolicySnapshot::Rules::add(QString path)
+{
+    const bool prefix = path.endsWith('*') || path.endsWith('/');
+    if (path.endsWith('*'))
+        path.chop(1);
+    if (path.isEmpty())
+        return;
+    if (!prefix)
+    {
+        exact.insert(path);
+        return;
+    }
+    prefixes.insert(path);
+    auto it = std::lower_bound(prefixLengths.begin(), prefixLengths.end(), path.length());
+    if (it == prefixLengths.end() || *it != path.length())
+        prefixLengths.insert(it, path.length());
+}
+
+bool SecurityPolicySnapshot::Rules::matches(const QString &path) const
+{
+    if (exact.contains(path))
+        return true;
+    for (int length : prefixLengths)
+    {
+        if (length > path.length())
+            break;
+        if (prefixes.contains(path.left(length)))
+            return true;
+    }
+    return false;
+}
+
+bool SecurityPolicySnapshot::allows(const QString &path) const
+{
+    switch (mMode)
+    {
+    case ModeBlacklist:
+        return !mBlacklist.matches(path);
+    case ModeWhitelist:
+        return mWhitelist.matches(path);
+    default:
+        return true;
+    }
+}
+
+int SecurityPolicySnapshot::ruleCount() const
+{
+    return mBlacklist.size() + mWhitelist.size();
+}
+
+SecurityPolicy *SecurityPolicy::instance()
+{
+    static SecurityPolicy *policy = new SecurityPolicy;
+    return policy;
+}
+
+SecurityPolicy::SecurityPolicy(QObject *parent) :
+    QObject(parent),
+    mConfigPath(QDir::homePath() + QLatin1String(SECURITY_CONFIG_FILE)),
+    mSnapshot(new SecurityPolicySnapshot),
+    mWatcher(new QFileSystemWatcher(this)),
+    mReloadTimer(new QTimer(this))
+{
+    // 编辑器保存时会连续触发多次变化，合并成一次重新加载
+    mReloadTimer->setSingleShot(true);
+    mReloadTimer->setInterval(100);
+    connect(mReloadTimer, &QTimer::timeout, this, &SecurityPolicy::reload);
+    connect(mWatcher, &QFileSystemWatcher::fileChanged, mReloadTimer, static_cast<void (QTimer::*)()>(&QTimer::start));
+    connect(mWatcher, &QFileSystemWatcher::directoryChanged, this, [this] {
+        if (QFile::exists(mConfigPath))
+            mReloadTimer->start();
+    });
+
+    QFile file(mConfigPath);
+    if (file.open(QIODevice::ReadOnly))
+    {
+        QSharedPointer<const SecurityPolicySnapshot> snapshot = compile(file.readAll());
+        if (snapshot)
+            mSnapshot = snapshot;
+    }
+    watch();
+}
+
+/* 配置文件存在时只监视文件本身，不存在时监视所在目录等待其创建 */
+void SecurityPolicy::watch()
+{
+    const QString dir = QFileInfo(mConfigPath).absolutePath();
+    if (QFile::exists(mConfigPath))
+    {
+        if (!mWatcher->files().contains(mConfigPath))
+            mWatcher->addPath(mConfigPath);
+        if (mWatcher->directories().contains(dir))
+            mWatcher->removePath(dir);
+    }
+    else if (!mWatcher->directories().contains(dir))
+    {
+        mWatcher->addPath(dir);
+    }
+}
+
+void SecurityPolicy::reload()
+{
+    QSharedPointer<const SecurityPolicySnapshot> snapshot;
+    QFile file(mConfigPath);
+    if (!file.exists())
+    {
+        snapshot.reset(new SecurityPolicySnapshot);
+    }
+    else if (file.open(QIODevice::ReadOnly))
+    {
+        snapshot = compile(file.readAll());
+    }
+    watch();
+
+    // 解析失败时保留旧的策略，避免写了一半的文件让黑名单失效
+    if (!snapshot)
+        return;
+    mSnapshot = snapshot;
+    emit policyChanged();
+}
+
+QSharedPointer<const SecurityPolicySnapshot> SecurityPolicy::compile(const QByteArray &json)
+{
+    SecurityPolicySnapshot *snapshot = new SecurityPolicySnapshot;
+    if (json.trimmed().isEmpty())
+        return QSharedPointer<const SecurityPolicySnapshot>(snapshot);
+
+    QJsonParseError error;
+    const QJsonDocument doc = QJsonDocument::fromJson(json, &error);
+    if (error.error != QJsonParseError::NoError)
+    {
+        qWarning() << "Invalid security config" << error.errorString();
+        delete snapshot;
+        return QSharedPointer<const SecurityPolicySnapshot>();
+    }
+
+    const QJsonObject panel = doc.object().value(QLatin1String("ukui-panel")).toObject();
+    const QString mode = panel.value(QLatin1String("mode")).toString();
+    if (mode == QLatin1String("blacklist"))
+        snapshot->mMode = SecurityPolicySnapshot::ModeBlacklist;
+    else if (mode == QLatin1String("whitelist"))
+        snapshot->mMode = SecurityPolicySnapshot::ModeWhitelist;
+
+    auto load = [&panel] (const char *name, SecurityPolicySnapshot::Rules &rules) {
+        const QJsonArray lists = panel.value(QLatin1String(name)).toArray();
+        for (const QJsonValue &list : lists)
+        {
+            const QJsonArray entries = list.toObject().value(QLatin1String("entries")).toArray();
+            for (const QJsonValue &entry : entries)
+                rules.add(entry.toObject().value(QLatin1String("path")).toString());
+        }
+    };
+    load("blacklist", snapshot->mBlacklist);
+    load("whitelist", snapshot->mWhitelist);
+
+    return QSharedPointer<const SecurityPolicySnapshot>(snapshot);
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#ifndef SECURITYPOLICY_H
+#define SECURITYPOLICY_H
+
+#include <QObject>
+#include <QSet>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+#include "ukuipanelglobals.h"
+
+class QFileSystemWatcher;
+class QTimer;
+
+/*! \brief Compiled form of ~/.config/ukui-panel-security-config.json
+ *
+ * Exact paths go into a hash set. Entries ending with '/' or '*' are prefix
+ * rules, hashed by their text and looked up once per distinct prefix length,
+ * so a check does not depend on the number of rules. Snapshots are immutable
+ * and can be kept by the consumers as long as they like.
+ */
+class UKUI_PANEL_API SecurityPolicySnapshot
+{
+public:
+    enum Mode { ModeNone, ModeBlacklist, ModeWhitelist };
+
+    SecurityPolicySnapshot() : mMode(ModeNone) {}
+
+    Mode mode() const { return mMode; }
+    //! true if the desktop file may be shown in the panel
+    bool allows(const QString &path) const;
+    int ruleCount() const;
+
+private:
+    friend class SecurityPolicy;
+
+    struct Rules
+    {
+        QSet<QString> exact;
+        QSet<QString> prefixes;
+        QVector<int> prefixLengths; //!< distinct, ascending
+        void add(QString path);
+        bool matches(const QString &path) const;
+        int size() const { return exact.size() + prefixes.size(); }
+    };
+
+    Mode mMode;
+    Rules mBlacklist;
+    Rules mWhitelist;
+};
+
+/*! \brief Process wide owner of the panel security policy.
+ *
+ * The config is parsed once and watched with a single file system watcher;
+ * the taskbar and the quicklaunch get a new snapshot through policyChanged()
+ * instead of each parsing the file on their own.
+ */
+class UKUI_PANEL_API SecurityPolicy : public QObject
+{
+    Q_OBJECT
+public:
+    static SecurityPolicy *instance();
+
+    QString configPath() const { return mConfigPath; }
+    QSharedPointer<const SecurityPolicySnapshot> snapshot() const { return mSnapshot; }
+    bool allows(const QString &path) const { return mSnapshot->allows(path); }
+
+public slots:
+    void reload();
+
+signals:
+    void policyChanged();
+
+private:
+    explicit SecurityPolicy(QObject *parent = nullptr);
+    void watch();
+    static QSharedPointer<const SecurityPolicySnapshot> compile(const QByteArray &json);
+
+    QString mConfigPath;
+    QSharedPointer<const SecurityPolicySnapshot> mSnapshot;
+    QFileSystemWatcher *mWatcher;
+    QTimer *mReloadTimer;
+};
+
+#endif // SECURITYPOLICY_H
@@ -0,0 +1,193 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#include "stagedpluginloader.h"
+#include "plugin.h"
+#include "pluginhost.h"
+#include "pluginregistry.h"
+#include "pluginsettings.h"
+#include "iukuipanelplugin.h"
+#include "ukuipanel.h"
+#include "launchmanager.h"
+#include "securitypolicy.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QEvent>
+#include <QPluginLoader>
+#include <QRunnable>
+#include <QTimer>
+#include <algorithm>
+
+namespace
+{
+    class PrepareJob : public QRunnable
+    {
+    public:
+        PrepareJob(StagedPluginLoader *loader, int token, const UKUi::PluginInfo &desktopFile,
+                   const QVariantMap &settings, const QString &libraryPath) :
+            mLoader(loader),
+            mToken(token),
+            mDesktopFile(desktopFile),
+            mSettings(settings),
+            mLibraryPath(libraryPath)
+        {
+        }
+
+        void run() override
+        {
+            const IUKUIPanelPluginPreparer *preparer = nullptr;
+            if (IUKUIPanelPluginLibrary const *lib = Plugin::findStaticPlugin(mDesktopFile.id()))
+            {
+                preparer = dynamic_cast<const IUKUIPanelPluginPreparer *>(lib);
+            }
+            else if (!mLibraryPath.isEmpty())
+            {
+                // 模块留在内存里,GUI线程的QPluginLoader直接复用同一个实例
+                QPluginLoader loader(mLibraryPath);
+                QObject *obj = loader.instance();
+                if (obj)
+                {
+                    if (obj->thread() == QThread::currentThread())
+                        obj->moveToThread(QCoreApplication::instance()->thread());
+                    preparer = qobject_cast<IUKUIPanelPluginPreparer *>(obj);
+                }
+            }
+
+            if (preparer)
+                preparer->prepare(mDesktopFile, mSettings);
+
+            QMetaObject::invokeMethod(mLoader, "prepared", Qt::QueuedConnection, Q_ARG(int, mToken));
+        }
+
+    private:
+        StagedPluginLoader *mLoader;
+        int mToken;
+        UKUi::PluginInfo mDesktopFile;
+        QVariantMap mSettings;
+        QString mLibraryPath;
+    };
+}
+
+StagedPluginLoader::StagedPluginLoader(UKUIPanel *panel, QObject *parent) :
+    QObject(parent),
+    mPanel(panel),
+    mNextToken(0),
+    mHandOffScheduled(false),
+    mFirstPaint(-1),
+    mInteractive(-1)
+{
+    mClock.start();
+    // 准备阶段会用到的共享服务必须属于GUI线程
+    LaunchManager::instance();
+    SecurityPolicy::instance();
+    mPanel->installEventFilter(this);
+}
+
+StagedPluginLoader::~StagedPluginLoader()
+{
+    mPool.clear();
+    mPool.waitForDone();
+}
+
+void StagedPluginLoader::enqueue(Plugin *plugin)
+{
+    QVariantMap settings;
+    PluginSettings *pluginSettings = plugin->settings();
+    const QStringList keys = pluginSettings->allKeys();
+    for (const QString &key : keys)
+        settings.insert(key, pluginSettings->value(key));
+
+    // 隔离的插件在宿主进程里加载,面板进程里不能dlopen它,也不调用prepare()
+    QString libraryPath;
+    const QString id = plugin->desktopFile().id();
+    PluginRegistry *registry = PluginRegistry::instance();
+    if (registry->origin(id) == PluginRegistry::OriginDynamic)
+    {
+        libraryPath = registry->libraryPath(id);
+        if (PluginHost::instance()->isIsolated(id, libraryPath, pluginSettings))
+            libraryPath.clear();
+    }
+
+    const int token = mNextToken++;
+    mPreparing.insert(token, plugin);
+    mPool.start(new PrepareJob(this, token, plugin->desktopFile(), settings, libraryPath));
+}
+
+bool StagedPluginLoader::eventFilter(QObject *watched, QEvent *event)
+{
+    if (watched == mPanel && event->type() == QEvent::Paint && mFirstPaint < 0)
+    {
+        mFirstPaint = mClock.elapsed();
+        mPanel->removeEventFilter(this);
+        qDebug() << "panel first paint after" << mFirstPaint << "ms";
+        // 先让这一帧画完
+        scheduleHandOff();
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+void StagedPluginLoader::prepared(int token)
+{
+    mReady.insert(std::lower_bound(mReady.begin(), mReady.end(), token), token);
+    scheduleHandOff();
+}
+
+void StagedPluginLoader::scheduleHandOff()
+{
+    if (mHandOffScheduled)
+        return;
+    mHandOffScheduled = true;
+    QTimer::singleShot(0, this, &StagedPluginLoader::handOff);
+}
+
+/*每轮事件循环只实例化一个插件,中间可以处理绘制和输入*/
+void StagedPluginLoader::handOff()
+{
+    mHandOffScheduled = false;
+    if (mFirstPaint < 0)
+        return;
+
+    if (!mReady.isEmpty())
+    {
+        const QPointer<Plugin> plugin = mPreparing.take(mReady.takeFirst());
+        if (plugin)
+        {
+            if (plugin->load())
+            {
+                mPanel->pluginFlagsChanged(plugin->iPlugin());
+                emit pluginLoaded(plugin);
+            }
+            else
+            {
+                emit pluginFailed(plugin);
+            }
+        }
+        if (!mReady.isEmpty())
+            scheduleHandOff();
+    }
+    checkInteractive();
+}
+
+void StagedPluginLoader::checkInteractive()
+{
+    if (mInteractive >= 0 || !mPreparing.isEmpty() || mFirstPaint < 0)
+        return;
+    mInteractive = mClock.elapsed();
+    qDebug() << "panel interactive after" << mInteractive << "ms";
+    emit interactive();
+}
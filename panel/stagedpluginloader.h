@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#ifndef STAGEDPLUGINLOADER_H
+#define STAGEDPLUGINLOADER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QPointer>
+#include <QThreadPool>
+
+class Plugin;
+class UKUIPanel;
+
+/*! \brief Second stage of the panel startup.
+ *
+ * Plugins marked X-UKUI-Panel-Deferred in their .desktop file are created
+ * as empty placeholders, so the panel frame and the cheap plugins are shown
+ * right away. Their IUKUIPanelPluginPreparer::prepare() (and the dlopen of
+ * *.so modules) runs in parallel on a private thread pool, except for
+ * plugins hosted out of process, which are never loaded into the panel.
+ * Once the panel is painted the prepared plugins are instantiated on the GUI
+ * thread one per event loop pass, the ones nearest to the start of the panel
+ * first.
+ *
+ * Both milestones are measured from the construction of the loader, which
+ * is when the panel starts loading its plugins.
+ */
+class StagedPluginLoader : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StagedPluginLoader(UKUIPanel *panel, QObject *parent = nullptr);
+    ~StagedPluginLoader();
+
+    //! plugins have to be enqueued in panel order
+    void enqueue(Plugin *plugin);
+
+    //! -1 until the panel was painted for the first time
+    qint64 timeToFirstPaint() const { return mFirstPaint; }
+    //! -1 until every deferred plugin is loaded
+    qint64 timeToInteractive() const { return mInteractive; }
+
+signals:
+    void pluginLoaded(Plugin *plugin);
+    void pluginFailed(Plugin *plugin);
+    void interactive();
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void prepared(int token);
+    void handOff();
+
+private:
+    void scheduleHandOff();
+    void checkInteractive();
+
+    UKUIPanel *mPanel;
+    QThreadPool mPool;
+    QElapsedTimer mClock;
+    int mNextToken;
+    QHash<int, QPointer<Plugin> > mPreparing;
+    QList<int> mReady;                  //!< tokens in panel order
+    bool mHandOffScheduled;
+    qint64 mFirstPaint;
+    qint64 mInteractive;
+};
+
+#endif // STAGEDPLUGINLOADER_H
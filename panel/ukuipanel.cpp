@@ -55,6 +55,10 @@
 //#include <glib.h>
 //#include <gio/gio.h>
 #include <QGSettings>
+#include "gsettingsregistry.h"
+#include "processrunner.h"
+#include <QDir>
+#include <QFile>
 #include <sys/stat.h>
 #include <unistd.h>
 // Turn on this to show the time required to load each plugin during startup
@@ -226,13 +230,13 @@ UKUIPanel::UKUIPanel(const QString &configGroup, UKUi::Settings *settings, QWidg
     connect(a, &UKUIPanelApplication::primaryScreenChanged, this, &UKUIPanel::setPanelGeometry);
 
     const QByteArray id(PANEL_SETTINGS);
-    gsettings = new QGSettings(id);
+    gsettings = GSettingsRegistry::instance()->settings(id);
 
 
     updateStyleSheet();
     const QByteArray transparency_id(TRANSPARENCY_SETTINGS);
     if(QGSettings::isSchemaInstalled(transparency_id)){
-        transparency_gsettings = new QGSettings(transparency_id);
+        transparency_gsettings = GSettingsRegistry::instance()->settings(transparency_id);
         //setPanelBackground(true);
         }
     connect(transparency_gsettings, &QGSettings::changed, this, [=] (const QString &key){
@@ -247,7 +251,7 @@ UKUIPanel::UKUIPanel(const QString &configGroup, UKUi::Settings *settings, QWidg
     QStringList stylelist;
     stylelist<<STYLE_NAME_KEY_DARK<<STYLE_NAME_KEY_BLACK<<STYLE_NAME_KEY_DEFAULT;
     if(QGSettings::isSchemaInstalled(style_id)){
-        style_gsettings = new QGSettings(style_id);
+        style_gsettings = GSettingsRegistry::instance()->settings(style_id);
         if(stylelist.contains(style_gsettings->get(STYLE_NAME).toString()))
             HighLightEffect::getBackGroundColor(this->palette().background().color().red(),this->palette().background().color().green(),this->palette().background().color().blue());
         }
@@ -408,7 +412,7 @@ void UKUIPanel::show()
 void UKUIPanel::bootOptionsFilter(QString opt) {
     if (opt == "--reset") {
 //        resetloadPlugins(CFG_KEY_PLUGINS_PC);
-        system("killall ukui-panel");
+        ProcessRunner::instance()->run("killall", QStringList() << "ukui-panel");
         qDebug()<<"!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!";
     }
     else if(opt == "--pad"){
@@ -439,7 +443,7 @@ void UKUIPanel::initLoadPlugins()
     const QByteArray panelmodel_id("org.ukui.SettingsDaemon.plugins.tablet-mode");
     //开机第一次检测模式执行对应的任务栏
     if(QGSettings::isSchemaInstalled(panelmodel_id)){
-        panelmodel_gsettings = new QGSettings(panelmodel_id);
+        panelmodel_gsettings = GSettingsRegistry::instance()->settings(panelmodel_id);
         if(panelmodel_gsettings->get("tablet-mode").toBool()){
             resetloadPlugins(CFG_KEY_PLUGINS_PC);
         }
@@ -1015,10 +1019,12 @@ void UKUIPanel::adjustPanel()
 
     QAction * resetPanel = menu->addAction(tr("Reset Panel"));
     connect(resetPanel, &QAction::triggered, [this] {
-        system("rm ~/.config/ukui/panel.conf");
-        system("cp /usr/share/ukui/panel.conf ~/.config/ukui/");
-        sleep(3);
-        resetloadPlugins(CFG_KEY_PLUGINS_PC);
+        const QString conf = QDir::homePath() + "/.config/ukui/panel.conf";
+        QFile::remove(conf);
+        QFile::copy("/usr/share/ukui/panel.conf", conf);
+        QTimer::singleShot(3000, this, [this] {
+            resetloadPlugins(CFG_KEY_PLUGINS_PC);
+        });
     });
 }
 /*右键　显示桌面选项*/
@@ -1762,7 +1768,7 @@ void UKUIPanel::updateConfigDialog() const
 bool UKUIPanel::isPluginSingletonAndRunnig(QString const & pluginId) const
 {
     Plugin const * plugin = mPlugins->pluginByID(pluginId);
-    if (nullptr == plugin)
+    if (nullptr == plugin || nullptr == plugin->iPlugin())
         return false;
     else
         return plugin->iPlugin()->flags().testFlag(IUKUIPanelPlugin::SingleInstance);
@@ -38,7 +38,20 @@
 #include <KWindowEffects>
 #include <QCommandLineParser>
 #include <QFile>
+#include <QJsonArray>
+#include <QTimer>
 #include "comm_func.h"
+#include "panelstats.h"
+#include "processrunner.h"
+#include "launchmanager.h"
+#include "gsettingsregistry.h"
+#include "x11meter.h"
+#include "wakeupauditor.h"
+#include "pluginprofiler.h"
+#include "painttracer.h"
+#include "hangwatchdog.h"
+#include "pluginhost.h"
+#include <QThread>
 
 #define CONFIG_FILE_BACKUP     "/usr/share/ukui/panel.conf"
 #define CONFIG_FILE_LOCAL      ".config/ukui/panel.conf"
@@ -111,8 +124,25 @@ UKUIPanelApplication::UKUIPanelApplication(int& argc, char** argv)
             QCoreApplication::translate("main", "Configuration file"));
     parser.addOption(configFileOption);
 
+    QCommandLineOption statsFileOption(QStringList() << QLatin1String("stats"),
+            QCoreApplication::translate("main", "Write performance statistics as JSON to file."),
+            QCoreApplication::translate("main", "Statistics file"));
+    parser.addOption(statsFileOption);
+
     parser.process(*this);
 
+    // reads UKUI_PANEL_AUDIT_WAKEUPS, then sees every timer from the start
+    WakeupAuditor::instance();
+    // reads UKUI_PANEL_TRACE_PAINT and can be switched on over DBus
+    PaintTracer::instance();
+    HangWatchdog::instance();
+    // reads UKUI_PANEL_METER_X11 before the plugins make their first requests
+    X11Meter::instance();
+    PluginProfiler::instance();
+
+    if (parser.isSet(statsFileOption))
+        startStats(parser.value(statsFileOption));
+
 //    if(parser.isSet(monitorRoleOption)){
 //        QFile::remove(QString(qgetenv("HOME"))+CONFIG_FILE_LOCAL);
 //        QFile::copy(CONFIG_FILE_BACKUP,QString(qgetenv("HOME"))+CONFIG_FILE_LOCAL);
@@ -174,6 +204,65 @@ UKUIPanelApplication::UKUIPanelApplication(int& argc, char** argv)
         addPanel(i);
     }
 //    updateStylesheet("default");
+
+    // the first pass of the event loop shows and paints the panels
+    QTimer::singleShot(0, this, [] { PanelStats::instance()->startupFinished(); });
+}
+
+void UKUIPanelApplication::startStats(const QString &path)
+{
+    // the reports of the panel services, one array element per line
+    auto lines = [] (const QString &report) {
+        return QJsonArray::fromStringList(report.split(QLatin1Char('\n'), QString::SkipEmptyParts));
+    };
+
+    PanelStats *stats = PanelStats::instance();
+    stats->addSection(QStringLiteral("panels"), [this] { return QJsonValue(count()); });
+    stats->addSection(QStringLiteral("processRunner"), [lines] { return QJsonValue(lines(ProcessRunner::instance()->report())); });
+    stats->addSection(QStringLiteral("launchManager"), [lines] { return QJsonValue(lines(LaunchManager::instance()->report())); });
+    stats->addSection(QStringLiteral("gsettings"), [lines] { return QJsonValue(lines(GSettingsRegistry::instance()->report())); });
+    stats->addSection(QStringLiteral("hangs"), [lines] { return QJsonValue(lines(HangWatchdog::instance()->report())); });
+    stats->addSection(QStringLiteral("paint"), [lines] { return QJsonValue(lines(PaintTracer::instance()->report())); });
+    stats->addSection(QStringLiteral("pluginHost"), [lines] { return QJsonValue(lines(PluginHost::instance()->report())); });
+    stats->addSection(QStringLiteral("plugins"), [lines] { return QJsonValue(lines(PluginProfiler::instance()->report())); });
+    stats->addSection(QStringLiteral("wakeups"), [lines] { return QJsonValue(lines(WakeupAuditor::instance()->report())); });
+    stats->addSection(QStringLiteral("x11"), [lines] { return QJsonValue(lines(X11Meter::instance()->report())); });
+    stats->start(path);
+}
+
+// paint events are nested in UpdateRequest, so this runs at any depth
+static inline void tracePaint(QObject *receiver, QEvent *event)
+{
+    if (PaintTracer::isEnabled() && event->type() == QEvent::Paint && receiver->isWidgetType())
+        PaintTracer::instance()->painted(static_cast<QWidget *>(receiver));
+}
+
+bool UKUIPanelApplication::notify(QObject *receiver, QEvent *event)
+{
+    static thread_local int depth = 0;
+    if (QThread::currentThread() != thread())
+    {
+        const bool result = UKUi::Application::notify(receiver, event);
+        tracePaint(receiver, event);
+        return result;
+    }
+
+    // the profiler sorts out nested deliveries and nested event loops itself;
+    // a delivery started while it was off is not finished there either
+    const bool profiling = PluginProfiler::isEnabled();
+    if (profiling)
+        PluginProfiler::instance()->deliveryStarted(receiver);
+    if (depth == 0)
+        HangWatchdog::eventStarted(receiver);
+    ++depth;
+    const bool result = UKUi::Application::notify(receiver, event);
+    --depth;
+    if (depth == 0)
+        HangWatchdog::eventFinished(receiver);
+    if (profiling && PluginProfiler::isEnabled())
+        PluginProfiler::instance()->deliveryFinished();
+    tracePaint(receiver, event);
+    return result;
 }
 
 void UKUIPanelApplication::updateStylesheet(QString themeName)
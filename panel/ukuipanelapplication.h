@@ -56,9 +56,9 @@ public:
      * \brief Creates a new UKUIPanelApplication with the given command line
      * arguments. Performs the following steps:
      * 1. Initializes the UKUi::Application, sets application name and version.
-     * 2. Handles command line arguments. Currently, the only cmdline argument
-     * is -c = -config = -configfile which chooses a different config file
-     * for the UKUi::Settings.
+     * 2. Handles command line arguments: -c = -config = -configfile chooses
+     * a different config file for the UKUi::Settings, --stats writes
+     * PanelStats snapshots to the given file.
      * 3. Creates the UKUi::Settings.
      * 4. Connects QCoreApplication::aboutToQuit to cleanup().
      * 5. Calls addPanel() for each panel found in the config file. If there is
@@ -89,6 +89,14 @@ public:
      */
     bool isPluginSingletonAndRunnig(QString const & pluginId) const;
 
+    /*!
+     * \brief Delivers the event and, on the GUI thread, reports the time it
+     * took to the PluginProfiler, which keeps nested event loops apart.
+     * Finished paint events are reported to the PaintTracer, the outermost
+     * deliveries are watched by the HangWatchdog.
+     */
+    bool notify(QObject *receiver, QEvent *event) override;
+
 public slots:
     /*!
      * \brief Adds a new UKUIPanel which consists of the following steps:
@@ -136,6 +144,12 @@ private:
      * \return The newly created UKUIPanel.
      */
     UKUIPanel* addPanel(const QString &name);
+    /*!
+     * \brief Enables PanelStats for the --stats command line option and
+     * registers the reports of the panel services with it.
+     * \param path File the JSON snapshots are written to.
+     */
+    void startStats(const QString &path);
 
 private slots:
     /*!
@@ -0,0 +1,294 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include "wakeupauditor.h"
+
+#include <algorithm>
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDebug>
+#include <QEvent>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+#include <QWidget>
+#ifdef HAVE_XSS
+#include <QX11Info>
+#include <X11/extensions/scrnsaver.h>
+#endif
+
+#define WAKEUP_DBUS_PATH        "/wakeups"
+#define WAKEUP_CHECK_INTERVAL   (30 * 1000)
+// no input to any window of the X screen for this long counts as idle
+#define WAKEUP_SCREEN_IDLE      (60 * 1000)
+// idle wakeups per second the whole panel may cause
+#define WAKEUP_BUDGET           2.0
+// gnome-session presence status
+#define PRESENCE_IDLE           3
+
+WakeupAuditor *WakeupAuditor::instance()
+{
+    static WakeupAuditor *auditor = new WakeupAuditor;
+    return auditor;
+}
+
+WakeupAuditor::WakeupAuditor(QObject *parent)
+    : QObject(parent),
+      mEnabled(false),
+      mSessionIdle(false),
+      mScreenIdle(false),
+      mIdleMsecs(0),
+      mIdleWakeups(0),
+      mCheckedWakeups(0),
+      mCheckedMsecs(0),
+      mCheckTimer(new QTimer(this))
+{
+    connect(mCheckTimer, &QTimer::timeout, this, &WakeupAuditor::checkIdle);
+    mCheckTimer->setInterval(WAKEUP_CHECK_INTERVAL);
+
+    QDBusConnection::sessionBus().connect(QStringLiteral("org.gnome.SessionManager"),
+                                          QStringLiteral("/org/gnome/SessionManager/Presence"),
+                                          QStringLiteral("org.gnome.SessionManager.Presence"),
+                                          QStringLiteral("StatusChanged"),
+                                          this, SLOT(presenceChanged(uint)));
+    QDBusConnection::sessionBus().registerObject(QStringLiteral(WAKEUP_DBUS_PATH), this,
+                                                 QDBusConnection::ExportScriptableSlots);
+
+    if (qgetenv("UKUI_PANEL_AUDIT_WAKEUPS") == "1")
+        setEnabled(true);
+}
+
+void WakeupAuditor::setEnabled(bool enabled)
+{
+    if (enabled == mEnabled)
+        return;
+
+    mEnabled = enabled;
+    if (enabled)
+    {
+        qApp->installEventFilter(this);
+        mCheckTimer->start();
+    }
+    else
+    {
+        qApp->removeEventFilter(this);
+        mCheckTimer->stop();
+    }
+}
+
+bool WakeupAuditor::eventFilter(QObject *watched, QEvent *event)
+{
+    switch (event->type())
+    {
+    case QEvent::Timer:
+    case QEvent::SockAct:
+        // the auditor's own timer is not counted
+        if (watched != mCheckTimer)
+            activated(watched);
+        break;
+
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseMove:
+    case QEvent::Wheel:
+    case QEvent::KeyPress:
+    case QEvent::TouchBegin:
+        // input to the panel itself ends the screen idle time before the next check
+        if (mScreenIdle)
+            setIdle(mSessionIdle, false);
+        break;
+
+    default:
+        break;
+    }
+    return false;
+}
+
+void WakeupAuditor::activated(QObject *receiver)
+{
+    auto key = mKeys.constFind(receiver);
+    if (key == mKeys.constEnd())
+    {
+        key = mKeys.insert(receiver, ownerKey(receiver));
+        connect(receiver, &QObject::destroyed, this, [this, receiver] { mKeys.remove(receiver); });
+    }
+
+    Stats &stats = mStats[key.value()];
+    ++stats.total;
+    if (isIdle())
+    {
+        ++stats.idle;
+        ++mIdleWakeups;
+    }
+
+    // the timer belongs to the nearest widget up the parent chain
+    for (QObject *o = receiver; o; o = o->parent())
+    {
+        if (o->isWidgetType())
+        {
+            if (!static_cast<QWidget *>(o)->isVisible())
+                ++stats.hidden;
+            break;
+        }
+    }
+}
+
+QByteArray WakeupAuditor::ownerKey(QObject *receiver)
+{
+    QByteArray key;
+    if (receiver->parent())
+    {
+        key += receiver->parent()->metaObject()->className();
+        key += '/';
+    }
+    key += receiver->metaObject()->className();
+    if (!receiver->objectName().isEmpty())
+    {
+        key += '(';
+        key += receiver->objectName().toUtf8();
+        key += ')';
+    }
+    if (QTimer *timer = qobject_cast<QTimer *>(receiver))
+    {
+        key += ' ';
+        key += QByteArray::number(timer->interval());
+        key += "ms";
+    }
+    return key;
+}
+
+void WakeupAuditor::presenceChanged(uint status)
+{
+    setIdle(status == PRESENCE_IDLE, mScreenIdle);
+}
+
+void WakeupAuditor::setIdle(bool sessionIdle, bool screenIdle)
+{
+    const bool wasIdle = isIdle();
+    mSessionIdle = sessionIdle;
+    mScreenIdle = screenIdle;
+
+    if (wasIdle && !isIdle())
+        mIdleMsecs += mIdleSince.elapsed();
+    else if (!wasIdle && isIdle())
+        mIdleSince.start();
+}
+
+qint64 WakeupAuditor::idleMsecs() const
+{
+    return mIdleMsecs + (isIdle() ? mIdleSince.elapsed() : 0);
+}
+
+double WakeupAuditor::idleRate() const
+{
+    const qint64 msecs = idleMsecs();
+    return msecs > 0 ? mIdleWakeups * 1000.0 / msecs : 0.0;
+}
+
+// time since the last input to any window, -1 without the X screensaver extension
+qint64 WakeupAuditor::screenIdleMsecs()
+{
+#ifdef HAVE_XSS
+    if (!QX11Info::isPlatformX11())
+        return -1;
+    Display *display = QX11Info::display();
+    int eventBase, errorBase;
+    if (!XScreenSaverQueryExtension(display, &eventBase, &errorBase))
+        return -1;
+    XScreenSaverInfo *info = XScreenSaverAllocInfo();
+    if (!info)
+        return -1;
+    qint64 msecs = -1;
+    if (XScreenSaverQueryInfo(display, QX11Info::appRootWindow(), info))
+        msecs = info->idle;
+    XFree(info);
+    return msecs;
+#else
+    return -1;
+#endif
+}
+
+void WakeupAuditor::checkIdle()
+{
+    const qint64 screenIdle = screenIdleMsecs();
+    if (screenIdle >= 0)
+        setIdle(mSessionIdle, screenIdle >= WAKEUP_SCREEN_IDLE);
+
+    // the rate over the idle time since the previous check
+    const qint64 msecs = idleMsecs();
+    const qint64 idleDelta = msecs - mCheckedMsecs;
+    const qint64 wakeupDelta = mIdleWakeups - mCheckedWakeups;
+    mCheckedMsecs = msecs;
+    mCheckedWakeups = mIdleWakeups;
+
+    if (idleDelta < WAKEUP_CHECK_INTERVAL / 2)
+        return;
+
+    const double rate = wakeupDelta * 1000.0 / idleDelta;
+    if (rate > WAKEUP_BUDGET)
+    {
+        qWarning() << "WakeupAuditor:" << rate << "idle wakeups/s, budget" << WAKEUP_BUDGET;
+        const QStringList lines = report().split(QLatin1Char('\n'), QString::SkipEmptyParts);
+        for (int i = 1; i < qMin(4, lines.size()); ++i)
+            qWarning() << "   " << lines.at(i);
+    }
+}
+
+QString WakeupAuditor::report() const
+{
+    QVector<QHash<QByteArray, Stats>::const_iterator> owners;
+    for (auto it = mStats.constBegin(); it != mStats.constEnd(); ++it)
+        owners << it;
+    std::sort(owners.begin(), owners.end(), [] (QHash<QByteArray, Stats>::const_iterator a,
+                                              QHash<QByteArray, Stats>::const_iterator b) {
+        if (a.value().idle != b.value().idle)
+            return a.value().idle > b.value().idle;
+        return a.value().total > b.value().total;
+    });
+
+    const qint64 msecs = idleMsecs();
+    QString result = QStringLiteral("auditing %1, %2 idle wakeups in %3 s idle (%4/s, budget %5/s), idle now: %6\n")
+            .arg(mEnabled ? QStringLiteral("on") : QStringLiteral("off"))
+            .arg(mIdleWakeups)
+            .arg(msecs / 1000)
+            .arg(idleRate(), 0, 'f', 2)
+            .arg(WAKEUP_BUDGET)
+            .arg(isIdle() ? QStringLiteral("yes") : QStringLiteral("no"));
+    for (auto it : qAsConst(owners))
+    {
+        const Stats &stats = it.value();
+        result += QStringLiteral("%1: %2 idle (%3/s), %4 total, %5 while hidden\n")
+                .arg(QString::fromUtf8(it.key()))
+                .arg(stats.idle)
+                .arg(msecs > 0 ? stats.idle * 1000.0 / msecs : 0.0, 0, 'f', 2)
+                .arg(stats.total)
+                .arg(stats.hidden);
+    }
+    return result;
+}
+
+void WakeupAuditor::reset()
+{
+    mStats.clear();
+    mIdleWakeups = 0;
+    mIdleMsecs = 0;
+    mCheckedWakeups = 0;
+    mCheckedMsecs = 0;
+    if (isIdle())
+        mIdleSince.restart();
+}
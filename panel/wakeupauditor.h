@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#ifndef WAKEUPAUDITOR_H
+#define WAKEUPAUDITOR_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+#include "ukuipanelglobals.h"
+
+class QTimer;
+
+/*! \brief Counts the timer and socket notifier wakeups of the panel.
+ *
+ * Installed as an application event filter, so every QTimer, startTimer()
+ * timer and QSocketNotifier on the GUI thread is seen without registering it
+ * anywhere. Activations are grouped by owner (the class of the parent object,
+ * the class and name of the timer and its interval) and counted separately
+ * while the session is idle. An activation whose nearest widget is hidden is
+ * flagged, such timers usually should have been stopped.
+ *
+ * The session counts as idle while org.gnome.SessionManager.Presence says so,
+ * or while the X screensaver extension reports no input to any window for
+ * a minute; input to the panel's own windows alone says nothing about the
+ * session. The idle time is polled with the budget check. If the idle wakeup
+ * rate goes over the budget the worst owners are logged. report() is exported
+ * on the session bus as com.ukui.panel.debug.WakeupAuditor at /wakeups.
+ *
+ * Disabled by default: an application event filter costs a call for every
+ * event. It is enabled by UKUI_PANEL_AUDIT_WAKEUPS=1 or setEnabled() on the
+ * session bus; only then are the filter and the check timer installed.
+ */
+class UKUI_PANEL_API WakeupAuditor : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "com.ukui.panel.debug.WakeupAuditor")
+public:
+    static WakeupAuditor *instance();
+
+    bool isEnabled() const { return mEnabled; }
+    bool isIdle() const { return mSessionIdle || mScreenIdle; }
+    //! wakeups per second while idle, since the last reset()
+    double idleRate() const;
+
+public slots:
+    Q_SCRIPTABLE void setEnabled(bool enabled);
+    //! owners ranked by idle wakeups, one line each
+    Q_SCRIPTABLE QString report() const;
+    Q_SCRIPTABLE void reset();
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private slots:
+    void presenceChanged(uint status);
+    void checkIdle();
+
+private:
+    explicit WakeupAuditor(QObject *parent = nullptr);
+
+    struct Stats
+    {
+        Stats() : total(0), idle(0), hidden(0) {}
+        qint64 total;
+        qint64 idle;
+        qint64 hidden;
+    };
+
+    void activated(QObject *receiver);
+    QByteArray ownerKey(QObject *receiver);
+    void setIdle(bool sessionIdle, bool screenIdle);
+    qint64 idleMsecs() const;
+    static qint64 screenIdleMsecs();
+
+    QHash<QObject *, QByteArray> mKeys;     // receiver -> owner key, dropped when destroyed
+    QHash<QByteArray, Stats> mStats;
+    bool mEnabled;
+    bool mSessionIdle;
+    bool mScreenIdle;
+    QElapsedTimer mIdleSince;
+    qint64 mIdleMsecs;
+    qint64 mIdleWakeups;
+    qint64 mCheckedWakeups;
+    qint64 mCheckedMsecs;
+    QTimer *mCheckTimer;
+};
+
+#endif // WAKEUPAUDITOR_H
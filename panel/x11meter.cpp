@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include "x11meter.h"
+
+#include <algorithm>
+#include <QDBusConnection>
+#include <QDebug>
+#include <QMutexLocker>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
+
+#include <X11/Xlib.h>
+
+#define X11METER_DBUS_PATH      "/x11meter"
+#define X11METER_SUMMARY        (5 * 60 * 1000)
+
+bool X11Meter::sEnabled = false;
+
+X11Meter *X11Meter::instance()
+{
+    static X11Meter *meter = new X11Meter;
+    return meter;
+}
+
+X11Meter::X11Meter(QObject *parent)
+    : QObject(parent),
+      mDisplaysOpened(0),
+      mDisplaysOpen(0),
+      mSummaryTimer(new QTimer(this))
+{
+    mSince.start();
+
+    connect(mSummaryTimer, &QTimer::timeout, this, &X11Meter::logSummary);
+    mSummaryTimer->setInterval(X11METER_SUMMARY);
+
+    QDBusConnection::sessionBus().registerObject(QStringLiteral(X11METER_DBUS_PATH), this,
+                                                 QDBusConnection::ExportScriptableSlots);
+
+    if (qgetenv("UKUI_PANEL_METER_X11") == "1")
+        setEnabled(true);
+}
+
+void X11Meter::setEnabled(bool enabled)
+{
+    sEnabled = enabled;
+    if (enabled)
+        mSummaryTimer->start();
+    else
+        mSummaryTimer->stop();
+}
+
+Display *X11Meter::openDisplay(const char *plugin, const char *site)
+{
+    Display *display = measure(plugin, "XOpenDisplay", site, [] { return XOpenDisplay(nullptr); });
+    if (display && sEnabled)
+    {
+        X11Meter *meter = instance();
+        QMutexLocker locker(&meter->mMutex);
+        ++meter->mDisplaysOpened;
+        ++meter->mDisplaysOpen;
+    }
+    return display;
+}
+
+void X11Meter::closeDisplay(Display *display)
+{
+    if (!display)
+        return;
+    XCloseDisplay(display);
+    if (!sEnabled)
+        return;
+
+    X11Meter *meter = instance();
+    QMutexLocker locker(&meter->mMutex);
+    // the display may have been opened before metering was switched on
+    if (meter->mDisplaysOpen > 0)
+        --meter->mDisplaysOpen;
+}
+
+void X11Meter::record(const char *plugin, const char *request, const char *site, qint64 nsecs)
+{
+    if (!sEnabled)
+        return;
+
+    QByteArray key(plugin);
+    key += ' ';
+    key += request;
+    key += " @ ";
+    key += site;
+
+    QMutexLocker locker(&mMutex);
+    Stats &stats = mSites[key];
+    if (stats.count == 0)
+        stats.plugin = plugin;
+    ++stats.count;
+    stats.nsecs += nsecs;
+    stats.maxNsecs = qMax(stats.maxNsecs, nsecs);
+}
+
+QString X11Meter::report() const
+{
+    QMutexLocker locker(&mMutex);
+
+    QVector<QHash<QByteArray, Stats>::const_iterator> sites;
+    qint64 count = 0;
+    qint64 nsecs = 0;
+    for (auto it = mSites.constBegin(); it != mSites.constEnd(); ++it)
+    {
+        sites << it;
+        count += it.value().count;
+        nsecs += it.value().nsecs;
+    }
+    std::sort(sites.begin(), sites.end(), [] (QHash<QByteArray, Stats>::const_iterator a,
+                                             QHash<QByteArray, Stats>::const_iterator b) {
+        return a.value().nsecs > b.value().nsecs;
+    });
+
+    const qint64 msecs = qMax<qint64>(1, mSince.elapsed());
+    QString result = QStringLiteral("metering %1, %2 round trips in %3 s (%4/s), %5 ms waiting, %6 displays opened, %7 open\n")
+            .arg(sEnabled ? QStringLiteral("on") : QStringLiteral("off"))
+            .arg(count)
+            .arg(msecs / 1000)
+            .arg(count * 1000.0 / msecs, 0, 'f', 1)
+            .arg(nsecs / 1000000)
+            .arg(mDisplaysOpened)
+            .arg(mDisplaysOpen);
+    for (auto it : qAsConst(sites))
+    {
+        const Stats &stats = it.value();
+        result += QStringLiteral("%1: %2 calls, avg %3 us, max %4 us, total %5 ms\n")
+                .arg(QString::fromLatin1(it.key()))
+                .arg(stats.count)
+                .arg(stats.nsecs / stats.count / 1000)
+                .arg(stats.maxNsecs / 1000)
+                .arg(stats.nsecs / 1000000);
+    }
+    return result;
+}
+
+void X11Meter::reset()
+{
+    QMutexLocker locker(&mMutex);
+    mSites.clear();
+    mLogged.clear();
+    mDisplaysOpened = 0;
+    mSince.restart();
+}
+
+void X11Meter::logSummary()
+{
+    QHash<QByteArray, qint64> totals;
+    {
+        QMutexLocker locker(&mMutex);
+        for (auto it = mSites.constBegin(); it != mSites.constEnd(); ++it)
+            totals[it.value().plugin] += it.value().count;
+    }
+
+    // only the plugins that made requests since the last summary
+    QStringList parts;
+    for (auto it = totals.constBegin(); it != totals.constEnd(); ++it)
+    {
+        const qint64 delta = it.value() - mLogged.value(it.key());
+        if (delta > 0)
+            parts << QStringLiteral("%1 %2 (%3/s)")
+                     .arg(QString::fromLatin1(it.key()))
+                     .arg(delta)
+                     .arg(delta * 1000.0 / X11METER_SUMMARY, 0, 'f', 2);
+    }
+    mLogged = totals;
+
+    if (!parts.isEmpty())
+        qDebug() << "X11 round trips:" << parts.join(QStringLiteral(", "));
+}
@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#ifndef X11METER_H
+#define X11METER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include "ukuipanelglobals.h"
+
+class QTimer;
+typedef struct _XDisplay Display;
+
+/*! \brief Counts and times the synchronous X requests of the panel process.
+ *
+ * Every request that waits for a reply (a round trip) is wrapped at its call
+ * site with measure() or a Trip, together with the plugin it belongs to.
+ * Extra display connections are opened and closed through openDisplay() and
+ * closeDisplay() so they are counted as well.
+ *
+ * The numbers are available from report(), which is also exported on the
+ * session bus as com.ukui.panel.debug.X11Meter at /x11meter, and a short
+ * summary per plugin is logged every few minutes while there is traffic.
+ *
+ * Disabled by default, measure() then only tests a flag and no summary timer
+ * runs. It is enabled by UKUI_PANEL_METER_X11=1 or setEnabled() on the
+ * session bus.
+ */
+class UKUI_PANEL_API X11Meter : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "com.ukui.panel.debug.X11Meter")
+public:
+    //! records one round trip when it goes out of scope
+    class Trip
+    {
+    public:
+        Trip(const char *plugin, const char *request, const char *site)
+            : mPlugin(plugin), mRequest(request), mSite(site)
+        {
+            mTimer.start();
+        }
+        ~Trip()
+        {
+            X11Meter::instance()->record(mPlugin, mRequest, mSite, mTimer.nsecsElapsed());
+        }
+
+    private:
+        Q_DISABLE_COPY(Trip)
+        const char *mPlugin;
+        const char *mRequest;
+        const char *mSite;
+        QElapsedTimer mTimer;
+    };
+
+    static X11Meter *instance();
+
+    static bool isEnabled() { return sEnabled; }
+
+    //! runs call, a synchronous X request, and records it, e.g.
+    //! X11Meter::measure("tray", "XGetImage", Q_FUNC_INFO, [&] { return XGetImage(...); })
+    template <typename Call>
+    static auto measure(const char *plugin, const char *request, const char *site, Call call) -> decltype(call())
+    {
+        if (!sEnabled)
+            return call();
+        Trip trip(plugin, request, site);
+        return call();
+    }
+
+    //! XOpenDisplay(nullptr), counted and timed
+    static Display *openDisplay(const char *plugin, const char *site);
+    //! XCloseDisplay() for a display from openDisplay(), display may be null
+    static void closeDisplay(Display *display);
+
+    void record(const char *plugin, const char *request, const char *site, qint64 nsecs);
+
+public slots:
+    Q_SCRIPTABLE void setEnabled(bool enabled);
+    //! totals, then one line per call site, the most expensive first
+    Q_SCRIPTABLE QString report() const;
+    Q_SCRIPTABLE void reset();
+
+private slots:
+    void logSummary();
+
+private:
+    explicit X11Meter(QObject *parent = nullptr);
+
+    struct Stats
+    {
+        Stats() : count(0), nsecs(0), maxNsecs(0) {}
+        QByteArray plugin;
+        qint64 count;
+        qint64 nsecs;
+        qint64 maxNsecs;
+    };
+
+    static bool sEnabled;
+    mutable QMutex mMutex;
+    QHash<QByteArray, Stats> mSites;
+    QHash<QByteArray, qint64> mLogged;      // round trips per plugin at the last summary
+    qint64 mDisplaysOpened;
+    qint64 mDisplaysOpen;
+    QElapsedTimer mSince;
+    QTimer *mSummaryTimer;
+};
+
+#endif // X11METER_H
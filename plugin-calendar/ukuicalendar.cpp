@@ -38,6 +38,8 @@
 #include <QWheelEvent>
 #include <QProcess>
 #include "../panel/pluginsettings.h"
+#include "../panel/gsettingsregistry.h"
+#include "../panel/painttracer.h"
 #include <QDebug>
 #include <QApplication>
 #include <QtWebKit/qwebsettings.h>
@@ -98,7 +100,7 @@ IndicatorCalendar::IndicatorCalendar(const IUKUIPanelPluginStartupInfo &startupI
     mTimer->setTimerType(Qt::PreciseTimer);
 
     const QByteArray id(HOUR_SYSTEM_CONTROL);
-    gsettings = new QGSettings(id);
+    gsettings = GSettingsRegistry::instance()->settings(id);
 
     if(QString::compare(gsettings->get("date").toString(),"cn"))
     {
@@ -265,18 +267,11 @@ void IndicatorCalendar::updateTimeText()
     //    if (!isUpToDate || mbIsNeedUpdate)
     //    {
     //const QSize old_size = mContent->sizeHint();
-    const QByteArray _id("org.ukui.style");
-    QGSettings *fgsettings = new QGSettings(_id);
     QString str;
     const QByteArray id(HOUR_SYSTEM_CONTROL);
     if(QGSettings::isSchemaInstalled(id))
     {
-        gsettings = new QGSettings(id);
-        QStringList keys = gsettings->keys();
-        if(keys.contains("hoursystem"))
-            hourSystemMode=gsettings->get("hoursystem").toString();
-        if(!gsettings)
-            return;
+        hourSystemMode = GSettingsRegistry::instance()->value(id, "hoursystem", hourSystemMode).toString();
         if(!QString::compare("24",hourSystemMode))
         {
             if(panel()->isHorizontal())
@@ -305,6 +300,8 @@ void IndicatorCalendar::updateTimeText()
         else
             str=tzNow.toString(hourSystem_24_vartical);
     }
+    if (!isUpToDate)
+        PaintTracer::trace(mContent, "clock");
     mContent->setText(str);
     mContent->setStyleSheet(
                 //正常状态样式
@@ -326,7 +323,7 @@ void IndicatorCalendar::updateTimeText()
                 "}"
                 );
     QFont font;
-    int font_size = fgsettings->get("system-font-size").toInt() +
+    int font_size = GSettingsRegistry::instance()->value("org.ukui.style", "system-font-size").toInt() +
                     mContent->getmPlugin()->panel()->panelSize() / 23 - 1;
     font.setPixelSize(font_size);
     mContent->setFont(font);
@@ -76,7 +76,12 @@ public:
 public slots:
     void execAction(QString additionalAction = QString{});
 
+private slots:
+    void launchFailed(const QString &id);
+
 private:
+    void showLaunchError();
+
     enum ActionType { ActionLegacy, ActionXdg, ActionFile };
     ActionType m_type;
     QString m_data;
@@ -25,8 +25,10 @@
  * END_COMMON_COPYRIGHT_HEADER */
 
 #include "quicklaunchbutton.h"
+#include "../panel/launchmanager.h"
 #include "ukuiquicklaunch.h"
 #include "../panel/iukuipanelplugin.h"
+#include "../panel/gsettingsregistry.h"
 #include <QAction>
 #include <QDrag>
 #include <QMenu>
@@ -62,12 +64,9 @@ QuickLaunchButton::QuickLaunchButton(QuickLaunchAction * act, IUKUIPanelPlugin *
 
     /*设置快速启动栏的菜单项*/
     const QByteArray id(UKUI_PANEL_SETTINGS);
-    mgsettings = new QGSettings(id);
     modifyQuicklaunchMenuAction(true);
-    connect(mgsettings, &QGSettings::changed, this, [=] (const QString &key){
-        if(key==PANELPOSITION){
-            modifyQuicklaunchMenuAction(true);
-        }
+    GSettingsRegistry::instance()->subscribe(id, PANELPOSITION, this, [=] {
+        modifyQuicklaunchMenuAction(true);
     });
 
     setContextMenuPolicy(Qt::CustomContextMenu);
@@ -150,6 +149,7 @@ void QuickLaunchButton::selfRemove()
 void QuickLaunchButton::enterEvent(QEvent *)
 {
     //quicklanuchstatus =HOVER;
+    LaunchManager::instance()->prewarm(file_name);
     repaint();
 }
 
@@ -304,7 +304,6 @@ void QuickLaunchButton::dropEvent(QDropEvent *e)
         if (_action)
             uqk->pubAddButton(_action);
     }
-    uqk->saveSettings();
 
 }
 /***************************************************/
@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#include "quicklaunchjournal.h"
+#include "../panel/pluginsettings.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QLockFile>
+#include <QTimer>
+
+/* 超过该数量的记录后把日志合并回 panel.conf 中的 apps 数组 */
+#define JOURNAL_COMPACT_RECORDS  64
+/* 日志中有未合并的记录时，最长隔多久合并一次(ms) */
+#define JOURNAL_COMPACT_INTERVAL (5 * 60 * 1000)
+
+QuickLaunchJournal::QuickLaunchJournal(PluginSettings *settings, QObject *parent) :
+    QObject(parent),
+    mSettings(settings),
+    mOffset(0),
+    mRecords(0),
+    mWatcher(new QFileSystemWatcher(this)),
+    mCompactTimer(new QTimer(this))
+{
+    mJournalPath = QString("%1.%2.journal").arg(mSettings->fileName(), mSettings->group());
+
+    mCompactTimer->setSingleShot(true);
+    mCompactTimer->setInterval(JOURNAL_COMPACT_INTERVAL);
+    connect(mCompactTimer, &QTimer::timeout, this, &QuickLaunchJournal::compact);
+
+    loadSnapshot();
+    {
+        QLockFile lock(mJournalPath + QLatin1String(".lock"));
+        lock.lock();
+        QFile file(mJournalPath);
+        if (!file.exists() || file.size() == 0)
+            writeGeneration();
+        replay(false);
+    }
+
+    mWatcher->addPath(mJournalPath);
+    connect(mWatcher, &QFileSystemWatcher::fileChanged, this, &QuickLaunchJournal::journalChanged);
+}
+
+QuickLaunchJournal::~QuickLaunchJournal()
+{
+    if (mRecords > 0)
+        compact();
+}
+
+QString QuickLaunchJournal::pinKey(const Pin &pin)
+{
+    if (pin.contains("desktop"))
+        return pin.value("desktop").toString();
+    if (pin.contains("file"))
+        return pin.value("file").toString();
+    return pin.value("exec").toString();
+}
+
+void QuickLaunchJournal::appendAdd(const Pin &pin, const QString &before)
+{
+    append(QByteArray(1, OpAdd) + '\t' + encodePin(pin) + '\t' + before.toUtf8().toPercentEncoding());
+}
+
+void QuickLaunchJournal::appendMove(const QString &key, const QString &before)
+{
+    append(QByteArray(1, OpMove) + '\t' + key.toUtf8().toPercentEncoding() + '\t' + before.toUtf8().toPercentEncoding());
+}
+
+void QuickLaunchJournal::appendRemove(const QString &key)
+{
+    append(QByteArray(1, OpRemove) + '\t' + key.toUtf8().toPercentEncoding());
+}
+
+void QuickLaunchJournal::append(const QByteArray &record)
+{
+    {
+        QLockFile lock(mJournalPath + QLatin1String(".lock"));
+        lock.lock();
+        // pick up what the other panel instances wrote before our record
+        replay(true);
+        if (!applyRecord(record, false))
+            return;
+
+        QFile file(mJournalPath);
+        if (file.size() == 0)
+            writeGeneration();
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Append))
+        {
+            qWarning() << "Can't append to quicklaunch journal" << mJournalPath << file.errorString();
+            return;
+        }
+        file.write(record + '\n');
+        file.close();
+        mOffset = file.size();
+        ++mRecords;
+    }
+
+    if (mRecords >= JOURNAL_COMPACT_RECORDS)
+        compact();
+    else if (!mCompactTimer->isActive())
+        mCompactTimer->start();
+}
+
+void QuickLaunchJournal::compact()
+{
+    QLockFile lock(mJournalPath + QLatin1String(".lock"));
+    lock.lock();
+    replay(true);
+
+    mSettings->remove("apps");
+    mSettings->setArray("apps", mPins);
+    // the snapshot has to hit the disk before the journal is dropped
+    mSettings->sync();
+
+    writeGeneration();
+    mCompactTimer->stop();
+}
+
+void QuickLaunchJournal::journalChanged(const QString &path)
+{
+    replay(true);
+    // the watch is lost if the file was replaced
+    if (!mWatcher->files().contains(path) && QFile::exists(path))
+        mWatcher->addPath(path);
+}
+
+void QuickLaunchJournal::loadSnapshot()
+{
+    mPins = mSettings->readArray("apps");
+}
+
+/* 日志第一行是生成号，每次合并后更新；生成号变化说明别的实例已经合并过，需要重新读取快照 */
+void QuickLaunchJournal::writeGeneration()
+{
+    QFile file(mJournalPath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "Can't write quicklaunch journal" << mJournalPath << file.errorString();
+        return;
+    }
+    mGeneration = QByteArray::number(QDateTime::currentMSecsSinceEpoch());
+    file.write(mGeneration + '\n');
+    mOffset = file.pos();
+    mRecords = 0;
+}
+
+void QuickLaunchJournal::replay(bool notify)
+{
+    QFile file(mJournalPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    const QByteArray generation = file.readLine().trimmed();
+    bool reset = false;
+    if (generation != mGeneration)
+    {
+        reset = !mGeneration.isNull();
+        mGeneration = generation;
+        mOffset = file.pos();
+        mRecords = 0;
+        if (reset)
+        {
+            mSettings->sync();
+            loadSnapshot();
+        }
+    }
+
+    if (!file.seek(mOffset))
+        return;
+    while (!file.atEnd())
+    {
+        QByteArray line = file.readLine();
+        // a half written record is picked up on the next change notification
+        if (!line.endsWith('\n'))
+            break;
+        line.chop(1);
+        mOffset = file.pos();
+        ++mRecords;
+        applyRecord(line, notify && !reset);
+    }
+
+    if (reset && notify)
+        emit pinsReset();
+}
+
+bool QuickLaunchJournal::applyRecord(const QByteArray &line, bool notify)
+{
+    const QList<QByteArray> fields = line.split('\t');
+    if (fields.isEmpty() || fields.first().size() != 1)
+        return false;
+    auto field = [&fields] (int i) {
+        return i < fields.size() ? QString::fromUtf8(QByteArray::fromPercentEncoding(fields.at(i))) : QString();
+    };
+
+    switch (fields.first().at(0))
+    {
+    case OpAdd: {
+        const Pin pin = decodePin(fields.value(1));
+        if (pinKey(pin).isEmpty() || indexOfKey(pinKey(pin)) >= 0)
+            return false;
+        insertBefore(pin, field(2));
+        if (notify)
+            emit pinAdded(pin, field(2));
+        return true;
+    }
+    case OpMove: {
+        const int index = indexOfKey(field(1));
+        if (index < 0 || field(1) == field(2))
+            return false;
+        insertBefore(mPins.takeAt(index), field(2));
+        if (notify)
+            emit pinMoved(field(1), field(2));
+        return true;
+    }
+    case OpRemove: {
+        const int index = indexOfKey(field(1));
+        if (index < 0)
+            return false;
+        mPins.removeAt(index);
+        if (notify)
+            emit pinRemoved(field(1));
+        return true;
+    }
+    default:
+        qWarning() << "Unknown quicklaunch journal record" << line;
+        return false;
+    }
+}
+
+int QuickLaunchJournal::indexOfKey(const QString &key) const
+{
+    for (int i = 0; i < mPins.size(); ++i)
+    {
+        if (pinKey(mPins.at(i)) == key)
+            return i;
+    }
+    return -1;
+}
+
+void QuickLaunchJournal::insertBefore(const Pin &pin, const QString &before)
+{
+    const int index = before.isEmpty() ? -1 : indexOfKey(before);
+    if (index < 0)
+        mPins.append(pin);
+    else
+        mPins.insert(index, pin);
+}
+
+QByteArray QuickLaunchJournal::encodePin(const Pin &pin)
+{
+    QList<QByteArray> entries;
+    for (auto it = pin.constBegin(); it != pin.constEnd(); ++it)
+        entries << it.key().toUtf8().toPercentEncoding() + '=' + it.value().toString().toUtf8().toPercentEncoding();
+    return entries.join('&');
+}
+
+QuickLaunchJournal::Pin QuickLaunchJournal::decodePin(const QByteArray &data)
+{
+    Pin pin;
+    const QList<QByteArray> entries = data.split('&');
+    for (const QByteArray &entry : entries)
+    {
+        const int sep = entry.indexOf('=');
+        if (sep <= 0)
+            continue;
+        pin.insert(QString::fromUtf8(QByteArray::fromPercentEncoding(entry.left(sep))),
+                   QString::fromUtf8(QByteArray::fromPercentEncoding(entry.mid(sep + 1))));
+    }
+    return pin;
+}
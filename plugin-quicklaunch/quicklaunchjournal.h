@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#ifndef QUICKLAUNCHJOURNAL_H
+#define QUICKLAUNCHJOURNAL_H
+
+#include <QObject>
+#include <QList>
+#include <QMap>
+#include <QString>
+#include <QVariant>
+
+class PluginSettings;
+class QFileSystemWatcher;
+class QTimer;
+
+/*! \brief Append-only journal of the quicklaunch pins.
+ *
+ * The "apps" array in the plugin settings is only the last compacted
+ * snapshot. Every add/move/remove appends a single record to a journal file
+ * next to the panel config, other panel instances watching the journal get
+ * the exact delta instead of reloading the whole array. The journal is folded
+ * back into the snapshot once it grows past a threshold, periodically while
+ * dirty, and on destruction.
+ *
+ * Moves and inserts are anchored on the key of the following pin (empty for
+ * the end of the list), so they stay valid when some pins are filtered out
+ * of the visible buttons by the security config.
+ */
+class QuickLaunchJournal : public QObject
+{
+    Q_OBJECT
+public:
+    typedef QMap<QString, QVariant> Pin;
+
+    explicit QuickLaunchJournal(PluginSettings *settings, QObject *parent = nullptr);
+    ~QuickLaunchJournal();
+
+    //! snapshot + replayed journal, in display order
+    QList<Pin> pins() const { return mPins; }
+
+    void appendAdd(const Pin &pin, const QString &before = QString());
+    void appendMove(const QString &key, const QString &before);
+    void appendRemove(const QString &key);
+
+    //! write the current pins as the settings snapshot and truncate the journal
+    void compact();
+
+    static QString pinKey(const Pin &pin);
+
+signals:
+    //! deltas written by another panel instance
+    void pinAdded(const QVariantMap &pin, const QString &before);
+    void pinMoved(const QString &key, const QString &before);
+    void pinRemoved(const QString &key);
+    //! the journal was compacted elsewhere, pins() has to be read again
+    void pinsReset();
+
+private slots:
+    void journalChanged(const QString &path);
+
+private:
+    enum Op { OpAdd = 'A', OpMove = 'M', OpRemove = 'R' };
+
+    void loadSnapshot();
+    void writeGeneration();
+    void replay(bool notify);
+    bool applyRecord(const QByteArray &line, bool notify);
+    void append(const QByteArray &record);
+
+    int indexOfKey(const QString &key) const;
+    void insertBefore(const Pin &pin, const QString &before);
+
+    static QByteArray encodePin(const Pin &pin);
+    static Pin decodePin(const QByteArray &data);
+
+    PluginSettings *mSettings;
+    QList<Pin> mPins;
+    QString mJournalPath;
+    QByteArray mGeneration;
+    qint64 mOffset;
+    int mRecords;
+    QFileSystemWatcher *mWatcher;
+    QTimer *mCompactTimer;
+};
+
+#endif // QUICKLAUNCHJOURNAL_H
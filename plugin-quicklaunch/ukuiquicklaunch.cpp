@@ -28,6 +28,7 @@
 #include "ukuiquicklaunch.h"
 #include "quicklaunchbutton.h"
 #include "quicklaunchaction.h"
+#include "quicklaunchjournal.h"
 #include "../panel/iukuipanelplugin.h"
 #include <QDesktopServices>
 #include <QDragEnterEvent>
@@ -57,12 +58,11 @@
 #include <QWidget>
 #include <QPushButton>
 #include <stdio.h>
-#include <pwd.h>
 #include <unistd.h>
-#include "json.h"
+#include "../panel/securitypolicy.h"
+#include "../panel/launchmanager.h"
+#include "../panel/gsettingsregistry.h"
 using namespace  std;
-using QtJson::JsonObject;
-using QtJson::JsonArray;
 
 #define PAGEBUTTON_SMALL_SIZE  20
 #define PAGEBUTTON_MEDIUM_SIZE 30
@@ -80,11 +80,6 @@ UKUIQuickLaunch::UKUIQuickLaunch(IUKUIPanelPlugin *plugin, QWidget* parent) :
     mPlaceHolder(0)
 {
 
-    struct passwd *pwd;
-    pwd=getpwuid(getuid());
-    pwd->pw_name;
-    SecurityConfigPath=QString("/home/")+pwd->pw_name+QString("/.config/ukui-panel-security-config.json");
-
     setAcceptDrops(true);
     mVBtn.clear();
 
@@ -110,29 +105,30 @@ UKUIQuickLaunch::UKUIQuickLaunch(IUKUIPanelPlugin *plugin, QWidget* parent) :
     _style->addWidget(pagedown,0,Qt::AlignHCenter);
     _style->setContentsMargins(0,1,0,10);
     //tmpwidget->setFixedSize(24,mPlugin->panel()->panelSize());
-    if(QGSettings::isSchemaInstalled(id)){
-        settings=new QGSettings(id);
-    }
-    apps_number = settings->get("quicklaunchappsnumber").toInt();
+    GSettingsRegistry *registry = GSettingsRegistry::instance();
+    apps_number = registry->value(id, "quicklaunchappsnumber").toInt();
     GetMaxPage();
     old_page = page_num;
 
     connect(pageup,SIGNAL(clicked()),this,SLOT(PageUp()));
     connect(pagedown,SIGNAL(clicked()),this,SLOT(PageDown()));
-    connect(settings, &QGSettings::changed, this, [=] (const QString &key){
-        if (key == "quicklaunchappsnumber") {
-            apps_number = settings->get("quicklaunchappsnumber").toInt();
-            realign();
-        }
-        if(key==PANEL_LINES)
-        {
-            realign();
-            mLayout->removeWidget(tmpwidget);
-            mLayout->addWidget(tmpwidget);
-            mLayout->removeWidget(mPlaceHolder);
-        }
+    registry->subscribe(id, "quicklaunchappsnumber", this, [=] (const QVariant &value){
+        apps_number = value.toInt();
+        realign();
+    });
+    registry->subscribe(id, PANEL_LINES, this, [=] {
+        realign();
+        mLayout->removeWidget(tmpwidget);
+        mLayout->addWidget(tmpwidget);
+        mLayout->removeWidget(mPlaceHolder);
     });
+    mJournal = new QuickLaunchJournal(mPlugin->settings(), this);
+    connect(mJournal, &QuickLaunchJournal::pinAdded, this, &UKUIQuickLaunch::journalPinAdded);
+    connect(mJournal, &QuickLaunchJournal::pinMoved, this, &UKUIQuickLaunch::journalPinMoved);
+    connect(mJournal, &QuickLaunchJournal::pinRemoved, this, &UKUIQuickLaunch::journalPinRemoved);
+    connect(mJournal, &QuickLaunchJournal::pinsReset, this, [this] { refreshQuickLaunch("init"); });
     refreshQuickLaunch("init");
+    connect(SecurityPolicy::instance(), &SecurityPolicy::policyChanged, this, [this] { refreshQuickLaunch("ukui-panel2"); });
     QDBusConnection::sessionBus().connect(QString(), QString("/org/kylinssoclient/path"), "org.freedesktop.kylinssoclient.interface", "keyChanged", this, SLOT(refreshQuickLaunch(QString)));
 
     /*监听系统应用的目录以及安卓兼容应用的目录*/
@@ -157,144 +153,32 @@ UKUIQuickLaunch::~UKUIQuickLaunch()
     mVBtn.clear();
 }
 
+/*安全配置由 SecurityPolicy 统一解析和监视，变化后通过 policyChanged 刷新*/
 void UKUIQuickLaunch::ReloadSecurityConfig(){
-    this->loadJsonfile();
-    this->refreshQuickLaunch("ukui-panel2");
+    SecurityPolicy::instance()->reload();
 }
 
 QString UKUIQuickLaunch::GetSecurityConfigPath(){
-    return SecurityConfigPath;
-}
-QString UKUIQuickLaunch::readFile(const QString &filename) {
-    QFile f(filename);
-    if (!f.open(QFile::ReadOnly)) {
-        return QString();
-    } else {
-        QTextStream in(&f);
-        return in.readAll();
-    }
-}
-
-void UKUIQuickLaunch::loadJsonfile() {
-    QString json = readFile(SecurityConfigPath);
-    if (json.isEmpty()) {
-        qFatal("Could not read JSON file!");
-        return ;
-    }
-    bool ok;
-    JsonObject result = QtJson::parse(json, ok).toMap();
-    QVariant fristLayer;
-    fristLayer=result.value("ukui-panel");
-    mModel=fristLayer.toMap().value("mode").toString();
-
-    QVariant blacklistLayer;
-    blacklistLayer=fristLayer.toMap().value("blacklist");
-    QVariant whitelistLayer;
-    whitelistLayer=fristLayer.toMap().value("whitelist");
-
-    if(!blacklistLayer.isNull()){
-        QList<QVariant> thirdLayer;
-        thirdLayer=blacklistLayer.toList();
-        QMap<QString,QVariant> fourthLayer;
-        fourthLayer=thirdLayer.at(0).toMap();
-        QList<QVariant> fifthLayer;
-        fifthLayer=fourthLayer.value("entries").toList();
-        QMap<QString,QVariant> attribute;
-        QList<QString> blackNames;
-        for(int i=0;i<fifthLayer.size();i++){
-            attribute=fifthLayer.at(i).toMap();
-            blackNames.append(attribute.value("path").toString());
-        }
-        blacklist=blackNames;
-    }
-
-    if(!whitelistLayer.isNull()){
-        QList<QVariant> thirdLayer;
-        thirdLayer=whitelistLayer.toList();
-        QMap<QString,QVariant> fourthLayer;
-        fourthLayer=thirdLayer.at(0).toMap();
-        QList<QVariant> fifthLayer;
-        fifthLayer=fourthLayer.value("entries").toList();
-        QMap<QString,QVariant> attribute;
-        QList<QString> whiteNames;
-        for(int i=0;i<fifthLayer.size();i++){
-            attribute=fifthLayer.at(i).toMap();
-            whiteNames.append(attribute.value("path").toString());
-        }
-        whitelist=whiteNames;
-    }
+    return SecurityPolicy::instance()->configPath();
 }
 
 /*任务栏刷新  在快读启动栏初始化和云账户同步的时候调用*/
 void UKUIQuickLaunch::refreshQuickLaunch(QString ssoclient){
     if(ssoclient != "ukui-panel2" && ssoclient != "init")
         return;
-    QStringList mblacklist;
-    QStringList mwhitelist;
-    if(mModel=="blacklist")
-    mblacklist=blacklist;
-    if(mModel=="whitelist")
-    mwhitelist=whitelist;
     for(auto it = mVBtn.begin(); it != mVBtn.end();)
     {
         (*it)->deleteLater();
         mVBtn.erase(it);
     }
 
-    QString desktop;
-    QString file;
-    QString execname;
-    QString exec;
-    QString icon;
-    //qsetting的方式读取写入 apps
-    const auto apps = mPlugin->settings()->readArray("apps");
+    //快照加上日志中的记录
+    const auto apps = mJournal->pins();
     for (const QMap<QString, QVariant> &app : apps)
     {
-        desktop = app.value("desktop", "").toString();
-
-        if(mblacklist.contains(desktop)){
-            desktop.clear();
-        }
-        if(mModel=="whitelist"){
-            if(!mwhitelist.contains(desktop)){
-                desktop.clear();
-            }
-        }
-
-        file = app.value("file", "").toString();
-        if (!desktop.isEmpty())
-        {
-            XdgDesktopFile xdg;
-            if (!xdg.load(desktop))
-            {
-                qDebug() << "XdgDesktopFile" << desktop << "is not valid";
-                continue;
-            }
-            /* 检测desktop文件的属性，目前UKUI桌面环境不需要此进行isSuitable检测
-            if (!xdg.isSuitable())
-            {
-                qDebug() << "XdgDesktopFile" << desktop << "is not applicable";
-                continue;
-            }
-            */
-            addButton(new QuickLaunchAction(&xdg, this));
-        }
-        else if (! file.isEmpty())
-        {
-            addButton(new QuickLaunchAction(file, this));
-        }
-        else
-        {
-            execname = app.value("name", "").toString();
-            exec = app.value("exec", "").toString();
-            icon = app.value("icon", "").toString();
-        if (icon.isNull())
-            {
-                qDebug() << "Icon" << icon << "is not valid (isNull). Skipped.";
-                continue;
-            }
-            //addButton(new QuickLaunchAction(execname, exec, icon, this));
-        }
+        QuickLaunchAction *action = actionForPin(app);
+        if (action)
+            addButton(action);
     }
     int i = 0;
     int counts = countOfButtons();
@@ -313,6 +197,39 @@ void UKUIQuickLaunch::refreshQuickLaunch(QString ssoclient){
     mLayout->addWidget(tmpwidget);
 }
 
+/*根据固定项创建对应的action，被安全配置过滤或无效时返回NULL*/
+QuickLaunchAction *UKUIQuickLaunch::actionForPin(const QMap<QString, QVariant> &app)
+{
+    QString desktop = app.value("desktop", "").toString();
+    if(!SecurityPolicy::instance()->allows(desktop)){
+        desktop.clear();
+    }
+
+    QString file = app.value("file", "").toString();
+    if (!desktop.isEmpty())
+    {
+        const XdgDesktopFile xdg = LaunchManager::instance()->entry(desktop);
+        if (!xdg.isValid())
+        {
+            qDebug() << "XdgDesktopFile" << desktop << "is not valid";
+            return NULL;
+        }
+        /* 检测desktop文件的属性，目前UKUI桌面环境不需要此进行isSuitable检测
+        if (!xdg.isSuitable())
+        {
+            qDebug() << "XdgDesktopFile" << desktop << "is not applicable";
+            return NULL;
+        }
+        */
+        return new QuickLaunchAction(&xdg, this);
+    }
+    else if (! file.isEmpty())
+    {
+        return new QuickLaunchAction(file, this);
+    }
+    return NULL;
+}
+
 void UKUIQuickLaunch::PageUp() {
     --page_num;
     if (page_num < 1) page_num = max_page;
@@ -379,7 +296,7 @@ void UKUIQuickLaunch::realign()
             loop_times = apps_number;
             if (counts < apps_number) loop_times = counts - i;
             setMaximumWidth(mPlugin->panel()->panelSize() * apps_number + 27);
-            if(settings->get(PANEL_LINES).toInt()==1)
+            if(GSettingsRegistry::instance()->value(PANEL_SETTINGS, PANEL_LINES).toInt()==1)
             {
                 mLayout->setRowCount(panel->lineCount());
                 mLayout->setColumnCount(0);
@@ -419,7 +336,7 @@ void UKUIQuickLaunch::realign()
                 if (counts < 3) loop_times = counts - i;
                 setMaximumHeight(mPlugin->panel()->panelSize() * 3 + 27);
             }
-            if(settings->get(PANEL_LINES).toInt()==1)
+            if(GSettingsRegistry::instance()->value(PANEL_SETTINGS, PANEL_LINES).toInt()==1)
             {
             mLayout->setColumnCount(panel->lineCount());
             mLayout->setRowCount(0);
@@ -537,19 +454,46 @@ bool UKUIQuickLaunch::checkButton(QuickLaunchAction* action)
     delete btn;
 }
 
+/*固定到快速启动栏并写入日志*/
+void UKUIQuickLaunch::pinButton(QuickLaunchAction *action)
+{
+    addButton(action);
+    QuickLaunchButton *btn = mVBtn.last();
+    QMap<QString, QVariant> pin;
+    QHashIterator<QString, QString> it(btn->settingsMap());
+    while (it.hasNext())
+    {
+        it.next();
+        pin[it.key()] = it.value();
+    }
+    mJournal->appendAdd(pin);
+    emit PinAdded(buttonKey(btn), QString());
+}
+
 /* 删除　button*/
 void UKUIQuickLaunch::removeButton(QString filename)
 {
-    //QuickLaunchButton* btn = new QuickLaunchButton(action, mPlugin, this);
+    if (takeButton(filename))
+    {
+        mJournal->appendRemove(filename);
+        emit PinRemoved(filename);
+    }
+}
+
+/*只从界面上移除，不写日志*/
+bool UKUIQuickLaunch::takeButton(const QString &filename)
+{
+    bool found = false;
     for(auto it = mVBtn.begin();it != mVBtn.end();it++)
     {
         QuickLaunchButton *b = *it;
-        if(b->file_name == filename)
+        if(buttonKey(b) == filename)
         {
             mVBtn.erase(it);
             mLayout->removeWidget(b);
             b->deleteLater();
             this->repaint();
+            found = true;
             break;
          }
      }
@@ -560,10 +504,89 @@ void UKUIQuickLaunch::removeButton(QString filename)
         old_page = page_num;
         PageUp();
     }
-    saveSettings();
     mLayout->removeWidget(tmpwidget);
     mLayout->addWidget(tmpwidget);
     mLayout->removeWidget(mPlaceHolder);
+    return found;
+}
+
+QString UKUIQuickLaunch::buttonKey(QuickLaunchButton *button) const
+{
+    QMap<QString, QVariant> pin;
+    QHashIterator<QString, QString> it(button->settingsMap());
+    while (it.hasNext())
+    {
+        it.next();
+        pin[it.key()] = it.value();
+    }
+    return QuickLaunchJournal::pinKey(pin);
+}
+
+QuickLaunchButton *UKUIQuickLaunch::buttonForKey(const QString &key) const
+{
+    for (QuickLaunchButton *b : mVBtn)
+    {
+        if (buttonKey(b) == key)
+            return b;
+    }
+    return NULL;
+}
+
+/*布局中紧跟在button后面的应用，作为日志中移动操作的锚点*/
+QString UKUIQuickLaunch::keyOfButtonAfter(QuickLaunchButton *button) const
+{
+    const int index = indexOfButton(button);
+    if (index < 0 || index + 1 >= countOfButtons())
+        return QString();
+    QuickLaunchButton *next = qobject_cast<QuickLaunchButton*>(mLayout->itemAt(index + 1)->widget());
+    return next ? buttonKey(next) : QString();
+}
+
+void UKUIQuickLaunch::moveButtonBefore(QuickLaunchButton *button, const QString &before)
+{
+    QuickLaunchButton *anchor = before.isEmpty() ? NULL : buttonForKey(before);
+    const int from = indexOfButton(button);
+    int to = countOfButtons() - 1;
+    if (anchor)
+    {
+        to = indexOfButton(anchor);
+        if (from < to)
+            --to;
+    }
+    if (from < 0 || from == to)
+        return;
+
+    mLayout->moveItem(from, to);
+    mVBtn.removeOne(button);
+    if (anchor)
+        mVBtn.insert(mVBtn.indexOf(anchor), button);
+    else
+        mVBtn.append(button);
+    realign();
+}
+
+/*其它任务栏实例写入日志的增量*/
+void UKUIQuickLaunch::journalPinAdded(const QVariantMap &pin, const QString &before)
+{
+    if (buttonForKey(QuickLaunchJournal::pinKey(pin)))
+        return;
+    QuickLaunchAction *action = actionForPin(pin);
+    if (!action)
+        return;
+    addButton(action);
+    moveButtonBefore(mVBtn.last(), before);
+}
+
+void UKUIQuickLaunch::journalPinMoved(const QString &key, const QString &before)
+{
+    QuickLaunchButton *button = buttonForKey(key);
+    if (button)
+        moveButtonBefore(button, before);
+}
+
+void UKUIQuickLaunch::journalPinRemoved(const QString &key)
+{
+    takeButton(key);
 }
 
 void UKUIQuickLaunch::dragEnterEvent(QDragEnterEvent *e)
@@ -618,9 +641,8 @@ void UKUIQuickLaunch::dropEvent(QDropEvent *e)
                                      );
         }
         if (_action)
-            addButton(_action);
+            pinButton(_action);
     }
-    saveSettings();
 }
 
 // 只要任何监控的目录更新（添加、删除、重命名），就会调用。
@@ -688,15 +710,15 @@ bool UKUIQuickLaunch::AddToTaskbar(QString arg)
           but I don't need this attributes now
         */
         //        if (xdg.isSuitable())
-        addButton(new QuickLaunchAction(&xdg, this));
+        pinButton(new QuickLaunchAction(&xdg, this));
     }
     else if (fi.exists() && fi.isExecutable() && !fi.isDir())
     {
-        addButton(new QuickLaunchAction(fileName, fileName, "", this));
+        pinButton(new QuickLaunchAction(fileName, fileName, "", this));
     }
     else if (fi.exists())
     {
-        addButton(new QuickLaunchAction(fileName, this));
+        pinButton(new QuickLaunchAction(fileName, this));
     }
     else
     {
@@ -705,7 +727,6 @@ bool UKUIQuickLaunch::AddToTaskbar(QString arg)
                                  tr("File/URL '%1' cannot be embedded into QuickLaunch for now").arg(fileName)
                                  );
     }
-    saveSettings();
     return true;
 }
 
@@ -779,7 +800,10 @@ void UKUIQuickLaunch::switchButtons(QuickLaunchButton *button1, QuickLaunchButto
         return;
     mLayout->moveItem(l, m, true);
     mLayout->moveItem(m-1, l, true);
-    saveSettings();
+    mJournal->appendMove(buttonKey(button1), keyOfButtonAfter(button1));
+    mJournal->appendMove(buttonKey(button2), keyOfButtonAfter(button2));
+    emit PinMoved(buttonKey(button1), keyOfButtonAfter(button1));
+    emit PinMoved(buttonKey(button2), keyOfButtonAfter(button2));
 }
 
 /*右键删除*/
@@ -811,7 +835,8 @@ void UKUIQuickLaunch::buttonMoveLeft()
     {
         mLayout->moveItem(index, index - 1);
         mVBtn.move(index, index - 1);
-        saveSettings();
+        mJournal->appendMove(buttonKey(btn), keyOfButtonAfter(btn));
+        emit PinMoved(buttonKey(btn), keyOfButtonAfter(btn));
     }
 }
 
@@ -827,36 +852,17 @@ void UKUIQuickLaunch::buttonMoveRight()
     {
         mLayout->moveItem(index, index + 1);
         mVBtn.move(index, index + 1);
-        saveSettings();
+        mJournal->appendMove(buttonKey(btn1), keyOfButtonAfter(btn1));
+        emit PinMoved(buttonKey(btn1), keyOfButtonAfter(btn1));
     }
 }
 
-/*保持设置*/
+/*保持设置
+ * 平时的增删移动只在日志中追加一条记录，这里把日志合并回配置文件中的 apps 数组
+ */
 void UKUIQuickLaunch::saveSettings()
 {
-    PluginSettings *settings = mPlugin->settings();
-    settings->remove("apps");
-
-    QList<QMap<QString, QVariant> > hashList;
-    int size = mLayout->count();
-    for (int j = 0; j < size; ++j)
-    {
-        QuickLaunchButton *b = qobject_cast<QuickLaunchButton*>(mLayout->itemAt(j)->widget());
-        if (!b)
-            continue;
-
-        // convert QHash<QString, QString> to QMap<QString, QVariant>
-        QMap<QString, QVariant> map;
-        QHashIterator<QString, QString> it(b->settingsMap());
-        while (it.hasNext())
-        {
-            it.next();
-            map[it.key()] = it.value();
-        }
-        hashList << map;
-    }
-
-    settings->setArray("apps", hashList);
+    mJournal->compact();
 }
 
 /*在快速启动栏区域没有应用的时候显示一块空白的区域用以实现拖拽等操作
@@ -59,6 +59,7 @@ class XdgDesktopFile;
 class QuickLaunchAction;
 class QDragEnterEvent;
 class QuickLaunchButton;
+class QuickLaunchJournal;
 class QSettings;
 class QLabel;
 
@@ -86,7 +87,7 @@ public:
     //virtual QLayoutItem *takeAt(int index) = 0;
     void saveSettings();
     void showPlaceHolder();
-    void pubAddButton (QuickLaunchAction *action) { addButton(action); }
+    void pubAddButton (QuickLaunchAction *action) { pinButton(action); }
     bool pubCheckIfExist(QString name);
 
     friend class FilectrlAdaptor;
@@ -99,7 +100,7 @@ private:
     void dragEnterEvent(QDragEnterEvent *e);
     void dropEvent(QDropEvent *e);
     QVector<QuickLaunchButton*> mVBtn;
-    QGSettings *settings;
+    QuickLaunchJournal *mJournal;
     QFileSystemWatcher *fsWatcher;
     QMap<QString, QStringList> m_currentContentsMap; // 当前每个监控的内容目录列表
     QString desktopFilePath ="/usr/share/applications/";
@@ -113,16 +114,21 @@ private:
     int max_page;
     int old_page;
 
-    QList<QString> blacklist;
-    QList<QString> whitelist;
-    QString mModel;
-    QString SecurityConfigPath;
-
     void directoryUpdated(const QString &path);
     void GetMaxPage();
+    void pinButton(QuickLaunchAction *action);
+    bool takeButton(const QString &filename);
+    QuickLaunchButton *buttonForKey(const QString &key) const;
+    QString buttonKey(QuickLaunchButton *button) const;
+    QString keyOfButtonAfter(QuickLaunchButton *button) const;
+    void moveButtonBefore(QuickLaunchButton *button, const QString &before);
+    QuickLaunchAction *actionForPin(const QMap<QString, QVariant> &pin);
 
 signals:
     void setsizeoftaskbarbutton(int _size);
+    void PinAdded(const QString &key, const QString &before);
+    void PinMoved(const QString &key, const QString &before);
+    void PinRemoved(const QString &key);
 
 
 
@@ -137,8 +143,9 @@ private slots:
     void buttonMoveRight();
     void PageUp();
     void PageDown();
-    QString readFile(const QString &filename);
-    void loadJsonfile();
+    void journalPinAdded(const QVariantMap &pin, const QString &before);
+    void journalPinMoved(const QString &key, const QString &before);
+    void journalPinRemoved(const QString &key);
 
 public slots:
     bool AddToTaskbar(QString arg);
@@ -189,6 +196,17 @@ class FilectrlAdaptor: public QDBusAbstractAdaptor
 "    <method name=\"GetSecurityConfigPath\">\n"
 "      <arg direction=\"out\" type=\"s\"/>\n"
 "    </method>\n"
+"    <signal name=\"PinAdded\">\n"
+"      <arg type=\"s\" name=\"key\"/>\n"
+"      <arg type=\"s\" name=\"before\"/>\n"
+"    </signal>\n"
+"    <signal name=\"PinMoved\">\n"
+"      <arg type=\"s\" name=\"key\"/>\n"
+"      <arg type=\"s\" name=\"before\"/>\n"
+"    </signal>\n"
+"    <signal name=\"PinRemoved\">\n"
+"      <arg type=\"s\" name=\"key\"/>\n"
+"    </signal>\n"
 "  </interface>\n"
         "")
 public:
@@ -207,6 +225,9 @@ public Q_SLOTS: // METHODS
     QString GetSecurityConfigPath();
 
 Q_SIGNALS: // SIGNALS
+    void PinAdded(const QString &key, const QString &before);
+    void PinMoved(const QString &key, const QString &before);
+    void PinRemoved(const QString &key);
 
 signals:
     void addtak(int);
@@ -26,6 +26,7 @@
 
 #include "ukuiquicklaunchplugin.h"
 #include "ukuiquicklaunch.h"
+#include "../panel/launchmanager.h"
 
 
 UKUIQuickLaunchPlugin::UKUIQuickLaunchPlugin(const IUKUIPanelPluginStartupInfo &startupInfo):
@@ -57,3 +58,13 @@ void UKUIQuickLaunchPlugin::realign()
 {
     mWidget->realign();
 }
+
+/*在工作线程里预先解析固定应用的desktop文件*/
+void UKUIQuickLaunchPluginLibrary::prepare(const UKUi::PluginInfo &, const QVariantMap &settings) const
+{
+    for (auto it = settings.constBegin(); it != settings.constEnd(); ++it)
+    {
+        if (it.key().startsWith(QLatin1String("apps/")) && it.key().endsWith(QLatin1String("/desktop")))
+            LaunchManager::instance()->entry(it.value().toString());
+    }
+}
@@ -53,15 +53,17 @@ private:
 };
 
 
-class UKUIQuickLaunchPluginLibrary: public QObject, public IUKUIPanelPluginLibrary
+class UKUIQuickLaunchPluginLibrary: public QObject, public IUKUIPanelPluginLibrary, public IUKUIPanelPluginPreparer
 {
     Q_OBJECT
     // Q_PLUGIN_METADATA(IID "ukui.org/Panel/PluginInterface/3.0")
-    Q_INTERFACES(IUKUIPanelPluginLibrary)
+    Q_INTERFACES(IUKUIPanelPluginLibrary IUKUIPanelPluginPreparer)
 public:
     IUKUIPanelPlugin *instance(const IUKUIPanelPluginStartupInfo &startupInfo) const
     {
         return new UKUIQuickLaunchPlugin(startupInfo);
     }
+
+    void prepare(const UKUi::PluginInfo &desktopFile, const QVariantMap &settings) const;
 };
 #endif // UKUIQUICKLAUNCHPLUGIN_H
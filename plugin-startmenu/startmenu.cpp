@@ -29,6 +29,7 @@
 #include "QFileInfo"
 
 #include "../panel/customstyle.h"
+#include "../panel/processrunner.h"
 
 UKUIStartMenuPlugin::UKUIStartMenuPlugin(const IUKUIPanelPluginStartupInfo &startupInfo):
     QObject(),
@@ -161,51 +162,49 @@ void UKUIStartMenuButton::contextMenuEvent(QContextMenuEvent *event)
 //锁屏
 void UKUIStartMenuButton::ScreenServer()
 {
-    system("ukui-screensaver-command -l");
+    ProcessRunner::instance()->run("ukui-screensaver-command", QStringList() << "-l");
 }
 
 //切换用户
 void UKUIStartMenuButton::SessionSwitch()
 {
-    QProcess::startDetached(QString("ukui-session-tools --switchuser"));
+    ProcessRunner::instance()->startDetached("ukui-session-tools", QStringList() << "--switchuser");
 }
 
 //注销
 void UKUIStartMenuButton::SessionLogout()
 {
-    system("ukui-session-tools --logout");
+    ProcessRunner::instance()->startDetached("ukui-session-tools", QStringList() << "--logout");
 }
 
 //休眠 睡眠
 void UKUIStartMenuButton::SessionHibernate()
 {
-    system("ukui-session-tools --hibernate");
+    ProcessRunner::instance()->startDetached("ukui-session-tools", QStringList() << "--hibernate");
 }
 
 //挂起
 void UKUIStartMenuButton::SessionSuspend()
 {
-    system("ukui-session-tools --suspend");
+    ProcessRunner::instance()->startDetached("ukui-session-tools", QStringList() << "--suspend");
 }
 
 //重启
 void UKUIStartMenuButton::SessionReboot()
 {
-    system("ukui-session-tools --reboot");
+    ProcessRunner::instance()->startDetached("ukui-session-tools", QStringList() << "--reboot");
 }
 
 //定时关机
 void UKUIStartMenuButton::TimeShutdown()
 {
-    QProcess *process_timeshutdowm =new QProcess(this);
-    process_timeshutdowm->startDetached("/usr/bin/time-shutdown");
-    process_timeshutdowm->deleteLater();
+    ProcessRunner::instance()->startDetached("/usr/bin/time-shutdown");
 }
 
 //关机
 void UKUIStartMenuButton::SessionShutdown()
 {
-    system("ukui-session-tools --shutdown");
+    ProcessRunner::instance()->startDetached("ukui-session-tools", QStringList() << "--shutdown");
 }
 
 //获取系统版本,若为ubuntu则取消休眠功能
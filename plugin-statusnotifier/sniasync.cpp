@@ -46,3 +46,10 @@ QDBusPendingReply<QDBusVariant> SniAsync::asyncPropGet(QString const & property)
     msg << mSni.interface() << property;
     return mSni.connection().asyncCall(msg);
 }
+
+QDBusPendingReply<QVariantMap> SniAsync::asyncPropGetAll()
+{
+    QDBusMessage msg = QDBusMessage::createMethodCall(mSni.service(), mSni.path(), QLatin1String("org.freedesktop.DBus.Properties"), QLatin1String("GetAll"));
+    msg << mSni.interface();
+    return mSni.connection().asyncCall(msg);
+}
@@ -86,6 +86,30 @@ public:
         );
     }
 
+    //! one org.freedesktop.DBus.Properties.GetAll for all the item properties, F: (bool ok, QVariantMap) -> void
+    template <typename F>
+    inline void propertiesGetAllAsync(F finished)
+    {
+        connect(new QDBusPendingCallWatcher{asyncPropGetAll(), this},
+                &QDBusPendingCallWatcher::finished,
+                [finished] (QDBusPendingCallWatcher * call)
+                {
+                    QDBusPendingReply<QVariantMap> reply = *call;
+                    if (reply.isError())
+                        qDebug() << "Error on DBus request:" << reply.error();
+                    finished(!reply.isError(), reply.value());
+                    call->deleteLater();
+                }
+        );
+    }
+
+    //! unpacks one value of the propertiesGetAllAsync() result
+    template <typename T>
+    static inline T property(const QVariantMap &properties, QString const &name)
+    {
+        return qdbus_cast<T>(properties.value(name));
+    }
+
     //exposed methods from org::kde::StatusNotifierItem
     inline QString service() const { return mSni.service(); }
 
@@ -107,6 +131,7 @@ signals:
 
 private:
     QDBusPendingReply<QDBusVariant> asyncPropGet(QString const & property);
+    QDBusPendingReply<QVariantMap> asyncPropGetAll();
 
 private:
     org::kde::StatusNotifierItem mSni;
@@ -0,0 +1,183 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#include "sniiconcache.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QImage>
+#include <QPixmap>
+#include <QtEndian>
+#include "../panel/highlight-effect.h"
+#include "../panel/gsettingsregistry.h"
+#include "../panel/pluginprofiler.h"
+
+#define SNI_ICON_CACHE_SIZE     128
+#define SNI_FILE_CACHE_SIZE     1024
+
+SniIconCache *SniIconCache::instance()
+{
+    static SniIconCache *cache = new SniIconCache;
+    return cache;
+}
+
+SniIconCache::SniIconCache()
+    : mIcons(SNI_ICON_CACHE_SIZE)
+{
+    PluginProfiler *profiler = PluginProfiler::instance();
+    profiler->addCache(QStringLiteral("statusnotifier"), QStringLiteral("icons"),
+                       [this] { return PluginProfiler::CacheSize(mIcons.size()); });
+    profiler->addCache(QStringLiteral("statusnotifier"), QStringLiteral("theme files"),
+                       [this] { return PluginProfiler::CacheSize(mFiles.size() + mHicolorDirs.size()); });
+}
+
+QByteArray SniIconCache::nameKey(const QString &themePath, const QString &iconName)
+{
+    //图标按主题重新着色，缓存键里带上当前主题
+    const QString style = GSettingsRegistry::instance()->value("org.ukui.style", "styleName").toString();
+    return QStringLiteral("N\n%1\n%2\n%3").arg(themePath, iconName, style).toUtf8();
+}
+
+QByteArray SniIconCache::pixmapKey(const IconPixmap &pixmap)
+{
+    QCryptographicHash hash(QCryptographicHash::Md5);
+    const qint32 size[2] = { pixmap.width, pixmap.height };
+    hash.addData(reinterpret_cast<const char *>(size), sizeof(size));
+    hash.addData(pixmap.bytes);
+    return QByteArray("P\n") + hash.result();
+}
+
+int SniIconCache::bestPixmap(const IconPixmapList &pixmaps, int size)
+{
+    int best = -1;
+    for (int i = 0; i < pixmaps.size(); ++i)
+    {
+        const IconPixmap &pixmap = pixmaps.at(i);
+        if (pixmap.width <= 0 || pixmap.height <= 0
+                || pixmap.bytes.size() / 4 / pixmap.width < pixmap.height)
+            continue;
+
+        if (best < 0)
+        {
+            best = i;
+            continue;
+        }
+        const int current = pixmaps.at(best).width;
+        if (current < size ? pixmap.width > current
+                           : (pixmap.width >= size && pixmap.width < current))
+            best = i;
+    }
+    return best;
+}
+
+QIcon SniIconCache::fromName(const QByteArray &key, const QString &themePath, const QString &iconName)
+{
+    if (QIcon *cached = mIcons.object(key))
+        return *cached;
+
+    QIcon icon;
+    if (QIcon::hasThemeIcon(iconName))
+        icon = QIcon::fromTheme(iconName);
+    else
+    {
+        const QStringList files = themeFiles(themePath, iconName);
+        for (const QString &file : files)
+            icon.addFile(file);
+    }
+    icon = HighLightEffect::drawSymbolicColoredIcon(icon);
+
+    //找不到的图标不缓存，应用可能稍后才把文件写进主题目录
+    if (!icon.isNull())
+        mIcons.insert(key, new QIcon(icon));
+    return icon;
+}
+
+QIcon SniIconCache::fromPixmap(const QByteArray &key, const IconPixmap &pixmap)
+{
+    if (QIcon *cached = mIcons.object(key))
+        return *cached;
+
+    //ARGB32 按网络字节序传输，直接从 DBus 数据转换进图像缓冲区
+    QImage image(pixmap.width, pixmap.height, QImage::Format_ARGB32);
+    const int pixels = pixmap.width * pixmap.height;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    qFromBigEndian<quint32>(pixmap.bytes.constData(), pixels, image.bits());
+#else
+    const quint32 *src = reinterpret_cast<const quint32 *>(pixmap.bytes.constData());
+    quint32 *dest = reinterpret_cast<quint32 *>(image.bits());
+    for (int i = 0; i < pixels; ++i)
+        dest[i] = qFromBigEndian(src[i]);
+#endif
+
+    QIcon icon(QPixmap::fromImage(std::move(image)));
+    mIcons.insert(key, new QIcon(icon));
+    return icon;
+}
+
+QStringList SniIconCache::themeFiles(const QString &themePath, const QString &iconName)
+{
+    const QString id = themePath + QLatin1Char('\n') + iconName;
+    auto it = mFiles.constFind(id);
+    if (it != mFiles.constEnd())
+        return it.value();
+
+    QStringList files;
+    QDir themeDir(themePath);
+    if (!themePath.isEmpty() && themeDir.exists())
+    {
+        if (themeDir.exists(iconName + ".png"))
+            files << themeDir.filePath(iconName + ".png");
+
+        for (const QString &dir : hicolorDirs(themePath))
+        {
+            const QString file = dir + "/" + iconName + ".png";
+            if (QFile::exists(file))
+                files << file;
+        }
+    }
+
+    if (!files.isEmpty())
+    {
+        if (mFiles.size() >= SNI_FILE_CACHE_SIZE)
+            mFiles.clear();
+        mFiles.insert(id, files);
+    }
+    return files;
+}
+
+const QStringList &SniIconCache::hicolorDirs(const QString &themePath)
+{
+    auto it = mHicolorDirs.find(themePath);
+    if (it != mHicolorDirs.end())
+        return it.value();
+
+    QStringList dirs;
+    QDir themeDir(themePath);
+    if (themeDir.cd("hicolor") || (themeDir.cd("icons") && themeDir.cd("hicolor")))
+    {
+        const QStringList sizes = themeDir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot);
+        for (const QString &dir : sizes)
+        {
+            const QStringList contexts = QDir(themeDir.filePath(dir)).entryList(QDir::AllDirs | QDir::NoDotAndDotDot);
+            for (const QString &innerDir : contexts)
+                dirs << themeDir.absolutePath() + "/" + dir + "/" + innerDir;
+        }
+    }
+    return mHicolorDirs.insert(themePath, dirs).value();
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#ifndef SNIICONCACHE_H
+#define SNIICONCACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QIcon>
+#include <QString>
+#include <QStringList>
+#include "dbustypes.h"
+
+/*! \brief Icons of the StatusNotifierItems, shared by all the buttons.
+ *
+ * Icon names are resolved against the item's IconThemePath once per theme
+ * path and name, the ready (recolored) QIcon is kept under a key built from
+ * the theme path and name, or from a hash of the IconPixmap data. Items that
+ * blink by switching between a few icons hit the cache on every frame.
+ *
+ * Of the IconPixmap sizes an item offers only the one fitting the panel is
+ * hashed and decoded.
+ */
+class SniIconCache
+{
+public:
+    static SniIconCache *instance();
+
+    //! cache key of a named icon, includes the style the icon gets recolored for
+    static QByteArray nameKey(const QString &themePath, const QString &iconName);
+    //! cache key of pixmap data, a hash of the content
+    static QByteArray pixmapKey(const IconPixmap &pixmap);
+    /*! index of the pixmap to show at size pixels: the smallest one not smaller
+        than size, the largest one if all are smaller; -1 if there is no valid one */
+    static int bestPixmap(const IconPixmapList &pixmaps, int size);
+
+    QIcon fromName(const QByteArray &key, const QString &themePath, const QString &iconName);
+    QIcon fromPixmap(const QByteArray &key, const IconPixmap &pixmap);
+
+private:
+    SniIconCache();
+
+    QStringList themeFiles(const QString &themePath, const QString &iconName);
+    const QStringList &hicolorDirs(const QString &themePath);
+
+    QCache<QByteArray, QIcon> mIcons;
+    QHash<QString, QStringList> mHicolorDirs;   //!< theme path -> hicolor/<size>/<context> dirs
+    QHash<QString, QStringList> mFiles;         //!< theme path + '\n' + icon name -> files
+};
+
+#endif // SNIICONCACHE_H
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#include "sniupdatescheduler.h"
+#include "../panel/panelstats.h"
+
+#include <QJsonArray>
+#include <QTimer>
+
+//每个托盘项最多每100毫秒刷新一次
+#define SNI_UPDATE_INTERVAL     100
+
+SniUpdateScheduler *SniUpdateScheduler::instance()
+{
+    static SniUpdateScheduler *scheduler = new SniUpdateScheduler;
+    return scheduler;
+}
+
+SniUpdateScheduler::SniUpdateScheduler(QObject *parent)
+    : QObject(parent)
+{
+    //和面板的其他统计一样写进 --stats 的快照，每个托盘项一行
+    PanelStats::instance()->addSection(QStringLiteral("statusNotifier"), [this] {
+        return QJsonValue(QJsonArray::fromStringList(report().split(QLatin1Char('\n'), QString::SkipEmptyParts)));
+    });
+}
+
+void SniUpdateScheduler::add(QObject *item, const QString &name, std::function<void (Updates)> update)
+{
+    Item &entry = mItems[item];
+    entry.name = name;
+    entry.update = update;
+    entry.pending = 0;
+    entry.running = false;
+    entry.signalCount = 0;
+    entry.updateCount = 0;
+    entry.nsecs = 0;
+    entry.timer = new QTimer(this);
+    entry.timer->setSingleShot(true);
+    entry.timer->setProperty("item", QVariant::fromValue(item));
+    connect(entry.timer, &QTimer::timeout, this, &SniUpdateScheduler::timeout);
+    connect(item, &QObject::destroyed, this, &SniUpdateScheduler::removeItem);
+}
+
+void SniUpdateScheduler::request(QObject *item, Updates updates)
+{
+    auto it = mItems.find(item);
+    if (it == mItems.end())
+        return;
+
+    ++it->signalCount;
+    it->pending |= updates;
+    if (!it->running)
+        schedule(*it);
+}
+
+void SniUpdateScheduler::finished(QObject *item)
+{
+    auto it = mItems.find(item);
+    if (it == mItems.end() || !it->running)
+        return;
+
+    it->running = false;
+    it->nsecs += it->started.nsecsElapsed();
+    //更新期间又来了信号
+    if (it->pending)
+        schedule(*it);
+}
+
+void SniUpdateScheduler::schedule(Item &item)
+{
+    if (item.timer->isActive())
+        return;
+
+    qint64 wait = 0;
+    if (item.started.isValid())
+        wait = qMax<qint64>(0, SNI_UPDATE_INTERVAL - item.started.elapsed());
+    item.timer->start(wait);
+}
+
+void SniUpdateScheduler::timeout()
+{
+    QObject *key = sender()->property("item").value<QObject *>();
+    auto it = mItems.find(key);
+    if (it != mItems.end() && !it->running && it->pending)
+        run(*it);
+}
+
+void SniUpdateScheduler::run(Item &item)
+{
+    const Updates updates = item.pending;
+    item.pending = 0;
+    item.running = true;
+    item.started.start();
+    ++item.updateCount;
+    //回调里可能直接调用finished()
+    std::function<void (Updates)> update = item.update;
+    update(updates);
+}
+
+void SniUpdateScheduler::removeItem(QObject *item)
+{
+    auto it = mItems.find(item);
+    if (it == mItems.end())
+        return;
+    delete it->timer;
+    mItems.erase(it);
+}
+
+QString SniUpdateScheduler::report() const
+{
+    QString result;
+    for (auto it = mItems.constBegin(); it != mItems.constEnd(); ++it)
+    {
+        const Item &item = it.value();
+        result += QStringLiteral("%1: signals %2, updates %3, coalesced %4, time %5 ms\n")
+                .arg(item.name)
+                .arg(item.signalCount)
+                .arg(item.updateCount)
+                .arg(item.signalCount - item.updateCount)
+                .arg(item.nsecs / 1000000.0, 0, 'f', 2);
+    }
+    return result;
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#ifndef SNIUPDATESCHEDULER_H
+#define SNIUPDATESCHEDULER_H
+
+#include <functional>
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QString>
+
+class QTimer;
+
+/*! \brief Coalesces and rate limits the updates of the StatusNotifierItems.
+ *
+ * The item signals only mark what changed, the item's update callback runs
+ * at most once per SNI_UPDATE_INTERVAL with everything that piled up in the
+ * meantime, and never while the previous update is still running (waiting
+ * for its DBus reply). A busy item therefore costs a bounded amount of work
+ * no matter how fast it signals.
+ */
+class SniUpdateScheduler : public QObject
+{
+    Q_OBJECT
+public:
+    enum Update
+    {
+        IconUpdate          = 0x01,
+        OverlayIconUpdate   = 0x02,
+        AttentionIconUpdate = 0x04,
+        ToolTipUpdate       = 0x08,
+        TitleUpdate         = 0x10,
+        StatusUpdate        = 0x20
+    };
+    Q_DECLARE_FLAGS(Updates, Update)
+
+    static SniUpdateScheduler *instance();
+
+    /*! Registers an item, update is called with the pending updates; the
+        item has to call finished() once it has applied them. */
+    void add(QObject *item, const QString &name, std::function<void (Updates)> update);
+    void request(QObject *item, Updates updates);
+    void finished(QObject *item);
+
+    //! signals, updates, coalesced signals and time spent per item, one line each
+    QString report() const;
+
+private slots:
+    void timeout();
+    void removeItem(QObject *item);
+
+private:
+    explicit SniUpdateScheduler(QObject *parent = nullptr);
+
+    struct Item
+    {
+        QString name;
+        std::function<void (Updates)> update;
+        Updates pending;
+        bool running;
+        QElapsedTimer started;      //!< last update
+        QTimer *timer;
+        qint64 signalCount;
+        qint64 updateCount;
+        qint64 nsecs;               //!< from update start to finished()
+    };
+    void schedule(Item &item);
+    void run(Item &item);
+
+    QHash<QObject *, Item> mItems;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(SniUpdateScheduler::Updates)
+
+#endif // SNIUPDATESCHEDULER_H
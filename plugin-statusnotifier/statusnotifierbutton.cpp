@@ -28,13 +28,13 @@
 
 #include "statusnotifierbutton.h"
 
-#include <QDir>
-#include <QFile>
 #include <dbusmenu-qt5/dbusmenuimporter.h>
 #include "../panel/iukuipanelplugin.h"
 #include "sniasync.h"
+#include "sniiconcache.h"
+#include "sniupdatescheduler.h"
 #include "../panel/customstyle.h"
-#include "../panel/highlight-effect.h"
+#include "../panel/painttracer.h"
 //#include <XdgIcon>
 
 namespace
@@ -60,39 +60,28 @@ StatusNotifierButton::StatusNotifierButton(QString service, QString objectPath,
     mMenu(nullptr),
     mStatus(Passive),
     mFallbackIcon(QIcon::fromTheme("application-x-executable")),
+    mPanelIconSize(plugin->panel()->iconSize()),
     mPlugin(plugin)
 {
 //    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Expanding);
     setAutoRaise(true);
     interface = new SniAsync(service, objectPath, QDBusConnection::sessionBus(), this);
 
+    //变化信号只做标记，由调度器合并、限频后统一取属性
+    SniUpdateScheduler *scheduler = SniUpdateScheduler::instance();
+    scheduler->add(this, service, [this] (SniUpdateScheduler::Updates updates) {
+        fetchProperties(updates);
+    });
+
     connect(interface, &SniAsync::NewIcon, this, &StatusNotifierButton::newIcon);
     connect(interface, &SniAsync::NewOverlayIcon, this, &StatusNotifierButton::newOverlayIcon);
     connect(interface, &SniAsync::NewAttentionIcon, this, &StatusNotifierButton::newAttentionIcon);
     connect(interface, &SniAsync::NewToolTip, this, &StatusNotifierButton::newToolTip);
+    connect(interface, &SniAsync::NewTitle, this, &StatusNotifierButton::newTitle);
     connect(interface, &SniAsync::NewStatus, this, &StatusNotifierButton::newStatus);
 
-    interface->propertyGetAsync(QLatin1String("Menu"), [this] (QDBusObjectPath path) {
-        if (!path.path().isEmpty())
-        {
-            mMenu = (new MenuImporter{interface->service(), path.path(), this})->menu();
-            mMenu->setObjectName(QLatin1String("StatusNotifierMenu"));
-        }
-    });
-
-    interface->propertyGetAsync(QLatin1String("Status"), [this] (QString status) {
-        newStatus(status);
-    });
-
-    interface->propertyGetAsync(QLatin1String("IconThemePath"), [this] (QString value) {
-        mThemePath = value;
-        //do the logic of icons after we've got the theme path
-        refetchIcon(Active);
-        refetchIcon(Passive);
-        refetchIcon(NeedsAttention);
-    });
-
-    newToolTip();
+    scheduler->request(this, SniUpdateScheduler::IconUpdate | SniUpdateScheduler::OverlayIconUpdate
+                       | SniUpdateScheduler::AttentionIconUpdate | SniUpdateScheduler::ToolTipUpdate);
 }
 
 StatusNotifierButton::~StatusNotifierButton()
@@ -102,145 +91,148 @@ StatusNotifierButton::~StatusNotifierButton()
 
 void StatusNotifierButton::newIcon()
 {
-    refetchIcon(Passive);
+    PaintTracer::trace(this, "sni");
+    SniUpdateScheduler::instance()->request(this, SniUpdateScheduler::IconUpdate);
 }
 
 void StatusNotifierButton::newOverlayIcon()
 {
-    refetchIcon(Active);
+    PaintTracer::trace(this, "sni");
+    SniUpdateScheduler::instance()->request(this, SniUpdateScheduler::OverlayIconUpdate);
 }
 
 void StatusNotifierButton::newAttentionIcon()
 {
-    refetchIcon(NeedsAttention);
+    PaintTracer::trace(this, "sni");
+    SniUpdateScheduler::instance()->request(this, SniUpdateScheduler::AttentionIconUpdate);
+}
+
+void StatusNotifierButton::newToolTip()
+{
+    SniUpdateScheduler::instance()->request(this, SniUpdateScheduler::ToolTipUpdate);
+}
+
+void StatusNotifierButton::newTitle()
+{
+    SniUpdateScheduler::instance()->request(this, SniUpdateScheduler::TitleUpdate);
+}
+
+void StatusNotifierButton::newStatus(QString status)
+{
+    //状态随信号带过来，不用再取属性
+    mPendingStatus = status;
+    SniUpdateScheduler::instance()->request(this, SniUpdateScheduler::StatusUpdate);
+}
+
+void StatusNotifierButton::fetchProperties(SniUpdateScheduler::Updates updates)
+{
+    if (updates & SniUpdateScheduler::StatusUpdate)
+        setStatus(mPendingStatus);
+
+    if (updates == SniUpdateScheduler::StatusUpdate)
+    {
+        SniUpdateScheduler::instance()->finished(this);
+        return;
+    }
+
+    interface->propertiesGetAllAsync([this] (bool ok, QVariantMap properties) {
+        //出错时的空表会清掉标题和图标主题路径，保留上一次的状态
+        if (ok)
+            applyProperties(properties);
+        SniUpdateScheduler::instance()->finished(this);
+    });
 }
 
-void StatusNotifierButton::refetchIcon(Status status)
+void StatusNotifierButton::applyProperties(const QVariantMap &properties)
+{
+    if (!mMenu)
+    {
+        const QDBusObjectPath path = SniAsync::property<QDBusObjectPath>(properties, QLatin1String("Menu"));
+        if (!path.path().isEmpty())
+        {
+            mMenu = (new MenuImporter{interface->service(), path.path(), this})->menu();
+            mMenu->setObjectName(QLatin1String("StatusNotifierMenu"));
+        }
+    }
+
+    mThemePath = properties.value(QLatin1String("IconThemePath")).toString();
+    mTitle = properties.value(QLatin1String("Title")).toString();
+
+    const ToolTip tooltip = SniAsync::property<ToolTip>(properties, QLatin1String("ToolTip"));
+    if (!tooltip.title.isEmpty())
+        setToolTip(tooltip.title);
+    else if (!mTitle.isEmpty())
+        setToolTip(mTitle);
+
+    bool changed = refetchIcon(Passive, properties);
+    changed = refetchIcon(Active, properties) || changed;
+    changed = refetchIcon(NeedsAttention, properties) || changed;
+
+    const QString status = properties.value(QLatin1String("Status")).toString();
+    if (!status.isEmpty())
+        setStatus(status);
+    if (changed)
+        resetIcon();
+}
+
+bool StatusNotifierButton::refetchIcon(Status status, const QVariantMap &properties)
 {
     QString nameProperty, pixmapProperty;
+    QIcon *icon;
+    QByteArray *iconKey;
     if (status == Active)
     {
         nameProperty = QLatin1String("OverlayIconName");
         pixmapProperty = QLatin1String("OverlayIconPixmap");
+        icon = &mOverlayIcon;
+        iconKey = &mOverlayIconKey;
     }
     else if (status == NeedsAttention)
     {
         nameProperty = QLatin1String("AttentionIconName");
         pixmapProperty = QLatin1String("AttentionIconPixmap");
+        icon = &mAttentionIcon;
+        iconKey = &mAttentionIconKey;
     }
     else // status == Passive
     {
         nameProperty = QLatin1String("IconName");
         pixmapProperty = QLatin1String("IconPixmap");
+        icon = &mIcon;
+        iconKey = &mIconKey;
     }
 
-    interface->propertyGetAsync(nameProperty, [this, status, pixmapProperty] (QString iconName) {
-        QIcon nextIcon;
-        if (!iconName.isEmpty())
-        {
-            if (QIcon::hasThemeIcon(iconName))
-                nextIcon = QIcon::fromTheme(iconName);
-            else
-            {
-                QDir themeDir(mThemePath);
-                if (themeDir.exists())
-                {
-                    if (themeDir.exists(iconName + ".png"))
-                        nextIcon.addFile(themeDir.filePath(iconName + ".png"));
-
-                    if (themeDir.cd("hicolor") || (themeDir.cd("icons") && themeDir.cd("hicolor")))
-                    {
-                        const QStringList sizes = themeDir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot);
-                        for (const QString &dir : sizes)
-                        {
-                            const QStringList dirs = QDir(themeDir.filePath(dir)).entryList(QDir::AllDirs | QDir::NoDotAndDotDot);
-                            for (const QString &innerDir : dirs)
-                            {
-                                QString file = themeDir.absolutePath() + "/" + dir + "/" + innerDir + "/" + iconName + ".png";
-                                if (QFile::exists(file))
-                                    nextIcon.addFile(file);
-                            }
-                        }
-                    }
-                }
-            }
-            nextIcon=HighLightEffect::drawSymbolicColoredIcon(nextIcon);
-
-            switch (status)
-            {
-                case Active:
-                    mOverlayIcon = nextIcon;
-                    break;
-                case NeedsAttention:
-                    mAttentionIcon = nextIcon;
-                    break;
-                case Passive:
-                    mIcon = nextIcon;
-                    break;
-            }
-
-            resetIcon();
-        }
-        else
-        {
-            interface->propertyGetAsync(pixmapProperty, [this, status, pixmapProperty] (IconPixmapList iconPixmaps) {
-                if (iconPixmaps.empty())
-                    return;
-
-                QIcon nextIcon;
-
-                for (IconPixmap iconPixmap: iconPixmaps)
-                {
-                    if (!iconPixmap.bytes.isNull())
-                    {
-                        QImage image((uchar*) iconPixmap.bytes.data(), iconPixmap.width,
-                                     iconPixmap.height, QImage::Format_ARGB32);
-
-                        const uchar *end = image.constBits() + image.byteCount();
-                        uchar *dest = reinterpret_cast<uchar*>(iconPixmap.bytes.data());
-                        for (const uchar *src = image.constBits(); src < end; src += 4, dest += 4)
-                            qToUnaligned(qToBigEndian<quint32>(qFromUnaligned<quint32>(src)), dest);
-
-                        nextIcon.addPixmap(QPixmap::fromImage(image));
-                    }
-                }
-
-                switch (status)
-                {
-                    case Active:
-                        mOverlayIcon = nextIcon;
-                        break;
-                    case NeedsAttention:
-                        mAttentionIcon = nextIcon;
-                        break;
-                    case Passive:
-                        mIcon = nextIcon;
-                        break;
-                }
-
-                resetIcon();
-            });
-        }
-    });
-}
+    SniIconCache *cache = SniIconCache::instance();
+    const QString iconName = properties.value(nameProperty).toString();
+    if (!iconName.isEmpty())
+    {
+        const QByteArray key = SniIconCache::nameKey(mThemePath, iconName);
+        if (key == *iconKey)
+            return false;
+        *icon = cache->fromName(key, mThemePath, iconName);
+        //没找到的图标下次更新时再找
+        *iconKey = icon->isNull() ? QByteArray() : key;
+        return true;
+    }
 
-void StatusNotifierButton::newToolTip()
-{
-    interface->propertyGetAsync(QLatin1String("ToolTip"), [this] (ToolTip tooltip) {
-
-        QString toolTipTitle = tooltip.title;
-        if (!toolTipTitle.isEmpty())
-            setToolTip(toolTipTitle);
-        else
-            interface->propertyGetAsync(QLatin1String("Title"), [this] (QString title) {
-                // we should get here only in case the ToolTip.title was empty
-                if (!title.isEmpty())
-                    setToolTip(title);
-            });
-    });
+    const IconPixmapList iconPixmaps = SniAsync::property<IconPixmapList>(properties, pixmapProperty);
+    if (iconPixmaps.empty())
+        return false;
+
+    //只解码最适合面板图标尺寸的那一张
+    const int best = SniIconCache::bestPixmap(iconPixmaps, qRound(mPanelIconSize * devicePixelRatioF()));
+    if (best < 0)
+        return false;
+
+    const QByteArray key = SniIconCache::pixmapKey(iconPixmaps.at(best));
+    if (key == *iconKey)
+        return false;
+    *iconKey = key;
+    *icon = cache->fromPixmap(key, iconPixmaps.at(best));
+    return true;
 }
 
-void StatusNotifierButton::newStatus(QString status)
+void StatusNotifierButton::setStatus(const QString &status)
 {
     Status newStatus;
     if (status == QLatin1String("Passive"))
@@ -303,10 +295,21 @@ void StatusNotifierButton::resetIcon()
         setIcon(mFallbackIcon);
 }
 
+void StatusNotifierButton::setPanelIconSize(int size)
+{
+    if (size == mPanelIconSize)
+        return;
+
+    //缓存键不含尺寸，清掉后下次取属性时按新尺寸重新选图解码
+    mPanelIconSize = size;
+    mIconKey.clear();
+    mOverlayIconKey.clear();
+    mAttentionIconKey.clear();
+    SniUpdateScheduler::instance()->request(this, SniUpdateScheduler::IconUpdate | SniUpdateScheduler::OverlayIconUpdate
+                                            | SniUpdateScheduler::AttentionIconUpdate);
+}
+
 QString StatusNotifierButton::hideAbleStatusNotifierButton()
 {
-    interface->propertyGetAsync(QLatin1String("Title"), [this] (QString title) {
-        mTitle = title;
-    });
     return mTitle;
 }
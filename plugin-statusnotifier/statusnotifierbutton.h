@@ -38,16 +38,8 @@
 #include <QWheelEvent>
 #include <QMenu>
 #include <QString>
-
-#if QT_VERSION < QT_VERSION_CHECK(5, 5, 0)
-template <typename T> inline T qFromUnaligned(const uchar *src)
-{
-    T dest;
-    const size_t size = sizeof(T);
-    memcpy(&dest, src, size);
-    return dest;
-}
-#endif
+#include <QVariantMap>
+#include "sniupdatescheduler.h"
 
 class IUKUIPanelPlugin;
 class SniAsync;
@@ -65,12 +57,15 @@ public:
         Passive, Active, NeedsAttention
     };
     QString hideAbleStatusNotifierButton();
+    //! the panel icon size changed, the pixmaps have to be chosen and decoded again
+    void setPanelIconSize(int size);
 
 public slots:
     void newIcon();
     void newAttentionIcon();
     void newOverlayIcon();
     void newToolTip();
+    void newTitle();
     void newStatus(QString status);
 
 private:
@@ -81,6 +76,10 @@ private:
     QString mThemePath;
     QString mTitle;
     QIcon mIcon, mOverlayIcon, mAttentionIcon, mFallbackIcon;
+    QByteArray mIconKey, mOverlayIconKey, mAttentionIconKey;
+    int mPanelIconSize;
+
+    QString mPendingStatus;
 
     IUKUIPanelPlugin* mPlugin;
 
@@ -89,7 +88,10 @@ protected:
     void mouseReleaseEvent(QMouseEvent *event);
     void wheelEvent(QWheelEvent *event);
 
-    void refetchIcon(Status status);
+    void fetchProperties(SniUpdateScheduler::Updates updates);
+    void setStatus(const QString &status);
+    void applyProperties(const QVariantMap &properties);
+    bool refetchIcon(Status status, const QVariantMap &properties);
     void resetIcon();
 };
 
@@ -29,6 +29,8 @@
 #include "statusnotifierwatcher.h"
 #include <QDebug>
 #include <QDBusConnectionInterface>
+#include <QDBusPendingCallWatcher>
+#include <QTimer>
 
 StatusNotifierWatcher::StatusNotifierWatcher(QObject *parent) : QObject(parent)
 {
@@ -50,6 +52,12 @@ StatusNotifierWatcher::StatusNotifierWatcher(QObject *parent) : QObject(parent)
     mWatcher->setWatchMode(QDBusServiceWatcher::WatchForUnregistration);
 
     connect(mWatcher, &QDBusServiceWatcher::serviceUnregistered, this, &StatusNotifierWatcher::serviceUnregistered);
+
+    //同一轮事件循环里的注册一起交给界面
+    mFlushTimer = new QTimer(this);
+    mFlushTimer->setSingleShot(true);
+    mFlushTimer->setInterval(0);
+    connect(mFlushTimer, &QTimer::timeout, this, &StatusNotifierWatcher::flushRegistrations);
 }
 
 StatusNotifierWatcher::~StatusNotifierWatcher()
@@ -70,22 +78,87 @@ void StatusNotifierWatcher::RegisterStatusNotifierItem(const QString &serviceOrP
     }
 
     QString notifierItemId = service + path;
+    if (mServices.contains(notifierItemId) || mPendingItems.contains(notifierItemId))
+        return;
 
-    if (QDBusConnection::sessionBus().interface()->isServiceRegistered(service).value()
-        && !mServices.contains(notifierItemId))
+    //调用者自己的连接名一定存在，其他名字异步确认，不阻塞界面
+    if (service == message().service())
     {
-        mServices << notifierItemId;
+        queueItem(service, notifierItemId);
+        return;
+    }
+
+    //先监视再查询：查询期间名字消失会先收到注销，回调里就不再入队
+    watchService(service);
+    ++mCheckingServices[service];
+    QDBusPendingCallWatcher *call = new QDBusPendingCallWatcher(
+                QDBusConnection::sessionBus().interface()->asyncCall(QLatin1String("NameHasOwner"), service), this);
+    connect(call, &QDBusPendingCallWatcher::finished, this, [this, service, notifierItemId] (QDBusPendingCallWatcher *call) {
+        call->deleteLater();
+        QHash<QString, int>::iterator it = mCheckingServices.find(service);
+        if (it == mCheckingServices.end())
+            return;
+        if (--it.value() == 0)
+            mCheckingServices.erase(it);
+
+        QDBusPendingReply<bool> reply = *call;
+        if (!reply.isError() && reply.value())
+            queueItem(service, notifierItemId);
+        else
+            unwatchIfUnused(service);
+    });
+}
+
+void StatusNotifierWatcher::watchService(const QString &service)
+{
+    if (!mWatcher->watchedServices().contains(service))
         mWatcher->addWatchedService(service);
+}
+
+void StatusNotifierWatcher::unwatchIfUnused(const QString &service)
+{
+    if (!mServiceItems.contains(service) && !mHosts.contains(service)
+            && !mPendingServices.contains(service) && !mCheckingServices.contains(service))
+        mWatcher->removeWatchedService(service);
+}
+
+void StatusNotifierWatcher::queueItem(const QString &service, const QString &notifierItemId)
+{
+    if (mServices.contains(notifierItemId) || mPendingItems.contains(notifierItemId))
+        return;
+
+    //入队时就开始监视，刷新前退出的服务也能收到注销
+    watchService(service);
+    mPending << notifierItemId;
+    mPendingItems << notifierItemId;
+    mPendingServices << service;
+    mFlushTimer->start();
+}
+
+void StatusNotifierWatcher::flushRegistrations()
+{
+    if (mPending.isEmpty())
+        return;
+
+    const QStringList items = mPending;
+    mPending.clear();
+    mPendingItems.clear();
+    mPendingServices.clear();
+    for (const QString &notifierItemId : items)
+    {
+        mServices.insert(notifierItemId);
+        mServiceItems.insert(notifierItemId.left(notifierItemId.indexOf('/')), notifierItemId);
         emit StatusNotifierItemRegistered(notifierItemId);
     }
+    emit StatusNotifierItemsRegistered(items);
 }
 
 void StatusNotifierWatcher::RegisterStatusNotifierHost(const QString &service)
 {
     if (!mHosts.contains(service))
     {
-        mHosts.append(service);
-        mWatcher->addWatchedService(service);
+        mHosts.insert(service);
+        watchService(service);
     }
 }
 
@@ -94,24 +167,33 @@ void StatusNotifierWatcher::serviceUnregistered(const QString &service)
     qDebug() << "Service" << service << "unregistered";
 
     mWatcher->removeWatchedService(service);
+    mCheckingServices.remove(service);
 
-    if (mHosts.contains(service))
-    {
-        mHosts.removeAll(service);
+    if (mHosts.remove(service))
         return;
-    }
 
-    QString match = service + '/';
-    QStringList::Iterator it = mServices.begin();
-    while (it != mServices.end())
+    //还没来得及通知的注册直接丢掉
+    if (mPendingServices.remove(service))
     {
-        if (it->startsWith(match))
+        const QString match = service + '/';
+        QStringList::Iterator it = mPending.begin();
+        while (it != mPending.end())
         {
-            QString name = *it;
-            it = mServices.erase(it);
-            emit StatusNotifierItemUnregistered(name);
+            if (it->startsWith(match))
+            {
+                mPendingItems.remove(*it);
+                it = mPending.erase(it);
+            }
+            else
+                ++it;
         }
-        else
-            ++it;
+    }
+
+    const QList<QString> items = mServiceItems.values(service);
+    mServiceItems.remove(service);
+    for (const QString &name : items)
+    {
+        mServices.remove(name);
+        emit StatusNotifierItemUnregistered(name);
     }
 }
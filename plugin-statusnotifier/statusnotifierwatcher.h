@@ -34,9 +34,13 @@
 #include <QDBusMessage>
 #include <QDBusMetaType>
 #include <QDBusServiceWatcher>
+#include <QHash>
+#include <QSet>
 
 #include "dbustypes.h"
 
+class QTimer;
+
 class StatusNotifierWatcher : public QObject, protected QDBusContext
 {
     Q_OBJECT
@@ -51,23 +55,40 @@ public:
 
     bool isStatusNotifierHostRegistered() { return mHosts.count() > 0; }
     int protocolVersion() const { return 0; }
-    QStringList RegisteredStatusNotifierItems() const { return mServices; }
+    QStringList RegisteredStatusNotifierItems() const { return mServices.values(); }
 
 signals:
     Q_SCRIPTABLE void StatusNotifierItemRegistered(const QString &service);
     Q_SCRIPTABLE void StatusNotifierItemUnregistered(const QString &service);
     Q_SCRIPTABLE void StatusNotifierHostRegistered();
 
+    //! the items registered in one event loop pass, emitted after the single StatusNotifierItemRegistered signals
+    void StatusNotifierItemsRegistered(const QStringList &services);
+
 public slots:
     Q_SCRIPTABLE void RegisterStatusNotifierItem(const QString &serviceOrPath);
     Q_SCRIPTABLE void RegisterStatusNotifierHost(const QString &service);
 
     void serviceUnregistered(const QString &service);
 
+private slots:
+    void flushRegistrations();
+
 private:
-    QStringList mServices;
-    QStringList mHosts;
+    void queueItem(const QString &service, const QString &notifierItemId);
+    void watchService(const QString &service);
+    void unwatchIfUnused(const QString &service);
+
+    QSet<QString> mServices;
+    QMultiHash<QString, QString> mServiceItems;     //!< DBus service -> its item ids
+    QSet<QString> mHosts;
     QDBusServiceWatcher *mWatcher;
+
+    QStringList mPending;                           //!< registered in this event loop pass
+    QSet<QString> mPendingItems;
+    QSet<QString> mPendingServices;
+    QHash<QString, int> mCheckingServices;          //!< NameHasOwner calls in flight per service
+    QTimer *mFlushTimer;
 };
 
 #endif // STATUSNOTIFIERWATCHER_H
@@ -32,6 +32,7 @@
 #include <QDebug>
 #include "../panel/iukuipanelplugin.h"
 #include "../panel/customstyle.h"
+#include "../panel/gsettingsregistry.h"
 
 
 #define UKUI_PANEL_SETTINGS              "org.ukui.panel.settings"
@@ -48,8 +49,8 @@ StatusNotifierWidget::StatusNotifierWidget(IUKUIPanelPlugin *plugin, QWidget *pa
     mWatcher = new StatusNotifierWatcher;
     mWatcher->RegisterStatusNotifierHost(dbusName);
 
-    connect(mWatcher, &StatusNotifierWatcher::StatusNotifierItemRegistered,
-            this, &StatusNotifierWidget::itemAdded);
+    connect(mWatcher, &StatusNotifierWatcher::StatusNotifierItemsRegistered,
+            this, &StatusNotifierWidget::itemsAdded);
     connect(mWatcher, &StatusNotifierWatcher::StatusNotifierItemUnregistered,
             this, &StatusNotifierWidget::itemRemoved);
 
@@ -60,12 +61,8 @@ StatusNotifierWidget::StatusNotifierWidget(IUKUIPanelPlugin *plugin, QWidget *pa
     realign();
     layout()->addWidget(mBtn);
 
-    const QByteArray id(UKUI_PANEL_SETTINGS);
-    if(QGSettings::isSchemaInstalled(id))
-        gsettings = new QGSettings(id);
-    connect(gsettings, &QGSettings::changed, this, [=] (const QString &key){
-        if(key==SHOW_STATUSNOTIFIER_BUTTON)
-            realign();
+    GSettingsRegistry::instance()->subscribe(UKUI_PANEL_SETTINGS, SHOW_STATUSNOTIFIER_BUTTON, this, [this] (const QVariant &){
+        realign();
     });
 
     qDebug() << mWatcher->RegisteredStatusNotifierItems();
@@ -90,9 +87,18 @@ void StatusNotifierWidget::itemAdded(QString serviceAndPath)
     button->show();
 }
 
+void StatusNotifierWidget::itemsAdded(const QStringList &services)
+{
+    //一批注册只重新布局一次
+    layout()->setEnabled(false);
+    for (const QString &serviceAndPath : services)
+        itemAdded(serviceAndPath);
+    realign();
+}
+
 void StatusNotifierWidget::itemRemoved(const QString &serviceAndPath)
 {
-    StatusNotifierButton *button = mServices.value(serviceAndPath, NULL);
+    StatusNotifierButton *button = mServices.take(serviceAndPath);
     if (button)
     {
         mStatusNotifierButtons.removeOne(button);
@@ -125,10 +131,11 @@ void StatusNotifierWidget::realign()
         {
             mStatusNotifierButtons.at(i)->setFixedSize(mPlugin->panel()->iconSize(),mPlugin->panel()->panelSize());
             mStatusNotifierButtons.at(i)->setIconSize(QSize(mPlugin->panel()->iconSize()/2,mPlugin->panel()->iconSize()/2));
+            mStatusNotifierButtons.at(i)->setPanelIconSize(mPlugin->panel()->iconSize());
             QStringList mStatusNotifierButtonList;
             mStatusNotifierButtonList<<"ukui-volume-control-applet-qt"<<"kylin-nm"<<"ukui-sidebar"<<"fcitx"<<"sogouimebs-qimpanel"<<"fcitx-qimpanel";
             if(!mStatusNotifierButtonList.contains(mStatusNotifierButtons.at(i)->hideAbleStatusNotifierButton()))
-                mStatusNotifierButtons.at(i)->setVisible(gsettings->get(SHOW_STATUSNOTIFIER_BUTTON).toBool());
+                mStatusNotifierButtons.at(i)->setVisible(GSettingsRegistry::instance()->value(UKUI_PANEL_SETTINGS, SHOW_STATUSNOTIFIER_BUTTON, true).toBool());
             else
                 mStatusNotifierButtons.at(i)->setVisible(true);
         }
@@ -142,9 +149,6 @@ void StatusNotifierWidget::realign()
 StatusNotifierPopUpButton::StatusNotifierPopUpButton()
 {
     this->setStyle(new CustomStyle);
-    const QByteArray id(UKUI_PANEL_SETTINGS);
-    if(QGSettings::isSchemaInstalled(id))
-        gsettings = new QGSettings(id);
 }
 
 StatusNotifierPopUpButton::~StatusNotifierPopUpButton()
@@ -154,12 +158,13 @@ StatusNotifierPopUpButton::~StatusNotifierPopUpButton()
 
 void StatusNotifierPopUpButton::mousePressEvent(QMouseEvent *)
 {
-    if(gsettings->get(SHOW_STATUSNOTIFIER_BUTTON).toBool()){
+    GSettingsRegistry *registry = GSettingsRegistry::instance();
+    if(registry->value(UKUI_PANEL_SETTINGS, SHOW_STATUSNOTIFIER_BUTTON, true).toBool()){
         this->setText("<");
-        gsettings->set(SHOW_STATUSNOTIFIER_BUTTON,false);
+        registry->setValue(UKUI_PANEL_SETTINGS, SHOW_STATUSNOTIFIER_BUTTON, false);
     }
     else{
         this->setText(">");
-        gsettings->set(SHOW_STATUSNOTIFIER_BUTTON,true);
+        registry->setValue(UKUI_PANEL_SETTINGS, SHOW_STATUSNOTIFIER_BUTTON, true);
     }
 }
@@ -30,7 +30,6 @@
 #define STATUSNOTIFIERWIDGET_H
 
 #include <QDir>
-#include <QGSettings/QGSettings>
 
 #include "../panel/common/ukuigridlayout.h"
 #include "../panel/iukuipanelplugin.h"
@@ -50,6 +49,7 @@ signals:
 
 public slots:
     void itemAdded(QString serviceAndPath);
+    void itemsAdded(const QStringList &services);
     void itemRemoved(const QString &serviceAndPath);
 
     void realign();
@@ -62,7 +62,6 @@ private:
 
     QList<StatusNotifierButton*> mStatusNotifierButtons;
     QToolButton *mBtn;
-    QGSettings *gsettings;
 };
 
 class StatusNotifierPopUpButton : public QToolButton
@@ -72,8 +71,6 @@ public:
     ~StatusNotifierPopUpButton();
 protected:
     void mousePressEvent(QMouseEvent *);
-private:
-    QGSettings *gsettings;
 };
 
 #endif // STATUSNOTIFIERWIDGET_H
@@ -26,6 +26,7 @@
 
 #include <gio/gdesktopappinfo.h>
 #include "quicklaunchaction.h"
+#include "../panel/launchmanager.h"
 #include <QDesktopServices>
 #include <QFileIconProvider>
 #include <QMimeDatabase>
@@ -127,40 +128,27 @@ QuickLaunchAction::QuickLaunchAction(const QString & fileName, QWidget * parent)
 /*解析Exec字段*/
 void QuickLaunchAction::execAction(QString additionalAction)
 {
-    UKUITaskBar *uqk = qobject_cast<UKUITaskBar*>(parent());
     QString exec(data().toString());
     bool showQMessage = false;
     switch (m_type)
     {
         case ActionLegacy:
-            if (!QProcess::startDetached(exec))
-                showQMessage =true;
+            LaunchManager::instance()->launchCommand(exec, this);
             break;
-        case ActionXdg: {
-            XdgDesktopFile xdg;
-            if(xdg.load(exec))
-            {
-                if(exec.contains("ubuntu-kylin-software-center",Qt::CaseSensitive)){
-                    //无法打开麒麟应用商店，因此改为gio的方式加载
-                    QByteArray ba = exec.toLatin1();
-                    char * filepath=ba.data();
-                    GDesktopAppInfo * appinfo=g_desktop_app_info_new_from_filename(filepath);
-                    if (!g_app_info_launch(G_APP_INFO(appinfo),nullptr, nullptr, nullptr))
-                        showQMessage =true;
+        case ActionXdg:
+            if(exec.contains("ubuntu-kylin-software-center",Qt::CaseSensitive)){
+                //无法打开麒麟应用商店，因此改为gio的方式加载
+                QByteArray ba = exec.toLatin1();
+                char * filepath=ba.data();
+                GDesktopAppInfo * appinfo=g_desktop_app_info_new_from_filename(filepath);
+                if (!appinfo || !g_app_info_launch(G_APP_INFO(appinfo),nullptr, nullptr, nullptr))
+                    showQMessage =true;
+                if (appinfo)
                     g_object_unref(appinfo);
-                 } else {
-                    //xdg 的方式实现点击打开应用，可正确读取转义的字符
-                    if (!additionalAction.isEmpty()){
-                        if (xdg.startDetached())
-                            showQMessage =true;
-                    } else {
-                        if (!xdg.actionActivate(additionalAction, QStringList{}))
-                            showQMessage =true;
-                    }
-                }
-            } else
-                showQMessage =true;
-        }
+            } else {
+                //在线程池中启动，启动中的重复点击会被忽略，失败时只通知发起启动的这个 action
+                LaunchManager::instance()->launch(exec, additionalAction, this);
+            }
             break;
         case ActionFile:
             QFileInfo fileinfo(exec);
@@ -175,10 +163,22 @@ void QuickLaunchAction::execAction(QString additionalAction)
             }
             break;
     }
-    if (showQMessage) {
-        qWarning() << "XdgDesktopFile" << exec << "is not valid";
-        QMessageBox::information(uqk, tr("Error Path"),
-                                 tr("File/URL cannot be opened cause invalid path.")
-                                 );
-    }
+    if (showQMessage)
+        showLaunchError();
+}
+
+void QuickLaunchAction::showLaunchError()
+{
+    UKUITaskBar *uqk = qobject_cast<UKUITaskBar*>(parent());
+    qWarning() << "XdgDesktopFile" << data().toString() << "is not valid";
+    QMessageBox::information(uqk, tr("Error Path"),
+                             tr("File/URL cannot be opened cause invalid path.")
+                             );
+}
+
+/*启动在线程池中失败时由 LaunchManager 调用*/
+void QuickLaunchAction::launchFailed(const QString &id)
+{
+    Q_UNUSED(id)
+    showLaunchError();
 }
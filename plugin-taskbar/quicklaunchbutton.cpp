@@ -27,6 +27,7 @@
 #include "quicklaunchbutton.h"
 #include "ukuiquicklaunch.h"
 #include "../panel/iukuipanelplugin.h"
+#include "../panel/gsettingsregistry.h"
 #include <QAction>
 #include <QDrag>
 #include <QMenu>
@@ -59,12 +60,9 @@ QuickLaunchButton::QuickLaunchButton(QuickLaunchAction * act, IUKUIPanelPlugin *
 
     /*设置快速启动栏的菜单项*/
     const QByteArray id(UKUI_PANEL_SETTINGS);
-    mgsettings = new QGSettings(id);
     modifyQuicklaunchMenuAction(true);
-    connect(mgsettings, &QGSettings::changed, this, [=] (const QString &key){
-        if(key==PANELPOSITION){
-            modifyQuicklaunchMenuAction(true);
-        }
+    GSettingsRegistry::instance()->subscribe(id, PANELPOSITION, this, [=] {
+        modifyQuicklaunchMenuAction(true);
     });
 
     setContextMenuPolicy(Qt::CustomContextMenu);
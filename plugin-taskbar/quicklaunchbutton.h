@@ -91,7 +91,6 @@ private:
     enum QuickLaunchStatus{NORMAL, HOVER, PRESS};
     QuickLaunchStatus quicklanuchstatus;
     CustomStyle toolbuttonstyle;
-    QGSettings *mgsettings;
 
     void modifyQuicklaunchMenuAction(bool direction);
 
@@ -48,12 +48,14 @@
 #include "ukuitaskgroup.h"
 #include "ukuitaskbaricon.h"
 #include "quicklaunchaction.h"
-#include "json.h"
+#include "../panel/securitypolicy.h"
+#include "../panel/launchmanager.h"
+#include "../panel/x11meter.h"
+#include "../panel/pluginprofiler.h"
+#include "../panel/pluginsettings.h"
 #define PANEL_SETTINGS "org.ukui.panel.settings"
 #define PANEL_LINES    "panellines"
 using namespace UKUi;
-using QtJson::JsonObject;
-using QtJson::JsonArray;
 /************************************************
 
 ************************************************/
@@ -79,8 +81,6 @@ UKUITaskBar::UKUITaskBar(IUKUIPanelPlugin *plugin, QWidget *parent) :
     mStyle(new LeftAlignedTextStyle())
 {
 
-    SecurityConfigPath=QDir::homePath()+QString("/.config/ukui-panel-security-config.json");
-
     taskstatus=NORMAL;
     setAttribute(Qt::WA_TranslucentBackground);//设置窗口背景透明
     setWindowFlags(Qt::FramelessWindowHint);   //设置无边框窗口
@@ -112,6 +112,7 @@ UKUITaskBar::UKUITaskBar(IUKUIPanelPlugin *plugin, QWidget *parent) :
     */
     //往任务栏中加入快速启动按钮
     refreshQuickLaunch();
+    connect(SecurityPolicy::instance(), &SecurityPolicy::policyChanged, this, &UKUITaskBar::refreshQuickLaunch);
 
     //往任务栏中加入任务栏按钮
     realign();
@@ -136,6 +137,20 @@ UKUITaskBar::UKUITaskBar(IUKUIPanelPlugin *plugin, QWidget *parent) :
         settings=new QGSettings(id);
     }
 
+    // 最小化预览截图存在/tmp下，按已知窗口统计
+    PluginProfiler::instance()->addCache(mPlugin->settings()->group(), QStringLiteral("thumbnails"), [this] {
+        PluginProfiler::CacheSize size(0, 0);
+        for (auto it = mKnownWindows.constBegin(); it != mKnownWindows.constEnd(); ++it)
+        {
+            QFileInfo file(QString("/tmp/%1.png").arg(it.key()));
+            if (!file.exists())
+                continue;
+            ++size.entries;
+            size.bytes += file.size();
+        }
+        return size;
+    }, this);
+
   //  connect(pageup,SIGNAL(clicked()),this,SLOT(PageUp()));
   //  connect(pagedown,SIGNAL(clicked()),this,SLOT(PageDown()));
 
@@ -201,8 +216,7 @@ UKUITaskBar::UKUITaskBar(IUKUIPanelPlugin *plugin, QWidget *parent) :
     realign();
     */
     //龙芯机器的最小化任务窗口的预览窗口的特殊处理
-    system("cat /proc/cpuinfo >> /tmp/_tmp_cpu_info_cat_");
-    QFile file("/tmp/_tmp_cpu_info_cat_");
+    QFile file("/proc/cpuinfo");
     if (!file.open(QIODevice::ReadOnly)) qDebug() << "Read CpuInfo Failed.";
     while (CpuInfoFlg && !file.atEnd()) {
         QByteArray line = file.readLine();
@@ -231,72 +245,13 @@ UKUITaskBar::~UKUITaskBar()
     mVBtn.clear();
 }
 
+/*安全配置由 SecurityPolicy 统一解析和监视，变化后通过 policyChanged 刷新*/
 void UKUITaskBar::ReloadSecurityConfig(){
-    this->loadJsonfile();
-    this->refreshQuickLaunch();
+    SecurityPolicy::instance()->reload();
 }
 
 QString UKUITaskBar::GetSecurityConfigPath(){
-    return SecurityConfigPath;
-}
-QString UKUITaskBar::readFile(const QString &filename) {
-    QFile f(filename);
-    if (!f.open(QFile::ReadOnly)) {
-        return QString();
-    } else {
-        QTextStream in(&f);
-        return in.readAll();
-    }
-}
-
-void UKUITaskBar::loadJsonfile() {
-    QString json = readFile(SecurityConfigPath);
-    if (json.isEmpty()) {
-        qFatal("Could not read JSON file!");
-        return ;
-    }
-    bool ok;
-    JsonObject result = QtJson::parse(json, ok).toMap();
-    QVariant fristLayer;
-    fristLayer=result.value("ukui-panel");
-    mModel=fristLayer.toMap().value("mode").toString();
-
-    QVariant blacklistLayer;
-    blacklistLayer=fristLayer.toMap().value("blacklist");
-    QVariant whitelistLayer;
-    whitelistLayer=fristLayer.toMap().value("whitelist");
-
-    if(!blacklistLayer.isNull()){
-        QList<QVariant> thirdLayer;
-        thirdLayer=blacklistLayer.toList();
-        QMap<QString,QVariant> fourthLayer;
-        fourthLayer=thirdLayer.at(0).toMap();
-        QList<QVariant> fifthLayer;
-        fifthLayer=fourthLayer.value("entries").toList();
-        QMap<QString,QVariant> attribute;
-        QList<QString> blackNames;
-        for(int i=0;i<fifthLayer.size();i++){
-            attribute=fifthLayer.at(i).toMap();
-            blackNames.append(attribute.value("path").toString());
-        }
-        blacklist=blackNames;
-    }
-
-    if(!whitelistLayer.isNull()){
-        QList<QVariant> thirdLayer;
-        thirdLayer=whitelistLayer.toList();
-        QMap<QString,QVariant> fourthLayer;
-        fourthLayer=thirdLayer.at(0).toMap();
-        QList<QVariant> fifthLayer;
-        fifthLayer=fourthLayer.value("entries").toList();
-        QMap<QString,QVariant> attribute;
-        QList<QString> whiteNames;
-        for(int i=0;i<fifthLayer.size();i++){
-            attribute=fifthLayer.at(i).toMap();
-            whiteNames.append(attribute.value("path").toString());
-        }
-        whitelist=whiteNames;
-    }
+    return SecurityPolicy::instance()->configPath();
 }
 
 void UKUITaskBar::PageUp() {
@@ -336,13 +291,6 @@ void UKUITaskBar::refreshQuickLaunch(){
         hasPlaceHolder = false;
     }
 
-    QStringList mblacklist;
-    QStringList mwhitelist;
-    if(mModel=="blacklist")
-    mblacklist=blacklist;
-    if(mModel=="whitelist")
-    mwhitelist=whitelist;
-
     for(auto it = mVBtn.begin(); it != mVBtn.end();)
     {
         (*it)->deleteLater();
@@ -361,20 +309,15 @@ void UKUITaskBar::refreshQuickLaunch(){
     {
         desktop = app.value("desktop", "").toString();
 
-        if(mblacklist.contains(desktop)){
+        if(!SecurityPolicy::instance()->allows(desktop)){
             desktop.clear();
         }
-        if(mModel=="whitelist"){
-            if(!mwhitelist.contains(desktop)){
-                desktop.clear();
-            }
-        }
 
         file = app.value("file", "").toString();
         if (!desktop.isEmpty())
         {
-            XdgDesktopFile xdg;
-            if (xdg.load(desktop))
+            const XdgDesktopFile xdg = LaunchManager::instance()->entry(desktop);
+            if (xdg.isValid())
                 addButton(new QuickLaunchAction(&xdg, this));
         }
         else if (! file.isEmpty())
@@ -406,7 +349,10 @@ bool UKUITaskBar::acceptWindow(WId window) const
     ignoreList |= NET::PopupMenuMask;
     ignoreList |= NET::NotificationMask;
 
-    KWindowInfo info(window, NET::WMWindowType | NET::WMState, NET::WM2TransientFor);
+    // KWindowInfo reads all the requested properties in its constructor
+    KWindowInfo info = X11Meter::measure("taskbar", "KWindowInfo", Q_FUNC_INFO, [&] {
+        return KWindowInfo(window, NET::WMWindowType | NET::WMState, NET::WM2TransientFor);
+    });
     if (!info.valid())
         return false;
 
@@ -421,7 +367,8 @@ bool UKUITaskBar::acceptWindow(WId window) const
     if (transFor == 0 || transFor == window || transFor == (WId) QX11Info::appRootWindow())
         return true;
 
-    info = KWindowInfo(transFor, NET::WMWindowType);
+    info = X11Meter::measure("taskbar", "KWindowInfo", Q_FUNC_INFO,
+                             [&] { return KWindowInfo(transFor, NET::WMWindowType); });
 
     QFlags<NET::WindowTypeMask> normalFlag;
     normalFlag |= NET::NormalMask;
@@ -648,7 +595,10 @@ void UKUITaskBar::addWindow(WId window)
         hasPlaceHolder = false;
     }
     // If grouping disabled group behaves like regular button
-    const QString group_id = mGroupingEnabled ? KWindowInfo(window, 0, NET::WM2WindowClass).windowClassClass() : QString("%1").arg(window);
+    const QString group_id = mGroupingEnabled
+            ? X11Meter::measure("taskbar", "KWindowInfo", Q_FUNC_INFO,
+                                [&] { return KWindowInfo(window, 0, NET::WM2WindowClass).windowClassClass(); })
+            : QString("%1").arg(window);
 #if (QT_VERSION < QT_VERSION_CHECK(5,7,0))
     if(!group_id.compare("peony-qt-desktop"))
     {
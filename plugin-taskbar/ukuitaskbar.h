@@ -185,12 +185,6 @@ private slots:
     void PageUp();
     void PageDown();
 
-    QString readFile(const QString &filename);
-    /**
-     * @brief loadJsonfile
-     * 加载json文件
-     */
-    void loadJsonfile();
 
 private:
     typedef QMap<WId, UKUITaskGroup*> windowMap_t;
@@ -273,11 +267,6 @@ private:
     LeftAlignedTextStyle *mStyle;
     UKUITaskBarIcon *mpTaskBarIcon;
 
-    QList<QString> blacklist;
-    QList<QString> whitelist;
-    QString mModel;
-    QString SecurityConfigPath;
-
 public slots:
     bool AddToTaskbar(QString arg);
     bool RemoveFromTaskbar(QString arg);
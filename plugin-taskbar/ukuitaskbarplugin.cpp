@@ -27,6 +27,7 @@
 
 
 #include "ukuitaskbarplugin.h"
+#include "../panel/launchmanager.h"
 
 UKUITaskBarPlugin::UKUITaskBarPlugin(const IUKUIPanelPluginStartupInfo &startupInfo):
     QObject(),
@@ -47,3 +48,13 @@ void UKUITaskBarPlugin::realign()
 {
     mTaskBar->realign();
 }
+
+/*在工作线程里预先解析固定到任务栏的应用的desktop文件*/
+void UKUITaskBarPluginLibrary::prepare(const UKUi::PluginInfo &, const QVariantMap &settings) const
+{
+    for (auto it = settings.constBegin(); it != settings.constEnd(); ++it)
+    {
+        if (it.key().startsWith(QLatin1String("apps/")) && it.key().endsWith(QLatin1String("/desktop")))
+            LaunchManager::instance()->entry(it.value().toString());
+    }
+}
@@ -27,6 +27,8 @@
  * END_COMMON_COPYRIGHT_HEADER */
 
 #include "ukuitaskbutton.h"
+#include "../panel/launchmanager.h"
+#include "../panel/gsettingsregistry.h"
 #include "ukuitaskgroup.h"
 #include "ukuitaskbar.h"
 
@@ -125,12 +127,8 @@ UKUITaskButton::UKUITaskButton(QString appName,const WId window, UKUITaskBar * t
     connect(mParentTaskBar, &UKUITaskBar::iconByClassChanged, this, &UKUITaskButton::updateIcon);
 
     const QByteArray id(PANEL_SETTINGS);
-    gsettings = new QGSettings(id);
-    connect(gsettings, &QGSettings::changed, this, [=] (const QString &key){
-        if (key == PANEL_SIZE_KEY)
-        {
-            updateIcon();
-        }
+    GSettingsRegistry::instance()->subscribe(id, PANEL_SIZE_KEY, this, [=] {
+        updateIcon();
     });
 }
 
@@ -779,6 +777,7 @@ void UKUITaskButton::setAutoRotation(bool value, IUKUIPanel::Position position)
 void UKUITaskButton::enterEvent(QEvent *)
 {
     taskbuttonstatus=HOVER;
+    LaunchManager::instance()->prewarm(file_name);
     update();
 }
 
@@ -891,12 +890,9 @@ UKUITaskButton::UKUITaskButton(QuickLaunchAction * act, IUKUIPanelPlugin * plugi
 
     /*设置快速启动栏的菜单项*/
     const QByteArray id(UKUI_PANEL_SETTINGS);
-    mgsettings = new QGSettings(id);
     modifyQuicklaunchMenuAction(true);
-    connect(mgsettings, &QGSettings::changed, this, [=] (const QString &key){
-        if(key==PANELPOSITION){
-            modifyQuicklaunchMenuAction(true);
-        }
+    GSettingsRegistry::instance()->subscribe(id, PANELPOSITION, this, [=] {
+        modifyQuicklaunchMenuAction(true);
     });
 
     setContextMenuPolicy(Qt::CustomContextMenu);
@@ -180,7 +180,6 @@ private:
     // Timer for when draggind something into a button (the button's window
     // must be activated so that the use can continue dragging to the window
     QTimer * mDNDTimer;
-    QGSettings *gsettings;
 
 
     ///////////////////////////////////
@@ -190,7 +189,6 @@ private:
     QPoint mDragStart;
     TaskButtonStatus quicklanuchstatus;
     CustomStyle toolbuttonstyle;
-    QGSettings *mgsettings;
 
     void modifyQuicklaunchMenuAction(bool direction);
 private slots:
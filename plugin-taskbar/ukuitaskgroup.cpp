@@ -39,6 +39,10 @@
 #include <KF5/KWindowSystem/KWindowSystem>
 #include <functional>
 #include <QProcess>
+#include <QDateTime>
+#include <QFile>
+#include <QHash>
+#include <QRegExp>
 
 #include <QtX11Extras/QX11Info>
 #include <X11/Xlib.h>
@@ -58,6 +62,9 @@
 #include <XdgDesktopFile>
 #include <QMessageBox>
 #include "../panel/customstyle.h"
+#include "../panel/gsettingsregistry.h"
+#include "../panel/x11meter.h"
+#include "../panel/painttracer.h"
 #define UKUI_PANEL_SETTINGS "org.ukui.panel.settings"
 #define PANELPOSITION       "panelposition"
 
@@ -131,12 +138,9 @@ UKUITaskGroup::UKUITaskGroup(QuickLaunchAction * act, IUKUIPanelPlugin * plugin,
 
     /*设置快速启动栏的菜单项*/
     const QByteArray id(UKUI_PANEL_SETTINGS);
-    mgsettings = new QGSettings(id);
     toDomodifyQuicklaunchMenuAction(true);
-    connect(mgsettings, &QGSettings::changed, this, [=] (const QString &key){
-        if(key==PANELPOSITION){
-            toDomodifyQuicklaunchMenuAction(true);
-        }
+    GSettingsRegistry::instance()->subscribe(id, PANELPOSITION, this, [=] {
+        toDomodifyQuicklaunchMenuAction(true);
     });
     setContextMenuPolicy(Qt::CustomContextMenu);
    // connect(this, SIGNAL(customContextMenuRequested(const QPoint&)),
@@ -217,15 +221,65 @@ bool DesktopFileNameCompare(QString str1, QString str2) {
     return false;
 }
 
-QString getDesktopFileName(QString cmd) {
-    char name[200];
-    FILE *fp1 = NULL;
-    if ((fp1 = popen(cmd.toStdString().data(), "r")) == NULL)
-        return QString();
-    memset(name, 0, sizeof(name));
-    fgets(name, sizeof(name),fp1);
-    pclose(fp1);
-    return QString(name);
+namespace
+{
+    struct DesktopExecNames
+    {
+        QDateTime modified;
+        QString exec;       // Exec 行的程序名，带 % 参数时只取程序
+        QString wmClass;    // StartupWMClass
+    };
+
+    /* 以前每个 desktop 文件都要起一次 cat|awk|cut 管道，现在直接解析并按修改时间缓存；
+     * 取值规则和换行结尾与原来的管道输出一致，但原来 fgets 只读 199 字节，超长的值被截断，
+     * 这里保留完整值 */
+    const DesktopExecNames &desktopExecNames(const QFileInfo &fileInfo)
+    {
+        static QHash<QString, DesktopExecNames> cache;
+        DesktopExecNames &names = cache[fileInfo.filePath()];
+        if (names.modified.isValid() && names.modified == fileInfo.lastModified())
+            return names;
+
+        names.modified = fileInfo.lastModified();
+        names.exec.clear();
+        names.wmClass.clear();
+        QFile file(fileInfo.filePath());
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+            return names;
+
+        bool execFound = false, wmClassFound = false;
+        while (!file.atEnd() && !(execFound && wmClassFound))
+        {
+            const QString line = QString::fromUtf8(file.readLine()).remove('\n');
+            const QStringList fields = line.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+            if (fields.isEmpty())
+                continue;
+            if (!execFound && fields.at(0).contains("Exec="))
+            {
+                const QString value = fields.size() > 1 && fields.at(1).contains('%') ? fields.at(0) : line;
+                names.exec = value.section('=', 1, 1) + '\n';
+                execFound = true;
+            }
+            if (!wmClassFound && fields.at(0).contains("StartupWMClass="))
+            {
+                names.wmClass = fields.at(0).section('=', 1, 1) + '\n';
+                wmClassFound = true;
+            }
+        }
+        return names;
+    }
+
+    //与 ps aux 的 COMMAND 列相同
+    QString processCommandLine(int pid)
+    {
+        QFile file(QString("/proc/%1/cmdline").arg(pid));
+        if (!file.open(QIODevice::ReadOnly))
+            return QString();
+        QByteArray cmdline = file.readAll();
+        cmdline.replace('\0', ' ');
+        const QString command = QString::fromLocal8Bit(cmdline).replace(QRegExp(" +"), " ").trimmed();
+        return command.isEmpty() ? QString() : command + '\n';
+    }
 }
 
 void UKUITaskGroup::badBackFunctionToFindDesktop() {
@@ -248,21 +302,17 @@ void UKUITaskGroup::badBackFunctionToFindDesktop() {
 
 void UKUITaskGroup::initDesktopFileName(WId window) {
     KWindowInfo info(window, 0, NET::WM2DesktopFileName);
-    QString cmd;
-    cmd.sprintf(GET_PROCESS_EXEC_NAME_MAIN, info.pid());
-    QString processExeName = getDesktopFileName(cmd);
+    QString processExeName = processCommandLine(info.pid());
 
     QDir dir(DEKSTOP_FILE_PATH);
     QFileInfoList list = dir.entryInfoList();
     for (int i = 0; i < list.size(); i++) {
         bool flag = false;
         QFileInfo fileInfo = list.at(i);
-        QString _cmd;
         if (fileInfo.filePath() == QString(USR_SHARE_APP_CURRENT) ||
             fileInfo.filePath() == QString(USR_SHARE_APP_UPER) )
             continue;
-        _cmd.sprintf(GET_DESKTOP_EXEC_NAME_MAIN, fileInfo.filePath().toStdString().data());
-        QString desktopFileExeName = getDesktopFileName(_cmd);
+        QString desktopFileExeName = desktopExecNames(fileInfo).exec;
         flag = DesktopFileNameCompare(desktopFileExeName, processExeName);
         if (flag && !desktopFileExeName.isEmpty()) {
             file_name = fileInfo.filePath();
@@ -280,9 +330,7 @@ void UKUITaskGroup::initDesktopFileName(WId window) {
             if (fileInfo.filePath() == QString(USR_SHARE_APP_CURRENT) ||
                 fileInfo.filePath() == QString(USR_SHARE_APP_UPER) )
                 continue;
-            QString _cmd;
-            _cmd.sprintf(GET_DESKTOP_EXEC_NAME_BACK, fileInfo.filePath().toStdString().data());
-            QString desktopFileExeName = getDesktopFileName(_cmd);
+            QString desktopFileExeName = desktopExecNames(fileInfo).wmClass;
             flag = DesktopFileNameCompare(desktopFileExeName, processExeName);
             if (flag && !desktopFileExeName.isEmpty()) {
                 file_name = fileInfo.filePath();
@@ -446,16 +494,19 @@ QWidget * UKUITaskGroup::addWindow(WId id)
         QPixmap thumbnail;
         XWindowAttributes attr;
 
-        display = XOpenDisplay(nullptr);
-        XGetWindowAttributes(display, id, &attr);
-        img = XGetImage(display, id, 0, 0, attr.width, attr.height, 0xffffffff, ZPixmap);
+        display = X11Meter::openDisplay("taskbar", Q_FUNC_INFO);
+        X11Meter::measure("taskbar", "XGetWindowAttributes", Q_FUNC_INFO,
+                          [&] { return XGetWindowAttributes(display, id, &attr); });
+        img = X11Meter::measure("taskbar", "XGetImage", Q_FUNC_INFO, [&] {
+            return XGetImage(display, id, 0, 0, attr.width, attr.height, 0xffffffff, ZPixmap);
+        });
         QThread::sleep(1);
         if (img) {
             thumbnail = qimageFromXImage(img).scaled(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT, Qt::KeepAspectRatio, Qt::SmoothTransformation);
             thumbnail.save(QString("/tmp/%1.png").arg(id));  //存储在tmp下
         }
         if (img) XDestroyImage(img);
-        if (display) XCloseDisplay(display);
+        X11Meter::closeDisplay(display);
     }
 
     return btn;
@@ -572,7 +623,7 @@ void UKUITaskGroup::onWindowRemoved(WId window)
         mPopup->removeWidget(button);
         button->deleteLater();
         if (!parentTaskBar()->getCpuInfoFlg())
-            system(QString("rm -f /tmp/%1.png").arg(window).toLatin1());
+            QFile::remove(QString("/tmp/%1.png").arg(window));
         if (mButtonHash.count())
         {
             if(mPopup->isVisible())
@@ -1145,6 +1196,9 @@ bool UKUITaskGroup::onWindowChanged(WId window, NET::Properties prop, NET::Prope
 
     if (!buttons.isEmpty())
     {
+        for (QWidget *button : qAsConst(buttons))
+            PaintTracer::trace(button, "window-changed");
+
         // if class is changed the window won't belong to our group any more
         if (parentTaskBar()->isGroupingEnabled() && prop2.testFlag(NET::WM2WindowClass))
         {
@@ -1545,21 +1599,24 @@ void UKUITaskGroup::showAllWindowByThumbnail()
     float minimumHeight = THUMBNAIL_HEIGHT;
     for (UKUITaskButtonHash::const_iterator it = mButtonHash.begin();it != mButtonHash.end();it++)
     {
-        display = XOpenDisplay(nullptr);
-        XGetWindowAttributes(display, it.key(), &attr);
+        display = X11Meter::openDisplay("taskbar", Q_FUNC_INFO);
+        X11Meter::measure("taskbar", "XGetWindowAttributes", Q_FUNC_INFO,
+                          [&] { return XGetWindowAttributes(display, it.key(), &attr); });
         max_Height = attr.height > max_Height ? attr.height : max_Height;
         max_Width = attr.width > max_Width ? attr.width : max_Width;
-        if(display)
-            XCloseDisplay(display);
+        X11Meter::closeDisplay(display);
     }
     for (UKUITaskButtonHash::const_iterator it = mButtonHash.begin();it != mButtonHash.end();it++)
     {
         UKUITaskWidget *btn = it.value();
         btn->addThumbNail();
         connect(btn, &UKUITaskWidget::closeSigtoPop, [this] { mPopup->pubcloseWindowDelay(); });
-        display = XOpenDisplay(nullptr);
-        XGetWindowAttributes(display, it.key(), &attr);
-        img = XGetImage(display, it.key(), 0, 0, attr.width, attr.height, 0xffffffff,ZPixmap);
+        display = X11Meter::openDisplay("taskbar", Q_FUNC_INFO);
+        X11Meter::measure("taskbar", "XGetWindowAttributes", Q_FUNC_INFO,
+                          [&] { return XGetWindowAttributes(display, it.key(), &attr); });
+        img = X11Meter::measure("taskbar", "XGetImage", Q_FUNC_INFO, [&] {
+            return XGetImage(display, it.key(), 0, 0, attr.width, attr.height, 0xffffffff,ZPixmap);
+        });
         float imgWidth = 0;
         float imgHeight = 0;
         if (plugin()->panel()->isHorizontal()) {
@@ -1637,10 +1694,7 @@ void UKUITaskGroup::showAllWindowByThumbnail()
         {
            XDestroyImage(img);
         }
-        if(display)
-        {
-            XCloseDisplay(display);
-        }
+        X11Meter::closeDisplay(display);
     }
     /*end*/
         for (UKUITaskButtonHash::const_iterator it = mButtonHash.begin();it != mButtonHash.end();it++)
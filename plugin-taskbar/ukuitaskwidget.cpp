@@ -43,6 +43,7 @@
 #include "ukuitaskgroup.h"
 #include "ukuitaskbar.h"
 #include "ukuitaskclosebutton.h"
+#include "../panel/gsettingsregistry.h"
 
 #include <KWindowSystem/KWindowSystem>
 // Necessary for closeApplication()
@@ -164,22 +165,9 @@ UKUITaskWidget::UKUITaskWidget(const WId window, UKUITaskBar * taskbar, QWidget
     const QByteArray style_id(ORG_UKUI_STYLE);
     QStringList stylelist;
     stylelist<<STYLE_NAME_KEY_DARK<<STYLE_NAME_KEY_BLACK<<STYLE_NAME_KEY_DEFAULT;
-    if(QGSettings::isSchemaInstalled(style_id)){
-        style_settings = new QGSettings(style_id);
-        if(stylelist.contains(style_settings->get(STYLE_NAME).toString())){
-            style_dark=true;
-        }else{
-            style_dark=false;
-        }
-        }
-    connect(style_settings, &QGSettings::changed, this, [=] (const QString &key){
-        if(key==STYLE_NAME){
-            if(stylelist.contains(style_settings->get(STYLE_NAME).toString())){
-                style_dark=true;
-            }else{
-                style_dark=false;
-            }
-        }
+    style_dark = stylelist.contains(GSettingsRegistry::instance()->value(style_id, STYLE_NAME).toString());
+    GSettingsRegistry::instance()->subscribe(style_id, STYLE_NAME, this, [=] (const QVariant &value){
+        style_dark = stylelist.contains(value.toString());
     });
 }
 
@@ -141,7 +141,6 @@ private:
     TaskWidgetStatus status;
     bool taskWidgetPress; //按钮左键是否按下
 
-    QGSettings *style_settings;
     bool style_dark;
 
 private slots:
@@ -27,6 +27,7 @@
 #include <QDBusInterface>
 #include <QDBusReply>
 #include "../panel/customstyle.h"
+#include "../panel/processrunner.h"
 #include <QPalette>
 #include <QToolTip>
 
@@ -113,7 +114,7 @@ void TaskViewButton::mousePressEvent(QMouseEvent *event)
 #endif
     //调用命令
     if (Qt::LeftButton == b){
-    	system("ukui-window-switch --show-workspace");
+        ProcessRunner::instance()->startDetached("ukui-window-switch", QStringList() << "--show-workspace");
     }
 
     QWidget::mousePressEvent(event);
@@ -35,6 +35,8 @@
 #include <QScreen>
 
 #include "../panel/ukuipanel.h"
+#include "../panel/gsettingsregistry.h"
+#include "../panel/x11meter.h"
 #include "trayicon.h"
 #include "xfitman.h"
 
@@ -111,21 +113,10 @@ TrayIcon::TrayIcon(Window iconId, QSize const & iconSize, QWidget* parent):
     const QByteArray id(ORG_UKUI_STYLE);
     QStringList stylelist;
     stylelist<<STYLE_NAME_KEY_DARK<<STYLE_NAME_KEY_BLACK<<STYLE_NAME_KEY_DEFAULT<<STYLE_NAME_KEY;
-    if(QGSettings::isSchemaInstalled(id)){
-        gsettings = new QGSettings(id);
-        if(stylelist.contains(gsettings->get(STYLE_NAME).toString()))
-            dark_style=true;
-        else
-            dark_style=false;
-        }
-    connect(gsettings, &QGSettings::changed, this, [=] (const QString &key){
-        if(key==STYLE_NAME){
-            if(stylelist.contains(gsettings->get(STYLE_NAME).toString()))
-                dark_style=true;
-            else
-                dark_style=false;
-            repaint();
-        }
+    dark_style = stylelist.contains(GSettingsRegistry::instance()->value(id, STYLE_NAME).toString());
+    GSettingsRegistry::instance()->subscribe(id, STYLE_NAME, this, [=] (const QVariant &value){
+        dark_style = stylelist.contains(value.toString());
+        repaint();
     });
 }
 
@@ -139,7 +130,8 @@ void TrayIcon::init()
     Display* dsp = mDisplay;
 
     XWindowAttributes attr;
-    if (! XGetWindowAttributes(dsp, mIconId, &attr))
+    if (! X11Meter::measure("tray", "XGetWindowAttributes", Q_FUNC_INFO,
+                            [&] { return XGetWindowAttributes(dsp, mIconId, &attr); }))
     {
         deleteLater();
         return;
@@ -169,7 +161,7 @@ void TrayIcon::init()
     XErrorHandler old;
     old = XSetErrorHandler(windowErrorHandler);
     XReparentWindow(dsp, mIconId, mWindowId, 0, 0);
-    XSync(dsp, false);
+    X11Meter::measure("tray", "XSync", Q_FUNC_INFO, [&] { return XSync(dsp, false); });
     XSetErrorHandler(old);
 
     if (xError)
@@ -187,9 +179,11 @@ void TrayIcon::init()
         unsigned char *data = 0;
         int ret;
 
-        ret = XGetWindowProperty(dsp, mIconId, xfitMan().atom("_XEMBED_INFO"),
-                                 0, 2, false, xfitMan().atom("_XEMBED_INFO"),
-                                 &acttype, &actfmt, &nbitem, &bytes, &data);
+        ret = X11Meter::measure("tray", "XGetWindowProperty", Q_FUNC_INFO, [&] {
+            return XGetWindowProperty(dsp, mIconId, xfitMan().atom("_XEMBED_INFO"),
+                                      0, 2, false, xfitMan().atom("_XEMBED_INFO"),
+                                      &acttype, &actfmt, &nbitem, &bytes, &data);
+        });
         if (ret == Success)
         {
             if (data)
@@ -252,7 +246,7 @@ TrayIcon::~TrayIcon()
 
     if (mWindowId)
         XDestroyWindow(dsp, mWindowId);
-    XSync(dsp, False);
+    X11Meter::measure("tray", "XSync", Q_FUNC_INFO, [&] { return XSync(dsp, False); });
     XSetErrorHandler(old);
 }
 
@@ -340,14 +334,17 @@ void TrayIcon::draw(QPaintEvent* /*event*/)
     Display* dsp = mDisplay;
 
     XWindowAttributes attr;
-    if (!XGetWindowAttributes(dsp, mIconId, &attr))
+    if (!X11Meter::measure("tray", "XGetWindowAttributes", Q_FUNC_INFO,
+                           [&] { return XGetWindowAttributes(dsp, mIconId, &attr); }))
     {
         qWarning() << "Paint error";
         return;
     }
 
     QImage image;
-    XImage* ximage = XGetImage(dsp, mIconId, 0, 0, attr.width, attr.height, AllPlanes, ZPixmap);
+    XImage* ximage = X11Meter::measure("tray", "XGetImage", Q_FUNC_INFO, [&] {
+        return XGetImage(dsp, mIconId, 0, 0, attr.width, attr.height, AllPlanes, ZPixmap);
+    });
     if(ximage)
     {
         image = QImage((const uchar*) ximage->data, ximage->width, ximage->height, ximage->bytes_per_line,  QImage::Format_ARGB32_Premultiplied);
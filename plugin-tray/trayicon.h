@@ -101,7 +101,6 @@ private:
     static bool isXCompositeAvailable();
     QPixmap drawSymbolicColoredPixmap(const QPixmap &source);
     QSize mRectSize;
-    QGSettings *gsettings;
     int tray_icon_color;
     bool dark_style;
 
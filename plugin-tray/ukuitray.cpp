@@ -45,6 +45,8 @@
 #include "../panel/common/ukuigridlayout.h"
 #include "ukuitray.h"
 #include "xfitman.h"
+#include "../panel/x11meter.h"
+#include "../panel/painttracer.h"
 
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
@@ -310,7 +312,10 @@ bool UKUITray::nativeEventFilter(const QByteArray &eventType, void *message, lon
             xcb_damage_notify_event_t* dmg = reinterpret_cast<xcb_damage_notify_event_t*>(event);
             icon = findIcon(dmg->drawable);
             if (icon)
+            {
+                PaintTracer::trace(icon, "tray-damage");
                 icon->update();
+            }
         }
         break;
     }
@@ -556,7 +561,9 @@ VisualID UKUITray::getVisual()
     templ.c_class=TrueColor;
 
     int nvi;
-    XVisualInfo* xvi = XGetVisualInfo(dsp, VisualScreenMask|VisualDepthMask|VisualClassMask, &templ, &nvi);
+    XVisualInfo* xvi = X11Meter::measure("tray", "XGetVisualInfo", Q_FUNC_INFO, [&] {
+        return XGetVisualInfo(dsp, VisualScreenMask|VisualDepthMask|VisualClassMask, &templ, &nvi);
+    });
 
     if (xvi)
     {
@@ -36,6 +36,7 @@
 #include <QIcon>
 
 #include "xfitman.h"
+#include "../panel/x11meter.h"
 #include <X11/Xatom.h>
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
@@ -99,9 +100,11 @@ bool XfitMan::getWindowProperty(Window window,
 {
     int  format;
     unsigned long type, rest;
-    return XGetWindowProperty(QX11Info::display(), window, atom, 0, 4096, false,
-                              reqType, &type, &format, resultLen, &rest,
-                              result)  == Success;
+    return X11Meter::measure("tray", "XGetWindowProperty", Q_FUNC_INFO, [&] {
+        return XGetWindowProperty(QX11Info::display(), window, atom, 0, 4096, false,
+                                  reqType, &type, &format, resultLen, &rest,
+                                  result);
+    }) == Success;
 }
 
 
@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include "panelharness.h"
+
+#include <QCoreApplication>
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QThread>
+
+#define POLL_INTERVAL   100
+
+namespace
+{
+    void wait(int msecs)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        while (timer.elapsed() < msecs)
+        {
+            QCoreApplication::processEvents(QEventLoop::AllEvents, POLL_INTERVAL);
+            QThread::msleep(10);
+        }
+    }
+
+    bool writeFile(const QString &path, const QByteArray &data)
+    {
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly))
+            return false;
+        return file.write(data) == data.size();
+    }
+}
+
+PanelHarness::PanelHarness()
+    : mEnvironment(QProcessEnvironment::systemEnvironment())
+{
+    QFile config(QStringLiteral(UKUI_PANEL_SOURCE_DIR "/panel/resources/panel.conf"));
+    if (config.open(QIODevice::ReadOnly))
+        mConfig = config.readAll();
+}
+
+PanelHarness::~PanelHarness()
+{
+    stop();
+}
+
+QStringList PanelHarness::missingTools()
+{
+    QStringList missing;
+    for (const QString &tool : { QStringLiteral("Xvfb"), QStringLiteral("glib-compile-schemas") })
+    {
+        if (QStandardPaths::findExecutable(tool).isEmpty())
+            missing << tool;
+    }
+    if (!QFileInfo(QStringLiteral(UKUI_PANEL_BINARY)).isExecutable())
+        missing << QStringLiteral(UKUI_PANEL_BINARY);
+    if (qEnvironmentVariableIsEmpty("DBUS_SESSION_BUS_ADDRESS"))
+        missing << QStringLiteral("dbus-run-session");
+    return missing;
+}
+
+// Xvfb 自己挑一个空闲的显示号，能接受连接后写到 fd 3 上
+bool PanelHarness::startXvfb(QString *error)
+{
+    const QString displayFile = mWork.filePath(QStringLiteral("display"));
+    mXvfb.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+    mXvfb.start(QStringLiteral("/bin/sh"), QStringList()
+                << QStringLiteral("-c")
+                << QStringLiteral("exec Xvfb -displayfd 3 -screen 0 1920x1080x24 -nolisten tcp 3>\"$0\"")
+                << displayFile);
+    if (!mXvfb.waitForStarted())
+    {
+        *error = QStringLiteral("cannot start Xvfb: ") + mXvfb.errorString();
+        return false;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < 10000 && mXvfb.state() == QProcess::Running)
+    {
+        QFile file(displayFile);
+        if (file.open(QIODevice::ReadOnly))
+        {
+            const QByteArray number = file.readAll().trimmed();
+            if (!number.isEmpty())
+            {
+                mDisplay = QLatin1Char(':') + QString::fromLatin1(number);
+                return true;
+            }
+        }
+        wait(POLL_INTERVAL);
+    }
+    *error = QStringLiteral("Xvfb did not report a display");
+    return false;
+}
+
+bool PanelHarness::prepareHome(QString *error)
+{
+    const QString home = mWork.filePath(QStringLiteral("home"));
+    const QString schemas = mWork.filePath(QStringLiteral("schemas"));
+    const QString plugins = mWork.filePath(QStringLiteral("plugins"));
+    for (const QString &dir : { home + QStringLiteral("/.config/ukui"), home + QStringLiteral("/.cache"),
+                                home + QStringLiteral("/.local/share"), schemas, plugins })
+    {
+        if (!QDir().mkpath(dir))
+        {
+            *error = QStringLiteral("cannot create ") + dir;
+            return false;
+        }
+    }
+
+    // 源码树里的 schema，系统里装的仍然能找到
+    QDirIterator it(QStringLiteral(UKUI_PANEL_SOURCE_DIR), QStringList(QStringLiteral("*.gschema.xml")),
+                    QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext())
+    {
+        it.next();
+        QFile::copy(it.filePath(), schemas + QLatin1Char('/') + it.fileName());
+    }
+    if (QProcess::execute(QStringLiteral("glib-compile-schemas"), QStringList(schemas)) != 0)
+    {
+        *error = QStringLiteral("glib-compile-schemas failed");
+        return false;
+    }
+
+    // 构建目录里每个插件生成的 desktop 文件，动态插件的库也在那里
+    QStringList pluginDirs = mPluginDirs;
+    const QStringList builtPlugins = QDir(QStringLiteral(UKUI_PANEL_BUILD_DIR))
+            .entryList(QStringList(QStringLiteral("plugin-*")), QDir::Dirs);
+    for (const QString &dir : builtPlugins)
+        pluginDirs << QStringLiteral(UKUI_PANEL_BUILD_DIR "/") + dir;
+    for (const QString &dir : qAsConst(pluginDirs))
+    {
+        const QFileInfoList desktops = QDir(dir).entryInfoList(QStringList(QStringLiteral("*.desktop")), QDir::Files);
+        for (const QFileInfo &desktop : desktops)
+            QFile::copy(desktop.filePath(), plugins + QLatin1Char('/') + desktop.fileName());
+    }
+
+    const QString config = mWork.filePath(QStringLiteral("panel.conf"));
+    if (!writeFile(config, mConfig))
+    {
+        *error = QStringLiteral("cannot write ") + config;
+        return false;
+    }
+
+    QProcessEnvironment env = mEnvironment;
+    env.insert(QStringLiteral("DISPLAY"), mDisplay);
+    env.insert(QStringLiteral("QT_QPA_PLATFORM"), QStringLiteral("xcb"));
+    env.insert(QStringLiteral("HOME"), home);
+    env.insert(QStringLiteral("XDG_CONFIG_HOME"), home + QStringLiteral("/.config"));
+    env.insert(QStringLiteral("XDG_CACHE_HOME"), home + QStringLiteral("/.cache"));
+    env.insert(QStringLiteral("XDG_DATA_HOME"), home + QStringLiteral("/.local/share"));
+    env.insert(QStringLiteral("GSETTINGS_BACKEND"), QStringLiteral("memory"));
+    env.insert(QStringLiteral("GSETTINGS_SCHEMA_DIR"), schemas);
+    env.insert(QStringLiteral("UKUI_PANEL_PLUGINS_DIR"), plugins);
+    env.insert(QStringLiteral("UKUIPanel_PLUGIN_PATH"), pluginDirs.join(QLatin1Char(':')));
+    mPanel.setProcessEnvironment(env);
+    return true;
+}
+
+bool PanelHarness::start(QString *error)
+{
+    if (!mWork.isValid())
+    {
+        *error = QStringLiteral("no temporary directory");
+        return false;
+    }
+    if (!startXvfb(error) || !prepareHome(error))
+        return false;
+
+    mPanel.setProcessChannelMode(QProcess::MergedChannels);
+    mPanel.setStandardOutputFile(mWork.filePath(QStringLiteral("panel.out")));
+    mPanel.start(QStringLiteral(UKUI_PANEL_BINARY), QStringList()
+                 << QStringLiteral("-c") << mWork.filePath(QStringLiteral("panel.conf")));
+    if (!mPanel.waitForStarted())
+    {
+        *error = QStringLiteral("cannot start the panel: ") + mPanel.errorString();
+        return false;
+    }
+    if (!findService(30000))
+    {
+        *error = isRunning() ? QStringLiteral("the panel did not connect to the session bus")
+                             : QStringLiteral("the panel exited");
+        return false;
+    }
+    return true;
+}
+
+void PanelHarness::stop()
+{
+    if (mPanel.state() != QProcess::NotRunning)
+    {
+        mPanel.terminate();
+        if (!mPanel.waitForFinished(5000))
+        {
+            mPanel.kill();
+            mPanel.waitForFinished();
+        }
+    }
+    if (mXvfb.state() != QProcess::NotRunning)
+    {
+        mXvfb.terminate();
+        mXvfb.waitForFinished();
+    }
+}
+
+// 面板不占用固定的服务名，按进程号找它的唯一名字
+bool PanelHarness::findService(int timeout)
+{
+    QDBusConnectionInterface *bus = QDBusConnection::sessionBus().interface();
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < timeout && isRunning())
+    {
+        const QStringList names = bus->registeredServiceNames();
+        for (const QString &name : names)
+        {
+            if (name.startsWith(QLatin1Char(':')) && bus->servicePid(name).value() == uint(pid()))
+            {
+                mService = name;
+                return true;
+            }
+        }
+        wait(POLL_INTERVAL);
+    }
+    return false;
+}
+
+bool PanelHarness::waitForObject(const QString &path, int timeout)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < timeout && isRunning())
+    {
+        const QDBusMessage reply = call(path, QStringLiteral("org.freedesktop.DBus.Introspectable"),
+                                        QStringLiteral("Introspect"));
+        if (reply.type() == QDBusMessage::ReplyMessage
+                && reply.arguments().value(0).toString().contains(QLatin1String("<interface name=\"com.ukui.panel.")))
+            return true;
+        wait(POLL_INTERVAL);
+    }
+    return false;
+}
+
+QDBusMessage PanelHarness::call(const QString &path, const QString &interface, const QString &method,
+                                const QVariantList &args, int timeout)
+{
+    QDBusMessage message = QDBusMessage::createMethodCall(mService, path, interface, method);
+    message.setArguments(args);
+    return QDBusConnection::sessionBus().call(message, QDBus::Block, timeout);
+}
+
+QString PanelHarness::log() const
+{
+    QString result;
+    for (const QString &path : { mWork.filePath(QStringLiteral("panel.out")),
+                                 mWork.filePath(QStringLiteral("home/.config/ukui/ukui-panel.log")) })
+    {
+        QFile file(path);
+        if (file.open(QIODevice::ReadOnly))
+            result += QStringLiteral("==> %1\n").arg(QFileInfo(path).fileName()) + QString::fromLocal8Bit(file.readAll());
+    }
+    return result;
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#ifndef PANELHARNESS_H
+#define PANELHARNESS_H
+
+#include <QDBusMessage>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QVariantList>
+
+/*
+ * 在 Xvfb 上跑一个真正的 ukui-panel，给需要整个面板的测试用。
+ * 面板用私有的 HOME 和 XDG 目录、内存里的 GSettings、源码树里的 schema，
+ * 插件的 desktop 文件和库都取自构建目录。测试本身在 dbus-run-session 里跑，
+ * 面板的调试接口通过它在会话总线上的唯一名字访问。
+ */
+class PanelHarness
+{
+public:
+    PanelHarness();
+    ~PanelHarness();
+
+    //! 缺少的外部程序，为空时才能 start()
+    static QStringList missingTools();
+
+    //! 面板的 -c 配置，默认是源码树里的 panel.conf
+    void setConfig(const QByteArray &config) { mConfig = config; }
+    void setEnvironment(const QString &name, const QString &value) { mEnvironment.insert(name, value); }
+    //! 额外的插件目录，里面的 desktop 文件和库都会被找到
+    void addPluginDir(const QString &dir) { mPluginDirs << dir; }
+
+    bool start(QString *error);
+    void stop();
+
+    qint64 pid() const { return mPanel.processId(); }
+    QString service() const { return mService; }
+    bool isRunning() const { return mPanel.state() == QProcess::Running; }
+
+    //! 等面板在 path 上注册好对象
+    bool waitForObject(const QString &path, int timeout = 30000);
+    QDBusMessage call(const QString &path, const QString &interface, const QString &method,
+                      const QVariantList &args = QVariantList(), int timeout = 25000);
+    //! 面板的标准输出和日志文件，测试失败时打印
+    QString log() const;
+
+private:
+    bool startXvfb(QString *error);
+    bool prepareHome(QString *error);
+    bool findService(int timeout);
+
+    QTemporaryDir mWork;
+    QByteArray mConfig;
+    QProcessEnvironment mEnvironment;
+    QStringList mPluginDirs;
+    QProcess mXvfb;
+    QProcess mPanel;
+    QString mDisplay;
+    QString mService;
+};
+
+#endif // PANELHARNESS_H
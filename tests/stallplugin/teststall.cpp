@@ -0,0 +1,61 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include "teststall.h"
+
+#include <QDBusConnection>
+#include <QElapsedTimer>
+#include <QThread>
+
+#define STALL_DBUS_PATH "/teststall"
+
+TestStall::TestStall(const IUKUIPanelPluginStartupInfo &startupInfo)
+    : QObject(),
+      IUKUIPanelPlugin(startupInfo),
+      mMsecs(0)
+{
+    mButton.setText(QStringLiteral("stall"));
+    // 定时器的事件由插件自己的对象接收，分析器能按接收者找到插件
+    mTimer.setParent(this);
+    mTimer.setSingleShot(true);
+    mTimer.setInterval(0);
+    connect(&mTimer, &QTimer::timeout, this, &TestStall::block);
+    QDBusConnection::sessionBus().registerObject(QStringLiteral(STALL_DBUS_PATH), this,
+                                                 QDBusConnection::ExportScriptableSlots);
+}
+
+TestStall::~TestStall()
+{
+    QDBusConnection::sessionBus().unregisterObject(QStringLiteral(STALL_DBUS_PATH));
+}
+
+// 先回复调用，卡住的是后面的定时器事件
+void TestStall::stall(int msecs)
+{
+    mMsecs = msecs;
+    mTimer.start();
+}
+
+void TestStall::block()
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < mMsecs)
+        QThread::msleep(10);
+}
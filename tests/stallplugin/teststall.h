@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#ifndef TESTSTALL_H
+#define TESTSTALL_H
+
+#include <QObject>
+#include <QTimer>
+#include <QToolButton>
+#include "iukuipanelplugin.h"
+
+/*
+ * 只给测试用的插件：stall() 之后在下一轮事件循环里把 GUI 线程卡住一段时间，
+ * 卡住时栈上是这个库里的代码，看门狗应该把停顿记到它头上。
+ * 在会话总线上是 /teststall 的 com.ukui.panel.test.Stall。
+ */
+class TestStall : public QObject, public IUKUIPanelPlugin
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "com.ukui.panel.test.Stall")
+public:
+    explicit TestStall(const IUKUIPanelPluginStartupInfo &startupInfo);
+    ~TestStall();
+
+    QWidget *widget() override { return &mButton; }
+    QString themeId() const override { return QStringLiteral("teststall"); }
+
+public slots:
+    Q_SCRIPTABLE void stall(int msecs);
+
+private slots:
+    void block();
+
+private:
+    QToolButton mButton;
+    QTimer mTimer;
+    int mMsecs;
+};
+
+class TestStallLibrary : public QObject, public IUKUIPanelPluginLibrary
+{
+    Q_OBJECT
+    Q_PLUGIN_METADATA(IID "ukui.org/Panel/PluginInterface/3.0")
+    Q_INTERFACES(IUKUIPanelPluginLibrary)
+public:
+    IUKUIPanelPlugin *instance(const IUKUIPanelPluginStartupInfo &startupInfo) const override
+    {
+        return new TestStall(startupInfo);
+    }
+};
+
+#endif // TESTSTALL_H
@@ -0,0 +1,210 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include "linuxbackend.h"
+
+using namespace UKUi;
+
+/* 假的 /sys/class/backlight 放在构建目录里（UKUI_BACKLIGHT_SYSFS_DIR），
+ * 写背光的助手换成 fake-pkexec，它把值写回假的 sysfs 并记日志。 */
+static const char *SysfsDir = UKUI_BACKLIGHT_SYSFS_DIR;
+
+class TestBacklight : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void readsSysfs();
+    void externalChange();
+    void backlightPower();
+    void coalescedWrites();
+    void clamped();
+    void restartAfterIdle();
+    void noDriver();
+
+private:
+    QString driverDir() const { return QFile::decodeName(SysfsDir) + QStringLiteral("/acpi_video0"); }
+    QString logPath() const { return QFile::decodeName(SysfsDir) + QStringLiteral("/../helper.log"); }
+    void writeFile(const QString &name, const QByteArray &value);
+    QStringList helperLog() const;
+    QStringList writtenValues() const;
+
+    LinuxBackend *mBackend = nullptr;
+};
+
+// 原地覆盖，不先截断，文件监视不会读到空文件（真的 sysfs 也不会是空的）
+void TestBacklight::writeFile(const QString &name, const QByteArray &value)
+{
+    QFile file(driverDir() + QLatin1Char('/') + name);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    file.write(value + '\n');
+    QVERIFY(file.flush());
+    QVERIFY(file.resize(file.pos()));
+}
+
+QStringList TestBacklight::helperLog() const
+{
+    QFile file(logPath());
+    if (!file.open(QIODevice::ReadOnly))
+        return QStringList();
+    return QString::fromLatin1(file.readAll()).split(QLatin1Char('\n'), QString::SkipEmptyParts);
+}
+
+QStringList TestBacklight::writtenValues() const
+{
+    QStringList values = helperLog();
+    values.removeAll(QStringLiteral("start"));
+    values.removeAll(QStringLiteral("exit"));
+    return values;
+}
+
+void TestBacklight::initTestCase()
+{
+    QFileInfo helper(QStringLiteral(UKUI_BACKLIGHT_HELPER));
+    QVERIFY2(helper.isExecutable(), qPrintable(helper.filePath()));
+    qputenv("FAKE_BACKLIGHT_DIR", QFile::encodeName(driverDir()));
+    qputenv("FAKE_BACKLIGHT_LOG", QFile::encodeName(logPath()));
+}
+
+// 每个测试都从同一个假设备开始：固件驱动，最大 100，当前 40
+void TestBacklight::init()
+{
+    QVERIFY(QDir(QFile::decodeName(SysfsDir)).removeRecursively());
+    QVERIFY(QDir().mkpath(driverDir()));
+    // 排在前面的 raw 驱动不该被选中
+    QVERIFY(QDir().mkpath(QFile::decodeName(SysfsDir) + QStringLiteral("/intel_backlight")));
+    QFile raw(QFile::decodeName(SysfsDir) + QStringLiteral("/intel_backlight/type"));
+    QVERIFY(raw.open(QIODevice::WriteOnly));
+    raw.write("raw\n");
+    raw.close();
+
+    writeFile(QStringLiteral("type"), "firmware");
+    writeFile(QStringLiteral("max_brightness"), "100");
+    writeFile(QStringLiteral("actual_brightness"), "40");
+    writeFile(QStringLiteral("brightness"), "40");
+    writeFile(QStringLiteral("bl_power"), "0");
+    QFile::remove(logPath());
+
+    mBackend = new LinuxBackend;
+}
+
+void TestBacklight::cleanup()
+{
+    // 析构时送出最后一个值，等助手读到 EOF 退出
+    delete mBackend;
+    mBackend = nullptr;
+}
+
+void TestBacklight::readsSysfs()
+{
+    QVERIFY(mBackend->isBacklightAvailable());
+    QCOMPARE(mBackend->getMaxBacklight(), 100);
+    QCOMPARE(mBackend->getBacklight(), 40);
+    QVERIFY(!mBackend->isBacklightOff());
+    // 只读不写，不启动助手
+    QVERIFY(helperLog().isEmpty());
+}
+
+// 亮度被别人改了（热键、电源管理），缓存跟着文件监视更新
+void TestBacklight::externalChange()
+{
+    QSignalSpy changed(mBackend, &VirtualBackEnd::backlightChanged);
+    writeFile(QStringLiteral("actual_brightness"), "70");
+    QTRY_COMPARE(mBackend->getBacklight(), 70);
+    QCOMPARE(changed.last().at(0).toInt(), 70);
+
+    // 值没变就不通知
+    const int count = changed.count();
+    writeFile(QStringLiteral("actual_brightness"), "70");
+    QTest::qWait(100);
+    QCOMPARE(changed.count(), count);
+}
+
+void TestBacklight::backlightPower()
+{
+    writeFile(QStringLiteral("bl_power"), "4");
+    QTRY_VERIFY(mBackend->isBacklightOff());
+    writeFile(QStringLiteral("bl_power"), "0");
+    QTRY_VERIFY(!mBackend->isBacklightOff());
+    QCOMPARE(mBackend->getBacklight(), 40);
+}
+
+// 拖动滑块：同一帧里的值只写最后一个，整段拖动只启动一次助手
+void TestBacklight::coalescedWrites()
+{
+    QSignalSpy changed(mBackend, &VirtualBackEnd::backlightChanged);
+    for (int value = 0; value < 100; ++value)
+        mBackend->setBacklight(value);
+    QTRY_COMPARE(writtenValues(), QStringList() << QStringLiteral("99"));
+    QTRY_COMPARE(mBackend->getBacklight(), 99);
+    QCOMPARE(changed.last().at(0).toInt(), 99);
+
+    const int steps = 50;
+    for (int value = 0; value < steps; ++value)
+    {
+        mBackend->setBacklight(value);
+        QTest::qWait(2);
+    }
+    QTRY_COMPARE(writtenValues().last(), QString::number(steps - 1));
+    QVERIFY2(writtenValues().size() < steps / 2, qPrintable(writtenValues().join(QLatin1Char(' '))));
+    QCOMPARE(helperLog().count(QStringLiteral("start")), 1);
+    QTRY_COMPARE(mBackend->getBacklight(), steps - 1);
+}
+
+void TestBacklight::clamped()
+{
+    mBackend->setBacklight(1000);
+    QTRY_COMPARE(writtenValues(), QStringList() << QStringLiteral("100"));
+    mBackend->setBacklight(-3);
+    QTRY_COMPARE(writtenValues(), QStringList() << QStringLiteral("100") << QStringLiteral("0"));
+}
+
+// 空闲后助手退出，之后的写入要启动新的助手，不能写进关掉的通道
+void TestBacklight::restartAfterIdle()
+{
+    mBackend->setBacklight(10);
+    QTRY_COMPARE(helperLog(), QStringList() << QStringLiteral("start") << QStringLiteral("10") << QStringLiteral("exit"));
+
+    mBackend->setBacklight(20);
+    QTRY_COMPARE(writtenValues(), QStringList() << QStringLiteral("10") << QStringLiteral("20"));
+    QCOMPARE(helperLog().count(QStringLiteral("start")), 2);
+    QTRY_COMPARE(mBackend->getBacklight(), 20);
+}
+
+void TestBacklight::noDriver()
+{
+    delete mBackend;
+    QVERIFY(QDir(QFile::decodeName(SysfsDir)).removeRecursively());
+    QVERIFY(QDir().mkpath(QFile::decodeName(SysfsDir)));
+    mBackend = new LinuxBackend;
+
+    QVERIFY(!mBackend->isBacklightAvailable());
+    mBackend->setBacklight(50);
+    QTest::qWait(100);
+    QVERIFY(helperLog().isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestBacklight)
+#include "tst_backlight.moc"
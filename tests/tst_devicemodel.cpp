@@ -0,0 +1,512 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include <QtTest>
+#include <QTemporaryDir>
+#include <gio/gio.h>
+#include "devicemodel.h"
+#include "capacitysampler.h"
+
+/* 假的 GDrive/GVolume/GMount，只实现模型用到的方法。
+ * 驱动器持有分区，分区持有挂载点，反向指针不占引用；
+ * liveFakes 记录还没析构的对象数，用来查引用泄漏。 */
+namespace
+{
+int liveFakes = 0;
+}
+
+struct FakeMount
+{
+    GObject parent;
+    GVolume *volume;
+    GFile *root;
+};
+struct FakeMountClass
+{
+    GObjectClass parentClass;
+};
+
+struct FakeVolume
+{
+    GObject parent;
+    char *name;
+    char *device;
+    GDrive *drive;
+    GMount *mount;
+};
+struct FakeVolumeClass
+{
+    GObjectClass parentClass;
+};
+
+struct FakeDrive
+{
+    GObject parent;
+    char *name;
+    char *device;
+    GList *volumes;
+};
+struct FakeDriveClass
+{
+    GObjectClass parentClass;
+};
+
+static void fake_mount_iface_init(GMountIface *iface);
+static void fake_volume_iface_init(GVolumeIface *iface);
+static void fake_drive_iface_init(GDriveIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE(FakeMount, fake_mount, G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(G_TYPE_MOUNT, fake_mount_iface_init))
+G_DEFINE_TYPE_WITH_CODE(FakeVolume, fake_volume, G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(G_TYPE_VOLUME, fake_volume_iface_init))
+G_DEFINE_TYPE_WITH_CODE(FakeDrive, fake_drive, G_TYPE_OBJECT,
+                        G_IMPLEMENT_INTERFACE(G_TYPE_DRIVE, fake_drive_iface_init))
+
+static void fake_mount_init(FakeMount *)
+{
+    ++liveFakes;
+}
+
+static void fake_mount_finalize(GObject *object)
+{
+    FakeMount *self = reinterpret_cast<FakeMount *>(object);
+    g_clear_object(&self->root);
+    --liveFakes;
+    G_OBJECT_CLASS(fake_mount_parent_class)->finalize(object);
+}
+
+static void fake_mount_class_init(FakeMountClass *klass)
+{
+    G_OBJECT_CLASS(klass)->finalize = fake_mount_finalize;
+}
+
+static GFile *fake_mount_get_root(GMount *mount)
+{
+    return G_FILE(g_object_ref(reinterpret_cast<FakeMount *>(mount)->root));
+}
+
+static char *fake_mount_get_name(GMount *)
+{
+    return g_strdup("fake");
+}
+
+static GVolume *fake_mount_get_volume(GMount *mount)
+{
+    GVolume *volume = reinterpret_cast<FakeMount *>(mount)->volume;
+    return volume ? G_VOLUME(g_object_ref(volume)) : nullptr;
+}
+
+static GDrive *fake_mount_get_drive(GMount *)
+{
+    return nullptr;
+}
+
+static void fake_mount_iface_init(GMountIface *iface)
+{
+    iface->get_root = fake_mount_get_root;
+    iface->get_name = fake_mount_get_name;
+    iface->get_volume = fake_mount_get_volume;
+    iface->get_drive = fake_mount_get_drive;
+}
+
+static void fake_volume_init(FakeVolume *)
+{
+    ++liveFakes;
+}
+
+static void fake_volume_finalize(GObject *object)
+{
+    FakeVolume *self = reinterpret_cast<FakeVolume *>(object);
+    g_free(self->name);
+    g_free(self->device);
+    g_clear_object(&self->mount);
+    --liveFakes;
+    G_OBJECT_CLASS(fake_volume_parent_class)->finalize(object);
+}
+
+static void fake_volume_class_init(FakeVolumeClass *klass)
+{
+    G_OBJECT_CLASS(klass)->finalize = fake_volume_finalize;
+}
+
+static char *fake_volume_get_name(GVolume *volume)
+{
+    return g_strdup(reinterpret_cast<FakeVolume *>(volume)->name);
+}
+
+static char *fake_volume_get_identifier(GVolume *volume, const char *kind)
+{
+    if (g_strcmp0(kind, G_VOLUME_IDENTIFIER_KIND_UNIX_DEVICE) != 0)
+        return nullptr;
+    return g_strdup(reinterpret_cast<FakeVolume *>(volume)->device);
+}
+
+static GDrive *fake_volume_get_drive(GVolume *volume)
+{
+    GDrive *drive = reinterpret_cast<FakeVolume *>(volume)->drive;
+    return drive ? G_DRIVE(g_object_ref(drive)) : nullptr;
+}
+
+static GMount *fake_volume_get_mount(GVolume *volume)
+{
+    GMount *mount = reinterpret_cast<FakeVolume *>(volume)->mount;
+    return mount ? G_MOUNT(g_object_ref(mount)) : nullptr;
+}
+
+static void fake_volume_iface_init(GVolumeIface *iface)
+{
+    iface->get_name = fake_volume_get_name;
+    iface->get_identifier = fake_volume_get_identifier;
+    iface->get_drive = fake_volume_get_drive;
+    iface->get_mount = fake_volume_get_mount;
+}
+
+static void fake_drive_init(FakeDrive *)
+{
+    ++liveFakes;
+}
+
+static void fake_drive_finalize(GObject *object)
+{
+    FakeDrive *self = reinterpret_cast<FakeDrive *>(object);
+    g_free(self->name);
+    g_free(self->device);
+    g_list_free_full(self->volumes, g_object_unref);
+    --liveFakes;
+    G_OBJECT_CLASS(fake_drive_parent_class)->finalize(object);
+}
+
+static void fake_drive_class_init(FakeDriveClass *klass)
+{
+    G_OBJECT_CLASS(klass)->finalize = fake_drive_finalize;
+}
+
+static char *fake_drive_get_name(GDrive *drive)
+{
+    return g_strdup(reinterpret_cast<FakeDrive *>(drive)->name);
+}
+
+static char *fake_drive_get_identifier(GDrive *drive, const char *kind)
+{
+    if (g_strcmp0(kind, G_DRIVE_IDENTIFIER_KIND_UNIX_DEVICE) != 0)
+        return nullptr;
+    return g_strdup(reinterpret_cast<FakeDrive *>(drive)->device);
+}
+
+static GList *fake_drive_get_volumes(GDrive *drive)
+{
+    return g_list_copy_deep(reinterpret_cast<FakeDrive *>(drive)->volumes,
+                            reinterpret_cast<GCopyFunc>(g_object_ref), nullptr);
+}
+
+static gboolean fake_drive_has_volumes(GDrive *drive)
+{
+    return reinterpret_cast<FakeDrive *>(drive)->volumes != nullptr;
+}
+
+static void fake_drive_iface_init(GDriveIface *iface)
+{
+    iface->get_name = fake_drive_get_name;
+    iface->get_identifier = fake_drive_get_identifier;
+    iface->get_volumes = fake_drive_get_volumes;
+    iface->has_volumes = fake_drive_has_volumes;
+}
+
+// 一个 U 盘：驱动器、分区、挂载点，测试持有驱动器的引用
+struct Stick
+{
+    FakeDrive *drive = nullptr;
+    QList<FakeVolume *> volumes;
+    QList<FakeMount *> mounts;
+
+    GDrive *gdrive() const { return G_DRIVE(drive); }
+};
+
+class TestDeviceModel : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void plugAndUnplug();
+    void partitionsBeforeDrive();
+    void unplugWithoutChildren();
+    void rename();
+    void hotplugStress();
+
+private:
+    Stick makeStick(int partitions, bool mounted);
+    void releaseStick(Stick &stick);
+    void plug(const Stick &stick);
+    void unplug(const Stick &stick);
+    static void emitSignal(const char *signal, gpointer object);
+
+    QTemporaryDir mMedia;
+    int mSerial = 0;
+    int mBaseDrives = 0;
+    int mBaseVolumes = 0;
+    int mBaseMounts = 0;
+    QStringList mEvents;
+    QList<QMetaObject::Connection> mConnections;
+};
+
+void TestDeviceModel::initTestCase()
+{
+    QVERIFY(mMedia.isValid());
+    // 真实的卷监视器里已经有的设备不算
+    DeviceModel *model = DeviceModel::instance();
+    mBaseDrives = model->drives().size();
+    mBaseVolumes = model->volumes().size();
+    mBaseMounts = model->mounts().size();
+}
+
+// 记录信号顺序，并检查信号发出时模型已经是更新后的状态
+void TestDeviceModel::init()
+{
+    DeviceModel *model = DeviceModel::instance();
+    mEvents.clear();
+    mConnections << connect(model, &DeviceModel::driveConnected, this, [this, model] (GDrive *drive) {
+        QVERIFY(model->drive(drive));
+        mEvents << QStringLiteral("drive+");
+    });
+    mConnections << connect(model, &DeviceModel::driveDisconnected, this, [this, model] (GDrive *drive) {
+        QVERIFY(G_IS_DRIVE(drive));
+        QVERIFY(!model->drive(drive));
+        mEvents << QStringLiteral("drive-");
+    });
+    mConnections << connect(model, &DeviceModel::volumeAdded, this, [this, model] (GVolume *volume, GDrive *drive) {
+        QCOMPARE(model->driveOf(volume), drive);
+        QVERIFY(model->partition(volume));
+        mEvents << QStringLiteral("volume+");
+    });
+    mConnections << connect(model, &DeviceModel::volumeRemoved, this, [this, model] (GVolume *volume, GDrive *) {
+        QVERIFY(G_IS_VOLUME(volume));
+        QVERIFY(!model->partition(volume));
+        mEvents << QStringLiteral("volume-");
+    });
+    mConnections << connect(model, &DeviceModel::mountAdded, this, [this, model] (GMount *mount, GVolume *volume, GDrive *) {
+        QCOMPARE(model->volumeOf(mount), volume);
+        QCOMPARE(model->partition(volume)->mount, mount);
+        mEvents << QStringLiteral("mount+");
+    });
+    mConnections << connect(model, &DeviceModel::mountRemoved, this, [this, model] (GMount *mount, GVolume *, GDrive *) {
+        QVERIFY(G_IS_MOUNT(mount));
+        QVERIFY(!model->mounts().contains(mount));
+        mEvents << QStringLiteral("mount-");
+    });
+    mConnections << connect(model, &DeviceModel::driveChanged, this, [this] (GDrive *) {
+        mEvents << QStringLiteral("changed");
+    });
+}
+
+void TestDeviceModel::cleanup()
+{
+    for (const QMetaObject::Connection &connection : mConnections)
+        disconnect(connection);
+    mConnections.clear();
+
+    DeviceModel *model = DeviceModel::instance();
+    QCOMPARE(model->drives().size(), mBaseDrives);
+    QCOMPARE(model->volumes().size(), mBaseVolumes);
+    QCOMPARE(model->mounts().size(), mBaseMounts);
+    QCOMPARE(liveFakes, 0);
+}
+
+Stick TestDeviceModel::makeStick(int partitions, bool mounted)
+{
+    const int serial = ++mSerial;
+    Stick stick;
+    stick.drive = static_cast<FakeDrive *>(g_object_new(fake_drive_get_type(), nullptr));
+    stick.drive->name = g_strdup_printf("Stick %d", serial);
+    stick.drive->device = g_strdup_printf("/dev/fake%d", serial);
+    for (int i = 1; i <= partitions; ++i)
+    {
+        FakeVolume *volume = static_cast<FakeVolume *>(g_object_new(fake_volume_get_type(), nullptr));
+        volume->name = g_strdup_printf("Part %d.%d", serial, i);
+        volume->device = g_strdup_printf("/dev/fake%d%d", serial, i);
+        volume->drive = stick.gdrive();
+        if (mounted)
+        {
+            const QString path = mMedia.path() + QStringLiteral("/%1-%2").arg(serial).arg(i);
+            QDir().mkpath(path);
+            FakeMount *mount = static_cast<FakeMount *>(g_object_new(fake_mount_get_type(), nullptr));
+            mount->volume = G_VOLUME(volume);
+            mount->root = g_file_new_for_path(QFile::encodeName(path).constData());
+            volume->mount = G_MOUNT(mount);
+            stick.mounts << mount;
+        }
+        stick.drive->volumes = g_list_append(stick.drive->volumes, volume);
+        stick.volumes << volume;
+    }
+    return stick;
+}
+
+// 模型不能再持有任何引用：除了驱动器本身，每个对象的引用只剩父对象那一份
+void TestDeviceModel::releaseStick(Stick &stick)
+{
+    QCOMPARE(G_OBJECT(stick.drive)->ref_count, 1u);
+    for (FakeVolume *volume : stick.volumes)
+        QCOMPARE(G_OBJECT(volume)->ref_count, 1u);
+    for (FakeMount *mount : stick.mounts)
+        QCOMPARE(G_OBJECT(mount)->ref_count, 1u);
+    g_object_unref(stick.drive);
+    stick = Stick();
+}
+
+void TestDeviceModel::emitSignal(const char *signal, gpointer object)
+{
+    // g_volume_monitor_get() 返回新引用，模型连的就是同一个单例
+    GVolumeMonitor *monitor = g_volume_monitor_get();
+    g_signal_emit_by_name(monitor, signal, object);
+    g_object_unref(monitor);
+}
+
+// GIO 接入时的顺序：驱动器、分区、挂载点
+void TestDeviceModel::plug(const Stick &stick)
+{
+    emitSignal("drive-connected", stick.drive);
+    for (FakeVolume *volume : stick.volumes)
+        emitSignal("volume-added", volume);
+    for (FakeMount *mount : stick.mounts)
+        emitSignal("mount-added", mount);
+}
+
+void TestDeviceModel::unplug(const Stick &stick)
+{
+    for (FakeMount *mount : stick.mounts)
+        emitSignal("mount-removed", mount);
+    for (FakeVolume *volume : stick.volumes)
+        emitSignal("volume-removed", volume);
+    emitSignal("drive-disconnected", stick.drive);
+}
+
+void TestDeviceModel::plugAndUnplug()
+{
+    DeviceModel *model = DeviceModel::instance();
+    Stick stick = makeStick(2, true);
+
+    plug(stick);
+    QCOMPARE(mEvents, QStringList() << "drive+" << "volume+" << "mount+" << "volume+" << "mount+");
+    QCOMPARE(model->drives().last(), stick.gdrive());
+    QCOMPARE(model->volumeCount(stick.gdrive()), 2);
+    QCOMPARE(model->mountCount(stick.gdrive()), 2);
+    const DeviceModel::Drive *drive = model->drive(stick.gdrive());
+    QCOMPARE(drive->device, QString::fromUtf8(stick.drive->device));
+    QCOMPARE(drive->partitions.at(1).device, QString::fromUtf8(stick.volumes.at(1)->device));
+    QVERIFY(drive->partitions.at(0).uri.startsWith(QLatin1String("file://")));
+
+    mEvents.clear();
+    unplug(stick);
+    QCOMPARE(mEvents, QStringList() << "mount-" << "mount-" << "volume-" << "volume-" << "drive-");
+    releaseStick(stick);
+}
+
+// 分区的回调比驱动器先到，驱动器也要先于分区通知
+void TestDeviceModel::partitionsBeforeDrive()
+{
+    Stick stick = makeStick(1, true);
+    emitSignal("mount-added", stick.mounts.first());
+    QCOMPARE(mEvents, QStringList() << "drive+" << "volume+" << "mount+");
+
+    emitSignal("volume-added", stick.volumes.first());
+    emitSignal("drive-connected", stick.drive);
+    QCOMPARE(mEvents.size(), 3);
+
+    unplug(stick);
+    releaseStick(stick);
+}
+
+// 只收到驱动器断开，子对象先子后父地移除
+void TestDeviceModel::unplugWithoutChildren()
+{
+    Stick stick = makeStick(3, true);
+    plug(stick);
+    mEvents.clear();
+
+    emitSignal("drive-disconnected", stick.drive);
+    QCOMPARE(mEvents, QStringList() << "mount-" << "volume-" << "mount-" << "volume-" << "mount-" << "volume-" << "drive-");
+    // 迟到的回调什么都不做
+    unplug(stick);
+    QCOMPARE(mEvents.size(), 7);
+    releaseStick(stick);
+}
+
+void TestDeviceModel::rename()
+{
+    DeviceModel *model = DeviceModel::instance();
+    Stick stick = makeStick(1, false);
+    plug(stick);
+    const quint64 revision = model->drive(stick.gdrive())->revision;
+    mEvents.clear();
+
+    emitSignal("volume-changed", stick.volumes.first());
+    QVERIFY(mEvents.isEmpty());
+
+    g_free(stick.volumes.first()->name);
+    stick.volumes.first()->name = g_strdup("Renamed");
+    emitSignal("volume-changed", stick.volumes.first());
+    QCOMPARE(mEvents, QStringList() << "changed");
+    QCOMPARE(model->partition(G_VOLUME(stick.volumes.first()))->name, QStringLiteral("Renamed"));
+    QVERIFY(model->drive(stick.gdrive())->revision > revision);
+
+    unplug(stick);
+    releaseStick(stick);
+}
+
+// 反复插拔，每轮都检查引用计数，最后对象全部析构、采样缓存也清空
+void TestDeviceModel::hotplugStress()
+{
+    const QString baseSampler = CapacitySampler::instance()->report().section(QLatin1Char(','), 0, 0);
+    // "drives N, volumes N, mounts N"，回调和信号的计数只增不减
+    const QString baseModel = DeviceModel::instance()->report().section(QLatin1Char(','), 0, 2);
+    const int rounds = 500;
+    QList<Stick> plugged;
+    for (int round = 0; round < rounds; ++round)
+    {
+        Stick stick = makeStick(1 + round % 3, round % 2 == 0);
+        plug(stick);
+        plugged << stick;
+        // 同时最多插着 4 个，拔掉的方式轮换
+        if (plugged.size() > 4)
+        {
+            Stick old = plugged.takeFirst();
+            if (round % 3 == 0)
+                emitSignal("drive-disconnected", old.drive);
+            else
+                unplug(old);
+            releaseStick(old);
+        }
+        if (round % 50 == 0)
+            QCoreApplication::processEvents();
+    }
+    for (Stick &stick : plugged)
+    {
+        unplug(stick);
+        releaseStick(stick);
+    }
+    QCOMPARE(liveFakes, 0);
+
+    QTRY_COMPARE(CapacitySampler::instance()->report().section(QLatin1Char(','), 0, 0), baseSampler);
+    QCOMPARE(DeviceModel::instance()->report().section(QLatin1Char(','), 0, 2), baseModel);
+}
+
+QTEST_GUILESS_MAIN(TestDeviceModel)
+#include "tst_devicemodel.moc"
@@ -0,0 +1,352 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include <QtTest>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusMetaType>
+#include <QDBusVirtualObject>
+#include <QTemporaryDir>
+#include "ejectengine.h"
+
+#define UDISKS_SERVICE      "org.freedesktop.UDisks2"
+#define UDISKS_PATH         "/org/freedesktop/UDisks2"
+#define UDISKS_BLOCK        "org.freedesktop.UDisks2.Block"
+#define UDISKS_FILESYSTEM   "org.freedesktop.UDisks2.Filesystem"
+#define UDISKS_DRIVE        "org.freedesktop.UDisks2.Drive"
+#define DRIVE_PATH          UDISKS_PATH "/drives/Test_Disk"
+#define BLOCK_PATH          UDISKS_PATH "/block_devices/"
+
+/* 假的 UDisks2：一个 U 盘 /dev/sdb，两个分区都已挂载。
+ * 每个调用都记下来，回复可以换成错误，或者推迟到 releaseDelayed()。 */
+class MockUDisks : public QDBusVirtualObject
+{
+public:
+    struct Call
+    {
+        QString path;
+        QString member;
+        QVariantMap options;
+    };
+
+    explicit MockUDisks(const QStringList &mountPoints)
+        : mMountPoints(mountPoints),
+          mEjectable(true),
+          mCanPowerOff(true)
+    {
+    }
+
+    QList<Call> calls;
+    QHash<QString, QString> errors;     // "path member" -> DBus error name
+    QSet<QString> delayed;              // "path member" answered only by releaseDelayed()
+
+    void setDrive(bool ejectable, bool canPowerOff)
+    {
+        mEjectable = ejectable;
+        mCanPowerOff = canPowerOff;
+    }
+
+    QStringList members() const
+    {
+        QStringList result;
+        for (const Call &call : calls)
+            result << call.member;
+        return result;
+    }
+
+    void releaseDelayed()
+    {
+        for (const QDBusMessage &reply : mDelayedReplies)
+            mConnection.send(reply);
+        mDelayedReplies.clear();
+    }
+
+    QString introspect(const QString &) const override { return QString(); }
+
+    bool handleMessage(const QDBusMessage &message, const QDBusConnection &connection) override
+    {
+        mConnection = connection;
+        Call call;
+        call.path = message.path();
+        call.member = message.member();
+        if (!message.arguments().isEmpty())
+            call.options = qdbus_cast<QVariantMap>(message.arguments().first());
+        calls << call;
+
+        const QString key = call.path + ' ' + call.member;
+        QDBusMessage reply;
+        if (errors.contains(key))
+            reply = message.createErrorReply(errors.value(key), QStringLiteral("mock error for %1").arg(key));
+        else if (call.member == QLatin1String("GetManagedObjects"))
+            reply = message.createReply(QVariant::fromValue(objects()));
+        else
+            reply = message.createReply();
+
+        if (delayed.contains(key))
+            mDelayedReplies << reply;
+        else
+            connection.send(reply);
+        return true;
+    }
+
+private:
+    UDisksObjects objects() const
+    {
+        UDisksObjects objects;
+        QVariantMap drive;
+        drive.insert(QStringLiteral("Ejectable"), mEjectable);
+        drive.insert(QStringLiteral("CanPowerOff"), mCanPowerOff);
+        objects[QDBusObjectPath(DRIVE_PATH)].insert(UDISKS_DRIVE, drive);
+
+        // 整盘没有文件系统
+        objects[QDBusObjectPath(BLOCK_PATH "sdb")].insert(UDISKS_BLOCK, block(QStringLiteral("/dev/sdb")));
+        for (int i = 0; i < mMountPoints.size(); ++i)
+        {
+            const QString name = QStringLiteral("sdb%1").arg(i + 1);
+            UDisksInterfaces &interfaces = objects[QDBusObjectPath(BLOCK_PATH + name)];
+            interfaces.insert(UDISKS_BLOCK, block("/dev/" + name));
+            QVariantMap filesystem;
+            filesystem.insert(QStringLiteral("MountPoints"),
+                              QVariant::fromValue(QList<QByteArray>() << byteString(mMountPoints.at(i))));
+            interfaces.insert(UDISKS_FILESYSTEM, filesystem);
+        }
+
+        // 另一块盘上的分区不能被卸载
+        UDisksInterfaces &other = objects[QDBusObjectPath(BLOCK_PATH "sdc1")];
+        QVariantMap otherBlock = block(QStringLiteral("/dev/sdc1"));
+        otherBlock.insert(QStringLiteral("Drive"), QVariant::fromValue(QDBusObjectPath(UDISKS_PATH "/drives/Other")));
+        other.insert(UDISKS_BLOCK, otherBlock);
+        QVariantMap otherFilesystem;
+        otherFilesystem.insert(QStringLiteral("MountPoints"),
+                               QVariant::fromValue(QList<QByteArray>() << byteString(QStringLiteral("/media/other"))));
+        other.insert(UDISKS_FILESYSTEM, otherFilesystem);
+        return objects;
+    }
+
+    static QVariantMap block(const QString &device)
+    {
+        QVariantMap props;
+        props.insert(QStringLiteral("Device"), byteString(device));
+        props.insert(QStringLiteral("Drive"), QVariant::fromValue(QDBusObjectPath(DRIVE_PATH)));
+        return props;
+    }
+
+    // UDisks2 的 ay 字符串带结尾的 '\0'
+    static QByteArray byteString(const QString &text)
+    {
+        QByteArray bytes = QFile::encodeName(text);
+        bytes.append('\0');
+        return bytes;
+    }
+
+    QStringList mMountPoints;
+    bool mEjectable;
+    bool mCanPowerOff;
+    QDBusConnection mConnection = QDBusConnection(QString());
+    QList<QDBusMessage> mDelayedReplies;
+};
+
+class TestEjectEngine : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void ejectDrive();
+    void ejectByPartition();
+    void notEjectable();
+    void notMounted();
+    void ejectFailureIsNotFatal();
+    void busyDevice();
+    void forceUnmount();
+    void unknownDevice();
+    void asynchronous();
+
+private:
+    QTemporaryDir mMedia;
+    QStringList mMountPoints;
+    MockUDisks *mUDisks;
+    QDBusConnection mBus = QDBusConnection(QString());
+    QSignalSpy *mFinished;
+    QSignalSpy *mFailed;
+    QSignalSpy *mProgress;
+};
+
+// 引擎走系统总线，测试里把系统总线指到 dbus-run-session 的私有总线上
+void TestEjectEngine::initTestCase()
+{
+    QVERIFY(!qEnvironmentVariableIsEmpty("DBUS_SESSION_BUS_ADDRESS"));
+    qputenv("DBUS_SYSTEM_BUS_ADDRESS", qgetenv("DBUS_SESSION_BUS_ADDRESS"));
+    qRegisterMetaType<EjectEngine::Stage>("EjectEngine::Stage");
+    qDBusRegisterMetaType<QList<QByteArray> >();
+    qDBusRegisterMetaType<UDisksInterfaces>();
+    qDBusRegisterMetaType<UDisksObjects>();
+
+    QVERIFY(mMedia.isValid());
+    for (const QString &name : { QStringLiteral("part1"), QStringLiteral("part2") })
+    {
+        QVERIFY(QDir(mMedia.path()).mkdir(name));
+        // 和 /proc/<pid>/fd 里的链接目标比较，要用真实路径
+        mMountPoints << QDir(mMedia.path()).canonicalPath() + '/' + name;
+    }
+
+    mBus = QDBusConnection::connectToBus(QDBusConnection::SessionBus, QStringLiteral("udisks"));
+    QVERIFY(mBus.registerService(QStringLiteral(UDISKS_SERVICE)));
+}
+
+void TestEjectEngine::init()
+{
+    mUDisks = new MockUDisks(mMountPoints);
+    QVERIFY(mBus.registerVirtualObject(QStringLiteral(UDISKS_PATH), mUDisks, QDBusConnection::SubPath));
+
+    EjectEngine *engine = EjectEngine::instance();
+    mFinished = new QSignalSpy(engine, &EjectEngine::finished);
+    mFailed = new QSignalSpy(engine, &EjectEngine::failed);
+    mProgress = new QSignalSpy(engine, &EjectEngine::progress);
+}
+
+void TestEjectEngine::cleanup()
+{
+    QTRY_VERIFY(!EjectEngine::instance()->isBusy(QStringLiteral("/dev/sdb")));
+    mBus.unregisterObject(QStringLiteral(UDISKS_PATH), QDBusConnection::UnregisterTree);
+    delete mUDisks;
+    delete mFinished;
+    delete mFailed;
+    delete mProgress;
+}
+
+void TestEjectEngine::ejectDrive()
+{
+    QVERIFY(EjectEngine::instance()->eject(QStringLiteral("/dev/sdb")));
+    QTRY_COMPARE(mFinished->count(), 1);
+    QCOMPARE(mFinished->at(0).at(0).toString(), QStringLiteral("/dev/sdb"));
+    QCOMPARE(mFailed->count(), 0);
+
+    QCOMPARE(mUDisks->members(), QStringList() << "GetManagedObjects" << "Unmount" << "Unmount" << "Eject" << "PowerOff");
+    QCOMPARE(mUDisks->calls.at(1).path, QStringLiteral(BLOCK_PATH "sdb1"));
+    QCOMPARE(mUDisks->calls.at(2).path, QStringLiteral(BLOCK_PATH "sdb2"));
+    QCOMPARE(mUDisks->calls.at(3).path, QStringLiteral(DRIVE_PATH));
+    QVERIFY(!mUDisks->calls.at(1).options.contains(QStringLiteral("force")));
+
+    QList<EjectEngine::Stage> stages;
+    for (const QList<QVariant> &args : *mProgress)
+        stages << args.at(1).value<EjectEngine::Stage>();
+    QCOMPARE(stages, QList<EjectEngine::Stage>() << EjectEngine::Resolving << EjectEngine::Unmounting
+                                                 << EjectEngine::Unmounting << EjectEngine::Ejecting
+                                                 << EjectEngine::PoweringOff);
+    QCOMPARE(mProgress->at(2).at(2).toInt(), 1);
+    QCOMPARE(mProgress->at(2).at(3).toInt(), 2);
+}
+
+// 从一个分区弹出，同一驱动器上的其他分区也要卸载
+void TestEjectEngine::ejectByPartition()
+{
+    QVERIFY(EjectEngine::instance()->eject(QStringLiteral("/dev/sdb2")));
+    QTRY_COMPARE(mFinished->count(), 1);
+    QCOMPARE(mUDisks->members().count(QStringLiteral("Unmount")), 2);
+    for (const MockUDisks::Call &call : mUDisks->calls)
+        QVERIFY(!call.path.endsWith(QLatin1String("sdc1")));
+}
+
+void TestEjectEngine::notEjectable()
+{
+    mUDisks->setDrive(false, false);
+    QVERIFY(EjectEngine::instance()->eject(QStringLiteral("/dev/sdb")));
+    QTRY_COMPARE(mFinished->count(), 1);
+    QCOMPARE(mUDisks->members(), QStringList() << "GetManagedObjects" << "Unmount" << "Unmount");
+}
+
+void TestEjectEngine::notMounted()
+{
+    mUDisks->errors.insert(BLOCK_PATH "sdb1 Unmount", QStringLiteral("org.freedesktop.UDisks2.Error.NotMounted"));
+    QVERIFY(EjectEngine::instance()->eject(QStringLiteral("/dev/sdb")));
+    QTRY_COMPARE(mFinished->count(), 1);
+    QCOMPARE(mFailed->count(), 0);
+}
+
+// 文件系统都卸载了，弹出失败只记录，照样断电
+void TestEjectEngine::ejectFailureIsNotFatal()
+{
+    mUDisks->errors.insert(DRIVE_PATH " Eject", QStringLiteral("org.freedesktop.UDisks2.Error.Failed"));
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("^Eject \"/dev/sdb\" failed")));
+    QVERIFY(EjectEngine::instance()->eject(QStringLiteral("/dev/sdb")));
+    QTRY_COMPARE(mFinished->count(), 1);
+    QCOMPARE(mUDisks->members().last(), QStringLiteral("PowerOff"));
+}
+
+void TestEjectEngine::busyDevice()
+{
+    // 这个进程在挂载点里开着一个文件
+    QFile file(mMountPoints.at(1) + QStringLiteral("/open.txt"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+
+    mUDisks->errors.insert(BLOCK_PATH "sdb2 Unmount", QStringLiteral("org.freedesktop.UDisks2.Error.DeviceBusy"));
+    QVERIFY(EjectEngine::instance()->eject(QStringLiteral("/dev/sdb")));
+    QTRY_COMPARE(mFailed->count(), 1);
+    QCOMPARE(mFinished->count(), 0);
+
+    const QList<QVariant> args = mFailed->at(0);
+    QCOMPARE(args.at(0).toString(), QStringLiteral("/dev/sdb"));
+    QVERIFY(args.at(1).toString().contains(QStringLiteral("mock error")));
+    QVERIFY(args.at(2).toBool());
+    const QString self = QStringLiteral("(%1)").arg(QCoreApplication::applicationPid());
+    QVERIFY2(args.at(3).toStringList().filter(self).size() == 1, qPrintable(args.at(3).toStringList().join(", ")));
+    QVERIFY(!mUDisks->members().contains(QStringLiteral("Eject")));
+}
+
+void TestEjectEngine::forceUnmount()
+{
+    QVERIFY(EjectEngine::instance()->eject(QStringLiteral("/dev/sdb"), true));
+    QTRY_COMPARE(mFinished->count(), 1);
+    QCOMPARE(mUDisks->calls.at(1).member, QStringLiteral("Unmount"));
+    QCOMPARE(mUDisks->calls.at(1).options.value(QStringLiteral("force")).toBool(), true);
+}
+
+void TestEjectEngine::unknownDevice()
+{
+    QVERIFY(EjectEngine::instance()->eject(QStringLiteral("/dev/sdz")));
+    QTRY_COMPARE(mFailed->count(), 1);
+    QCOMPARE(mFailed->at(0).at(2).toBool(), false);
+    QVERIFY(mFailed->at(0).at(3).toStringList().isEmpty());
+    QVERIFY(!EjectEngine::instance()->isBusy(QStringLiteral("/dev/sdz")));
+}
+
+// 卸载等缓存写回时界面照常运行，同一设备不会重复弹出
+void TestEjectEngine::asynchronous()
+{
+    mUDisks->delayed.insert(BLOCK_PATH "sdb1 Unmount");
+    EjectEngine *engine = EjectEngine::instance();
+    QVERIFY(engine->eject(QStringLiteral("/dev/sdb")));
+    QTRY_COMPARE(mUDisks->members().count(QStringLiteral("Unmount")), 1);
+
+    QVERIFY(engine->isBusy(QStringLiteral("/dev/sdb")));
+    QVERIFY(!engine->eject(QStringLiteral("/dev/sdb")));
+    QTest::qWait(200);
+    QCOMPARE(mFinished->count(), 0);
+    QCOMPARE(mUDisks->members().count(QStringLiteral("Unmount")), 1);
+
+    mUDisks->releaseDelayed();
+    QTRY_COMPARE(mFinished->count(), 1);
+    QCOMPARE(mUDisks->members().count(QStringLiteral("Unmount")), 2);
+}
+
+QTEST_GUILESS_MAIN(TestEjectEngine)
+#include "tst_ejectengine.moc"
@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include <QtTest>
+#include <QDBusMessage>
+#include <QRegularExpression>
+#include "panelharness.h"
+
+#define WATCHDOG_PATH       "/watchdog"
+#define WATCHDOG_INTERFACE  "com.ukui.panel.debug.HangWatchdog"
+#define STALL_PATH          "/teststall"
+#define STALL_INTERFACE     "com.ukui.panel.test.Stall"
+#define THRESHOLD           500     // ms
+
+/* 面板在 Xvfb 上只加载测试插件 teststall，让它把 GUI 线程卡住，
+ * 看门狗要记下停顿的时长、插件和栈，面板之后照常响应。 */
+class TestHangWatchdog : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void shortStallIgnored();
+    void stallAttributed();
+    void disable();
+
+private:
+    QString report();
+    int stalls();
+    void stall(int msecs);
+
+    PanelHarness mPanel;
+};
+
+QString TestHangWatchdog::report()
+{
+    const QDBusMessage reply = mPanel.call(QStringLiteral(WATCHDOG_PATH), QStringLiteral(WATCHDOG_INTERFACE),
+                                           QStringLiteral("report"));
+    return reply.arguments().value(0).toString();
+}
+
+int TestHangWatchdog::stalls()
+{
+    static const QRegularExpression summary(QStringLiteral("threshold \\d+ ms, (\\d+) stalls"));
+    return summary.match(report()).captured(1).toInt();
+}
+
+void TestHangWatchdog::stall(int msecs)
+{
+    const QDBusMessage reply = mPanel.call(QStringLiteral(STALL_PATH), QStringLiteral(STALL_INTERFACE),
+                                           QStringLiteral("stall"), QVariantList() << msecs);
+    QCOMPARE(reply.type(), QDBusMessage::ReplyMessage);
+}
+
+void TestHangWatchdog::initTestCase()
+{
+    const QStringList missing = PanelHarness::missingTools();
+    if (!missing.isEmpty())
+        QSKIP(qPrintable(QStringLiteral("needs ") + missing.join(QStringLiteral(", "))));
+
+    mPanel.setConfig("panels=panel1\n"
+                     "\n"
+                     "[panel1]\n"
+                     "plugins=teststall\n"
+                     "position=Bottom\n"
+                     "\n"
+                     "[teststall]\n"
+                     "type=teststall\n");
+    mPanel.addPluginDir(QStringLiteral(STALL_PLUGIN_DIR));
+    mPanel.setEnvironment(QStringLiteral("UKUI_PANEL_WATCHDOG"), QStringLiteral("1"));
+    mPanel.setEnvironment(QStringLiteral("UKUI_PANEL_WATCHDOG_MS"), QString::number(THRESHOLD));
+    QString error;
+    QVERIFY2(mPanel.start(&error), qPrintable(error + QLatin1Char('\n') + mPanel.log()));
+    QVERIFY2(mPanel.waitForObject(QStringLiteral(WATCHDOG_PATH)), qPrintable(mPanel.log()));
+    QVERIFY2(mPanel.waitForObject(QStringLiteral(STALL_PATH)), qPrintable(mPanel.log()));
+    QVERIFY2(report().startsWith(QStringLiteral("watchdog on, threshold %1 ms").arg(THRESHOLD)), qPrintable(report()));
+}
+
+void TestHangWatchdog::cleanupTestCase()
+{
+    mPanel.stop();
+}
+
+void TestHangWatchdog::shortStallIgnored()
+{
+    // 启动时的加载可能已经算过停顿，只看之后的变化
+    const int before = stalls();
+    stall(THRESHOLD / 5);
+    QTest::qWait(THRESHOLD * 2);
+    QCOMPARE(stalls(), before);
+}
+
+void TestHangWatchdog::stallAttributed()
+{
+    const int before = stalls();
+    stall(THRESHOLD * 4);
+    // 卡住期间 report() 的调用排在后面，面板恢复后才回答
+    QTRY_COMPARE_WITH_TIMEOUT(stalls(), before + 1, THRESHOLD * 10);
+    QVERIFY2(mPanel.isRunning(), qPrintable(mPanel.log()));
+
+    // "<time> <ms> ms <plugin> (<receiver>): <frames>"，最新的在最后
+    const QStringList lines = report().split(QLatin1Char('\n'), QString::SkipEmptyParts);
+    const QString last = lines.last();
+    static const QRegularExpression entry(QStringLiteral("^\\S+ (\\d+) ms (\\S+) \\((.*)\\): (.*)$"));
+    const QRegularExpressionMatch match = entry.match(last);
+    QVERIFY2(match.hasMatch(), qPrintable(last));
+    const int msecs = match.captured(1).toInt();
+    QVERIFY2(msecs >= THRESHOLD * 3 && msecs < THRESHOLD * 8, qPrintable(last));
+    QCOMPARE(match.captured(2), QStringLiteral("teststall"));
+    QCOMPARE(match.captured(3), QStringLiteral("QTimer"));
+    QVERIFY2(!match.captured(4).isEmpty(), qPrintable(last));
+
+    // 报告只留栈顶几帧，完整的栈在日志里，里面要有卡住的插件库
+    const QString log = mPanel.log();
+    QVERIFY2(log.contains(QLatin1String("libteststall.so")), qPrintable(log));
+    QVERIFY2(log.contains(QLatin1String("GUI thread was stalled")), qPrintable(log));
+}
+
+void TestHangWatchdog::disable()
+{
+    const int before = stalls();
+    QCOMPARE(mPanel.call(QStringLiteral(WATCHDOG_PATH), QStringLiteral(WATCHDOG_INTERFACE),
+                         QStringLiteral("setEnabled"), QVariantList() << false).type(), QDBusMessage::ReplyMessage);
+    QVERIFY(report().startsWith(QLatin1String("watchdog off")));
+
+    stall(THRESHOLD * 3);
+    QTest::qWait(THRESHOLD);
+    QCOMPARE(stalls(), before);
+    QVERIFY2(mPanel.isRunning(), qPrintable(mPanel.log()));
+}
+
+QTEST_GUILESS_MAIN(TestHangWatchdog)
+#include "tst_hangwatchdog.moc"
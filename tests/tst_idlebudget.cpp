@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include <QtTest>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QRegularExpression>
+#include "panelharness.h"
+
+#define PRESENCE_SERVICE    "org.gnome.SessionManager"
+#define PRESENCE_PATH       "/org/gnome/SessionManager/Presence"
+#define PRESENCE_INTERFACE  "org.gnome.SessionManager.Presence"
+#define PRESENCE_AVAILABLE  0
+#define PRESENCE_IDLE       3
+#define AUDITOR_PATH        "/wakeups"
+#define AUDITOR_INTERFACE   "com.ukui.panel.debug.WakeupAuditor"
+
+/* 默认配置的面板在 Xvfb 上启动，会话进入空闲后统计一段时间的唤醒，
+ * 空闲唤醒率不能超过审计器自己的预算。
+ * 统计时长默认 20 秒，可以用 UKUI_PANEL_IDLE_SECONDS 加长。 */
+class TestIdleBudget : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void idleWithinBudget();
+    void activeAgain();
+
+private:
+    void setPresence(uint status);
+    QString report();
+
+    PanelHarness mPanel;
+    QDBusConnection mSession = QDBusConnection(QString());
+    QElapsedTimer mStarted;
+};
+
+void TestIdleBudget::setPresence(uint status)
+{
+    QDBusMessage signal = QDBusMessage::createSignal(QStringLiteral(PRESENCE_PATH), QStringLiteral(PRESENCE_INTERFACE),
+                                                     QStringLiteral("StatusChanged"));
+    signal << status;
+    QVERIFY(mSession.send(signal));
+}
+
+QString TestIdleBudget::report()
+{
+    const QDBusMessage reply = mPanel.call(QStringLiteral(AUDITOR_PATH), QStringLiteral(AUDITOR_INTERFACE),
+                                           QStringLiteral("report"));
+    return reply.arguments().value(0).toString();
+}
+
+void TestIdleBudget::initTestCase()
+{
+    const QStringList missing = PanelHarness::missingTools();
+    if (!missing.isEmpty())
+        QSKIP(qPrintable(QStringLiteral("needs ") + missing.join(QStringLiteral(", "))));
+
+    // 面板启动前就要有会话管理器，它按服务名连接 StatusChanged
+    mStarted.start();
+    mSession = QDBusConnection::connectToBus(QDBusConnection::SessionBus, QStringLiteral("session-manager"));
+    QVERIFY(mSession.registerService(QStringLiteral(PRESENCE_SERVICE)));
+
+    mPanel.setEnvironment(QStringLiteral("UKUI_PANEL_AUDIT_WAKEUPS"), QStringLiteral("1"));
+    QString error;
+    QVERIFY2(mPanel.start(&error), qPrintable(error + QLatin1Char('\n') + mPanel.log()));
+    QVERIFY2(mPanel.waitForObject(QStringLiteral(AUDITOR_PATH)), qPrintable(mPanel.log()));
+    QVERIFY(report().startsWith(QLatin1String("auditing on")));
+}
+
+void TestIdleBudget::cleanupTestCase()
+{
+    mPanel.stop();
+}
+
+void TestIdleBudget::idleWithinBudget()
+{
+    // 启动时的插件加载、首次绘制等不算
+    QTest::qWait(5000);
+    setPresence(PRESENCE_IDLE);
+    QTRY_VERIFY(report().contains(QLatin1String("idle now: yes")));
+    QCOMPARE(mPanel.call(QStringLiteral(AUDITOR_PATH), QStringLiteral(AUDITOR_INTERFACE),
+                         QStringLiteral("reset")).type(), QDBusMessage::ReplyMessage);
+
+    int seconds = qEnvironmentVariableIntValue("UKUI_PANEL_IDLE_SECONDS");
+    if (seconds <= 0)
+        seconds = 20;
+    QTest::qWait(seconds * 1000);
+    QVERIFY2(mPanel.isRunning(), qPrintable(mPanel.log()));
+
+    const QString result = report();
+    static const QRegularExpression summary(QStringLiteral("\\(([0-9.]+)/s, budget ([0-9.]+)/s\\), idle now: yes"));
+    const QRegularExpressionMatch match = summary.match(result);
+    QVERIFY2(match.hasMatch(), qPrintable(result));
+    const double rate = match.captured(1).toDouble();
+    const double budget = match.captured(2).toDouble();
+    QVERIFY2(rate <= budget, qPrintable(result));
+}
+
+void TestIdleBudget::activeAgain()
+{
+    // Xvfb never sees input, after a minute its screensaver idle time keeps the session idle
+    if (mStarted.elapsed() > 50000)
+        QSKIP("the X screen has been idle for a minute");
+    setPresence(PRESENCE_AVAILABLE);
+    QTRY_VERIFY(report().contains(QLatin1String("idle now: no")));
+}
+
+QTEST_GUILESS_MAIN(TestIdleBudget)
+#include "tst_idlebudget.moc"
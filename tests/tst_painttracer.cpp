@@ -0,0 +1,195 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include <QtTest>
+#include <QWidget>
+#include "painttracer.h"
+
+// 面板里由 UKUIPanelApplication::notify() 报告绘制，这里在 paintEvent() 里报告
+class TracedWidget : public QWidget
+{
+public:
+    int paints = 0;
+
+protected:
+    void paintEvent(QPaintEvent *) override
+    {
+        ++paints;
+        PaintTracer::instance()->painted(this);
+    }
+};
+
+class TestPaintTracer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void disabledByDefault();
+    void latencyBucket_data();
+    void latencyBucket();
+    void coalescedStamps();
+    void staleStamp();
+    void unstampedPaint();
+    void destroyedWidget();
+    void reset();
+
+private:
+    static QString line(const QString &source);
+
+    TracedWidget *mWidget = nullptr;
+};
+
+QString TestPaintTracer::line(const QString &source)
+{
+    const QStringList lines = PaintTracer::instance()->report().split(QLatin1Char('\n'), QString::SkipEmptyParts);
+    for (const QString &l : lines)
+    {
+        if (l.startsWith(source + QLatin1Char(':')))
+            return l;
+    }
+    return QString();
+}
+
+void TestPaintTracer::init()
+{
+    mWidget = new TracedWidget;
+    mWidget->resize(50, 20);
+    mWidget->show();
+    QVERIFY(QTest::qWaitForWindowExposed(mWidget));
+    PaintTracer::instance()->reset();
+}
+
+void TestPaintTracer::cleanup()
+{
+    delete mWidget;
+    PaintTracer::instance()->setEnabled(false);
+}
+
+void TestPaintTracer::disabledByDefault()
+{
+    QVERIFY(!PaintTracer::isEnabled());
+    PaintTracer::trace(mWidget, "damage");
+    mWidget->repaint();
+    QCOMPARE(PaintTracer::instance()->report(), QStringLiteral("tracing off, 0 stamps waiting for a paint\n"));
+}
+
+void TestPaintTracer::latencyBucket_data()
+{
+    QTest::addColumn<int>("delay");
+    QTest::addColumn<QString>("bucket");
+
+    QTest::newRow("immediate") << 0 << "<1ms:1";
+    QTest::newRow("two frames") << 40 << "<66ms:1";
+    QTest::newRow("slow") << 600 << ">=533ms:1";
+}
+
+void TestPaintTracer::latencyBucket()
+{
+    QFETCH(int, delay);
+    QFETCH(QString, bucket);
+
+    PaintTracer::instance()->setEnabled(true);
+    PaintTracer::trace(mWidget, "damage");
+    if (delay > 0)
+        QThread::msleep(delay);
+    mWidget->repaint();
+
+    const QString result = line(QStringLiteral("damage"));
+    QVERIFY2(result.startsWith(QLatin1String("damage: 1 painted, 0 dropped")), qPrintable(result));
+    QVERIFY2(result.contains(bucket), qPrintable(result));
+    const qint64 maxUsecs = result.section(QLatin1Char(' '), 6, 6).toLongLong();
+    QVERIFY2(maxUsecs >= delay * 1000LL, qPrintable(result));
+}
+
+// 两个事件赶上同一次绘制：只记一次，算在较早的来源上
+void TestPaintTracer::coalescedStamps()
+{
+    PaintTracer::instance()->setEnabled(true);
+    PaintTracer::trace(mWidget, "damage");
+    PaintTracer::trace(mWidget, "sni");
+    QVERIFY(PaintTracer::instance()->report().contains(QLatin1String("1 stamps waiting")));
+    mWidget->repaint();
+
+    QVERIFY(line(QStringLiteral("damage")).startsWith(QLatin1String("damage: 1 painted")));
+    QVERIFY(line(QStringLiteral("sni")).isEmpty());
+    QVERIFY(PaintTracer::instance()->report().contains(QLatin1String("0 stamps waiting")));
+}
+
+// 一秒内没画的标记算丢弃，由下一个标记代替
+void TestPaintTracer::staleStamp()
+{
+    PaintTracer::instance()->setEnabled(true);
+    PaintTracer::trace(mWidget, "property");
+    QThread::msleep(1100);
+    PaintTracer::trace(mWidget, "clock");
+    mWidget->repaint();
+
+    QVERIFY(line(QStringLiteral("property")).startsWith(QLatin1String("property: 0 painted, 1 dropped")));
+    QVERIFY(line(QStringLiteral("clock")).startsWith(QLatin1String("clock: 1 painted, 0 dropped")));
+
+    // 画得太晚也算丢弃
+    PaintTracer::trace(mWidget, "clock");
+    QThread::msleep(1100);
+    mWidget->repaint();
+    QVERIFY(line(QStringLiteral("clock")).startsWith(QLatin1String("clock: 1 painted, 1 dropped")));
+}
+
+void TestPaintTracer::unstampedPaint()
+{
+    PaintTracer::instance()->setEnabled(true);
+    PaintTracer::trace(nullptr, "damage");
+    const int paints = mWidget->paints;
+    mWidget->repaint();
+    QVERIFY(mWidget->paints > paints);
+    QCOMPARE(PaintTracer::instance()->report(), QStringLiteral("tracing on, 0 stamps waiting for a paint\n"));
+}
+
+// 控件销毁时它的标记一起去掉，地址被新控件复用也不会串
+void TestPaintTracer::destroyedWidget()
+{
+    PaintTracer::instance()->setEnabled(true);
+    QWidget *other = new QWidget;
+    PaintTracer::trace(other, "damage");
+    QVERIFY(PaintTracer::instance()->report().contains(QLatin1String("1 stamps waiting")));
+    delete other;
+    QVERIFY(PaintTracer::instance()->report().contains(QLatin1String("0 stamps waiting")));
+}
+
+void TestPaintTracer::reset()
+{
+    PaintTracer::instance()->setEnabled(true);
+    PaintTracer::trace(mWidget, "damage");
+    mWidget->repaint();
+    PaintTracer::trace(mWidget, "damage");
+    PaintTracer::instance()->reset();
+    QCOMPARE(PaintTracer::instance()->report(), QStringLiteral("tracing on, 0 stamps waiting for a paint\n"));
+
+    // 关掉时丢掉等待中的标记，统计保留
+    PaintTracer::trace(mWidget, "damage");
+    mWidget->repaint();
+    PaintTracer::trace(mWidget, "damage");
+    PaintTracer::instance()->setEnabled(false);
+    QVERIFY(PaintTracer::instance()->report().startsWith(QLatin1String("tracing off, 0 stamps waiting")));
+    QVERIFY(line(QStringLiteral("damage")).startsWith(QLatin1String("damage: 1 painted")));
+}
+
+QTEST_MAIN(TestPaintTracer)
+#include "tst_painttracer.moc"
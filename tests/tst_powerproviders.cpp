@@ -0,0 +1,273 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include <QtTest>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QDBusVariant>
+#include <QDBusVirtualObject>
+#include "ukuipowerproviders.h"
+
+#define LOGIND_SERVICE      "org.freedesktop.login1"
+#define LOGIND_PATH         "/org/freedesktop/login1"
+#define LOGIND_INTERFACE    "org.freedesktop.login1.Manager"
+#define UPOWER_SERVICE      "org.freedesktop.UPower"
+#define UPOWER_PATH         "/org/freedesktop/UPower"
+
+using namespace UKUi;
+
+/* 假的 logind / UPower：answers 按方法名给出回复，Properties.Get 按属性名。
+ * 没给答案的方法回错误；delayed 时回复攒着，releaseDelayed() 才发出去。 */
+class MockPowerService : public QDBusVirtualObject
+{
+public:
+    QHash<QString, QVariant> answers;
+    QStringList calls;
+    bool delayed = false;
+
+    int count(const QString &member) const { return calls.count(member); }
+
+    void releaseDelayed()
+    {
+        for (const QDBusMessage &reply : mDelayedReplies)
+            mConnection.send(reply);
+        mDelayedReplies.clear();
+    }
+
+    QString introspect(const QString &) const override { return QString(); }
+
+    bool handleMessage(const QDBusMessage &message, const QDBusConnection &connection) override
+    {
+        mConnection = connection;
+        QString key = message.member();
+        if (key == QLatin1String("Get") && message.arguments().size() == 2)
+            key = message.arguments().at(1).toString();
+        calls << key;
+
+        QDBusMessage reply;
+        if (!answers.contains(key))
+            reply = message.createErrorReply(QStringLiteral("org.freedesktop.DBus.Error.AccessDenied"), key);
+        else if (message.member() == QLatin1String("Get"))
+            reply = message.createReply(QVariant::fromValue(QDBusVariant(answers.value(key))));
+        else
+            reply = message.createReply(answers.value(key));
+
+        if (delayed)
+            mDelayedReplies << reply;
+        else
+            connection.send(reply);
+        return true;
+    }
+
+private:
+    QDBusConnection mConnection = QDBusConnection(QString());
+    QList<QDBusMessage> mDelayedReplies;
+};
+
+class TestPowerProviders : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void logindAnswers();
+    void canActionNeverCalls();
+    void errorIsUnavailable();
+    void upowerNeedsBoth();
+    void ownerChange();
+    void resume();
+    void staleAnswersIgnored();
+
+private:
+    static void waitForProbes(MockPowerService *service, int calls);
+
+    QDBusConnection mLogindBus = QDBusConnection(QString());
+    QDBusConnection mUPowerBus = QDBusConnection(QString());
+    MockPowerService *mLogind;
+    MockPowerService *mUPower;
+};
+
+void TestPowerProviders::waitForProbes(MockPowerService *service, int calls)
+{
+    QTRY_COMPARE(service->calls.size(), calls);
+}
+
+// 提供者走系统总线，测试里把系统总线指到 dbus-run-session 的私有总线上
+void TestPowerProviders::initTestCase()
+{
+    QVERIFY(!qEnvironmentVariableIsEmpty("DBUS_SESSION_BUS_ADDRESS"));
+    qputenv("DBUS_SYSTEM_BUS_ADDRESS", qgetenv("DBUS_SESSION_BUS_ADDRESS"));
+
+    // 两个服务各用一个连接，才能分别换主人
+    mLogindBus = QDBusConnection::connectToBus(QDBusConnection::SessionBus, QStringLiteral("logind"));
+    mUPowerBus = QDBusConnection::connectToBus(QDBusConnection::SessionBus, QStringLiteral("upower"));
+    QVERIFY(mLogindBus.registerService(QStringLiteral(LOGIND_SERVICE)));
+    QVERIFY(mUPowerBus.registerService(QStringLiteral(UPOWER_SERVICE)));
+}
+
+void TestPowerProviders::init()
+{
+    mLogind = new MockPowerService;
+    mLogind->answers.insert(QStringLiteral("CanReboot"), QStringLiteral("yes"));
+    mLogind->answers.insert(QStringLiteral("CanPowerOff"), QStringLiteral("challenge"));
+    mLogind->answers.insert(QStringLiteral("CanSuspend"), QStringLiteral("no"));
+    mLogind->answers.insert(QStringLiteral("CanHibernate"), QStringLiteral("na"));
+    QVERIFY(mLogindBus.registerVirtualObject(QStringLiteral(LOGIND_PATH), mLogind));
+
+    mUPower = new MockPowerService;
+    mUPower->answers.insert(QStringLiteral("CanSuspend"), true);
+    mUPower->answers.insert(QStringLiteral("SuspendAllowed"), true);
+    mUPower->answers.insert(QStringLiteral("CanHibernate"), true);
+    mUPower->answers.insert(QStringLiteral("HibernateAllowed"), false);
+    QVERIFY(mUPowerBus.registerVirtualObject(QStringLiteral(UPOWER_PATH), mUPower));
+}
+
+void TestPowerProviders::cleanup()
+{
+    mLogindBus.unregisterObject(QStringLiteral(LOGIND_PATH));
+    mUPowerBus.unregisterObject(QStringLiteral(UPOWER_PATH));
+    delete mLogind;
+    delete mUPower;
+}
+
+void TestPowerProviders::logindAnswers()
+{
+    SystemdProvider provider;
+    QSignalSpy changed(&provider, &PowerProvider::capabilitiesChanged);
+    // 回复到来前一律不可用
+    QVERIFY(!provider.canAction(Power::PowerReboot));
+
+    QTRY_COMPARE(changed.count(), 4);
+    QVERIFY(provider.canAction(Power::PowerReboot));
+    QVERIFY(provider.canAction(Power::PowerShutdown));
+    QVERIFY(!provider.canAction(Power::PowerSuspend));
+    QVERIFY(!provider.canAction(Power::PowerHibernate));
+    QVERIFY(!provider.canAction(Power::PowerLogout));
+    QCOMPARE(mLogind->calls.size(), 4);
+}
+
+// canAction() 只读缓存，服务再慢也不会卡住调用者
+void TestPowerProviders::canActionNeverCalls()
+{
+    mLogind->delayed = true;
+    SystemdProvider provider;
+    waitForProbes(mLogind, 4);
+
+    QElapsedTimer timer;
+    timer.start();
+    for (int i = 0; i < 10000; ++i)
+        QVERIFY(!provider.canAction(Power::PowerReboot));
+    QVERIFY(timer.elapsed() < 1000);
+    QCOMPARE(mLogind->calls.size(), 4);
+
+    mLogind->releaseDelayed();
+    QTRY_VERIFY(provider.canAction(Power::PowerReboot));
+    for (int i = 0; i < 10000; ++i)
+        provider.canAction(Power::PowerShutdown);
+    QCOMPARE(mLogind->calls.size(), 4);
+}
+
+// 错误回复算不可用，错误文本不能被当成 true
+void TestPowerProviders::errorIsUnavailable()
+{
+    mLogind->answers.remove(QStringLiteral("CanReboot"));
+    SystemdProvider provider;
+    QSignalSpy changed(&provider, &PowerProvider::capabilitiesChanged);
+    QTRY_COMPARE(changed.count(), 4);
+    QVERIFY(!provider.canAction(Power::PowerReboot));
+    QVERIFY(provider.canAction(Power::PowerShutdown));
+}
+
+// UPower 要属性和权限检查都通过
+void TestPowerProviders::upowerNeedsBoth()
+{
+    UPowerProvider provider;
+    QSignalSpy changed(&provider, &PowerProvider::capabilitiesChanged);
+    QTRY_COMPARE(changed.count(), 2);
+    QVERIFY(provider.canAction(Power::PowerSuspend));
+    QVERIFY(!provider.canAction(Power::PowerHibernate));
+    QCOMPARE(mUPower->count(QStringLiteral("CanSuspend")), 1);
+    QCOMPARE(mUPower->count(QStringLiteral("HibernateAllowed")), 1);
+
+    mUPower->answers.insert(QStringLiteral("SuspendAllowed"), false);
+    provider.refresh();
+    QTRY_VERIFY(!provider.canAction(Power::PowerSuspend));
+}
+
+// 服务重启后重新探测
+void TestPowerProviders::ownerChange()
+{
+    SystemdProvider provider;
+    QTRY_VERIFY(provider.canAction(Power::PowerReboot));
+    const int probes = mLogind->calls.size();
+
+    mLogind->answers.insert(QStringLiteral("CanReboot"), QStringLiteral("no"));
+    mLogind->answers.insert(QStringLiteral("CanSuspend"), QStringLiteral("yes"));
+    QVERIFY(mLogindBus.unregisterService(QStringLiteral(LOGIND_SERVICE)));
+    QVERIFY(mLogindBus.registerService(QStringLiteral(LOGIND_SERVICE)));
+
+    QTRY_VERIFY(provider.canAction(Power::PowerSuspend));
+    QVERIFY(!provider.canAction(Power::PowerReboot));
+    QVERIFY(mLogind->calls.size() > probes);
+}
+
+// 休眠回来后重新探测，进入休眠时不探测
+void TestPowerProviders::resume()
+{
+    SystemdProvider provider;
+    waitForProbes(mLogind, 4);
+    QTRY_VERIFY(provider.canAction(Power::PowerReboot));
+
+    QDBusMessage sleep = QDBusMessage::createSignal(QStringLiteral(LOGIND_PATH), QStringLiteral(LOGIND_INTERFACE),
+                                                    QStringLiteral("PrepareForSleep"));
+    QVERIFY(mLogindBus.send(QDBusMessage(sleep) << true));
+    QTest::qWait(200);
+    QCOMPARE(mLogind->calls.size(), 4);
+
+    mLogind->answers.insert(QStringLiteral("CanHibernate"), QStringLiteral("yes"));
+    QVERIFY(mLogindBus.send(QDBusMessage(sleep) << false));
+    waitForProbes(mLogind, 8);
+    QTRY_VERIFY(provider.canAction(Power::PowerHibernate));
+}
+
+// refresh() 之前发出的探测，回复晚到也不能覆盖新结果
+void TestPowerProviders::staleAnswersIgnored()
+{
+    mLogind->delayed = true;
+    SystemdProvider provider;
+    waitForProbes(mLogind, 4);
+
+    mLogind->answers.insert(QStringLiteral("CanReboot"), QStringLiteral("no"));
+    provider.refresh();
+    waitForProbes(mLogind, 8);
+
+    QList<bool> seen;
+    connect(&provider, &PowerProvider::capabilitiesChanged, this, [&provider, &seen] {
+        seen << provider.canAction(Power::PowerReboot);
+    });
+    mLogind->releaseDelayed();
+    QTRY_COMPARE(seen.size(), 4);
+    QVERIFY(!seen.contains(true));
+    QVERIFY(!provider.canAction(Power::PowerReboot));
+}
+
+QTEST_MAIN(TestPowerProviders)
+#include "tst_powerproviders.moc"
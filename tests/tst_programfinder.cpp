@@ -0,0 +1,296 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include "ukuiprogramfinder.h"
+
+using namespace UKUi;
+
+// 20 个 PATH 目录，每个 500 个可执行文件，和装满软件的系统差不多
+static const int PathDirs = 20;
+static const int ProgramsPerDir = 500;
+
+class TestProgramFinder : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void indexedPrograms();
+    void absoluteAndRelative();
+    void installAndRemove();
+    void becomesExecutable();
+    void hiddenProgram();
+    void laterCreatedDir();
+    void pathChanged();
+    void programName_data();
+    void programName();
+    void volatileNamesNotCached();
+    void lookup();
+    void rebuild();
+
+private:
+    QString dir(int i) const { return mRoot.path() + QStringLiteral("/bin%1").arg(i); }
+    void writeProgram(const QString &path, bool executable = true);
+    void setPath(const QStringList &dirs);
+
+    QTemporaryDir mRoot;
+    QByteArray mOldPath;
+    QString mOldCwd;
+    QStringList mDirs;
+};
+
+void TestProgramFinder::writeProgram(const QString &path, bool executable)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("#!/bin/sh\n");
+    file.close();
+    QFile::Permissions permissions = QFile::ReadOwner | QFile::WriteOwner;
+    if (executable)
+        permissions |= QFile::ExeOwner;
+    QVERIFY(file.setPermissions(permissions));
+}
+
+void TestProgramFinder::setPath(const QStringList &dirs)
+{
+    qputenv("PATH", QFile::encodeName(dirs.join(QLatin1Char(':'))));
+}
+
+void TestProgramFinder::initTestCase()
+{
+    QVERIFY(mRoot.isValid());
+    mOldPath = qgetenv("PATH");
+    mOldCwd = QDir::currentPath();
+    for (int i = 0; i < PathDirs; ++i)
+    {
+        QVERIFY(QDir().mkpath(dir(i)));
+        for (int j = 0; j < ProgramsPerDir; ++j)
+            writeProgram(dir(i) + QStringLiteral("/prog-%1-%2").arg(i).arg(j));
+        mDirs << dir(i);
+    }
+    // 不可执行的文件和子目录都不算
+    writeProgram(dir(0) + QStringLiteral("/readme"), false);
+    QVERIFY(QDir().mkpath(dir(0) + QStringLiteral("/subdir")));
+}
+
+void TestProgramFinder::cleanupTestCase()
+{
+    qputenv("PATH", mOldPath);
+    QDir::setCurrent(mOldCwd);
+}
+
+void TestProgramFinder::init()
+{
+    setPath(mDirs);
+}
+
+void TestProgramFinder::indexedPrograms()
+{
+    QVERIFY(ProgramFinder::programExists(QStringLiteral("prog-0-0")));
+    QVERIFY(ProgramFinder::programExists(QStringLiteral("prog-19-499 --with args")));
+    QVERIFY(ProgramFinder::programExists(QStringLiteral("'prog-7-42'")));
+    QVERIFY(!ProgramFinder::programExists(QStringLiteral("prog-20-0")));
+    QVERIFY(!ProgramFinder::programExists(QStringLiteral("readme")));
+    QVERIFY(!ProgramFinder::programExists(QStringLiteral("subdir")));
+    QVERIFY(!ProgramFinder::programExists(QString()));
+
+    const QStringList found = ProgramFinder::findPrograms(QStringList()
+            << QStringLiteral("prog-1-1 -x")
+            << QStringLiteral("nothing-here")
+            << QStringLiteral("prog-2-2"));
+    QCOMPARE(found, QStringList() << QStringLiteral("prog-1-1 -x") << QStringLiteral("prog-2-2"));
+}
+
+void TestProgramFinder::absoluteAndRelative()
+{
+    QVERIFY(ProgramFinder::programExists(dir(3) + QStringLiteral("/prog-3-3")));
+    QVERIFY(!ProgramFinder::programExists(dir(0) + QStringLiteral("/readme")));
+    // 带 / 的相对名字在每个 PATH 目录下找
+    QVERIFY(!ProgramFinder::programExists(QStringLiteral("subdir/tool")));
+    writeProgram(dir(0) + QStringLiteral("/subdir/tool"));
+    QVERIFY(ProgramFinder::programExists(QStringLiteral("subdir/tool")));
+
+    // 相对的 PATH 目录跟着当前目录走，每次都重新查
+    QVERIFY(QDir().mkpath(mRoot.path() + QStringLiteral("/cwd-a/rel")));
+    QVERIFY(QDir().mkpath(mRoot.path() + QStringLiteral("/cwd-b/rel")));
+    writeProgram(mRoot.path() + QStringLiteral("/cwd-a/rel/relative-tool"));
+    setPath(QStringList(mDirs) << QStringLiteral("rel"));
+    QVERIFY(QDir::setCurrent(mRoot.path() + QStringLiteral("/cwd-a")));
+    QVERIFY(ProgramFinder::programExists(QStringLiteral("relative-tool")));
+    QVERIFY(QDir::setCurrent(mRoot.path() + QStringLiteral("/cwd-b")));
+    QVERIFY(!ProgramFinder::programExists(QStringLiteral("relative-tool")));
+    QDir::setCurrent(mOldCwd);
+}
+
+void TestProgramFinder::installAndRemove()
+{
+    const QString path = dir(5) + QStringLiteral("/installed-later");
+    QVERIFY(!ProgramFinder::programExists(QStringLiteral("installed-later")));
+    writeProgram(path);
+    QVERIFY(ProgramFinder::programExists(QStringLiteral("installed-later")));
+
+    // 改名也要跟上
+    QVERIFY(QFile::rename(path, dir(6) + QStringLiteral("/renamed")));
+    QVERIFY(!ProgramFinder::programExists(QStringLiteral("installed-later")));
+    QVERIFY(ProgramFinder::programExists(QStringLiteral("renamed")));
+
+    QVERIFY(QFile::remove(dir(6) + QStringLiteral("/renamed")));
+    QVERIFY(!ProgramFinder::programExists(QStringLiteral("renamed")));
+}
+
+void TestProgramFinder::becomesExecutable()
+{
+    const QString path = dir(8) + QStringLiteral("/chmod-me");
+    writeProgram(path, false);
+    QVERIFY(!ProgramFinder::programExists(QStringLiteral("chmod-me")));
+    QVERIFY(QFile::setPermissions(path, QFile::ReadOwner | QFile::WriteOwner | QFile::ExeOwner));
+    QVERIFY(ProgramFinder::programExists(QStringLiteral("chmod-me")));
+    QVERIFY(QFile::remove(path));
+}
+
+void TestProgramFinder::hiddenProgram()
+{
+    writeProgram(dir(9) + QStringLiteral("/.hidden-tool"));
+    QVERIFY(ProgramFinder::programExists(QStringLiteral(".hidden-tool")));
+    QVERIFY(QFile::remove(dir(9) + QStringLiteral("/.hidden-tool")));
+    QVERIFY(!ProgramFinder::programExists(QStringLiteral(".hidden-tool")));
+}
+
+// 像 ~/.local/bin 一样，PATH 里的目录第一次装软件时才创建
+void TestProgramFinder::laterCreatedDir()
+{
+    const QString later = mRoot.path() + QStringLiteral("/home/.local/bin");
+    setPath(QStringList(mDirs) << later);
+    QVERIFY(!ProgramFinder::programExists(QStringLiteral("pip-tool")));
+
+    // 无关的兄弟目录不影响结果
+    QVERIFY(QDir().mkpath(mRoot.path() + QStringLiteral("/home/.cache")));
+    QVERIFY(!ProgramFinder::programExists(QStringLiteral("pip-tool")));
+
+    QVERIFY(QDir().mkpath(later));
+    writeProgram(later + QStringLiteral("/pip-tool"));
+    QVERIFY(ProgramFinder::programExists(QStringLiteral("pip-tool")));
+
+    // 目录删掉再建，之后装的程序照样能找到
+    QVERIFY(QDir(mRoot.path() + QStringLiteral("/home/.local")).removeRecursively());
+    QVERIFY(!ProgramFinder::programExists(QStringLiteral("pip-tool")));
+    QVERIFY(QDir().mkpath(later));
+    writeProgram(later + QStringLiteral("/pip-tool-2"));
+    QVERIFY(ProgramFinder::programExists(QStringLiteral("pip-tool-2")));
+    QVERIFY(QDir(mRoot.path() + QStringLiteral("/home")).removeRecursively());
+}
+
+void TestProgramFinder::pathChanged()
+{
+    setPath(mDirs.mid(0, 10));
+    QVERIFY(ProgramFinder::programExists(QStringLiteral("prog-9-0")));
+    QVERIFY(!ProgramFinder::programExists(QStringLiteral("prog-10-0")));
+    setPath(mDirs.mid(10));
+    QVERIFY(!ProgramFinder::programExists(QStringLiteral("prog-9-0")));
+    QVERIFY(ProgramFinder::programExists(QStringLiteral("prog-10-0")));
+}
+
+void TestProgramFinder::programName_data()
+{
+    QTest::addColumn<QString>("command");
+    QTest::addColumn<QString>("name");
+
+    QTest::newRow("plain") << "ukui-control-center" << "ukui-control-center";
+    QTest::newRow("arguments") << "ukui-control-center -m Power" << "ukui-control-center";
+    QTest::newRow("quoted") << "'/opt/my app/run' --x" << "/opt/my app/run";
+    QTest::newRow("escaped") << "my\\ app -v" << "my app";
+    QTest::newRow("empty") << "" << "";
+    QTest::newRow("command substitution") << "$(rm -rf /)" << "";
+}
+
+void TestProgramFinder::programName()
+{
+    QFETCH(QString, command);
+    QFETCH(QString, name);
+    // 第二次走缓存，结果要一样
+    QCOMPARE(ProgramFinder::programName(command), name);
+    QCOMPARE(ProgramFinder::programName(command), name);
+}
+
+// $VAR、~ 和通配符的展开结果会变，不能缓存
+void TestProgramFinder::volatileNamesNotCached()
+{
+    qputenv("TST_TOOL_DIR", "/opt/a");
+    QCOMPARE(ProgramFinder::programName(QStringLiteral("$TST_TOOL_DIR/run")), QStringLiteral("/opt/a/run"));
+    qputenv("TST_TOOL_DIR", "/opt/b");
+    QCOMPARE(ProgramFinder::programName(QStringLiteral("$TST_TOOL_DIR/run")), QStringLiteral("/opt/b/run"));
+
+    const QByteArray oldHome = qgetenv("HOME");
+    qputenv("HOME", "/home/first");
+    QCOMPARE(ProgramFinder::programName(QStringLiteral("~/bin/run")), QStringLiteral("/home/first/bin/run"));
+    qputenv("HOME", "/home/second");
+    QCOMPARE(ProgramFinder::programName(QStringLiteral("~/bin/run")), QStringLiteral("/home/second/bin/run"));
+    qputenv("HOME", oldHome);
+
+    const QString pattern = mRoot.path() + QStringLiteral("/glob-*/run");
+    QVERIFY(QDir().mkpath(mRoot.path() + QStringLiteral("/glob-b")));
+    writeProgram(mRoot.path() + QStringLiteral("/glob-b/run"));
+    QCOMPARE(ProgramFinder::programName(pattern), mRoot.path() + QStringLiteral("/glob-b/run"));
+    QVERIFY(QDir().mkpath(mRoot.path() + QStringLiteral("/glob-a")));
+    writeProgram(mRoot.path() + QStringLiteral("/glob-a/run"));
+    QCOMPARE(ProgramFinder::programName(pattern), mRoot.path() + QStringLiteral("/glob-a/run"));
+    QVERIFY(ProgramFinder::programExists(pattern));
+    QVERIFY(QFile::remove(mRoot.path() + QStringLiteral("/glob-a/run")));
+    QCOMPARE(ProgramFinder::programName(pattern), mRoot.path() + QStringLiteral("/glob-b/run"));
+}
+
+// 索引建好以后的查询：命中、未命中各一半，外加带参数的命令
+void TestProgramFinder::lookup()
+{
+    QStringList commands;
+    for (int i = 0; i < 100; ++i)
+    {
+        commands << QStringLiteral("prog-%1-%2 --arg").arg(i % PathDirs).arg(i * 7 % ProgramsPerDir);
+        commands << QStringLiteral("missing-%1").arg(i);
+    }
+    QVERIFY(ProgramFinder::programExists(commands.first()));
+
+    int found = 0;
+    QBENCHMARK {
+        found = ProgramFinder::findPrograms(commands).size();
+    }
+    QCOMPARE(found, 100);
+}
+
+// PATH 每变一次就要重建：列 20 个目录、1 万个文件
+void TestProgramFinder::rebuild()
+{
+    // 末尾多一个空项，目录不变但 PATH 的值变了
+    const QByteArray path = QFile::encodeName(mDirs.join(QLatin1Char(':')));
+    bool toggle = false;
+    QBENCHMARK {
+        qputenv("PATH", toggle ? path + ':' : path);
+        toggle = !toggle;
+        QVERIFY(ProgramFinder::programExists(QStringLiteral("prog-19-499")));
+    }
+}
+
+QTEST_GUILESS_MAIN(TestProgramFinder)
+#include "tst_programfinder.moc"
@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include <QtTest>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTemporaryDir>
+#include "securitypolicy.h"
+
+class TestSecurityPolicy : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void prefixRules();
+    void reloadOnChange();
+    void keepPolicyOnParseError();
+    void removedConfig();
+    void manyRules();
+
+private:
+    void writeConfig(const QByteArray &json);
+    static QByteArray config(const QString &mode, const QStringList &paths);
+
+    QTemporaryDir mHome;
+};
+
+// SecurityPolicy 只在第一次 instance() 时读 HOME
+void TestSecurityPolicy::initTestCase()
+{
+    QVERIFY(mHome.isValid());
+    qputenv("HOME", QFile::encodeName(mHome.path()));
+    QVERIFY(QDir(mHome.path()).mkpath(QStringLiteral(".config")));
+    writeConfig(config(QStringLiteral("blacklist"), QStringList()
+                       << QStringLiteral("/usr/share/applications/a.desktop")
+                       << QStringLiteral("/opt/bad/")
+                       << QStringLiteral("/usr/local/share/applications/x-*")));
+    QCOMPARE(SecurityPolicy::instance()->configPath(),
+             mHome.path() + QStringLiteral("/.config/ukui-panel-security-config.json"));
+}
+
+void TestSecurityPolicy::prefixRules()
+{
+    QSharedPointer<const SecurityPolicySnapshot> snapshot = SecurityPolicy::instance()->snapshot();
+    QCOMPARE(snapshot->mode(), SecurityPolicySnapshot::ModeBlacklist);
+    QCOMPARE(snapshot->ruleCount(), 3);
+
+    QVERIFY(!snapshot->allows(QStringLiteral("/usr/share/applications/a.desktop")));
+    QVERIFY(snapshot->allows(QStringLiteral("/usr/share/applications/a.desktop.bak")));
+    QVERIFY(!snapshot->allows(QStringLiteral("/opt/bad/app.desktop")));
+    QVERIFY(snapshot->allows(QStringLiteral("/opt/badge/app.desktop")));
+    QVERIFY(!snapshot->allows(QStringLiteral("/usr/local/share/applications/x-term.desktop")));
+    QVERIFY(snapshot->allows(QStringLiteral("/usr/local/share/applications/y.desktop")));
+}
+
+void TestSecurityPolicy::reloadOnChange()
+{
+    SecurityPolicy *policy = SecurityPolicy::instance();
+    QSharedPointer<const SecurityPolicySnapshot> old = policy->snapshot();
+    QSignalSpy changed(policy, &SecurityPolicy::policyChanged);
+
+    writeConfig(config(QStringLiteral("whitelist"), QStringList() << QStringLiteral("/usr/share/applications/")));
+    QVERIFY(changed.wait(2000));
+    QCOMPARE(policy->snapshot()->mode(), SecurityPolicySnapshot::ModeWhitelist);
+    QVERIFY(policy->allows(QStringLiteral("/usr/share/applications/a.desktop")));
+    QVERIFY(!policy->allows(QStringLiteral("/opt/bad/app.desktop")));
+
+    // 旧快照不受影响
+    QCOMPARE(old->mode(), SecurityPolicySnapshot::ModeBlacklist);
+    QVERIFY(!old->allows(QStringLiteral("/opt/bad/app.desktop")));
+}
+
+void TestSecurityPolicy::keepPolicyOnParseError()
+{
+    SecurityPolicy *policy = SecurityPolicy::instance();
+    QSharedPointer<const SecurityPolicySnapshot> before = policy->snapshot();
+    QSignalSpy changed(policy, &SecurityPolicy::policyChanged);
+
+    QTest::ignoreMessage(QtWarningMsg, QRegularExpression(QStringLiteral("^Invalid security config")));
+    writeConfig("{ \"ukui-panel\": { \"mode\": ");
+    QVERIFY(!changed.wait(1000));
+    QCOMPARE(policy->snapshot(), before);
+}
+
+void TestSecurityPolicy::removedConfig()
+{
+    SecurityPolicy *policy = SecurityPolicy::instance();
+    QSignalSpy changed(policy, &SecurityPolicy::policyChanged);
+
+    QVERIFY(QFile::remove(policy->configPath()));
+    QVERIFY(changed.wait(2000));
+    QCOMPARE(policy->snapshot()->mode(), SecurityPolicySnapshot::ModeNone);
+    QVERIFY(policy->allows(QStringLiteral("/opt/bad/app.desktop")));
+
+    // 之后重新创建的文件要通过目录监视发现
+    writeConfig(config(QStringLiteral("blacklist"), QStringList() << QStringLiteral("/opt/bad/")));
+    QVERIFY(changed.wait(2000));
+    QVERIFY(!policy->allows(QStringLiteral("/opt/bad/app.desktop")));
+}
+
+void TestSecurityPolicy::manyRules()
+{
+    QStringList paths;
+    for (int i = 0; i < 5000; ++i)
+        paths << QStringLiteral("/opt/app%1/").arg(i) << QStringLiteral("/usr/share/applications/app%1.desktop").arg(i);
+    writeConfig(config(QStringLiteral("blacklist"), paths));
+    QSignalSpy changed(SecurityPolicy::instance(), &SecurityPolicy::policyChanged);
+    QVERIFY(changed.wait(2000));
+
+    QSharedPointer<const SecurityPolicySnapshot> snapshot = SecurityPolicy::instance()->snapshot();
+    QCOMPARE(snapshot->ruleCount(), 10000);
+    QVERIFY(!snapshot->allows(QStringLiteral("/opt/app4999/bin.desktop")));
+    bool allowed = false;
+    QBENCHMARK {
+        allowed = snapshot->allows(QStringLiteral("/usr/share/applications/other.desktop"));
+    }
+    QVERIFY(allowed);
+}
+
+void TestSecurityPolicy::writeConfig(const QByteArray &json)
+{
+    QFile file(mHome.path() + QStringLiteral("/.config/ukui-panel-security-config.json"));
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    QCOMPARE(file.write(json), qint64(json.size()));
+}
+
+QByteArray TestSecurityPolicy::config(const QString &mode, const QStringList &paths)
+{
+    QJsonArray entries;
+    for (const QString &path : paths)
+        entries.append(QJsonObject{{QStringLiteral("path"), path}});
+    QJsonObject list{{QStringLiteral("entries"), entries}};
+    QJsonObject panel{{QStringLiteral("mode"), mode},
+                      {mode, QJsonArray{list}}};
+    return QJsonDocument(QJsonObject{{QStringLiteral("ukui-panel"), panel}}).toJson();
+}
+
+QTEST_GUILESS_MAIN(TestSecurityPolicy)
+#include "tst_securitypolicy.moc"
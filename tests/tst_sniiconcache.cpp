@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include <QtTest>
+#include <QIcon>
+#include <QImage>
+#include <QtEndian>
+#include "sniiconcache.h"
+
+class TestSniIconCache : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void bestPixmap_data();
+    void bestPixmap();
+    void decodeByteOrder();
+    void pixmapKey();
+    void cachedIcon();
+    void decodeBest_data();
+    void decodeBest();
+
+private:
+    static IconPixmap pixmap(int width, int height, quint32 argb = 0xff204080);
+    static IconPixmapList offered(const QList<int> &sizes);
+};
+
+// 按网络字节序填充的 ARGB32，和 DBus 上传的一样
+IconPixmap TestSniIconCache::pixmap(int width, int height, quint32 argb)
+{
+    IconPixmap result;
+    result.width = width;
+    result.height = height;
+    result.bytes.resize(width * height * 4);
+    uchar *data = reinterpret_cast<uchar *>(result.bytes.data());
+    for (int i = 0; i < width * height; ++i)
+        qToBigEndian<quint32>(argb, data + i * 4);
+    return result;
+}
+
+IconPixmapList TestSniIconCache::offered(const QList<int> &sizes)
+{
+    IconPixmapList pixmaps;
+    for (int size : sizes)
+        pixmaps << pixmap(size, size);
+    return pixmaps;
+}
+
+void TestSniIconCache::bestPixmap_data()
+{
+    QTest::addColumn<IconPixmapList>("pixmaps");
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("best");
+
+    const IconPixmapList sizes = offered(QList<int>() << 16 << 64 << 22 << 32 << 256);
+    QTest::newRow("exact") << sizes << 22 << 2;
+    QTest::newRow("next larger") << sizes << 24 << 3;
+    QTest::newRow("hidpi") << sizes << 48 << 1;
+    QTest::newRow("all smaller") << offered(QList<int>() << 16 << 22) << 48 << 1;
+    QTest::newRow("empty") << IconPixmapList() << 24 << -1;
+
+    IconPixmapList truncated = offered(QList<int>() << 16 << 32);
+    truncated[1].bytes.chop(1);
+    QTest::newRow("truncated data") << truncated << 24 << 0;
+
+    IconPixmapList zero = offered(QList<int>() << 32);
+    zero.prepend(pixmap(0, 24));
+    zero[0].bytes.resize(64);
+    QTest::newRow("zero width") << zero << 24 << 1;
+}
+
+void TestSniIconCache::bestPixmap()
+{
+    QFETCH(IconPixmapList, pixmaps);
+    QFETCH(int, size);
+    QFETCH(int, best);
+    QCOMPARE(SniIconCache::bestPixmap(pixmaps, size), best);
+}
+
+void TestSniIconCache::decodeByteOrder()
+{
+    IconPixmap source = pixmap(2, 2, 0xff112233);
+    qToBigEndian<quint32>(0xffaabbcc, reinterpret_cast<uchar *>(source.bytes.data()) + 4);
+
+    const QIcon icon = SniIconCache::instance()->fromPixmap(SniIconCache::pixmapKey(source), source);
+    const QImage image = icon.pixmap(2, 2).toImage().convertToFormat(QImage::Format_ARGB32);
+    QCOMPARE(image.size(), QSize(2, 2));
+    QCOMPARE(image.pixel(0, 0), QRgb(0xff112233));
+    QCOMPARE(image.pixel(1, 0), QRgb(0xffaabbcc));
+    QCOMPARE(image.pixel(1, 1), QRgb(0xff112233));
+}
+
+void TestSniIconCache::pixmapKey()
+{
+    const IconPixmap a = pixmap(16, 16);
+    QCOMPARE(SniIconCache::pixmapKey(a), SniIconCache::pixmapKey(pixmap(16, 16)));
+    QVERIFY(SniIconCache::pixmapKey(a) != SniIconCache::pixmapKey(pixmap(16, 16, 0xff000000)));
+
+    // 同样的数据换个宽高是不同的图标
+    IconPixmap b = a;
+    b.width = 8;
+    b.height = 32;
+    QVERIFY(SniIconCache::pixmapKey(a) != SniIconCache::pixmapKey(b));
+}
+
+void TestSniIconCache::cachedIcon()
+{
+    const IconPixmap source = pixmap(24, 24);
+    const QByteArray key = SniIconCache::pixmapKey(source);
+    const QIcon first = SniIconCache::instance()->fromPixmap(key, source);
+    const QIcon second = SniIconCache::instance()->fromPixmap(key, pixmap(24, 24, 0xff000000));
+    QCOMPARE(second.cacheKey(), first.cacheKey());
+}
+
+void TestSniIconCache::decodeBest_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::newRow("16") << 16;
+    QTest::newRow("32") << 32;
+    QTest::newRow("64") << 64;
+}
+
+// 一个提供 16..256 五种尺寸的项目，每次换图标的开销：选尺寸、算键、解码
+void TestSniIconCache::decodeBest()
+{
+    QFETCH(int, size);
+    const IconPixmapList pixmaps = offered(QList<int>() << 16 << 32 << 64 << 128 << 256);
+    SniIconCache *cache = SniIconCache::instance();
+    int serial = 0;
+    QBENCHMARK {
+        const int best = SniIconCache::bestPixmap(pixmaps, size);
+        const QByteArray key = SniIconCache::pixmapKey(pixmaps.at(best)) + QByteArray::number(++serial);
+        cache->fromPixmap(key, pixmaps.at(best));
+    }
+}
+
+QTEST_MAIN(TestSniIconCache)
+#include "tst_sniiconcache.moc"
@@ -0,0 +1,207 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include <QtTest>
+#include <QDBusConnection>
+#include <QDBusConnectionInterface>
+#include <QDBusMessage>
+#include "statusnotifierwatcher.h"
+
+#define WATCHER_SERVICE     "org.kde.StatusNotifierWatcher"
+#define WATCHER_PATH        "/StatusNotifierWatcher"
+
+// 每个客户端一条独立的总线连接，断开连接就是应用退出
+class Client
+{
+public:
+    explicit Client(const QString &name)
+        : mName(name),
+          mConnection(QDBusConnection::connectToBus(QDBusConnection::SessionBus, name))
+    {
+    }
+    ~Client() { disconnect(); }
+
+    bool isConnected() const { return mConnection.isConnected(); }
+    QString uniqueName() const { return mConnection.baseService(); }
+    bool own(const QString &service) { return mConnection.registerService(service); }
+    bool release(const QString &service) { return mConnection.unregisterService(service); }
+    void disconnect() { QDBusConnection::disconnectFromBus(mName); }
+
+    void registerItem(const QString &serviceOrPath)
+    {
+        QDBusMessage call = QDBusMessage::createMethodCall(QStringLiteral(WATCHER_SERVICE), QStringLiteral(WATCHER_PATH),
+                                                          QStringLiteral(WATCHER_SERVICE),
+                                                          QStringLiteral("RegisterStatusNotifierItem"));
+        call << serviceOrPath;
+        mConnection.send(call);
+    }
+
+private:
+    QString mName;
+    QDBusConnection mConnection;
+};
+
+class TestStatusNotifierWatcher : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+    void batchedRegistrations();
+    void pathOnlyRegistration();
+    void registerOtherService();
+    void serviceWithoutOwner();
+    void serviceGoneWhileChecked();
+    void clientExit();
+    void duplicateRegistration();
+
+private:
+    int batchedCount() const;
+
+    StatusNotifierWatcher *mWatcher;
+    QSignalSpy *mRegistered;
+    QSignalSpy *mBatches;
+    QSignalSpy *mUnregistered;
+};
+
+void TestStatusNotifierWatcher::init()
+{
+    mWatcher = new StatusNotifierWatcher;
+    mRegistered = new QSignalSpy(mWatcher, &StatusNotifierWatcher::StatusNotifierItemRegistered);
+    mBatches = new QSignalSpy(mWatcher, &StatusNotifierWatcher::StatusNotifierItemsRegistered);
+    mUnregistered = new QSignalSpy(mWatcher, &StatusNotifierWatcher::StatusNotifierItemUnregistered);
+    QTRY_VERIFY(QDBusConnection::sessionBus().interface()->isServiceRegistered(QStringLiteral(WATCHER_SERVICE)));
+}
+
+void TestStatusNotifierWatcher::cleanup()
+{
+    delete mRegistered;
+    delete mBatches;
+    delete mUnregistered;
+    delete mWatcher;
+}
+
+int TestStatusNotifierWatcher::batchedCount() const
+{
+    int count = 0;
+    for (const QList<QVariant> &batch : *mBatches)
+        count += batch.at(0).toStringList().size();
+    return count;
+}
+
+void TestStatusNotifierWatcher::batchedRegistrations()
+{
+    const int clients = 50;
+    QList<QSharedPointer<Client> > items;
+    for (int i = 0; i < clients; ++i)
+    {
+        items << QSharedPointer<Client>::create(QStringLiteral("batch%1").arg(i));
+        QVERIFY(items.last()->isConnected());
+    }
+    for (const auto &client : items)
+        client->registerItem(client->uniqueName());
+
+    QTRY_COMPARE(mRegistered->count(), clients);
+    QTRY_COMPARE(batchedCount(), clients);
+    QCOMPARE(mWatcher->RegisteredStatusNotifierItems().size(), clients);
+    QVERIFY(mWatcher->RegisteredStatusNotifierItems().contains(items.first()->uniqueName() + "/StatusNotifierItem"));
+
+    items.clear();
+    QTRY_COMPARE(mUnregistered->count(), clients);
+    QVERIFY(mWatcher->RegisteredStatusNotifierItems().isEmpty());
+}
+
+// sni-qt 只传路径，服务取调用者
+void TestStatusNotifierWatcher::pathOnlyRegistration()
+{
+    Client client(QStringLiteral("sniqt"));
+    client.registerItem(QStringLiteral("/org/ayatana/NotificationItem/app"));
+    QTRY_COMPARE(mRegistered->count(), 1);
+    QCOMPARE(mRegistered->at(0).at(0).toString(), client.uniqueName() + "/org/ayatana/NotificationItem/app");
+}
+
+void TestStatusNotifierWatcher::registerOtherService()
+{
+    Client owner(QStringLiteral("owner"));
+    Client caller(QStringLiteral("caller"));
+    QVERIFY(owner.own(QStringLiteral("org.ukui.test.Item")));
+
+    caller.registerItem(QStringLiteral("org.ukui.test.Item"));
+    QTRY_COMPARE(mRegistered->count(), 1);
+    QCOMPARE(mRegistered->at(0).at(0).toString(), QStringLiteral("org.ukui.test.Item/StatusNotifierItem"));
+
+    QVERIFY(owner.release(QStringLiteral("org.ukui.test.Item")));
+    QTRY_COMPARE(mUnregistered->count(), 1);
+}
+
+void TestStatusNotifierWatcher::serviceWithoutOwner()
+{
+    Client caller(QStringLiteral("caller"));
+    caller.registerItem(QStringLiteral("org.ukui.test.Nobody"));
+    QTest::qWait(300);
+    QCOMPARE(mRegistered->count(), 0);
+    QVERIFY(mWatcher->RegisteredStatusNotifierItems().isEmpty());
+}
+
+// 名字在异步确认期间消失，不能留下一个没人提供的图标
+void TestStatusNotifierWatcher::serviceGoneWhileChecked()
+{
+    Client owner(QStringLiteral("owner"));
+    Client caller(QStringLiteral("caller"));
+    for (int i = 0; i < 20; ++i)
+    {
+        const QString service = QStringLiteral("org.ukui.test.Gone%1").arg(i);
+        QVERIFY(owner.own(service));
+        caller.registerItem(service);
+        QVERIFY(owner.release(service));
+    }
+    QTest::qWait(500);
+    QCOMPARE(mRegistered->count(), mUnregistered->count());
+    QVERIFY(mWatcher->RegisteredStatusNotifierItems().isEmpty());
+}
+
+void TestStatusNotifierWatcher::clientExit()
+{
+    Client client(QStringLiteral("exiting"));
+    client.registerItem(client.uniqueName());
+    QTRY_COMPARE(mRegistered->count(), 1);
+
+    client.disconnect();
+    QTRY_COMPARE(mUnregistered->count(), 1);
+    QCOMPARE(mUnregistered->at(0).at(0).toString(), mRegistered->at(0).at(0).toString());
+    QVERIFY(mWatcher->RegisteredStatusNotifierItems().isEmpty());
+}
+
+void TestStatusNotifierWatcher::duplicateRegistration()
+{
+    Client client(QStringLiteral("twice"));
+    client.registerItem(client.uniqueName());
+    client.registerItem(client.uniqueName());
+    QTRY_COMPARE(mRegistered->count(), 1);
+    QTest::qWait(200);
+    QCOMPARE(mRegistered->count(), 1);
+
+    client.registerItem(client.uniqueName());
+    QTest::qWait(200);
+    QCOMPARE(mRegistered->count(), 1);
+}
+
+QTEST_GUILESS_MAIN(TestStatusNotifierWatcher)
+#include "tst_statusnotifierwatcher.moc"
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+
+#include <QtTest>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QTimer>
+#include <QWidget>
+#include "wakeupauditor.h"
+
+#define PRESENCE_SERVICE    "org.gnome.SessionManager"
+#define PRESENCE_PATH       "/org/gnome/SessionManager/Presence"
+#define PRESENCE_INTERFACE  "org.gnome.SessionManager.Presence"
+#define PRESENCE_AVAILABLE  0
+#define PRESENCE_IDLE       3
+
+class TestWakeupAuditor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void disabledByDefault();
+    void activeWakeups();
+    void idleWakeups();
+    void reset();
+    void disable();
+
+private:
+    void setPresence(uint status);
+    // 在可见和隐藏的控件下各跑一个 10 ms 的定时器
+    void runTimers(int msecs);
+
+    QDBusConnection mSession = QDBusConnection(QString());
+};
+
+void TestWakeupAuditor::setPresence(uint status)
+{
+    QDBusMessage signal = QDBusMessage::createSignal(QStringLiteral(PRESENCE_PATH), QStringLiteral(PRESENCE_INTERFACE),
+                                                     QStringLiteral("StatusChanged"));
+    signal << status;
+    QVERIFY(mSession.send(signal));
+}
+
+void TestWakeupAuditor::runTimers(int msecs)
+{
+    QWidget visible;
+    visible.show();
+    QVERIFY(QTest::qWaitForWindowExposed(&visible));
+    QWidget hidden;
+
+    QTimer blink(&visible);
+    blink.setObjectName(QStringLiteral("blink"));
+    blink.start(10);
+    QTimer poll(&hidden);
+    poll.setObjectName(QStringLiteral("poll"));
+    poll.start(10);
+    QTest::qWait(msecs);
+}
+
+void TestWakeupAuditor::initTestCase()
+{
+    mSession = QDBusConnection::connectToBus(QDBusConnection::SessionBus, QStringLiteral("session-manager"));
+    QVERIFY(mSession.registerService(QStringLiteral(PRESENCE_SERVICE)));
+}
+
+void TestWakeupAuditor::init()
+{
+    WakeupAuditor *auditor = WakeupAuditor::instance();
+    if (auditor->isIdle())
+    {
+        setPresence(PRESENCE_AVAILABLE);
+        QTRY_VERIFY(!auditor->isIdle());
+    }
+    auditor->reset();
+}
+
+// 没打开时不装事件过滤器，什么都不记
+void TestWakeupAuditor::disabledByDefault()
+{
+    WakeupAuditor *auditor = WakeupAuditor::instance();
+    QVERIFY(!auditor->isEnabled());
+    runTimers(200);
+    const QStringList lines = auditor->report().split(QLatin1Char('\n'), QString::SkipEmptyParts);
+    QCOMPARE(lines.size(), 1);
+    QVERIFY(lines.first().startsWith(QLatin1String("auditing off, 0 idle wakeups")));
+}
+
+// 非空闲时只记总数，按父对象、类名、名字和间隔分组，隐藏控件下的单独计数
+void TestWakeupAuditor::activeWakeups()
+{
+    WakeupAuditor *auditor = WakeupAuditor::instance();
+    auditor->setEnabled(true);
+    runTimers(300);
+
+    const QString report = auditor->report();
+    QVERIFY2(report.startsWith(QLatin1String("auditing on, 0 idle wakeups")), qPrintable(report));
+    QRegularExpressionMatch blink = QRegularExpression(QStringLiteral("QWidget/QTimer\\(blink\\) 10ms: 0 idle \\(0.00/s\\), (\\d+) total, 0 while hidden")).match(report);
+    QVERIFY2(blink.hasMatch(), qPrintable(report));
+    QVERIFY(blink.captured(1).toInt() > 5);
+    QRegularExpressionMatch poll = QRegularExpression(QStringLiteral("QWidget/QTimer\\(poll\\) 10ms: 0 idle \\(0.00/s\\), (\\d+) total, (\\d+) while hidden")).match(report);
+    QVERIFY2(poll.hasMatch(), qPrintable(report));
+    QCOMPARE(poll.captured(2), poll.captured(1));
+    QCOMPARE(auditor->idleRate(), 0.0);
+}
+
+// 会话空闲时 10 ms 的定时器远远超出每秒 2 次的预算
+void TestWakeupAuditor::idleWakeups()
+{
+    WakeupAuditor *auditor = WakeupAuditor::instance();
+    setPresence(PRESENCE_IDLE);
+    QTRY_VERIFY(auditor->isIdle());
+    runTimers(500);
+
+    const QString report = auditor->report();
+    QVERIFY2(report.contains(QLatin1String("idle now: yes")), qPrintable(report));
+    QVERIFY2(auditor->idleRate() > 2.0, qPrintable(report));
+    // 两个定时器都按空闲唤醒排在最前
+    const QStringList lines = report.split(QLatin1Char('\n'), QString::SkipEmptyParts);
+    QVERIFY(lines.size() >= 3);
+    QVERIFY2(lines.at(1).contains(QLatin1String("10ms: ")) && !lines.at(1).contains(QLatin1String(": 0 idle")),
+             qPrintable(report));
+
+    setPresence(PRESENCE_AVAILABLE);
+    QTRY_VERIFY(!auditor->isIdle());
+    const double rate = auditor->idleRate();
+    runTimers(200);
+    QVERIFY(auditor->idleRate() <= rate);
+}
+
+void TestWakeupAuditor::reset()
+{
+    WakeupAuditor *auditor = WakeupAuditor::instance();
+    runTimers(100);
+    auditor->reset();
+    const QStringList lines = auditor->report().split(QLatin1Char('\n'), QString::SkipEmptyParts);
+    QCOMPARE(lines.size(), 1);
+    QCOMPARE(auditor->idleRate(), 0.0);
+}
+
+void TestWakeupAuditor::disable()
+{
+    WakeupAuditor *auditor = WakeupAuditor::instance();
+    auditor->setEnabled(false);
+    runTimers(200);
+    QCOMPARE(auditor->report().split(QLatin1Char('\n'), QString::SkipEmptyParts).size(), 1);
+}
+
+QTEST_MAIN(TestWakeupAuditor)
+#include "tst_wakeupauditor.moc"
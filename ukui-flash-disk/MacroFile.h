@@ -30,6 +30,7 @@ typedef enum {downPosition = 0,upPosition,leftPosition,rightPosition}Suit;
 #define DATADEVICE 1
 #define OCCUPYDEVICE 2
 #define GPARTEDINTERFACE 3
+#define EJECTFAILED 4
 #define DISTANCEPADDING 6
 #define DISTANCEMEND 2
 
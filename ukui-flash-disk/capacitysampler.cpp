@@ -0,0 +1,214 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+#include "capacitysampler.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QRunnable>
+#include <QStringList>
+#include <QTimer>
+
+#include <sys/statvfs.h>
+
+#define CAPACITY_TTL            2000
+#define CAPACITY_TIMEOUT        3000
+#define CAPACITY_MAX_THREADS    4
+
+namespace
+{
+    class SampleJob : public QRunnable
+    {
+    public:
+        SampleJob(CapacitySampler *sampler, const QString &path, quint64 serial)
+            : mSampler(sampler), mPath(path), mSerial(serial)
+        {
+        }
+
+        void run() override
+        {
+            struct statvfs buf;
+            const bool ok = statvfs(QFile::encodeName(mPath).constData(), &buf) == 0;
+            const quint64 blockSize = ok ? buf.f_frsize : 0;
+            QMetaObject::invokeMethod(mSampler, "finished", Qt::QueuedConnection,
+                                      Q_ARG(QString, mPath), Q_ARG(quint64, mSerial), Q_ARG(bool, ok),
+                                      Q_ARG(quint64, ok ? quint64(buf.f_blocks) * blockSize : 0),
+                                      Q_ARG(quint64, ok ? quint64(buf.f_bfree) * blockSize : 0),
+                                      Q_ARG(quint64, ok ? quint64(buf.f_bavail) * blockSize : 0));
+        }
+
+    private:
+        CapacitySampler *mSampler;
+        QString mPath;
+        quint64 mSerial;
+    };
+}
+
+CapacitySampler *CapacitySampler::instance()
+{
+    static CapacitySampler *sampler = new CapacitySampler;
+    return sampler;
+}
+
+CapacitySampler::CapacitySampler(QObject *parent)
+    : QObject(parent),
+      mRefreshTimer(new QTimer(this)),
+      mSerial(0),
+      mSamples(0),
+      mCacheHits(0),
+      mTimeouts(0)
+{
+    mPool.setMaxThreadCount(CAPACITY_MAX_THREADS);
+    mRefreshTimer->setInterval(CAPACITY_TTL);
+    connect(mRefreshTimer, &QTimer::timeout, this, &CapacitySampler::refresh);
+}
+
+void CapacitySampler::request(const QString &path)
+{
+    if (path.isEmpty())
+        return;
+
+    Entry &entry = mEntries[path];
+    //同一路径重新挂载后又被请求
+    entry.forgotten = false;
+    //还在采样（包括已经超时、卡住的）就不再排队
+    if (entry.running)
+        return;
+    if (entry.usage.valid && QDateTime::currentMSecsSinceEpoch() - entry.sampledAt < CAPACITY_TTL)
+    {
+        mCacheHits++;
+        return;
+    }
+
+    entry.running = true;
+    entry.serial = ++mSerial;
+    mSamples++;
+    mPool.start(new SampleJob(this, path, entry.serial));
+
+    const quint64 serial = entry.serial;
+    QTimer::singleShot(CAPACITY_TIMEOUT, this, [this, path, serial]() {
+        expire(path, serial);
+    });
+}
+
+void CapacitySampler::subscribe(const QString &path)
+{
+    if (path.isEmpty())
+        return;
+
+    mEntries[path].subscribers++;
+    request(path);
+    if (!mRefreshTimer->isActive())
+        mRefreshTimer->start();
+}
+
+void CapacitySampler::unsubscribe(const QString &path)
+{
+    auto it = mEntries.find(path);
+    if (it == mEntries.end() || it.value().subscribers == 0)
+        return;
+
+    it.value().subscribers--;
+    if (it.value().forgotten && it.value().subscribers == 0 && !it.value().running)
+        mEntries.erase(it);
+    for (const Entry &entry : qAsConst(mEntries))
+    {
+        if (entry.subscribers > 0)
+            return;
+    }
+    mRefreshTimer->stop();
+}
+
+void CapacitySampler::forget(const QString &path)
+{
+    auto it = mEntries.find(path);
+    if (it == mEntries.end())
+        return;
+    //正在采样或还有订阅的先标记，采样结束或退订时再删
+    if (it.value().running || it.value().subscribers > 0)
+    {
+        it.value().forgotten = true;
+        return;
+    }
+    mEntries.erase(it);
+}
+
+QString CapacitySampler::report() const
+{
+    int stalled = 0;
+    for (const Entry &entry : mEntries)
+    {
+        if (entry.stalled)
+            stalled++;
+    }
+    return QString("paths %1, samples %2, cache hits %3, timeouts %4, stalled %5")
+            .arg(mEntries.size()).arg(mSamples).arg(mCacheHits).arg(mTimeouts).arg(stalled);
+}
+
+void CapacitySampler::finished(const QString &path, quint64 serial, bool ok, quint64 total, quint64 free, quint64 available)
+{
+    auto it = mEntries.find(path);
+    if (it == mEntries.end() || it.value().serial != serial)
+        return;
+
+    Entry &entry = it.value();
+    entry.running = false;
+    entry.stalled = false;
+    //已经卸载的挂载点，结果不再有意义
+    if (entry.forgotten && entry.subscribers == 0)
+    {
+        mEntries.erase(it);
+        return;
+    }
+    if (!ok)
+    {
+        qWarning() << "statvfs failed for" << path;
+        return;
+    }
+
+    entry.usage.total = total;
+    entry.usage.free = free;
+    entry.usage.available = available;
+    entry.usage.valid = true;
+    entry.sampledAt = QDateTime::currentMSecsSinceEpoch();
+    Q_EMIT sampled(path, entry.usage);
+}
+
+void CapacitySampler::expire(const QString &path, quint64 serial)
+{
+    auto it = mEntries.find(path);
+    if (it == mEntries.end() || it.value().serial != serial || !it.value().running)
+        return;
+
+    it.value().stalled = true;
+    mTimeouts++;
+    qWarning() << "statvfs timed out for" << path;
+    Q_EMIT timedOut(path);
+}
+
+void CapacitySampler::refresh()
+{
+    QStringList paths;
+    for (auto it = mEntries.constBegin(); it != mEntries.constEnd(); ++it)
+    {
+        if (it.value().subscribers > 0)
+            paths << it.key();
+    }
+    for (const QString &path : qAsConst(paths))
+        request(path);
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+#ifndef CAPACITYSAMPLER_H
+#define CAPACITYSAMPLER_H
+
+#include <QObject>
+#include <QHash>
+#include <QString>
+#include <QThreadPool>
+
+class QTimer;
+
+/*
+ * 在后台线程里用 statvfs 采样挂载点的容量和已用空间。
+ * 结果缓存 CAPACITY_TTL 毫秒，期间重复请求直接用缓存；
+ * 单次采样超过 CAPACITY_TIMEOUT 毫秒算超时，卡住的挂载点（比如失去响应的
+ * NFS 或 U 盘）在原来的采样返回前不会再排队，所以不会占满线程池，界面也不会被卡住。
+ * 弹窗显示期间订阅的挂载点会按 TTL 定时刷新。
+ */
+class CapacitySampler : public QObject
+{
+    Q_OBJECT
+public:
+    struct Usage
+    {
+        Usage() : total(0), free(0), available(0), valid(false) {}
+
+        quint64 used() const { return total - free; }
+
+        quint64 total;
+        quint64 free;
+        quint64 available;          //普通用户可用的部分
+        bool valid;
+    };
+
+    static CapacitySampler *instance();
+
+    Usage usage(const QString &path) const { return mEntries.value(path).usage; }
+    //缓存过期或者还没有结果时在后台重新采样
+    void request(const QString &path);
+    void subscribe(const QString &path);
+    void unsubscribe(const QString &path);
+    //挂载点已经卸载；还在采样或有订阅的先标记，结束后再删
+    void forget(const QString &path);
+
+    QString report() const;
+
+Q_SIGNALS:
+    void sampled(const QString &path, const CapacitySampler::Usage &usage);
+    void timedOut(const QString &path);
+
+private Q_SLOTS:
+    void finished(const QString &path, quint64 serial, bool ok, quint64 total, quint64 free, quint64 available);
+
+private:
+    explicit CapacitySampler(QObject *parent = nullptr);
+
+    struct Entry
+    {
+        Entry() : sampledAt(0), serial(0), running(false), stalled(false), forgotten(false), subscribers(0) {}
+
+        Usage usage;
+        qint64 sampledAt;
+        quint64 serial;
+        bool running;
+        bool stalled;
+        bool forgotten;
+        int subscribers;
+    };
+
+    void expire(const QString &path, quint64 serial);
+    void refresh();
+
+    QHash<QString, Entry> mEntries;
+    QThreadPool mPool;
+    QTimer *mRefreshTimer;
+    quint64 mSerial;
+    quint64 mSamples;
+    quint64 mCacheHits;
+    quint64 mTimeouts;
+};
+
+#endif // CAPACITYSAMPLER_H
@@ -0,0 +1,520 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+#include "devicemodel.h"
+#include "UnionVariable.h"
+#include "capacitysampler.h"
+
+namespace
+{
+    QString takeString(char *str)
+    {
+        QString result = QString::fromUtf8(str);
+        g_free(str);
+        return result;
+    }
+}
+
+DeviceModel *DeviceModel::instance()
+{
+    static DeviceModel *model = new DeviceModel;
+    return model;
+}
+
+DeviceModel::DeviceModel(QObject *parent)
+    : QObject(parent),
+      mMonitor(g_volume_monitor_get()),
+      mRevision(0),
+      mCallbacks(0),
+      mSignals(0)
+{
+    //启动时完整遍历一次，之后只处理增量
+    GList *drives = g_volume_monitor_get_connected_drives(mMonitor);
+    for (GList *l = drives; l != nullptr; l = l->next)
+        insertDrive(G_DRIVE(l->data));
+    g_list_free_full(drives, g_object_unref);
+
+    GList *volumes = g_volume_monitor_get_volumes(mMonitor);
+    for (GList *l = volumes; l != nullptr; l = l->next)
+        insertVolume(G_VOLUME(l->data));
+    g_list_free_full(volumes, g_object_unref);
+
+    GList *mounts = g_volume_monitor_get_mounts(mMonitor);
+    for (GList *l = mounts; l != nullptr; l = l->next)
+        insertMount(G_MOUNT(l->data));
+    g_list_free_full(mounts, g_object_unref);
+    flush(false);
+
+    //容量在后台采样，只记下总容量给还没采样完的行兜底，不算内容变化
+    connect(CapacitySampler::instance(), &CapacitySampler::sampled, this,
+            [this](const QString &path, const CapacitySampler::Usage &usage) {
+        for (Drive &drive : mDrives)
+        {
+            for (Partition &partition : drive.partitions)
+            {
+                if (partition.mount != nullptr && partition.path == path)
+                    partition.capacity = usage.total;
+            }
+        }
+    });
+
+    g_signal_connect(mMonitor, "drive-connected", G_CALLBACK(driveConnectedCallback), this);
+    g_signal_connect(mMonitor, "drive-disconnected", G_CALLBACK(driveDisconnectedCallback), this);
+    g_signal_connect(mMonitor, "drive-changed", G_CALLBACK(driveChangedCallback), this);
+    g_signal_connect(mMonitor, "volume-added", G_CALLBACK(volumeAddedCallback), this);
+    g_signal_connect(mMonitor, "volume-removed", G_CALLBACK(volumeRemovedCallback), this);
+    g_signal_connect(mMonitor, "volume-changed", G_CALLBACK(volumeChangedCallback), this);
+    g_signal_connect(mMonitor, "mount-added", G_CALLBACK(mountAddedCallback), this);
+    g_signal_connect(mMonitor, "mount-removed", G_CALLBACK(mountRemovedCallback), this);
+    g_signal_connect(mMonitor, "mount-changed", G_CALLBACK(mountChangedCallback), this);
+}
+
+DeviceModel::~DeviceModel()
+{
+    g_signal_handlers_disconnect_by_data(mMonitor, this);
+    flush(false);
+    for (auto it = mMounts.constBegin(); it != mMounts.constEnd(); ++it)
+        g_object_unref(it.key());
+    for (auto it = mVolumes.constBegin(); it != mVolumes.constEnd(); ++it)
+        g_object_unref(it.key());
+    for (GDrive *drive : mOrder)
+        g_object_unref(drive);
+    g_object_unref(mMonitor);
+}
+
+const DeviceModel::Drive *DeviceModel::drive(GDrive *drive) const
+{
+    if (drive == nullptr)
+        return nullptr;
+    auto it = mDrives.constFind(drive);
+    return it == mDrives.constEnd() ? nullptr : &it.value();
+}
+
+const DeviceModel::Partition *DeviceModel::partition(GVolume *volume) const
+{
+    return const_cast<DeviceModel *>(this)->findPartition(volume);
+}
+
+int DeviceModel::volumeCount(GDrive *drive) const
+{
+    const Drive *entry = this->drive(drive);
+    return entry ? entry->partitions.size() : 0;
+}
+
+int DeviceModel::mountCount(GDrive *drive) const
+{
+    const Drive *entry = this->drive(drive);
+    if (entry == nullptr)
+        return 0;
+
+    int count = 0;
+    for (const Partition &partition : entry->partitions)
+    {
+        if (partition.mount != nullptr)
+            count++;
+    }
+    return count;
+}
+
+QString DeviceModel::report() const
+{
+    return QString("drives %1, volumes %2, mounts %3, callbacks %4, signals %5")
+            .arg(mOrder.size()).arg(mVolumes.size()).arg(mMounts.size())
+            .arg(mCallbacks).arg(mSignals);
+}
+
+void DeviceModel::insertDrive(GDrive *drive)
+{
+    if (drive == nullptr || mDrives.contains(drive))
+        return;
+
+    Drive entry;
+    entry.drive = G_DRIVE(g_object_ref(drive));
+    entry.name = takeString(g_drive_get_name(drive));
+    entry.device = takeString(g_drive_get_identifier(drive, G_DRIVE_IDENTIFIER_KIND_UNIX_DEVICE));
+    entry.revision = ++mRevision;
+    mDrives.insert(drive, entry);
+    mOrder.append(drive);
+    record(DriveConnected, drive);
+
+    //驱动器接入时 GIO 已经知道它有哪些分区，一并取出来
+    GList *volumes = g_drive_get_volumes(drive);
+    for (GList *l = volumes; l != nullptr; l = l->next)
+        insertVolume(G_VOLUME(l->data));
+    g_list_free_full(volumes, g_object_unref);
+}
+
+void DeviceModel::insertVolume(GVolume *volume)
+{
+    if (volume == nullptr || mVolumes.contains(volume))
+        return;
+
+    GDrive *drive = g_volume_get_drive(volume);
+    if (drive != nullptr)
+    {
+        insertDrive(drive);
+        //插入驱动器时可能已经顺带插入了这个分区
+        if (mVolumes.contains(volume))
+        {
+            g_object_unref(drive);
+            return;
+        }
+    }
+
+    Partition partition;
+    partition.volume = volume;
+    partition.name = takeString(g_volume_get_name(volume));
+    partition.device = takeString(g_volume_get_identifier(volume, G_VOLUME_IDENTIFIER_KIND_UNIX_DEVICE));
+    if (!partition.device.isEmpty())
+        handleVolumeLabelForFat32Me(partition.name, partition.device);
+
+    mVolumes.insert(G_VOLUME(g_object_ref(volume)), drive);
+    mDrives[drive].partitions.append(partition);
+    touch(drive);
+    record(VolumeAdded, drive, volume);
+
+    GMount *mount = g_volume_get_mount(volume);
+    if (mount != nullptr)
+    {
+        insertMount(mount);
+        g_object_unref(mount);
+    }
+    if (drive != nullptr)
+        g_object_unref(drive);
+}
+
+void DeviceModel::insertMount(GMount *mount)
+{
+    if (mount == nullptr || mMounts.contains(mount))
+        return;
+
+    GVolume *volume = g_mount_get_volume(mount);
+    if (volume != nullptr && !mVolumes.contains(volume))
+    {
+        insertVolume(volume);
+        if (mMounts.contains(mount))
+        {
+            g_object_unref(volume);
+            return;
+        }
+    }
+
+    MountEntry entry;
+    entry.volume = volume;
+    GFile *location = g_mount_get_default_location(mount);
+    entry.uri = takeString(g_file_get_uri(location));
+    g_object_unref(location);
+    GFile *root = g_mount_get_root(mount);
+    entry.path = takeString(g_file_get_path(root));
+    mMounts.insert(G_MOUNT(g_object_ref(mount)), entry);
+
+    GDrive *drive = mVolumes.value(volume);
+    if (Partition *partition = findPartition(volume))
+    {
+        partition->mount = mount;
+        partition->uri = entry.uri;
+        partition->path = entry.path;
+        partition->capacity = CapacitySampler::instance()->usage(entry.path).total;
+        touch(drive);
+    }
+    g_object_unref(root);
+    CapacitySampler::instance()->request(entry.path);
+    record(MountAdded, drive, volume, mount);
+
+    if (volume != nullptr)
+        g_object_unref(volume);
+}
+
+void DeviceModel::removeDrive(GDrive *drive)
+{
+    if (drive == nullptr || !mDrives.contains(drive))
+        return;
+
+    //先移除它下面的分区和挂载点
+    const QList<Partition> partitions = mDrives.value(drive).partitions;
+    for (const Partition &partition : partitions)
+        removeVolume(partition.volume);
+
+    mDrives.remove(drive);
+    mOrder.removeOne(drive);
+    record(DriveDisconnected, drive);
+    g_object_unref(drive);
+}
+
+void DeviceModel::removeVolume(GVolume *volume)
+{
+    if (volume == nullptr || !mVolumes.contains(volume))
+        return;
+
+    QList<GMount *> mounts;
+    for (auto it = mMounts.constBegin(); it != mMounts.constEnd(); ++it)
+    {
+        if (it.value().volume == volume)
+            mounts << it.key();
+    }
+    for (GMount *mount : mounts)
+        removeMount(mount);
+
+    GDrive *drive = mVolumes.take(volume);
+    auto it = mDrives.find(drive);
+    if (it != mDrives.end())
+    {
+        QList<Partition> &partitions = it.value().partitions;
+        for (int i = 0; i < partitions.size(); ++i)
+        {
+            if (partitions.at(i).volume == volume)
+            {
+                partitions.removeAt(i);
+                break;
+            }
+        }
+        touch(drive);
+    }
+    record(VolumeRemoved, drive, volume);
+    g_object_unref(volume);
+}
+
+void DeviceModel::removeMount(GMount *mount)
+{
+    auto it = mMounts.find(mount);
+    if (it == mMounts.end())
+        return;
+
+    GVolume *volume = it.value().volume;
+    CapacitySampler::instance()->forget(it.value().path);
+    mMounts.erase(it);
+
+    GDrive *drive = mVolumes.value(volume);
+    Partition *partition = findPartition(volume);
+    if (partition != nullptr && partition->mount == mount)
+    {
+        partition->mount = nullptr;
+        partition->uri.clear();
+        partition->path.clear();
+        partition->capacity = 0;
+        touch(drive);
+    }
+    record(MountRemoved, drive, volume, mount);
+    g_object_unref(mount);
+}
+
+void DeviceModel::refreshDrive(GDrive *drive)
+{
+    auto it = mDrives.find(drive);
+    if (drive == nullptr || it == mDrives.end())
+        return;
+
+    const QString name = takeString(g_drive_get_name(drive));
+    if (name == it.value().name)
+        return;
+    it.value().name = name;
+    touch(drive);
+    record(DriveChanged, drive);
+}
+
+void DeviceModel::refreshVolume(GVolume *volume)
+{
+    Partition *partition = findPartition(volume);
+    if (partition == nullptr)
+        return;
+
+    QString name = takeString(g_volume_get_name(volume));
+    if (!partition->device.isEmpty())
+        handleVolumeLabelForFat32Me(name, partition->device);
+    if (name == partition->name)
+        return;
+    partition->name = name;
+
+    GDrive *drive = mVolumes.value(volume);
+    touch(drive);
+    record(DriveChanged, drive);
+}
+
+void DeviceModel::refreshMount(GMount *mount)
+{
+    auto it = mMounts.find(mount);
+    if (it == mMounts.end())
+        return;
+
+    GFile *location = g_mount_get_default_location(mount);
+    const QString uri = takeString(g_file_get_uri(location));
+    g_object_unref(location);
+    if (uri == it.value().uri)
+        return;
+    it.value().uri = uri;
+
+    GVolume *volume = it.value().volume;
+    Partition *partition = findPartition(volume);
+    if (partition == nullptr || partition->mount != mount)
+        return;
+    partition->uri = uri;
+
+    GDrive *drive = mVolumes.value(volume);
+    touch(drive);
+    record(DriveChanged, drive);
+}
+
+DeviceModel::Partition *DeviceModel::findPartition(GVolume *volume)
+{
+    if (volume == nullptr || !mVolumes.contains(volume))
+        return nullptr;
+
+    auto it = mDrives.find(mVolumes.value(volume));
+    if (it == mDrives.end())
+        return nullptr;
+
+    for (Partition &partition : it.value().partitions)
+    {
+        if (partition.volume == volume)
+            return &partition;
+    }
+    return nullptr;
+}
+
+void DeviceModel::touch(GDrive *drive)
+{
+    auto it = mDrives.find(drive);
+    if (it != mDrives.end())
+        it.value().revision = ++mRevision;
+}
+
+void DeviceModel::record(EventType type, GDrive *drive, GVolume *volume, GMount *mount)
+{
+    Event event;
+    event.type = type;
+    event.drive = drive ? G_DRIVE(g_object_ref(drive)) : nullptr;
+    event.volume = volume ? G_VOLUME(g_object_ref(volume)) : nullptr;
+    event.mount = mount ? G_MOUNT(g_object_ref(mount)) : nullptr;
+    mEvents.append(event);
+}
+
+void DeviceModel::flush(bool notify)
+{
+    QList<Event> events;
+    events.swap(mEvents);
+
+    for (const Event &event : events)
+    {
+        if (notify)
+        {
+            switch (event.type)
+            {
+            case DriveConnected:
+                Q_EMIT driveConnected(event.drive);
+                break;
+            case DriveDisconnected:
+                Q_EMIT driveDisconnected(event.drive);
+                break;
+            case DriveChanged:
+                Q_EMIT driveChanged(event.drive);
+                break;
+            case VolumeAdded:
+                Q_EMIT volumeAdded(event.volume, event.drive);
+                break;
+            case VolumeRemoved:
+                Q_EMIT volumeRemoved(event.volume, event.drive);
+                break;
+            case MountAdded:
+                Q_EMIT mountAdded(event.mount, event.volume, event.drive);
+                break;
+            case MountRemoved:
+                Q_EMIT mountRemoved(event.mount, event.volume, event.drive);
+                break;
+            }
+            mSignals++;
+        }
+
+        if (event.mount != nullptr)
+            g_object_unref(event.mount);
+        if (event.volume != nullptr)
+            g_object_unref(event.volume);
+        if (event.drive != nullptr)
+            g_object_unref(event.drive);
+    }
+}
+
+void DeviceModel::driveConnectedCallback(GVolumeMonitor *monitor, GDrive *drive, DeviceModel *p_this)
+{
+    Q_UNUSED(monitor)
+    p_this->mCallbacks++;
+    p_this->insertDrive(drive);
+    p_this->flush();
+}
+
+void DeviceModel::driveDisconnectedCallback(GVolumeMonitor *monitor, GDrive *drive, DeviceModel *p_this)
+{
+    Q_UNUSED(monitor)
+    p_this->mCallbacks++;
+    p_this->removeDrive(drive);
+    p_this->flush();
+}
+
+void DeviceModel::driveChangedCallback(GVolumeMonitor *monitor, GDrive *drive, DeviceModel *p_this)
+{
+    Q_UNUSED(monitor)
+    p_this->mCallbacks++;
+    p_this->refreshDrive(drive);
+    p_this->flush();
+}
+
+void DeviceModel::volumeAddedCallback(GVolumeMonitor *monitor, GVolume *volume, DeviceModel *p_this)
+{
+    Q_UNUSED(monitor)
+    p_this->mCallbacks++;
+    p_this->insertVolume(volume);
+    p_this->flush();
+}
+
+void DeviceModel::volumeRemovedCallback(GVolumeMonitor *monitor, GVolume *volume, DeviceModel *p_this)
+{
+    Q_UNUSED(monitor)
+    p_this->mCallbacks++;
+    p_this->removeVolume(volume);
+    p_this->flush();
+}
+
+void DeviceModel::volumeChangedCallback(GVolumeMonitor *monitor, GVolume *volume, DeviceModel *p_this)
+{
+    Q_UNUSED(monitor)
+    p_this->mCallbacks++;
+    p_this->refreshVolume(volume);
+    p_this->flush();
+}
+
+void DeviceModel::mountAddedCallback(GVolumeMonitor *monitor, GMount *mount, DeviceModel *p_this)
+{
+    Q_UNUSED(monitor)
+    p_this->mCallbacks++;
+    p_this->insertMount(mount);
+    p_this->flush();
+}
+
+void DeviceModel::mountRemovedCallback(GVolumeMonitor *monitor, GMount *mount, DeviceModel *p_this)
+{
+    Q_UNUSED(monitor)
+    p_this->mCallbacks++;
+    p_this->removeMount(mount);
+    p_this->flush();
+}
+
+void DeviceModel::mountChangedCallback(GVolumeMonitor *monitor, GMount *mount, DeviceModel *p_this)
+{
+    Q_UNUSED(monitor)
+    p_this->mCallbacks++;
+    p_this->refreshMount(mount);
+    p_this->flush();
+}
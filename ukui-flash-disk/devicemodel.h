@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+#ifndef DEVICEMODEL_H
+#define DEVICEMODEL_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <gio/gio.h>
+
+/*
+ * 驱动器/分区/挂载点的增量模型。
+ * 只在启动时遍历一次 GVolumeMonitor，之后完全靠它的增删回调更新，
+ * 表里的每个 GDrive/GVolume/GMount 都持有一份引用，移除时释放。
+ * 对外的信号保证顺序：先父后子地添加，先子后父地移除，
+ * 信号发出时对象仍然有效，而且模型已经是更新后的状态。
+ */
+class DeviceModel : public QObject
+{
+    Q_OBJECT
+public:
+    struct Partition
+    {
+        Partition() : volume(nullptr), mount(nullptr), capacity(0) {}
+
+        GVolume *volume;
+        GMount *mount;              //未挂载时为 nullptr
+        QString name;
+        QString device;             //如 /dev/sdb1
+        QString uri;                //挂载点的默认位置，如 file:///media/xxx
+        QString path;               //挂载点的本地路径
+        qlonglong capacity;         //最近一次采样到的总容量，还没采样时为 0
+    };
+
+    struct Drive
+    {
+        Drive() : drive(nullptr), revision(0) {}
+
+        GDrive *drive;
+        QString name;
+        QString device;             //如 /dev/sdb
+        quint64 revision;           //全局递增，内容有变化就换一个新值
+        QList<Partition> partitions;
+    };
+
+    static DeviceModel *instance();
+    ~DeviceModel();
+
+    //按接入顺序排列的驱动器，不含没有驱动器的分区（手机等）
+    QList<GDrive *> drives() const { return mOrder; }
+    const Drive *drive(GDrive *drive) const;
+    const Partition *partition(GVolume *volume) const;
+
+    QList<GVolume *> volumes() const { return mVolumes.keys(); }
+    QList<GMount *> mounts() const { return mMounts.keys(); }
+
+    int volumeCount(GDrive *drive) const;
+    int mountCount(GDrive *drive) const;
+    GDrive *driveOf(GVolume *volume) const { return mVolumes.value(volume); }
+    GDrive *driveOf(GMount *mount) const { return driveOf(volumeOf(mount)); }
+    GVolume *volumeOf(GMount *mount) const { return mMounts.value(mount).volume; }
+    QString mountUri(GMount *mount) const { return mMounts.value(mount).uri; }
+
+    QString report() const;
+
+Q_SIGNALS:
+    void driveConnected(GDrive *drive);
+    void driveDisconnected(GDrive *drive);
+    void driveChanged(GDrive *drive);
+    void volumeAdded(GVolume *volume, GDrive *drive);
+    void volumeRemoved(GVolume *volume, GDrive *drive);
+    void mountAdded(GMount *mount, GVolume *volume, GDrive *drive);
+    void mountRemoved(GMount *mount, GVolume *volume, GDrive *drive);
+
+private:
+    explicit DeviceModel(QObject *parent = nullptr);
+
+    enum EventType
+    {
+        DriveConnected,
+        DriveDisconnected,
+        DriveChanged,
+        VolumeAdded,
+        VolumeRemoved,
+        MountAdded,
+        MountRemoved
+    };
+
+    //排队的事件各自持有对象的引用，发出信号后才释放
+    struct Event
+    {
+        EventType type;
+        GDrive *drive;
+        GVolume *volume;
+        GMount *mount;
+    };
+
+    struct MountEntry
+    {
+        MountEntry() : volume(nullptr) {}
+
+        GVolume *volume;
+        QString uri;
+        QString path;
+    };
+
+    void insertDrive(GDrive *drive);
+    void insertVolume(GVolume *volume);
+    void insertMount(GMount *mount);
+    void removeDrive(GDrive *drive);
+    void removeVolume(GVolume *volume);
+    void removeMount(GMount *mount);
+    void refreshDrive(GDrive *drive);
+    void refreshVolume(GVolume *volume);
+    void refreshMount(GMount *mount);
+
+    Partition *findPartition(GVolume *volume);
+    void touch(GDrive *drive);
+    void record(EventType type, GDrive *drive, GVolume *volume = nullptr, GMount *mount = nullptr);
+    void flush(bool notify = true);
+
+    static void driveConnectedCallback(GVolumeMonitor *monitor, GDrive *drive, DeviceModel *p_this);
+    static void driveDisconnectedCallback(GVolumeMonitor *monitor, GDrive *drive, DeviceModel *p_this);
+    static void driveChangedCallback(GVolumeMonitor *monitor, GDrive *drive, DeviceModel *p_this);
+    static void volumeAddedCallback(GVolumeMonitor *monitor, GVolume *volume, DeviceModel *p_this);
+    static void volumeRemovedCallback(GVolumeMonitor *monitor, GVolume *volume, DeviceModel *p_this);
+    static void volumeChangedCallback(GVolumeMonitor *monitor, GVolume *volume, DeviceModel *p_this);
+    static void mountAddedCallback(GVolumeMonitor *monitor, GMount *mount, DeviceModel *p_this);
+    static void mountRemovedCallback(GVolumeMonitor *monitor, GMount *mount, DeviceModel *p_this);
+    static void mountChangedCallback(GVolumeMonitor *monitor, GMount *mount, DeviceModel *p_this);
+
+    GVolumeMonitor *mMonitor;
+    QHash<GDrive *, Drive> mDrives;             //nullptr 下挂没有驱动器的分区
+    QList<GDrive *> mOrder;
+    QHash<GVolume *, GDrive *> mVolumes;
+    QHash<GMount *, MountEntry> mMounts;
+    QList<Event> mEvents;
+    quint64 mRevision;
+    quint64 mCallbacks;
+    quint64 mSignals;
+};
+
+#endif // DEVICEMODEL_H
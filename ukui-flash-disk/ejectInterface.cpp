@@ -56,10 +56,12 @@ ejectInterface::ejectInterface(QWidget *parent,QString mount_name,int deviceType
     QString strOccupy = tr("usb is occupying unejectable");
     QString strDataDevice = tr("data device has been unloaded");
     QString strGParted = tr("gparted has started");
+    QString strFailed = tr("usb eject failed");
     QString normalShow = getElidedText(show_text_label->font(),strNoraml,150);
     QString occupyShow = getElidedText(show_text_label->font(),strOccupy,150);
     QString datadeviceShow = getElidedText(show_text_label->font(),strDataDevice,150);
     QString gpartedShow = getElidedText(show_text_label->font(),strGParted,150);
+    QString failedShow = getElidedText(show_text_label->font(),strFailed,150);
     //add the text of the eject interface
     if(show_text_label)
     {
@@ -84,6 +86,10 @@ ejectInterface::ejectInterface(QWidget *parent,QString mount_name,int deviceType
         {
             show_text_label->setText(gpartedShow);
         }
+        else if(deviceType == EJECTFAILED)
+        {
+            show_text_label->setText(failedShow);
+        }
         else{}
     }
 
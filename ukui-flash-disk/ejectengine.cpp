@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+
+#include "ejectengine.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrent>
+#include <QtDBus/QDBusConnection>
+#include <QtDBus/QDBusMessage>
+#include <QtDBus/QDBusMetaType>
+#include <QtDBus/QDBusPendingCallWatcher>
+#include <QtDBus/QDBusPendingReply>
+
+#define UDISKS_SERVICE          "org.freedesktop.UDisks2"
+#define UDISKS_PATH             "/org/freedesktop/UDisks2"
+#define UDISKS_BLOCK            "org.freedesktop.UDisks2.Block"
+#define UDISKS_FILESYSTEM       "org.freedesktop.UDisks2.Filesystem"
+#define UDISKS_DRIVE            "org.freedesktop.UDisks2.Drive"
+#define UDISKS_NOT_MOUNTED      "org.freedesktop.UDisks2.Error.NotMounted"
+#define UDISKS_DEVICE_BUSY      "org.freedesktop.UDisks2.Error.DeviceBusy"
+//卸载要等缓存写回，授权要等用户输密码，默认的 25 秒不够
+#define UDISKS_CALL_TIMEOUT     (30 * 60 * 1000)
+
+namespace
+{
+    //UDisks2 的 ay 字符串带结尾的 '\0'
+    QString byteString(const QByteArray &bytes)
+    {
+        return QString::fromLocal8Bit(bytes.constData());
+    }
+
+    QStringList mountPoints(const QVariant &value)
+    {
+        QStringList result;
+        const QDBusArgument arg = value.value<QDBusArgument>();
+        arg.beginArray();
+        while (!arg.atEnd())
+        {
+            QByteArray point;
+            arg >> point;
+            result << byteString(point);
+        }
+        arg.endArray();
+        return result;
+    }
+}
+
+EjectEngine *EjectEngine::instance()
+{
+    static EjectEngine *engine = new EjectEngine;
+    return engine;
+}
+
+EjectEngine::EjectEngine(QObject *parent)
+    : QObject(parent)
+{
+    qDBusRegisterMetaType<UDisksInterfaces>();
+    qDBusRegisterMetaType<UDisksObjects>();
+}
+
+bool EjectEngine::eject(const QString &device, bool force)
+{
+    if (device.isEmpty() || mJobs.contains(device))
+        return false;
+
+    Job &job = mJobs[device];
+    job.force = force;
+    job.ejectable = false;
+    job.canPowerOff = false;
+    job.unmounted = 0;
+    Q_EMIT progress(device, Resolving, 0, 0);
+
+    QDBusPendingCallWatcher *watcher = call(UDISKS_PATH, "org.freedesktop.DBus.ObjectManager",
+                                            "GetManagedObjects", QVariantList());
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, device] (QDBusPendingCallWatcher *watcher) {
+        QDBusPendingReply<UDisksObjects> reply = *watcher;
+        watcher->deleteLater();
+        if (reply.isError())
+            fail(device, reply.error().message());
+        else
+            resolved(device, reply.value());
+    });
+    return true;
+}
+
+void EjectEngine::resolved(const QString &device, const UDisksObjects &objects)
+{
+    Job &job = mJobs[device];
+
+    //先找到设备文件对应的块设备，再取它所在的驱动器
+    QString block;
+    for (auto it = objects.constBegin(); it != objects.constEnd(); ++it)
+    {
+        const QVariantMap props = it.value().value(UDISKS_BLOCK);
+        if (!props.isEmpty() && byteString(props.value("Device").toByteArray()) == device)
+        {
+            block = it.key().path();
+            job.drive = props.value("Drive").value<QDBusObjectPath>().path();
+            break;
+        }
+    }
+    if (block.isEmpty())
+    {
+        fail(device, tr("No such device: %1").arg(device));
+        return;
+    }
+    const bool hasDrive = !job.drive.isEmpty() && job.drive != "/";
+
+    for (auto it = objects.constBegin(); it != objects.constEnd(); ++it)
+    {
+        const QVariantMap props = it.value().value(UDISKS_BLOCK);
+        if (props.isEmpty() || !it.value().contains(UDISKS_FILESYSTEM))
+            continue;
+        const bool onDevice = hasDrive ? props.value("Drive").value<QDBusObjectPath>().path() == job.drive
+                                       : it.key().path() == block;
+        if (!onDevice)
+            continue;
+        const QStringList points = mountPoints(it.value().value(UDISKS_FILESYSTEM).value("MountPoints"));
+        if (!points.isEmpty())
+            job.filesystems << qMakePair(it.key().path(), points.first());
+    }
+
+    if (hasDrive)
+    {
+        const QVariantMap drive = objects.value(QDBusObjectPath(job.drive)).value(UDISKS_DRIVE);
+        job.ejectable = drive.value("Ejectable").toBool();
+        job.canPowerOff = drive.value("CanPowerOff").toBool();
+    }
+
+    unmountNext(device);
+}
+
+void EjectEngine::unmountNext(const QString &device)
+{
+    Job &job = mJobs[device];
+    if (job.unmounted >= job.filesystems.size())
+    {
+        ejectDrive(device);
+        return;
+    }
+
+    Q_EMIT progress(device, Unmounting, job.unmounted, job.filesystems.size());
+    const QPair<QString, QString> fs = job.filesystems.at(job.unmounted);
+    QVariantMap options;
+    if (job.force)
+        options.insert("force", true);
+
+    QDBusPendingCallWatcher *watcher = call(fs.first, UDISKS_FILESYSTEM, "Unmount", QVariantList() << options);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, device, fs] (QDBusPendingCallWatcher *watcher) {
+        QDBusPendingReply<> reply = *watcher;
+        watcher->deleteLater();
+        if (reply.isError() && reply.error().name() != UDISKS_NOT_MOUNTED)
+        {
+            fail(device, reply.error().message(), reply.error().name() == UDISKS_DEVICE_BUSY ? fs.second : QString());
+            return;
+        }
+        ++mJobs[device].unmounted;
+        unmountNext(device);
+    });
+}
+
+void EjectEngine::ejectDrive(const QString &device)
+{
+    const Job &job = mJobs[device];
+    if (!job.ejectable)
+    {
+        powerOff(device);
+        return;
+    }
+
+    Q_EMIT progress(device, Ejecting, job.filesystems.size(), job.filesystems.size());
+    QDBusPendingCallWatcher *watcher = call(job.drive, UDISKS_DRIVE, "Eject", QVariantList() << QVariantMap());
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, device] (QDBusPendingCallWatcher *watcher) {
+        QDBusPendingReply<> reply = *watcher;
+        watcher->deleteLater();
+        //文件系统已经卸载，数据已经安全，弹出失败只记录
+        if (reply.isError())
+            qWarning() << "Eject" << device << "failed:" << reply.error().message();
+        powerOff(device);
+    });
+}
+
+void EjectEngine::powerOff(const QString &device)
+{
+    const Job &job = mJobs[device];
+    if (!job.canPowerOff)
+    {
+        mJobs.remove(device);
+        Q_EMIT finished(device);
+        return;
+    }
+
+    Q_EMIT progress(device, PoweringOff, job.filesystems.size(), job.filesystems.size());
+    QDBusPendingCallWatcher *watcher = call(job.drive, UDISKS_DRIVE, "PowerOff", QVariantList() << QVariantMap());
+    connect(watcher, &QDBusPendingCallWatcher::finished, this, [this, device] (QDBusPendingCallWatcher *watcher) {
+        QDBusPendingReply<> reply = *watcher;
+        watcher->deleteLater();
+        if (reply.isError())
+            qWarning() << "Power off" << device << "failed:" << reply.error().message();
+        mJobs.remove(device);
+        Q_EMIT finished(device);
+    });
+}
+
+void EjectEngine::fail(const QString &device, const QString &error, const QString &mountPoint)
+{
+    mJobs.remove(device);
+    if (mountPoint.isEmpty())
+    {
+        Q_EMIT failed(device, error, false, QStringList());
+        return;
+    }
+
+    //遍历 /proc 比较慢，放到线程里做
+    QFutureWatcher<QStringList> *watcher = new QFutureWatcher<QStringList>(this);
+    connect(watcher, &QFutureWatcher<QStringList>::finished, this, [this, watcher, device, error] {
+        Q_EMIT failed(device, error, true, watcher->result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run(&EjectEngine::busyProcesses, mountPoint));
+}
+
+QDBusPendingCallWatcher *EjectEngine::call(const QString &path, const QString &interface, const QString &method,
+                                           const QVariantList &arguments)
+{
+    QDBusMessage msg = QDBusMessage::createMethodCall(UDISKS_SERVICE, path, interface, method);
+    msg.setArguments(arguments);
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    msg.setInteractiveAuthorizationAllowed(true);
+#endif
+    return new QDBusPendingCallWatcher(QDBusConnection::systemBus().asyncCall(msg, UDISKS_CALL_TIMEOUT), this);
+}
+
+QStringList EjectEngine::busyProcesses(const QString &mountPoint)
+{
+    QStringList result;
+    const QString prefix = mountPoint.endsWith('/') ? mountPoint : mountPoint + '/';
+    auto inside = [&] (const QString &target) {
+        return target == mountPoint || target.startsWith(prefix);
+    };
+
+    const QStringList pids = QDir("/proc").entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &pid : pids)
+    {
+        bool isPid = false;
+        pid.toInt(&isPid);
+        if (!isPid)
+            continue;
+
+        const QString proc = "/proc/" + pid;
+        bool busy = inside(QFileInfo(proc + "/cwd").symLinkTarget());
+        if (!busy)
+        {
+            const QFileInfoList fds = QDir(proc + "/fd").entryInfoList(QDir::Files | QDir::System | QDir::NoDotAndDotDot);
+            for (const QFileInfo &fd : fds)
+            {
+                if (inside(fd.symLinkTarget()))
+                {
+                    busy = true;
+                    break;
+                }
+            }
+        }
+        if (busy)
+        {
+            QFile comm(proc + "/comm");
+            QString name = comm.open(QIODevice::ReadOnly) ? QString::fromLocal8Bit(comm.readAll()).trimmed() : QString();
+            result << QString("%1 (%2)").arg(name, pid);
+        }
+    }
+    return result;
+}
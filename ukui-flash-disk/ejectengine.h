@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2019 Tianjin KYLIN Information Technology Co., Ltd.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU  Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/&gt;.
+ *
+ */
+#ifndef EJECTENGINE_H
+#define EJECTENGINE_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+#include <QtDBus/QDBusObjectPath>
+
+class QDBusPendingCallWatcher;
+
+typedef QMap<QString, QVariantMap> UDisksInterfaces;
+typedef QMap<QDBusObjectPath, UDisksInterfaces> UDisksObjects;
+Q_DECLARE_METATYPE(UDisksInterfaces)
+Q_DECLARE_METATYPE(UDisksObjects)
+
+/*
+ * 通过 UDisks2 的 DBus 接口异步弹出设备：先卸载驱动器上所有已挂载的文件系统
+ * (Filesystem.Unmount)，再 Drive.Eject，最后 Drive.PowerOff。
+ * 全程不阻塞界面，授权由 UDisks2/polkit 处理，不再需要 pkexec。
+ * 卸载因设备忙(DeviceBusy)失败时，会找出占用挂载点的进程一起报告。
+ */
+class EjectEngine : public QObject
+{
+    Q_OBJECT
+public:
+    enum Stage
+    {
+        Resolving,
+        Unmounting,
+        Ejecting,
+        PoweringOff
+    };
+    Q_ENUM(Stage)
+
+    static EjectEngine *instance();
+
+    //device 为驱动器或分区的设备文件，如 /dev/sdb；同一设备正在弹出时返回 false
+    bool eject(const QString &device, bool force = false);
+    bool isBusy(const QString &device) const { return mJobs.contains(device); }
+
+Q_SIGNALS:
+    void progress(const QString &device, EjectEngine::Stage stage, int done, int total);
+    void finished(const QString &device);
+    //busy 只在 UDisks2 返回 DeviceBusy 时为真，busyProcesses: "进程名 (pid)"
+    void failed(const QString &device, const QString &error, bool busy, const QStringList &busyProcesses);
+
+private:
+    explicit EjectEngine(QObject *parent = nullptr);
+
+    struct Job
+    {
+        bool force;
+        QString drive;
+        bool ejectable;
+        bool canPowerOff;
+        QList<QPair<QString, QString> > filesystems;    //对象路径, 挂载点
+        int unmounted;
+    };
+
+    void resolved(const QString &device, const UDisksObjects &objects);
+    void unmountNext(const QString &device);
+    void ejectDrive(const QString &device);
+    void powerOff(const QString &device);
+    void fail(const QString &device, const QString &error, const QString &mountPoint = QString());
+    QDBusPendingCallWatcher *call(const QString &path, const QString &interface, const QString &method,
+                                  const QVariantList &arguments);
+
+    static QStringList busyProcesses(const QString &mountPoint);
+
+    QHash<QString, Job> mJobs;
+};
+
+#endif // EJECTENGINE_H
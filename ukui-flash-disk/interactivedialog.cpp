@@ -24,12 +24,6 @@ interactiveDialog::interactiveDialog(QWidget *parent):QWidget(parent)
     this->setFixedSize(300,86);
     this->setWindowFlags(Qt::FramelessWindowHint | Qt::Popup);
 
-    QPainterPath path;
-    auto rect = this->rect();
-    rect.adjust(1, 1, -1, -1);
-    path.addRoundedRect(rect, 6, 6);
-    setProperty("blurRegion", QRegion(path.toFillPolygon().toPolygon()));
-
     this->setAttribute(Qt::WA_TranslucentBackground);
     initWidgets();
     connect(chooseBtnCancle,SIGNAL(clicked()),this,SLOT(close()));
@@ -37,10 +31,40 @@ interactiveDialog::interactiveDialog(QWidget *parent):QWidget(parent)
     moveChooseDialogRight();
     initTransparentState();
     getTransparentData();
+    initBlurRegion();
+}
 
+void interactiveDialog::initBlurRegion()
+{
+    QPainterPath path;
+    auto rect = this->rect();
+    rect.adjust(1, 1, -1, -1);
+    path.addRoundedRect(rect, 6, 6);
+    setProperty("blurRegion", QRegion(path.toFillPolygon().toPolygon()));
     KWindowEffects::enableBlurBehind(this->winId(), true, QRegion(path.toFillPolygon().toPolygon()));
 }
 
+void interactiveDialog::setBusyProcesses(const QStringList &processes)
+{
+    QString text = tr("usb is occupying,do you want to eject it");
+    if(!processes.isEmpty())
+    {
+        //进程太多时只列前几个
+        QStringList shown = processes.mid(0, 5);
+        if(processes.size() > shown.size())
+            shown << QString("...");
+        text += "\n" + tr("used by: %1").arg(shown.join(", "));
+    }
+    contentLable->setWordWrap(true);
+    contentLable->setText(text);
+
+    const int h = main_V_BoxLayout->hasHeightForWidth() ? main_V_BoxLayout->heightForWidth(width())
+                                                         : main_V_BoxLayout->sizeHint().height();
+    this->setFixedSize(300, qMax(86, h));
+    moveChooseDialogRight();
+    initBlurRegion();
+}
+
 void interactiveDialog::initTransparentState()
 {
     const QByteArray idtrans(THEME_QT_TRANS);
@@ -48,6 +48,8 @@ class interactiveDialog: public QWidget
 public:
     interactiveDialog(QWidget *parent);
     ~interactiveDialog();
+    //列出占用设备的进程，对话框随内容变高
+    void setBusyProcesses(const QStringList &processes);
 private:
     QPushButton *chooseBtnContinue = nullptr;
     QPushButton *chooseBtnCancle = nullptr;
@@ -63,6 +65,7 @@ private:
 
 private:
     void initWidgets();
+    void initBlurRegion();
     void moveChooseDialogRight();
     void initTransparentState();
     void getTransparentData();
@@ -30,44 +30,7 @@
 #include <string.h>
 #include "clickLabel.h"
 #include "MacroFile.h"
-
-void frobnitz_result_func(GDrive *source_object,GAsyncResult *res,MainWindow *p_this)
-{
-    gboolean success =  FALSE;
-    GError *err = nullptr;
-    success = g_drive_eject_with_operation_finish (source_object, res, &err);
-
-    if (!err)
-    {
-      findGDriveList()->removeOne(source_object);
-      p_this->m_eject = new ejectInterface(p_this,g_drive_get_name(source_object),NORMALDEVICE);
-      p_this->m_eject->show();
-    }
-
-    else /*if(g_drive_can_stop(source_object) == true)*/
-    {
-        int volumeNum = g_list_length(g_drive_get_volumes(source_object));
-
-        for(int eachVolume = 0 ; eachVolume < volumeNum ;eachVolume++)
-        {
-            p_this->flagType = 0;
-
-            if(g_mount_can_unmount(g_volume_get_mount((GVolume *)g_list_nth_data(g_drive_get_volumes(source_object),eachVolume))))
-            {
-                char *dataPath = g_file_get_path(g_mount_get_root(g_volume_get_mount((GVolume *)g_list_nth_data(g_drive_get_volumes(source_object),eachVolume))));
-                QProcess p;
-                p.setProgram("pkexec");
-                p.setArguments(QStringList()<<"umount"<<QString(dataPath));
-                p.start();
-                p_this->ifSucess = p.waitForFinished();
-                p_this->m_eject = new ejectInterface(p_this,g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(source_object),eachVolume)),DATADEVICE);
-                p_this->m_eject->show();
-                findGMountList()->removeOne(g_volume_get_mount((GVolume *)g_list_nth_data(g_drive_get_volumes(source_object),eachVolume)));
-                findGDriveList()->removeOne(source_object);
-            }
-        }
-    }
-}
+#include "devicemodel.h"
 
 void frobnitz_result_func_drive(GDrive *source_object,GAsyncResult *res,MainWindow *p_this)
 {
@@ -92,7 +55,7 @@ MainWindow::MainWindow(QWidget *parent) :
     }
 
     const QByteArray id(AUTOLOAD);
-    if(QGSettings::isSchemaInstalled(idd))
+    if(QGSettings::isSchemaInstalled(id))
     {
         ifsettings = new QGSettings(id);
     }
@@ -189,35 +152,31 @@ void MainWindow::on_clickPanelToHideInterface()
 
 void MainWindow::getDeviceInfo()
 {
-//callback function that to monitor the insertion and removal of the underlying equipment
-    GVolumeMonitor *g_volume_monitor = g_volume_monitor_get();
-    g_signal_connect (g_volume_monitor, "drive-connected", G_CALLBACK (drive_connected_callback), this);
-    g_signal_connect (g_volume_monitor, "drive-disconnected", G_CALLBACK (drive_disconnected_callback), this);
-    g_signal_connect (g_volume_monitor, "volume-added", G_CALLBACK (volume_added_callback), this);
-    g_signal_connect (g_volume_monitor, "volume-removed", G_CALLBACK (volume_removed_callback), this);
-    g_signal_connect (g_volume_monitor, "mount-added", G_CALLBACK (mount_added_callback), this);
-    g_signal_connect (g_volume_monitor, "mount-removed", G_CALLBACK (mount_removed_callback), this);
+//the insertion and removal of the underlying equipment is monitored by DeviceModel,we only handle its deltas here
+    DeviceModel *model = DeviceModel::instance();
+    connect(model,&DeviceModel::driveConnected,this,&MainWindow::onDriveConnected);
+    connect(model,&DeviceModel::driveDisconnected,this,&MainWindow::onDriveDisconnected);
+    connect(model,&DeviceModel::volumeAdded,this,&MainWindow::onVolumeAdded);
+    connect(model,&DeviceModel::volumeRemoved,this,&MainWindow::onVolumeRemoved);
+    connect(model,&DeviceModel::mountAdded,this,&MainWindow::onMountAdded);
+    connect(model,&DeviceModel::mountRemoved,this,&MainWindow::onMountRemoved);
 //about drive
-    GList *current_drive_list = g_volume_monitor_get_connected_drives(g_volume_monitor);
-    while(current_drive_list)
+    for(GDrive *gdrive : model->drives())
     {
-        GDrive *gdrive = (GDrive *)current_drive_list->data;
-//        GVolume *g_volume = (GVolume *)g_list_nth(g_drive_get_volumes(gdrive),0);
-        char *devPath = g_drive_get_identifier(gdrive,G_DRIVE_IDENTIFIER_KIND_UNIX_DEVICE);
+        const QString devPath = model->drive(gdrive)->device;
         if(g_drive_can_eject(gdrive) || g_drive_can_stop(gdrive))
         {
-            if(g_str_has_prefix(devPath,"/dev/sda") != true)
+            if(!devPath.startsWith("/dev/sda"))
             {
-                if(g_str_has_prefix(devPath,"/dev/sr") || g_str_has_prefix(devPath,"/dev/sd"))
+                if(devPath.startsWith("/dev/sr") || devPath.startsWith("/dev/sd"))
                 {
-                    if(g_list_length(g_drive_get_volumes(gdrive)) != 0)
+                    if(model->volumeCount(gdrive) != 0)
                     {
                         *findGDriveList()<<gdrive;
                     }
                 }
             }
         }
-        current_drive_list = current_drive_list->next;
     }
 //about volume
 
@@ -238,17 +197,20 @@ void MainWindow::getDeviceInfo()
     fclose(fp);
     if(a > 0)
     {
-        QProcess::startDetached("gsettings set org.ukui.flash-disk.autoload ifautoload false");
+        if(ifsettings)
+            ifsettings->set(IFAUTOLOAD,false);
     }
 
-    GList *current_volume_list = g_volume_monitor_get_volumes(g_volume_monitor);
-    while(current_volume_list)
+    for(GVolume *gvolume : model->volumes())
     {
-        GVolume *gvolume = (GVolume *)current_volume_list->data;
-        if(g_volume_can_eject(gvolume) || g_drive_can_eject(g_volume_get_drive(gvolume)))
+        GDrive *gdrive = model->driveOf(gvolume);
+        if(g_volume_can_eject(gvolume) || (gdrive && g_drive_can_eject(gdrive)))
         {
             *findGVolumeList()<<gvolume;
-            ifautoload = ifsettings->get(IFAUTOLOAD).toBool();
+            //没有安装 schema 时按它的默认值自动挂载
+            ifautoload = true;
+            if(ifsettings)
+                ifautoload = ifsettings->get(IFAUTOLOAD).toBool();
             if(ifautoload == true)
             {
                 g_volume_mount(gvolume,
@@ -259,23 +221,18 @@ void MainWindow::getDeviceInfo()
                            nullptr);
             }
         }
-        current_volume_list = current_volume_list->next;
     }
 //about mount
-    GList *current_mount_list = g_volume_monitor_get_mounts(g_volume_monitor);
-    while(current_mount_list)
+    for(GMount *gmount : model->mounts())
     {
-        GMount *gmount = (GMount *)current_mount_list->data;
-        if(g_mount_can_eject(gmount) || g_drive_can_eject(g_mount_get_drive(gmount)))
+        GDrive *gdrive = model->driveOf(gmount);
+        if(g_mount_can_eject(gmount) || (gdrive && g_drive_can_eject(gdrive)))
         {
             *findGMountList()<<gmount;
         }
-        current_mount_list = current_mount_list->next;
-        this->root = g_mount_get_default_location(gmount);
-        this->mount_uri = g_file_get_uri(this->root);
-        if(g_str_has_prefix(this->mount_uri,"file:///data"))
+        if(model->mountUri(gmount).startsWith("file:///data"))
         {
-            findGVolumeList()->removeOne(g_mount_get_volume(gmount));
+            findGVolumeList()->removeOne(model->volumeOf(gmount));
             findGMountList()->removeOne(gmount);
         }
     }
@@ -301,63 +258,52 @@ void MainWindow::onConvertShowWindow()
 
 //the drive-connected callback function the is triggered when the usb device is inseted
 
-void MainWindow::drive_connected_callback(GVolumeMonitor *monitor, GDrive *drive, MainWindow *p_this)
+void MainWindow::onDriveConnected(GDrive *drive)
 {
     qDebug()<<"drive add";
-    p_this->driveVolumeNum = 0;
-    p_this->ifautoload = p_this->ifsettings->get(IFAUTOLOAD).toBool();
+    driveVolumeNum = 0;
+    ifautoload = true;
+    if(ifsettings)
+        ifautoload = ifsettings->get(IFAUTOLOAD).toBool();
 
-    if(p_this->ifautoload == true)
+    if(ifautoload == true)
     {
-        if(g_list_length(g_drive_get_volumes(drive)) > 0)
+        if(DeviceModel::instance()->volumeCount(drive) > 0)
         {
             *findGDriveList()<<drive;
         }
         else
         {
             qDebug()<<"wrong disk has intered";
-            p_this->onInsertAbnormalDiskNotify(tr("There is a problem with this device"));
+            onInsertAbnormalDiskNotify(tr("There is a problem with this device"));
         }
     }
     if(findGDriveList()->size() >= 1)
     {
-        p_this->m_systray->show();
+        m_systray->show();
     }
 
-//    for(int driveVolumeNum = 0; driveVolumeNum < g_list_length(g_drive_get_volumes(drive)); driveVolumeNum++)
-//    {
-//        p_this->volumeDevice << (GVolume *)g_list_nth_data(g_drive_get_volumes(drive),driveVolumeNum);
-//    }
-
-//    p_this->deviceMap.insert(drive,p_this->volumeDevice);
-
-    p_this->triggerType = 0;
+    triggerType = 0;
 
 }
 
 //the drive-disconnected callback function the is triggered when the usb device is pull out
-void MainWindow::drive_disconnected_callback (GVolumeMonitor *monitor, GDrive *drive, MainWindow *p_this)
+void MainWindow::onDriveDisconnected(GDrive *drive)
 {
-    p_this->driveVolumeNum = 0;
+    driveVolumeNum = 0;
     qDebug()<<"drive disconnect";
     findGDriveList()->removeOne(drive);
-    p_this->hide();
+    deviceMap.remove(drive);
+    hide();
     if(findGDriveList()->size() == 0)
     {
-        p_this->m_systray->hide();
+        m_systray->hide();
     }
-
-//    for(int driveVolumeNum = 0; driveVolumeNum < g_list_length(g_drive_get_volumes(drive)); driveVolumeNum++)
-//    {
-//        p_this->volumeDevice.removeOne((GVolume *)g_list_nth_data(g_drive_get_volumes(drive),driveVolumeNum));
-//    }
-
-//    p_this->deviceMap.remove(drive);
 }
 
 //when the usb device is identified,we should mount every partition
 
-void MainWindow::volume_added_callback(GVolumeMonitor *monitor, GVolume *volume, MainWindow *p_this)
+void MainWindow::onVolumeAdded(GVolume *volume, GDrive *drive)
 {
     qDebug()<<"volume add";
 
@@ -376,20 +322,17 @@ void MainWindow::volume_added_callback(GVolumeMonitor *monitor, GVolume *volume,
         qDebug()<<"a"<<a;
     }
     fclose(fp);
-    if(g_volume_get_drive(volume) == NULL)
+    if(drive == NULL)
     {
         *findTeleGVolumeList() << volume;
     }
-    p_this->ifautoload = p_this->ifsettings->get(IFAUTOLOAD).toBool();
-    if(a > 0)
+    ifautoload = true;
+    if(ifsettings)
     {
-        QProcess::startDetached("gsettings set org.ukui.flash-disk.autoload ifautoload false");
+        ifautoload = ifsettings->get(IFAUTOLOAD).toBool();
+        ifsettings->set(IFAUTOLOAD,a == 0);
     }
-    else
-    {
-        QProcess::startDetached("gsettings set org.ukui.flash-disk.autoload ifautoload true");
-    }
-    if(p_this->ifautoload == true)
+    if(ifautoload == true)
     {
         *findGVolumeList()<<volume;
         g_volume_mount(volume,
@@ -397,77 +340,81 @@ void MainWindow::volume_added_callback(GVolumeMonitor *monitor, GVolume *volume,
                    nullptr,
                    nullptr,
                    GAsyncReadyCallback(frobnitz_result_func_volume),
-                   p_this);
+                   this);
     }
     //if the deveice is CD
-    char *devPath = g_volume_get_identifier(volume,G_VOLUME_IDENTIFIER_KIND_UNIX_DEVICE);   //detective the kind of movable device
-    if(g_str_has_prefix(devPath,"/dev/sr")|| g_str_has_prefix(devPath,"/dev/sd") && g_str_has_prefix(devPath,"/dev/sda") != true)
+    const DeviceModel::Partition *partition = DeviceModel::instance()->partition(volume);
+    const QString devPath = partition ? partition->device : QString();   //detective the kind of movable device
+    if(devPath.startsWith("/dev/sr") || devPath.startsWith("/dev/sd") && !devPath.startsWith("/dev/sda"))
     {
-        if(!findGDriveList()->contains(g_volume_get_drive(volume)))
+        if(!findGDriveList()->contains(drive))
         {
-            if(p_this->ifautoload == true)
-            *findGDriveList()<<g_volume_get_drive(volume);
+            if(ifautoload == true)
+            *findGDriveList()<<drive;
         }
     }
     if(findGDriveList()->size() > 0 || findGMountList()->size() > 0)
     {
-        p_this->m_systray->show();
+        m_systray->show();
     }
 }
 
 //when the U disk is pull out we should reduce all its partitions
-void MainWindow::volume_removed_callback(GVolumeMonitor *monitor, GVolume *volume, MainWindow *p_this)
+void MainWindow::onVolumeRemoved(GVolume *volume, GDrive *drive)
 {
     qDebug()<<"volume removed";
-    if(g_list_length(g_drive_get_volumes(g_volume_get_drive(volume))) == 0)
+    if(DeviceModel::instance()->volumeCount(drive) == 0)
     {
-        findGDriveList()->removeOne(g_volume_get_drive(volume));
+        findGDriveList()->removeOne(drive);
     }
     findGVolumeList()->removeOne(volume);
-    if(g_volume_get_drive(volume) == NULL)
+    if(drive == NULL)
     {
         findTeleGVolumeList()->removeOne(volume);
     }
 
-    p_this->root = g_mount_get_default_location(g_volume_get_mount(volume));
-    p_this->mount_uri = g_file_get_uri(p_this->root);
-    if(p_this->mount_uri)
+    GMount *mount = g_volume_get_mount(volume);
+    if(mount)
     {
-        if(strcmp(p_this->mount_uri,"burn:///") == 0 || strcmp(p_this->mount_uri,"cdda://sr0/")==0)
+        GFile *location = g_mount_get_default_location(mount);
+        char *uri = g_file_get_uri(location);
+        if(strcmp(uri,"burn:///") == 0 || strcmp(uri,"cdda://sr0/")==0)
         {
-            findGDriveList()->removeOne(g_volume_get_drive(volume));
+            findGDriveList()->removeOne(drive);
         }
+        g_free(uri);
+        g_object_unref(location);
+        g_object_unref(mount);
     }
     else
     {
         char *devPath = g_volume_get_identifier(volume,G_VOLUME_IDENTIFIER_KIND_UNIX_DEVICE);   //detective the kind of movable device
         if(g_str_has_prefix(devPath,"/dev/sr"))
         {
-            findGDriveList()->removeOne(g_volume_get_drive(volume));
+            findGDriveList()->removeOne(drive);
         }
+        g_free(devPath);
     }
-    g_object_unref(p_this->root);
-    g_free(p_this->mount_uri);
     if(findGDriveList()->size() == 0 && findGMountList()->size() == 0 && findGVolumeList()->size() == 0)
     {
-        p_this->m_systray->hide();
+        m_systray->hide();
     }
 }
 
 //when the volumes were mounted we add its mounts number
-void MainWindow::mount_added_callback(GVolumeMonitor *monitor, GMount *mount, MainWindow *p_this)
+void MainWindow::onMountAdded(GMount *mount, GVolume *volume, GDrive *drive)
 {
     qDebug()<<"mount add";
-    p_this->root = g_mount_get_default_location(mount);
-    p_this->mount_uri = g_file_get_uri(p_this->root);
-    if(g_mount_get_drive(mount) == NULL)
+    DeviceModel *model = DeviceModel::instance();
+    if(drive == NULL)
     {
-       Q_EMIT p_this->telephoneMount();
+       Q_EMIT telephoneMount();
     }
 
-    char *devPath = g_volume_get_identifier(g_mount_get_volume(mount),G_VOLUME_IDENTIFIER_KIND_UNIX_DEVICE);
-    if(g_mount_can_eject(mount) || g_str_has_prefix(devPath,"/dev/bus")
-            && !g_str_has_prefix(devPath,"/dev/sda") || g_str_has_prefix(devPath,"/dev/sr"))
+    const DeviceModel::Partition *partition = model->partition(volume);
+    const QString devPath = partition ? partition->device : QString();
+    if(g_mount_can_eject(mount) || devPath.startsWith("/dev/bus")
+            && !devPath.startsWith("/dev/sda") || devPath.startsWith("/dev/sr"))
     {
         qDebug() << "real mount loaded";
         *findGMountList()<<mount;
@@ -477,12 +424,12 @@ void MainWindow::mount_added_callback(GVolumeMonitor *monitor, GMount *mount, Ma
         qDebug()<<"不符合过滤条件的设备已被挂载";
     }
 
-    if(!findGDriveList()->contains(g_mount_get_drive(mount)))
+    if(!findGDriveList()->contains(drive))
     {
-        *findGDriveList()<<g_mount_get_drive(mount);
+        *findGDriveList()<<drive;
     }
 
-    if(g_mount_get_drive(mount) == NULL)
+    if(drive == NULL)
     {
         *findTeleGMountList()<<mount;
         findGMountList()->removeOne(mount);
@@ -490,78 +437,60 @@ void MainWindow::mount_added_callback(GVolumeMonitor *monitor, GMount *mount, Ma
 
     if(findGMountList()->size() >= 1)
     {
-        p_this->m_systray->show();
+        m_systray->show();
     }
 
-    //    for(int driveVolumeNum = 0; driveVolumeNum < g_list_length(g_drive_get_volumes(drive)); driveVolumeNum++)
-    //    {
-    //        p_this->volumeDevice << (GVolume *)g_list_nth_data(g_drive_get_volumes(drive),driveVolumeNum);
-    //    }
-
-    //    p_this->deviceMap.insert(drive,p_this->volumeDevice);
-
-//    p_this->volumeDevice << mount;
-    if(!p_this->deviceMap.contains(g_mount_get_drive(mount)))
+    if(drive && !deviceMap.contains(drive))
     {
-        p_this->volumeDevice.clear();
-        for(int i = 0; i<g_list_length(g_drive_get_volumes(g_mount_get_drive(mount)));i++)
+        volumeDevice.clear();
+        for(int i = 0; i < model->mountCount(drive); i++)
         {
-            if(g_volume_get_mount((GVolume *)g_list_nth_data((g_drive_get_volumes(g_mount_get_drive(mount))),i)) != NULL)
-            {
-                p_this->volumeDevice.append(mount);
-            }
+            volumeDevice.append(mount);
         }
-        p_this->deviceMap.insert(g_mount_get_drive(mount),p_this->volumeDevice);
+        deviceMap.insert(drive,volumeDevice);
     }
-    qDebug()<<"device Map size"<<p_this->deviceMap.size();
+    qDebug()<<"device Map size"<<deviceMap.size();
 }
 
 //when the mountes were uninstalled we reduce mounts number
-void MainWindow::mount_removed_callback(GVolumeMonitor *monitor, GMount *mount, MainWindow *p_this)
+void MainWindow::onMountRemoved(GMount *mount, GVolume *volume, GDrive *drive)
 {
+    Q_UNUSED(volume)
     qDebug()<<mount<<"mount remove";
+    DeviceModel *model = DeviceModel::instance();
     findGMountList()->removeOne(mount);
 
-    if(g_mount_get_drive(mount) == NULL)
+    if(drive == NULL)
     {
         findTeleGMountList()->removeOne(mount);
     }
 
-//    p_this->volumeDevice.removeOne(mount);
     QMap<GDrive *,QList<GMount *>>::Iterator idit;
-    for(idit = p_this->deviceMap.begin(); idit != p_this->deviceMap.end();)
+    for(idit = deviceMap.begin(); idit != deviceMap.end();)
     {
         if(idit.value().contains(mount))
         {
             QMap<GDrive *,QList<GMount *>>::Iterator iter = idit;
             idit++;
-            p_this->deviceMap.erase(iter);
+            deviceMap.erase(iter);
         }
         else
             idit++;
     }
-    p_this->driveMountNum = 0;
 
-    for(int i = 0; i<=g_list_length(g_drive_get_volumes(g_mount_get_drive(mount)));i++)
+    if(model->volumeCount(drive) == 0)
     {
-        if(g_list_length(g_drive_get_volumes(g_mount_get_drive(mount))) == 0)
-        {
-            findGDriveList()->removeOne(g_mount_get_drive(mount));
-        }
-
-        if(g_volume_get_mount((GVolume *)g_list_nth(g_drive_get_volumes(g_mount_get_drive(mount)),i)) == NULL)
-        {
-            p_this->driveMountNum += 1;
-        }
+        findGDriveList()->removeOne(drive);
     }
+    driveMountNum = model->volumeCount(drive) - model->mountCount(drive);
 
-    if(p_this->findPointMount == false)
+    if(findPointMount == false)
     {
         if(findGMountList()->size() == 0 && findGDriveList()->size() == 0 )
         {
             if(findTeleGVolumeList()->size() != 1)
             {
-                p_this->m_systray->hide();
+                m_systray->hide();
             }
         }
     }
@@ -569,34 +498,20 @@ void MainWindow::mount_removed_callback(GVolumeMonitor *monitor, GMount *mount,
     {
         if(findGMountList()->size() == 0 && findGDriveList()->size() == 0)
         {
-            p_this->m_systray->hide();
+            m_systray->hide();
         }
     }
     if(findGMountList()->size() ==0  && findTeleGVolumeList()->size() == 1)
     {
-        p_this->m_systray->hide();
+        m_systray->hide();
     }
-    for(auto cacheDrive : *findGDriveList())
+    //a drive whose partitions are all unmounted is no longer listed
+    const QList<GDrive *> driveList = *findGDriveList();
+    for(GDrive *cacheDrive : driveList)
     {
-        qDebug()<<"while has entered";
-        qDebug()<<"list size"<<findGDriveList()->size();
-        int index = 0;
-        qDebug()<<"g_list_length"<<g_list_length(g_drive_get_volumes(cacheDrive));
-        qDebug()<<"000"<<g_volume_get_mount((GVolume *)g_list_nth(g_drive_get_volumes(cacheDrive),0)) ;
-        for(int i = 0; i<g_list_length(g_drive_get_volumes(cacheDrive));i++)
+        if(model->volumeCount(cacheDrive) > 0 && model->mountCount(cacheDrive) == 0)
         {
-            if(g_volume_get_mount((GVolume *)g_list_nth_data((g_drive_get_volumes(cacheDrive)),i)) != NULL)
-            {
-                qDebug()<<g_volume_get_mount((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),i))<<"mount name";
-                index += 1;
-                qDebug()<<"in index value"<<index;
-            }
-            qDebug()<<"out index value"<<index;
-            if(index == 0)
-            {
-                qDebug()<<"index value";
-                findGDriveList()->removeOne(cacheDrive);
-            }
+            findGDriveList()->removeOne(cacheDrive);
         }
     }
 }
@@ -610,32 +525,39 @@ void MainWindow::frobnitz_result_func_volume(GVolume *source_object,GAsyncResult
     success = g_volume_mount_finish (source_object, res, &err);
     if(!err)
     {
+        GDrive *drive = DeviceModel::instance()->driveOf(source_object);
         p_this->driveVolumeNum++;
-        if (p_this->driveVolumeNum >= g_list_length(g_drive_get_volumes(g_volume_get_drive(source_object))) && g_volume_get_drive(source_object) != NULL)
+        if (drive != NULL && p_this->driveVolumeNum >= DeviceModel::instance()->volumeCount(drive))
         {
             qDebug()<<"sig has emited";
             Q_EMIT p_this->convertShowWindow();     //emit a signal to trigger the MainMainShow slot
         }
 
-        if(p_this->mount_uri)
+        GMount *mount = g_volume_get_mount(source_object);
+        if(mount && drive)
         {
-            if(strcmp(p_this->mount_uri,"burn:///") == 0 || strcmp(p_this->mount_uri,"cdda://sr0/") == 0 || strcmp(p_this->mount_uri,"file:///data") !=0)
+            GFile *location = g_mount_get_default_location(mount);
+            char *uri = g_file_get_uri(location);
+            if(strcmp(uri,"burn:///") == 0 || strcmp(uri,"cdda://sr0/") == 0 || strcmp(uri,"file:///data") !=0)
             {
-                if(!findGDriveList()->contains(g_volume_get_drive(source_object)))
+                if(!findGDriveList()->contains(drive))
                 {
-                    if(g_drive_can_eject(g_volume_get_drive(source_object)))
+                    if(g_drive_can_eject(drive))
                     {
-                        *findGDriveList()<<g_volume_get_drive(source_object);
+                        *findGDriveList()<<drive;
                     }
                 }
             }
+            g_free(uri);
+            g_object_unref(location);
         }
-//        g_object_unref(p_this->root);
-//        g_free(p_this->mount_uri);
+        if(mount)
+            g_object_unref(mount);
     }
     else
     {
         qDebug()<<"sorry mount failed";
+        g_error_free(err);
     }
 }
 
@@ -677,27 +599,13 @@ void MainWindow::hideEvent(QHideEvent event)
 /*
  * newarea use all the information of the U disk to paint the main interface and add line
 */
-void MainWindow::newarea(int No,
-                         GDrive *Drive,
-                         GVolume *Volume,
-                         QString Drivename,
-                         QString nameDis1,
-                         QString nameDis2,
-                         QString nameDis3,
-                         QString nameDis4,
-                         qlonglong capacityDis1,
-                         qlonglong capacityDis2,
-                         qlonglong capacityDis3,
-                         qlonglong capacityDis4,
-                         QString pathDis1,
-                         QString pathDis2,
-                         QString pathDis3,
-                         QString pathDis4,
-                         int linestatus)
+QClickWidget *MainWindow::newarea(GDrive *Drive,
+                                  GVolume *Volume,
+                                  QString Drivename,
+                                  const QList<DeviceModel::Partition> &partitions,
+                                  int linestatus)
 {
-    open_widget = new QClickWidget(this,No,Drive,Volume,Drivename,nameDis1,nameDis2,nameDis3,nameDis4,
-                                   capacityDis1,capacityDis2,capacityDis3,capacityDis4,
-                                   pathDis1,pathDis2,pathDis3,pathDis4);
+    open_widget = new QClickWidget(this,Drive,Volume,Drivename,partitions);
     connect(open_widget,&QClickWidget::clickedConvert,this,[=]()
     {
         this->hide();
@@ -707,28 +615,36 @@ void MainWindow::newarea(int No,
        m_systray->hide();
     });
 
+    addRow(open_widget,linestatus);
+    return open_widget;
+}
 
-    line = new QWidget;
-    line->setFixedHeight(1);
-    line->setObjectName("lineWidget");
-    if(currentThemeMode == "ukui-dark" || currentThemeMode == "ukui-black" || currentThemeMode == "ukui-default")
-    {
-        line->setStyleSheet("background-color:rgba(255,255,255,0.2);");
-    }
-    else
+void MainWindow::addRow(QClickWidget *row, int linestatus)
+{
+    //when the drive is only or the drive is the first one,we make linestatus become  1
+    if (linestatus != 1)
     {
-        line->setStyleSheet("background-color:rgba(0,0,0,0.2);");
+        line = new QWidget;
+        line->setFixedHeight(1);
+        line->setObjectName("lineWidget");
+        if(currentThemeMode == "ukui-dark" || currentThemeMode == "ukui-black" || currentThemeMode == "ukui-default")
+        {
+            line->setStyleSheet("background-color:rgba(255,255,255,0.2);");
+        }
+        else
+        {
+            line->setStyleSheet("background-color:rgba(0,0,0,0.2);");
+        }
+        line->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+        line->setFixedSize(276,1);
     }
 
-    //when the drive is only or the drive is the first one,we make linestatus become  1
-    line->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
-    line->setFixedSize(276,1);
     if (linestatus == 2)
     {
         this->vboxlayout->addWidget(line);
     }
 
-    this->vboxlayout->addWidget(open_widget);
+    this->vboxlayout->addWidget(row);
     vboxlayout->setContentsMargins(2,8,2,8);
 
     if (linestatus == 0)
@@ -1035,12 +951,6 @@ void MainWindow::MainWindowShow()
 #else
 //    QString convertStyle = "#centralWidget{background:rgba(19,19,20," + strTrans + ");}";
 #endif
-//    QProcess *process = new QProcess();
-//    process->start();
-//    process->execute("gio list computer:///");
-//    process->waitForFinished();
-//    QByteArray iwname=process->readAllStandardOutput();
-//    qDebug()<<"iwname"<<iwname;   //此种读取文件的方法，并未解决实际问题
 
     if(ui->centralWidget != NULL)
     {
@@ -1054,20 +964,12 @@ void MainWindow::MainWindowShow()
             interfaceHideTime->start(5000);
         }
     }
-//    if ( this->vboxlayout != NULL )
-//    {
-//        QLayoutItem* item;
-//        while ((item = this->vboxlayout->takeAt(0)) != NULL)
-//        {
-//            delete item->widget();
-//            delete item;
-//        }
-//    }
+
     num = 0;
-    QList<QClickWidget *> listMainWindow = this->findChildren<QClickWidget *>();
-    for(QClickWidget *listItem:listMainWindow)
+    //行先全部从布局里拿出来，再按当前顺序放回去；只有变化过的驱动器才重建它的行
+    while(QLayoutItem *item = vboxlayout->takeAt(0))
     {
-        listItem->deleteLater();
+        delete item;
     }
 
     QList<QWidget *> listLine = this->findChildren<QWidget *>();
@@ -1077,335 +979,78 @@ void MainWindow::MainWindowShow()
           listItem->deleteLater();
     }
 
+    for(const QPointer<QClickWidget> &row : volumeRows)
+    {
+        if(row)
+            row->deleteLater();
+    }
+    volumeRows.clear();
+
       if (this->isHidden())
       {
+          DeviceModel *model = DeviceModel::instance();
+          QSet<GDrive *> shownDrives;
           //Convenient interface layout for all drives
 
           for(auto cacheDrive : *findGDriveList())
           {
-              GVolume *g_volume = (GVolume *)g_list_nth(g_drive_get_volumes(cacheDrive),0);
-              char *devPath = g_volume_get_identifier(g_volume,G_VOLUME_IDENTIFIER_KIND_UNIX_DEVICE);
+              const DeviceModel::Drive *entry = model->drive(cacheDrive);
+              if(entry == nullptr)
+                  continue;
+
               int singleSignal = 0;
               int cdSignal = 0;
-              listVolumes = g_drive_get_volumes(cacheDrive);
               hign = findGMountList()->size() *40 + findGDriveList()->size() *55;
-              for(vList = listVolumes; vList != NULL; vList = vList->next)
+              for(const DeviceModel::Partition &partition : entry->partitions)
               {
-                  volume = (GVolume *)vList->data;
-                  if(g_volume_get_mount(volume) != NULL)
-                  {
-                      root = g_mount_get_default_location(g_volume_get_mount(volume));
-                      mount_uri = g_file_get_uri(root);
-                      if(g_str_has_prefix(mount_uri,"file:///"))
-                      {
-                          singleSignal += 1;
-                      }
-
-                      if(g_str_has_prefix(mount_uri,"burn:///") || g_str_has_prefix(mount_uri,"cdda://"))
-                          cdSignal += 1;
-                      g_object_unref(volume);
-                      g_object_unref(root);
-                      g_free(mount_uri);
-                  }
+                  if(partition.mount == nullptr)
+                      continue;
+                  if(partition.uri.startsWith("file:///"))
+                      singleSignal += 1;
+                  if(partition.uri.startsWith("burn:///") || partition.uri.startsWith("cdda://"))
+                      cdSignal += 1;
               }
-              g_list_free(listVolumes);
               this->setFixedSize(280,hign);
 
-
+              int DisNum = entry->partitions.size();
               if(cdSignal)
               {
-                  switch(g_list_length(g_drive_get_volumes(cacheDrive)))
+                  //a CD only shows its first volume
+                  if(DisNum == 1 || DisNum == 2)
                   {
-                      case 1:
-                      num++;
-                      //when the drive's volume number is 1
-                      /*determine whether the drive is only one and whether if the drive is the fisrst one,
-                       *if the answer is yes,we set the last parameter is 1.*/
-                      /*if(findGDriveList()->size() == 1)
-                      {
-                          newarea(1,cacheDrive,g_drive_get_name(cacheDrive),
-                                  g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),0)),
-                                  NULL,NULL,NULL, 1,NULL,NULL,NULL, "burn:///",NULL,NULL,NULL,1);
-                      }*/
-                      if(num == 1)
-                      {
-                          newarea(1,cacheDrive,NULL,g_drive_get_name(cacheDrive),
-                                  g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),0)),
-                                  NULL,NULL,NULL, 1,NULL,NULL,NULL, "burn:///",NULL,NULL,NULL,1);
-                      }
-                      else
-                      {
-                          newarea(1,cacheDrive,NULL,g_drive_get_name(cacheDrive),
-                                  g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),0)),
-                                  NULL,NULL,NULL,1,NULL,NULL,NULL, "burn:///",NULL,NULL,NULL, 2);
-                      }
-                      break;
-                      case 2:
                       num++;
-                      if(num == 1)
-                      {
-                          newarea(1,cacheDrive,NULL,g_drive_get_name(cacheDrive),
-                                  g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),0)),
-                                  NULL,NULL,NULL, 1,NULL,NULL,NULL, "burn:///",NULL,NULL,NULL,1);
-                      }
-                      else
-                      {
-                          newarea(1,cacheDrive,NULL,g_drive_get_name(cacheDrive),
-                                  g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),0)),
-                                  NULL,NULL,NULL,1,NULL,NULL,NULL, "burn:///",NULL,NULL,NULL, 2);
-                      }
+                      showDriveRow(entry,true);
+                      shownDrives << cacheDrive;
                   }
               }
-              else
+              else if(singleSignal != 0 && DisNum > 0)
               {
-              GList *volumeNumber = g_drive_get_volumes(cacheDrive);
-              int DisNum = g_list_length(volumeNumber);
-              driveMountNum = 0;
+                  if (g_drive_can_eject(cacheDrive) || g_drive_can_stop(cacheDrive))
+                  {
+                      /*
+                       * the U disk partition's path,name,capacity and U disk's name are cached by DeviceModel,
+                       * then we layout by the number of its volume
+                       * */
+                      num++;
+                      showDriveRow(entry,false);
+                      shownDrives << cacheDrive;
+                  }
+              }
+          }
 
-              if(singleSignal !=0 )
-              {
-              if (DisNum >0)
+          //rows of the drives that are no longer listed
+          for(auto it = driveRows.begin(); it != driveRows.end();)
+          {
+              if(shownDrives.contains(it.key()))
               {
-                if (g_drive_can_eject(cacheDrive) || g_drive_can_stop(cacheDrive))
-                {
-                    /*
-                     * to get the U disk partition's path,name,capacity and U disk's name,then we layout by the
-                     * number of its volume
-                     * */
-
-                    //when the drive's volume number is 1
-                    if(DisNum == 1)
-                    {
-                       num++;
-                       char *driveName = g_drive_get_name(cacheDrive);
-                       GVolume *element = (GVolume *)g_list_nth_data(volumeNumber,0);
-                       char *volumeName = g_volume_get_name(element);
-                       QString apiName = QString(volumeName);
-                       char *deviceName = g_volume_get_identifier(element,G_VOLUME_IDENTIFIER_KIND_UNIX_DEVICE);
-                       if(deviceName){
-                           QString unixDeviceName = QString(deviceName);
-                           handleVolumeLabelForFat32Me(apiName,unixDeviceName);
-                           g_free(deviceName);
-                       }
-                       GFile *fileRoot = g_mount_get_root(g_volume_get_mount(element));
-                       UDiskPathDis1 = g_file_get_path(fileRoot);
-                       GFile *file = g_file_new_for_path(UDiskPathDis1);
-                       GFileInfo *info = g_file_query_filesystem_info(file,G_FILE_ATTRIBUTE_FILESYSTEM_SIZE,nullptr,nullptr);
-                       totalDis1 = g_file_info_get_attribute_uint64(info,G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
-                       /*new show u disk in next code*/
-                       root = g_mount_get_default_location(g_volume_get_mount(volume));
-                       mount_uri = g_file_get_uri(root);
-
-
-                       //when the drive's volume number is 1
-                       /*determine whether the drive is only one and whether if the drive is the fisrst one,
-                        *if the answer is yes,we set the last parameter is 1.*/
-                       if(num == 1)
-                       {
-                           newarea(DisNum,cacheDrive,NULL,driveName,
-                                   apiName,
-                                   NULL,NULL,NULL, totalDis1,NULL,NULL,NULL, QString(mount_uri),NULL,NULL,NULL,1);
-                       }
-                       else
-                       {
-                           newarea(DisNum,cacheDrive,NULL,driveName,
-                                   apiName,
-                                   NULL,NULL,NULL, totalDis1,NULL,NULL,NULL, QString(mount_uri),NULL,NULL,NULL,2);
-                       }
-
-                       g_object_unref(info);
-                       g_free(driveName);
-                       g_free(volumeName);
-                       g_object_unref(element);
-                       g_free(UDiskPathDis1);
-                       g_object_unref(file);
-                       g_object_unref(root);
-                       g_free(mount_uri);
-                    }
-                    //when the drive's volume number is 2
-                    if(DisNum == 2)
-                    {
-                        num++;
-                        char *driveName = g_drive_get_name(cacheDrive);
-                        GVolume *element1 = (GVolume *)g_list_nth_data(volumeNumber,0);
-                        char *volumeName1 = g_volume_get_name(element1);
-                        QString apiName1 = QString(volumeName1);
-                        char *deviceName1 = g_volume_get_identifier(element1,G_VOLUME_IDENTIFIER_KIND_UNIX_DEVICE);
-                        if(deviceName1){
-                            QString unixDeviceName = QString(deviceName1);
-                            handleVolumeLabelForFat32Me(apiName1,unixDeviceName);
-                            g_free(deviceName1);
-                        }
-                        GFile *fileRoot1 = g_mount_get_root(g_volume_get_mount(element1));
-                        UDiskPathDis1 = g_file_get_path(fileRoot1);
-                        GFile *file1 = g_file_new_for_path(UDiskPathDis1);
-                        GFileInfo *info1 = g_file_query_filesystem_info(file1,G_FILE_ATTRIBUTE_FILESYSTEM_SIZE,nullptr,nullptr);
-                        totalDis1 = g_file_info_get_attribute_uint64(info1,G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
-                        root = g_mount_get_default_location(g_volume_get_mount(element1));
-                        mount_uri = g_file_get_uri(root);
-
-
-                        GVolume *element2 = (GVolume *)g_list_nth_data(volumeNumber,1);
-                        char *volumeName2 = g_volume_get_name(element2);
-                        QString apiName2 = QString(volumeName2);
-                        char *deviceName2 = g_volume_get_identifier(element2,G_VOLUME_IDENTIFIER_KIND_UNIX_DEVICE);
-                        if(deviceName2){
-                            QString unixDeviceName = QString(deviceName2);
-                            handleVolumeLabelForFat32Me(apiName2,unixDeviceName);
-                            g_free(deviceName2);
-                        }
-                        GFile *fileRoot2 = g_mount_get_root(g_volume_get_mount(element2));
-                        UDiskPathDis2 = g_file_get_path(fileRoot2);
-                        GFile *file2 = g_file_new_for_path(UDiskPathDis2);
-                        GFileInfo *info2 = g_file_query_filesystem_info(file2,G_FILE_ATTRIBUTE_FILESYSTEM_SIZE,nullptr,nullptr);
-                        totalDis2 = g_file_info_get_attribute_uint64(info2,G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
-                        rootSecond = g_mount_get_default_location(g_volume_get_mount(element2));
-                        mount_uriSecond = g_file_get_uri(rootSecond);
-
-                        //when the drive's volume number is 1
-                        /*determine whether the drive is only one and whether if the drive is the fisrst one,
-                         *if the answer is yes,we set the last parameter is 1.*/
-                        if(num == 1)
-                        {
-                            newarea(DisNum,cacheDrive,NULL,driveName,
-                                    apiName1,
-                                    apiName2,
-                                    NULL,NULL, totalDis1,totalDis2,NULL,NULL, QString(mount_uri),QString(mount_uriSecond),NULL,NULL,1);
-                        }
-                        else
-                        {
-                            newarea(DisNum,cacheDrive,NULL,driveName,
-                                    apiName1,
-                                    apiName2,
-                                    NULL,NULL, totalDis1,totalDis2,NULL,NULL, QString(mount_uri),QString(mount_uriSecond),NULL,NULL,2);
-                        }
-
-                        g_free(driveName);
-                        g_free(volumeName1);
-                        g_free(volumeName2);
-                        g_object_unref(element1);
-                        g_object_unref(element2);
-                        g_free(UDiskPathDis1);
-                        g_free(UDiskPathDis2);
-                        g_object_unref(file1);
-                        g_object_unref(file2);
-                        g_object_unref(root);
-                        g_free(mount_uri);
-                        g_object_unref(rootSecond);
-                        g_free(mount_uriSecond);
-                    }
-                    //when the drive's volume number is 3
-                    if(DisNum == 3)
-                    {
-                        num++;
-                        UDiskPathDis1 = g_file_get_path(g_mount_get_root(g_volume_get_mount((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),0))));
-//                        QByteArray dateDis1 = UDiskPathDis1.toLocal8Bit();
-//                        char *p_ChangeDis1 = dateDis1.data();
-                        GFile *fileDis1 = g_file_new_for_path(UDiskPathDis1);
-                        GFileInfo *infoDis1 = g_file_query_filesystem_info(fileDis1,"*",nullptr,nullptr);
-                        totalDis1 = g_file_info_get_attribute_uint64(infoDis1,G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
-
-                        UDiskPathDis2 = g_file_get_path(g_mount_get_root(g_volume_get_mount((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),1))));
-//                        QByteArray dateDis2 = UDiskPathDis2.toLocal8Bit();
-//                        char *p_ChangeDis2 = dateDis2.data();
-                        GFile *fileDis2 = g_file_new_for_path(UDiskPathDis2);
-                        GFileInfo *infoDis2 = g_file_query_filesystem_info(fileDis2,"*",nullptr,nullptr);
-                        totalDis2 = g_file_info_get_attribute_uint64(infoDis2,G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
-
-                        UDiskPathDis3 = g_file_get_path(g_mount_get_root(g_volume_get_mount((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),2))));
-//                        QByteArray dateDis3 = UDiskPathDis3.toLocal8Bit();
-//                        char *p_ChangeDis3 = dateDis3.data();
-                        GFile *fileDis3 = g_file_new_for_path(UDiskPathDis3);
-                        GFileInfo *infoDis3 = g_file_query_filesystem_info(fileDis3,"*",nullptr,nullptr);
-                        totalDis3 = g_file_info_get_attribute_uint64(infoDis3,G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
-                        if(findGDriveList()->size() == 1)
-                        {
-                            newarea(DisNum,cacheDrive,NULL,g_drive_get_name(cacheDrive),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),0)),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),1)),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),2)),
-                                    NULL, totalDis1,totalDis2,totalDis3,NULL, QString(UDiskPathDis1),QString(UDiskPathDis2),QString(UDiskPathDis3),NULL,1);
-                        }
-
-                        else if(num == 1)
-                        {
-                            newarea(DisNum,cacheDrive,NULL,g_drive_get_name(cacheDrive),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),0)),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),1)),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),2)),
-                                    NULL, totalDis1,totalDis2,totalDis3,NULL, QString(UDiskPathDis1),QString(UDiskPathDis2),QString(UDiskPathDis3),NULL,1);
-                        }
-
-                        else
-                        {
-                            newarea(DisNum,cacheDrive,NULL,g_drive_get_name(cacheDrive),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),0)),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),1)),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),2)),
-                                    NULL, totalDis1,totalDis2,totalDis3,NULL, QString(UDiskPathDis1),QString(UDiskPathDis2),QString(UDiskPathDis3),NULL,2);
-                        }
-
-                    }
-                    //when the drive's volume number is 4
-                    if(DisNum == 4)
-                    {
-                        num++;
-                        UDiskPathDis1 = g_file_get_path(g_mount_get_root(g_volume_get_mount((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),0))));
-                        GFile *fileDis1 = g_file_new_for_path(UDiskPathDis1);
-                        GFileInfo *infoDis1 = g_file_query_filesystem_info(fileDis1,"*",nullptr,nullptr);
-                        totalDis1 = g_file_info_get_attribute_uint64(infoDis1,G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
-
-                        UDiskPathDis2 = g_file_get_path(g_mount_get_root(g_volume_get_mount((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),1))));
-                        GFile *fileDis2 = g_file_new_for_path(UDiskPathDis2);
-                        GFileInfo *infoDis2 = g_file_query_filesystem_info(fileDis2,"*",nullptr,nullptr);
-                        totalDis2 = g_file_info_get_attribute_uint64(infoDis2,G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
-
-                        UDiskPathDis3 = g_file_get_path(g_mount_get_root(g_volume_get_mount((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),2))));
-                        GFile *fileDis3 = g_file_new_for_path(UDiskPathDis3);
-                        GFileInfo *infoDis3 = g_file_query_filesystem_info(fileDis3,"*",nullptr,nullptr);
-                        totalDis3 = g_file_info_get_attribute_uint64(infoDis3,G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
-
-                        UDiskPathDis4 = g_file_get_path(g_mount_get_root(g_volume_get_mount((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),3))));
-                        GFile *fileDis4 = g_file_new_for_path(UDiskPathDis4);
-                        GFileInfo *infoDis4 = g_file_query_filesystem_info(fileDis4,"*",nullptr,nullptr);
-                        totalDis4 = g_file_info_get_attribute_uint64(infoDis4,G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
-
-                        if(findGDriveList()->size() == 1)
-                        {
-                            newarea(DisNum,cacheDrive,NULL,g_drive_get_name(cacheDrive),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),0)),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),1)),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),2)),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),3)),
-                                    totalDis1,totalDis2,totalDis3,totalDis4, QString(UDiskPathDis1),QString(UDiskPathDis2),QString(UDiskPathDis3),QString(UDiskPathDis4),1);
-                        }
-
-                        else if(num == 1)
-                        {
-                            newarea(DisNum,cacheDrive,NULL,g_drive_get_name(cacheDrive),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),0)),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),1)),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),2)),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),3)),
-                                    totalDis1,totalDis2,totalDis3,totalDis4, UDiskPathDis1,UDiskPathDis2,UDiskPathDis3,UDiskPathDis4,1);
-                        }
-
-                        else
-                        {
-                            newarea(DisNum,cacheDrive,NULL,g_drive_get_name(cacheDrive),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),0)),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),1)),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),2)),
-                                    g_volume_get_name((GVolume *)g_list_nth_data(g_drive_get_volumes(cacheDrive),3)),
-                                    totalDis1,totalDis2,totalDis3,totalDis4, UDiskPathDis1,UDiskPathDis2,UDiskPathDis3,UDiskPathDis4,2);
-                        }
-
-                    }
-                }
-              }
+                  ++it;
+                  continue;
               }
-              }
-      }
+              if(it.value().widget)
+                  it.value().widget->deleteLater();
+              it = driveRows.erase(it);
+          }
+
           if(insertorclick == false && findTeleGVolumeList()->size() >= 1)
           {
               qDebug()<<"findTeleVolume"<<findTeleGVolumeList()->size();
@@ -1414,44 +1059,12 @@ void MainWindow::MainWindowShow()
                   num++;
                   hign = findGMountList()->size() *40 + findGDriveList()->size() *55 + findTeleGMountList()->size() *90;
                   this->setFixedSize(280,hign);
-//                  if(g_volume_get_drive(cacheVolume) == NULL)
-//                  {
-//                  qDebug()<<"has no drive device";
-//                  root = g_mount_get_default_location(g_volume_get_mount(cacheVolume));
-//                  mount_uri = g_file_get_uri(root);
-//                  }
-//                  qDebug()<<"telephone mount uri"<<mount_uri;
-                  root = g_mount_get_default_location(g_volume_get_mount(cacheVolume));
-                  mount_uri = g_file_get_uri(root);
-                  if(g_str_has_prefix(mount_uri,"mtp://") || g_str_has_prefix(mount_uri,"gphoto2://"))
+                  const DeviceModel::Partition *partition = model->partition(cacheVolume);
+                  if(partition && (partition->uri.startsWith("mtp://") || partition->uri.startsWith("gphoto2://")))
                   {
-                      GFile *fileRoot = g_mount_get_root(g_volume_get_mount(cacheVolume));
-                      UDiskPathDis1 = g_file_get_path(fileRoot);
-                      GFile *file = g_file_new_for_path(UDiskPathDis1);
-                      GFileInfo *info = g_file_query_filesystem_info(file,G_FILE_ATTRIBUTE_FILESYSTEM_SIZE,nullptr,nullptr);
-                      totalDis1 = g_file_info_get_attribute_uint64(info,G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
-                      QString telephoneName = tr("telephone device");
-//                      QByteArray strTelePhone = telephoneName.toLatin1();  注意这里的类型转换需要调toLocal8Bit不能用toLatin1，否则会出现中文乱码。
-                      QByteArray strTelePhone = telephoneName.toLocal8Bit();
-                      char *realTele = strTelePhone.data();
-
-                      if(num == 1)
-                      {
-                          newarea(1,NULL,cacheVolume,realTele,
-                                  g_volume_get_name(cacheVolume),
-                                  NULL,NULL,NULL,totalDis1,NULL,NULL,NULL, QString(UDiskPathDis1),NULL,NULL,NULL,1);
-                      }
-                      else
-                      {
-                          newarea(1,NULL,cacheVolume,realTele,
-                                  g_volume_get_name(cacheVolume),
-                                  NULL,NULL,NULL,totalDis1,NULL,NULL,NULL, QString(UDiskPathDis1),NULL,NULL,NULL,2);
-                      }
-
-                      g_free(g_volume_get_name(cacheVolume));
-                      g_object_unref(file);
-                      g_free(UDiskPathDis1);
-                      g_object_unref(fileRoot);
+                      volumeRows << newarea(NULL,cacheVolume,tr("telephone device"),
+                                            QList<DeviceModel::Partition>() << *partition,
+                                            num == 1 ? 1 : 2);
                   }
 
                   else
@@ -1468,7 +1081,33 @@ void MainWindow::MainWindowShow()
     {
       this->hide();
     }
-//    ui->centralWidget->show();
+}
+
+//a row is rebuilt only when its drive changed after the row was built
+void MainWindow::showDriveRow(const DeviceModel::Drive *entry, bool cd)
+{
+    int linestatus = num == 1 ? 1 : 2;
+    DriveRow &row = driveRows[entry->drive];
+    if(row.widget && row.revision == entry->revision)
+    {
+        addRow(row.widget,linestatus);
+        return;
+    }
+    if(row.widget)
+        row.widget->deleteLater();
+
+    QList<DeviceModel::Partition> partitions = entry->partitions;
+    if(cd)
+    {
+        //a CD only shows its first volume
+        partitions = partitions.mid(0,1);
+        partitions[0].capacity = 1;
+        partitions[0].uri = "burn:///";
+        partitions[0].path.clear();
+    }
+
+    row.widget = newarea(entry->drive,NULL,entry->name,partitions,linestatus);
+    row.revision = entry->revision;
 }
 
 void MainWindow::ifgetPinitMount()
@@ -1500,6 +1139,8 @@ void MainWindow::GpartedStartedWindowShow()
     {
         listItem->deleteLater();
     }
+    driveRows.clear();
+    volumeRows.clear();
 
     QList<QWidget *> listLine = this->findChildren<QWidget *>();
     for(QWidget *listItem:listLine)
@@ -1529,43 +1170,15 @@ void MainWindow::GpartedStartedWindowShow()
         this->setFixedSize(280,hign);
 //        if(DisNum == 1)
 //        {
-            char *driveName = g_drive_get_name(it.key());
-            qDebug()<<"driveName"<<driveName;
-            GMount *element = it.value()[0];
-            char *volumeName = g_mount_get_name(element);
-            QString apiName = QString(volumeName);
-//            char *deviceName = g_volume_get_identifier(element,G_VOLUME_IDENTIFIER_KIND_UNIX_DEVICE);
-//            if(deviceName){
-//                QString unixDeviceName = QString(deviceName);
-//                handleVolumeLabelForFat32Me(apiName,unixDeviceName);
-//                g_free(deviceName);
-//            }
-            GFile *fileRoot = g_mount_get_root(element);
-            UDiskPathDis1 = g_file_get_path(fileRoot);
-            GFile *file = g_file_new_for_path(UDiskPathDis1);
-            GFileInfo *info = g_file_query_filesystem_info(file,G_FILE_ATTRIBUTE_FILESYSTEM_SIZE,nullptr,nullptr);
-            totalDis1 = g_file_info_get_attribute_uint64(info,G_FILE_ATTRIBUTE_FILESYSTEM_SIZE);
+            const DeviceModel::Drive *entry = DeviceModel::instance()->drive(it.key());
+            const DeviceModel::Partition *partition = DeviceModel::instance()->partition(DeviceModel::instance()->volumeOf(it.value().value(0)));
+            if(entry == nullptr || partition == nullptr)
+                continue;
+            qDebug()<<"driveName"<<entry->name;
             //when the drive's volume number is 1
             /*determine whether the drive is only one and whether if the drive is the fisrst one,
              *if the answer is yes,we set the last parameter is 1.*/
-            if(num == 1)
-            {
-                newarea(1,it.key(),NULL,driveName,
-                        apiName,
-                        NULL,NULL,NULL, totalDis1,NULL,NULL,NULL, QString(UDiskPathDis1),NULL,NULL,NULL,1);
-            }
-            else
-            {
-                newarea(1,it.key(),NULL,driveName,
-                        apiName,
-                        NULL,NULL,NULL, totalDis1,NULL,NULL,NULL, QString(UDiskPathDis1),NULL,NULL,NULL,2);
-            }
-
-            g_free(driveName);
-            g_free(volumeName);
-            g_object_unref(element);
-            g_free(UDiskPathDis1);
-            g_object_unref(file);
+            newarea(it.key(),NULL,entry->name,QList<DeviceModel::Partition>() << *partition,num == 1 ? 1 : 2);
 //        }
 //        if(DisNum == 2)
 //        {
@@ -29,12 +29,15 @@
 #include <QEvent>
 #include <qgsettings.h>
 #include <QMap>
+#include <QHash>
+#include <QPointer>
 
 #include "qclickwidget.h"
 #include "UnionVariable.h"
 #include "ejectInterface.h"
 #include "mainwindow.h"
 #include "MacroFile.h"
+#include "devicemodel.h"
 
 
 namespace Ui {
@@ -67,23 +70,13 @@ private:
     //QHBoxLayout *hboxlayout;
     QLabel *no_device_label;
     QPushButton *eject_image_button;
-    void newarea(int No,
-                 GDrive *Drive,
-                 GVolume *Volume,
-                 QString Drivename,
-                 QString nameDis1,
-                 QString nameDis2,
-                 QString nameDis3,
-                 QString nameDis4,
-                 qlonglong capacityDis1,
-                 qlonglong capacityDis2,
-                 qlonglong capacityDis3,
-                 qlonglong capacityDis4,
-                 QString pathDis1,
-                 QString pathDis2,
-                 QString pathDis3,
-                 QString pathDis4,
-                 int linestatus);
+    QClickWidget *newarea(GDrive *Drive,
+                          GVolume *Volume,
+                          QString Drivename,
+                          const QList<DeviceModel::Partition> &partitions,
+                          int linestatus);
+    void addRow(QClickWidget *row, int linestatus);
+    void showDriveRow(const DeviceModel::Drive *entry, bool cd);
     void moveBottomRight();
     void moveBottomDirect(GDrive *drive);
     void moveBottomNoBase();
@@ -93,12 +86,6 @@ private:
     static void frobnitz_result_func_volume(GVolume *source_object,GAsyncResult *res,MainWindow *p_this);
     static void frobnitz_result_func_mount(GMount *source_object,GAsyncResult *res,MainWindow *p_this);
     //static void frobnitz_result_func_volume(GVolume *source_object,GAsyncResult *res,gpointer);
-    static void drive_connected_callback (GVolumeMonitor *monitor, GDrive *drive, MainWindow *p_this);
-    static void drive_disconnected_callback (GVolumeMonitor *monitor, GDrive *drive, MainWindow *p_this);
-    static void volume_added_callback (GVolumeMonitor *monitor, GVolume *volume, MainWindow *p_this);
-    static void volume_removed_callback (GVolumeMonitor *monitor, GVolume *volume, MainWindow *p_this);
-    static void mount_added_callback (GVolumeMonitor *monitor, GMount *mount, MainWindow *p_this);
-    static void mount_removed_callback (GVolumeMonitor *monitor, GMount *mount, MainWindow *p_this);
     void ifgetPinitMount();
 
 private:
@@ -107,14 +94,6 @@ private:
 //    QString UDiskPathDis2;
 //    QString UDiskPathDis3;
 //    QString UDiskPathDis4;
-    char *UDiskPathDis1;
-    char *UDiskPathDis2;
-    char *UDiskPathDis3;
-    char *UDiskPathDis4;
-    quint64 totalDis1;
-    quint64 totalDis2;
-    quint64 totalDis3;
-    quint64 totalDis4;
 //    QClickWidget *open_widget;
     QClickWidget *open_widget;
     int hign;
@@ -124,13 +103,14 @@ private:
     QScreen *screen;
     int triggerType = 0; //detective the type of MainWinow(insert USB disk or click systemtray icon)
 
-    char *mount_uri;
-    GFile *root;
-    char *mount_uriSecond;
-    GFile *rootSecond;
-    GList *listVolumes;
-    GList *vList;
-    GVolume *volume;
+    //每个驱动器的行和建行时模型的版本，版本没变就直接复用
+    struct DriveRow
+    {
+        QPointer<QClickWidget> widget;
+        quint64 revision = 0;
+    };
+    QHash<GDrive *,DriveRow> driveRows;
+    QList<QPointer<QClickWidget>> volumeRows;
 
     double m_transparency;
     QString currentThemeMode;
@@ -139,10 +119,10 @@ private:
     QGSettings *qtSettings = nullptr;
 
     QWidget *line = nullptr;
-    bool ifautoload;
+    bool ifautoload = true;
     bool insertorclick;
 
-    QGSettings * ifsettings;
+    QGSettings * ifsettings = nullptr;
     int telephoneNum;
     QString tmpPath;
     bool findPointMount;
@@ -174,6 +154,13 @@ public Q_SLOTS:
     void on_clickPanelToHideInterface();
     void onRequestSendDesktopNotify(QString message);
     void onInsertAbnormalDiskNotify(QString message);
+private Q_SLOTS:
+    void onDriveConnected(GDrive *drive);
+    void onDriveDisconnected(GDrive *drive);
+    void onVolumeAdded(GVolume *volume, GDrive *drive);
+    void onVolumeRemoved(GVolume *volume, GDrive *drive);
+    void onMountAdded(GMount *mount, GVolume *volume, GDrive *drive);
+    void onMountRemoved(GMount *mount, GVolume *volume, GDrive *drive);
 Q_SIGNALS:
     void clicked();
     void convertShowWindow();
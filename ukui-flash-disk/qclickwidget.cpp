@@ -17,80 +17,7 @@
  */
 #include "qclickwidget.h"
 #include <KWindowEffects>
-#include <QtConcurrent/QtConcurrent>
-
-void frobnitz_force_result_func(GDrive *source_object,GAsyncResult *res,QClickWidget *p_this)
-{
-    auto env = qgetenv("QT_QPA_PLATFORMTHEME");
-    qDebug()<<"env"<<env;
-    gboolean success =  FALSE;
-    GError *err = nullptr;
-    success = g_drive_eject_with_operation_finish (source_object, res, &err);
-    if (!err)
-    {
-      findGDriveList()->removeOne(source_object);
-      p_this->m_eject = new ejectInterface(p_this,g_drive_get_name(source_object),NORMALDEVICE);
-      p_this->m_eject->show();
-    }
-    else
-    {
-        int volumeNum = g_list_length(g_drive_get_volumes(source_object));
-        for(int eachVolume = 0 ; eachVolume < volumeNum ;eachVolume++)
-        {
-            p_this->flagType = 0;
-
-            if(g_mount_can_unmount(g_volume_get_mount((GVolume *)g_list_nth_data(g_drive_get_volumes(source_object),eachVolume))))
-            {
-                QtConcurrent::run([=](){
-                char *dataPath = g_file_get_path(g_mount_get_root(g_volume_get_mount((GVolume *)g_list_nth_data(g_drive_get_volumes(source_object),eachVolume))));
-                qDebug()<<"dataPath"<<dataPath;
-                QProcess p;
-                p.setProgram("pkexec");
-                p.setArguments(QStringList()<<"eject"<<QString(dataPath));
-                p.start();
-                p_this->ifSucess = p.waitForFinished();
-                });
-            }
-        }
-    }
-}
-
-void frobnitz_result_func(GDrive *source_object,GAsyncResult *res,QClickWidget *p_this)
-{
-    gboolean success =  FALSE;
-    GError *err = nullptr;
-    success = g_drive_eject_with_operation_finish (source_object, res, &err);
-
-    if (!err)
-    {
-      findGDriveList()->removeOne(source_object);
-      p_this->m_eject = new ejectInterface(p_this,g_drive_get_name(source_object),NORMALDEVICE);
-      p_this->m_eject->show();
-    }
-
-    else /*if(g_drive_can_stop(source_object) == true)*/
-    {
-        if (p_this->chooseDialog == nullptr)
-        {
-            p_this->chooseDialog = new interactiveDialog(p_this);
-        }
-        qDebug()<<__FUNCTION__;
-//        p_this->chooseDialog->raise();
-        p_this->chooseDialog->show();
-        p_this->chooseDialog->setFocus();
-        p_this->connect(p_this->chooseDialog,&interactiveDialog::FORCESIG,p_this,[=]()
-        {
-            g_drive_eject_with_operation(source_object,
-                                         G_MOUNT_UNMOUNT_FORCE,
-                                         NULL,
-                                         NULL,
-                                         GAsyncReadyCallback(frobnitz_force_result_func),
-                                         p_this
-                                         );
-            p_this->chooseDialog->close();
-        });
-    }
-}
+#include "ejectengine.h"
 
 void frobnitz_force_result_tele(GVolume *source_object,GAsyncResult *res,QClickWidget *p_this)
 {
@@ -113,38 +40,13 @@ void frobnitz_force_result_tele(GVolume *source_object,GAsyncResult *res,QClickW
 }
 
 QClickWidget::QClickWidget(QWidget *parent,
-                           int num,
                            GDrive *Drive,
                            GVolume *Volume,
                            QString driveName,
-                           QString nameDis1,
-                           QString nameDis2,
-                           QString nameDis3,
-                           QString nameDis4,
-                           qlonglong capacityDis1,
-                           qlonglong capacityDis2,
-                           qlonglong capacityDis3,
-                           qlonglong capacityDis4,
-                           QString pathDis1,
-                           QString pathDis2,
-                           QString pathDis3,
-                           QString pathDis4)
+                           const QList<DeviceModel::Partition> &partitions)
     : QWidget(parent),
-      m_Num(num),
       m_Drive(Drive),
-      m_driveName(driveName),
-      m_nameDis1(nameDis1),
-      m_nameDis2(nameDis2),
-      m_nameDis3(nameDis3),
-      m_nameDis4(nameDis4),
-      m_capacityDis1(capacityDis1),
-      m_capacityDis2(capacityDis2),
-      m_capacityDis3(capacityDis3),
-      m_capacityDis4(capacityDis4),
-      m_pathDis1(pathDis1),
-      m_pathDis2(pathDis2),
-      m_pathDis3(pathDis3),
-      m_pathDis4(pathDis4)
+      m_driveName(driveName)
 
 {
 //union layout
@@ -204,16 +106,14 @@ QClickWidget::QClickWidget(QWidget *parent,
 
     connect(m_eject_button,SIGNAL(clicked()),SLOT(switchWidgetClicked()));  // this signal-slot function is to emit a signal which
                                                                             //is to trigger a slot in mainwindow
+    connect(EjectEngine::instance(),&EjectEngine::progress,this,&QClickWidget::onEjectProgress);
+    connect(EjectEngine::instance(),&EjectEngine::finished,this,&QClickWidget::onEjectFinished);
+    connect(EjectEngine::instance(),&EjectEngine::failed,this,&QClickWidget::onEjectFailed);
     connect(m_eject_button, &QPushButton::clicked,this,[=]()
     {
         if(Drive != NULL)
         {
-            g_drive_eject_with_operation(Drive,
-                         G_MOUNT_UNMOUNT_NONE,
-                         NULL,
-                         NULL,
-                         GAsyncReadyCallback(frobnitz_result_func),
-                         this);
+            ejectDrive(false);
         }
         else
         {
@@ -226,348 +126,48 @@ QClickWidget::QClickWidget(QWidget *parent,
         }
     });
 
-//when the drive only has one vlolume
-//we set the information and set all details of the U disk in main interface
-    if(m_Num == 1)
-    {
-        disWidgetNumOne = new QWidget(this);
-        QHBoxLayout *onevolume_h_BoxLayout = new QHBoxLayout();
-        m_nameDis1_label = new ClickLabel(disWidgetNumOne);
-        m_nameDis1_label->setFont(QFont("Microsoft YaHei",fontSize));
-        QString VolumeName = getElidedText(m_nameDis1_label->font(), m_nameDis1, 120);
-        m_nameDis1_label->adjustSize();
-        qDebug()<<m_nameDis1_label->width()<<"-----------------------"<<m_nameDis1_label->height();
-        m_nameDis1_label->setText("- "+VolumeName+":");
-        m_capacityDis1_label = new QLabel(disWidgetNumOne);
-
-        QString str_capacityDis1 = size_human(m_capacityDis1);
-//        QString str_capacityDis1Show = getElidedText(m_capacityDis1_label->font(),str_capacityDis1,200);
-        m_capacityDis1_label->setFont(QFont("Microsoft YaHei",fontSize));
-        m_capacityDis1_label->setText("("+str_capacityDis1+")");
-        qDebug()<<"size_human"<<str_capacityDis1;
-        m_capacityDis1_label->setObjectName("capacityLabel");
-        qDebug()<<m_capacityDis1_label->width()<<"++++++++++++++++++++++++"<<m_capacityDis1_label->height();
-        onevolume_h_BoxLayout->setSpacing(0);
-        onevolume_h_BoxLayout->addSpacing(50);
-        onevolume_h_BoxLayout->setMargin(0);   //使得widget上的label得以居中显示
-        onevolume_h_BoxLayout->addWidget(m_nameDis1_label);
-        onevolume_h_BoxLayout->addWidget(m_capacityDis1_label);
-        onevolume_h_BoxLayout->addSpacing(10);
-        onevolume_h_BoxLayout->addStretch();
-
-        disWidgetNumOne->setObjectName("OriginObjectOnly");
-        disWidgetNumOne->setLayout(onevolume_h_BoxLayout);
-        disWidgetNumOne->installEventFilter(this);
-        disWidgetNumOne->setFixedHeight(30);
-        main_V_BoxLayout->addLayout(drivename_H_BoxLayout);
-        if(m_pathDis1 != "")
-        {
-            qDebug() <<"path1"<< m_pathDis1;
-            main_V_BoxLayout->addWidget(disWidgetNumOne);
-        }
-        this->setLayout(main_V_BoxLayout);
-        this->setFixedSize(276,68);
-        qDebug()<<"qlcked over";
-    }
-//when the drive has two volumes
-    if(m_Num == 2)
-    {
-        QHBoxLayout *onevolume_h_BoxLayout = new QHBoxLayout();
-        m_nameDis1_label = new ClickLabel();
-        m_nameDis1_label->setFont(QFont("Microsoft YaHei",fontSize));
-        QString VolumeNameDis1 = getElidedText(m_nameDis1_label->font(), m_nameDis1, 120);
-        m_nameDis1_label->adjustSize();
-        m_nameDis1_label->setText("- "+VolumeNameDis1+":");
-        m_nameDis1_label->installEventFilter(this);
-        m_capacityDis1_label = new QLabel(this);
-        QString str_capacityDis1 = size_human(m_capacityDis1);
-        m_capacityDis1_label->setFont(QFont("Microsoft YaHei",fontSize));
-        m_capacityDis1_label->setText("("+str_capacityDis1+")");
-        m_capacityDis1_label->setObjectName("capacityLabel");
-        onevolume_h_BoxLayout->addSpacing(50);
-        onevolume_h_BoxLayout->setSpacing(0);
-        onevolume_h_BoxLayout->addWidget(m_nameDis1_label);
-        onevolume_h_BoxLayout->setMargin(0);
-        onevolume_h_BoxLayout->addWidget(m_capacityDis1_label);
-        onevolume_h_BoxLayout->addStretch();
-        disWidgetNumOne = new QWidget;
-        disWidgetNumOne->setFixedHeight(30);
-        disWidgetNumOne->setObjectName("OriginObjectOnly");
-        disWidgetNumOne->setLayout(onevolume_h_BoxLayout);
-        disWidgetNumOne->installEventFilter(this);
-
-        QHBoxLayout *twovolume_h_BoxLayout = new QHBoxLayout();
-        m_nameDis2_label = new ClickLabel(this);
-        m_nameDis2_label->setFont(QFont("Microsoft YaHei",fontSize));
-        QString VolumeNameDis2 = getElidedText(m_nameDis2_label->font(), m_nameDis2, 120);
-        m_nameDis2_label->setText("- "+VolumeNameDis2+":");
-        m_nameDis2_label->adjustSize();
-        m_nameDis2_label->installEventFilter(this);
-        m_capacityDis2_label = new QLabel(this);
-        QString str_capacityDis2 = size_human(m_capacityDis2);
-        m_capacityDis2_label->setText("("+str_capacityDis2+")");
-        m_capacityDis2_label->setFont(QFont("Microsoft YaHei",fontSize));
-        m_capacityDis2_label->setObjectName("capacityLabel");
-        twovolume_h_BoxLayout->addSpacing(50);
-        twovolume_h_BoxLayout->setSpacing(0);
-        twovolume_h_BoxLayout->addWidget(m_nameDis2_label);
-        twovolume_h_BoxLayout->setMargin(0);
-        twovolume_h_BoxLayout->addWidget(m_capacityDis2_label);
-        twovolume_h_BoxLayout->addStretch();
-        disWidgetNumTwo = new QWidget;
-        disWidgetNumTwo->setFixedHeight(30);
-        disWidgetNumTwo->setObjectName("OriginObjectOnly");
-        disWidgetNumTwo->setLayout(twovolume_h_BoxLayout);
-        disWidgetNumTwo->installEventFilter(this);
-
-        main_V_BoxLayout->setContentsMargins(0,0,0,0);
-        main_V_BoxLayout->addLayout(drivename_H_BoxLayout);
-        if(m_pathDis1 != "")
-        {
-            main_V_BoxLayout->addWidget(disWidgetNumOne);
-        }
-
-        if(m_pathDis2 != "")
-        {
-            main_V_BoxLayout->addWidget(disWidgetNumTwo);
-        }
-
-        main_V_BoxLayout->addStretch();
-        this->setLayout(main_V_BoxLayout);
-        this->setFixedSize(276,97);
-    }
-//when the drive has three volumes
-    if(m_Num == 3)
+//every volume that has a mount takes a line,we set its name and capacity
+    main_V_BoxLayout->addLayout(drivename_H_BoxLayout);
+    for(const DeviceModel::Partition &partition : partitions)
     {
-        QHBoxLayout *onevolume_h_BoxLayout = new QHBoxLayout();
-        m_nameDis1_label = new ClickLabel(this);
-        m_nameDis1_label->setFont(QFont("Microsoft YaHei",fontSize));
-        QString VolumeNameDis1 = getElidedText(m_nameDis1_label->font(), m_nameDis2, 120);
-        m_nameDis1_label->setText("- "+VolumeNameDis1+":");
-        m_nameDis1_label->adjustSize();
-        m_nameDis1_label->installEventFilter(this);
-        //m_nameDis1_label->setText("- "+m_nameDis1+":");
-        m_capacityDis1_label = new QLabel(this);
-        QString str_capacityDis1 = size_human(m_capacityDis1);
-        m_capacityDis1_label->setFont(QFont("Microsoft YaHei",fontSize));
-        m_capacityDis1_label->setText("("+str_capacityDis1+")");
-        m_capacityDis1_label->setObjectName("capacityLabel");
-        onevolume_h_BoxLayout->addSpacing(50);
-        onevolume_h_BoxLayout->setSpacing(0);
-        onevolume_h_BoxLayout->addWidget(m_nameDis1_label);
-        onevolume_h_BoxLayout->addWidget(m_capacityDis1_label);
-        onevolume_h_BoxLayout->addStretch();
-        onevolume_h_BoxLayout->setMargin(0);
-
-        disWidgetNumOne = new QWidget;
-        disWidgetNumOne->setFixedHeight(30);
-        disWidgetNumOne->setLayout(onevolume_h_BoxLayout);
-        disWidgetNumOne->setObjectName("OriginObjectOnly");
-        disWidgetNumOne->installEventFilter(this);
-
-        QHBoxLayout *twovolume_h_BoxLayout = new QHBoxLayout();
-        m_nameDis2_label = new ClickLabel(this);
-        m_nameDis2_label->setFont(QFont("Microsoft YaHei",fontSize));
-        QString VolumeNameDis2 = getElidedText(m_nameDis2_label->font(), m_nameDis2, 120);
-        m_nameDis2_label->setText("- "+VolumeNameDis2+":");
-        m_nameDis2_label->adjustSize();
-        m_nameDis2_label->installEventFilter(this);
-        m_capacityDis2_label = new QLabel(this);
-        QString str_capacityDis2 = size_human(m_capacityDis2);
-        m_capacityDis2_label->setText("("+str_capacityDis2+")");
-        m_capacityDis2_label->setFont(QFont("Microsoft YaHei",fontSize));
-        m_capacityDis2_label->setObjectName("capacityLabel");
-        twovolume_h_BoxLayout->addSpacing(50);
-        twovolume_h_BoxLayout->setSpacing(0);
-        twovolume_h_BoxLayout->addWidget(m_nameDis2_label);
-        twovolume_h_BoxLayout->addWidget(m_capacityDis2_label);
-        twovolume_h_BoxLayout->addStretch();
-        twovolume_h_BoxLayout->setMargin(0);
-
-        disWidgetNumTwo = new QWidget;
-        disWidgetNumTwo->setFixedHeight(30);
-        disWidgetNumTwo->setObjectName("OriginObjectOnly");
-        disWidgetNumTwo->setLayout(twovolume_h_BoxLayout);
-        disWidgetNumTwo->installEventFilter(this);
-
-        QHBoxLayout *threevolume_h_BoxLayout = new QHBoxLayout();
-        m_nameDis3_label = new ClickLabel(this);
-        m_nameDis3_label->setFont(QFont("Microsoft YaHei",fontSize));
-        QString VolumeNameDis3 = getElidedText(m_nameDis3_label->font(), m_nameDis3, 120);
-        m_nameDis3_label->setText("- "+VolumeNameDis3+":");
-        m_nameDis3_label->adjustSize();
-        m_nameDis3_label->installEventFilter(this);
-        m_capacityDis3_label = new QLabel(this);
-        QString str_capacityDis3 = size_human(m_capacityDis3);
-        m_capacityDis3_label->setText("("+str_capacityDis3+")");
-        m_capacityDis3_label->setFont(QFont("Microsoft YaHei",fontSize));
-        m_capacityDis3_label->setObjectName("capacityLabel");
-        threevolume_h_BoxLayout->addSpacing(50);
-        threevolume_h_BoxLayout->setSpacing(0);
-        threevolume_h_BoxLayout->addWidget(m_nameDis3_label);
-        threevolume_h_BoxLayout->addWidget(m_capacityDis3_label);
-        threevolume_h_BoxLayout->addStretch();
-        threevolume_h_BoxLayout->setMargin(0);
-
-        disWidgetNumThree = new QWidget;
-        disWidgetNumThree->setFixedHeight(30);
-        disWidgetNumThree->setObjectName("OriginObjectOnly");
-        disWidgetNumThree->setLayout(threevolume_h_BoxLayout);
-        disWidgetNumThree->installEventFilter(this);
-
-
-        main_V_BoxLayout->setContentsMargins(0,0,0,0);
-        main_V_BoxLayout->addLayout(drivename_H_BoxLayout);
-        if(m_pathDis1 != "")
-        {
-            main_V_BoxLayout->addWidget(disWidgetNumOne);
-        }
-
-        if(m_pathDis2 != "")
-        {
-            main_V_BoxLayout->addWidget(disWidgetNumTwo);
-        }
-
-        if(m_pathDis3 != "")
-        {
-            main_V_BoxLayout->addWidget(disWidgetNumThree);
-        }
-
-        this->setLayout(main_V_BoxLayout);
-        this->setFixedSize(276,136);
+        if(partition.uri.isEmpty())
+            continue;
+
+        QWidget *volumeWidget = new QWidget(this);
+        QHBoxLayout *volume_h_BoxLayout = new QHBoxLayout();
+        ClickLabel *nameLabel = new ClickLabel(volumeWidget);
+        nameLabel->setFont(QFont("Microsoft YaHei",fontSize));
+        QString VolumeName = getElidedText(nameLabel->font(), partition.name, 120);
+        nameLabel->setText("- "+VolumeName+":");
+        nameLabel->adjustSize();
+        QLabel *capacityLabel = new QLabel(volumeWidget);
+        capacityLabel->setFont(QFont("Microsoft YaHei",fontSize));
+        capacityLabel->setText(capacityText(partition));
+        capacityLabel->setObjectName("capacityLabel");
+        volume_h_BoxLayout->addSpacing(50);
+        volume_h_BoxLayout->setSpacing(0);
+        volume_h_BoxLayout->setMargin(0);   //使得widget上的label得以居中显示
+        volume_h_BoxLayout->addWidget(nameLabel);
+        volume_h_BoxLayout->addWidget(capacityLabel);
+        volume_h_BoxLayout->addStretch();
+
+        volumeWidget->setFixedHeight(30);
+        volumeWidget->setObjectName("OriginObjectOnly");
+        volumeWidget->setLayout(volume_h_BoxLayout);
+        volumeWidget->installEventFilter(this);
+        main_V_BoxLayout->addWidget(volumeWidget);
+
+        m_partitions << partition;
+        m_volumeWidgets << volumeWidget;
+        m_capacityLabels << capacityLabel;
     }
-//when the drive has four volumes
-    if(m_Num == 4)
-    {
-        QHBoxLayout *onevolume_h_BoxLayout = new QHBoxLayout();
-        m_nameDis1_label = new ClickLabel(this);
-        m_nameDis1_label->setFont(QFont("Microsoft YaHei",fontSize));
-        QString VolumeNameDis1 = getElidedText(m_nameDis1_label->font(), m_nameDis1, 120);
-        m_nameDis1_label->setText("- "+VolumeNameDis1+":");
-        m_nameDis1_label->adjustSize();
-        m_nameDis1_label->installEventFilter(this);
-        //m_nameDis1_label->setText("- "+m_nameDis1+":");
-        m_capacityDis1_label = new QLabel(this);
-        QString str_capacityDis1 = size_human(m_capacityDis1);
-        m_capacityDis1_label->setText("("+str_capacityDis1+")");
-        m_capacityDis1_label->setFont(QFont("Microsoft YaHei",fontSize));
-        m_capacityDis1_label->setObjectName("capacityLabel");
-        onevolume_h_BoxLayout->addSpacing(50);
-        onevolume_h_BoxLayout->setSpacing(0);
-        onevolume_h_BoxLayout->addWidget(m_nameDis1_label);
-        onevolume_h_BoxLayout->addWidget(m_capacityDis1_label);
-        onevolume_h_BoxLayout->addStretch();
-        onevolume_h_BoxLayout->setMargin(0);
-
-        disWidgetNumOne = new QWidget;
-        disWidgetNumOne->setFixedHeight(30);
-        disWidgetNumOne->setObjectName("OriginObjectOnly");
-        disWidgetNumOne->setLayout(onevolume_h_BoxLayout);
-        disWidgetNumOne->installEventFilter(this);
-
-        QHBoxLayout *twovolume_h_BoxLayout = new QHBoxLayout();
-        m_nameDis2_label = new ClickLabel(this);
-        m_nameDis2_label->setFont(QFont("Microsoft YaHei",fontSize));
-        QString VolumeNameDis2 = getElidedText(m_nameDis2_label->font(), m_nameDis2, 120);
-        m_nameDis2_label->setText("- "+VolumeNameDis2+":");
-        m_nameDis2_label->installEventFilter(this);
-        m_nameDis2_label->adjustSize();
-        m_nameDis2_label->installEventFilter(this);
-        //m_nameDis2_label->setText("- "+m_nameDis2+":");
-        m_capacityDis2_label = new QLabel(this);
-        QString str_capacityDis2 = size_human(m_capacityDis2);
-        m_capacityDis2_label->setText("("+str_capacityDis2+")");
-        m_capacityDis2_label->setFont(QFont("Microsoft YaHei",fontSize));
-        m_capacityDis2_label->setObjectName("capacityLabel");
-        twovolume_h_BoxLayout->addSpacing(50);
-        twovolume_h_BoxLayout->setSpacing(0);
-        twovolume_h_BoxLayout->addWidget(m_nameDis2_label);
-        twovolume_h_BoxLayout->addWidget(m_capacityDis2_label);
-        twovolume_h_BoxLayout->addStretch();
-        twovolume_h_BoxLayout->setMargin(0);
-
-        disWidgetNumTwo = new QWidget;
-        disWidgetNumTwo->setFixedHeight(30);
-        disWidgetNumTwo->setObjectName("OriginObjectOnly");
-        disWidgetNumTwo->setLayout(twovolume_h_BoxLayout);
-        disWidgetNumTwo->installEventFilter(this);
-
-        QHBoxLayout *threevolume_h_BoxLayout = new QHBoxLayout();
-        m_nameDis3_label = new ClickLabel(this);
-        m_nameDis3_label->setFont(QFont("Microsoft YaHei",fontSize));
-        QString VolumeNameDis3 = getElidedText(m_nameDis3_label->font(), m_nameDis3, 120);
-        m_nameDis3_label->setText("- "+VolumeNameDis3+":");
-        m_nameDis3_label->installEventFilter(this);
-        m_capacityDis3_label = new QLabel(this);
-        QString str_capacityDis3 = size_human(m_capacityDis3);
-        m_capacityDis3_label->setText("("+str_capacityDis3+")");
-        m_capacityDis3_label->setFont(QFont("Microsoft YaHei",fontSize));
-        m_capacityDis3_label->setObjectName("capacityLabel");
-        threevolume_h_BoxLayout->addSpacing(50);
-        threevolume_h_BoxLayout->setSpacing(0);
-        threevolume_h_BoxLayout->addWidget(m_nameDis3_label);
-        threevolume_h_BoxLayout->addWidget(m_capacityDis3_label);
-        threevolume_h_BoxLayout->addStretch(0);
-        threevolume_h_BoxLayout->setMargin(0);
-
-        disWidgetNumThree = new QWidget;
-        disWidgetNumThree->setFixedHeight(30);
-        disWidgetNumThree->setObjectName("OriginObjectOnly");
-        disWidgetNumThree->setLayout(threevolume_h_BoxLayout);
-        disWidgetNumThree->installEventFilter(this);
-
-        QHBoxLayout *fourvolume_h_BoxLayout = new QHBoxLayout();
-        m_nameDis4_label = new ClickLabel(this);
-        m_nameDis4_label->setFont(QFont("Microsoft YaHei",fontSize));
-        QString VolumeNameDis4 = getElidedText(m_nameDis4_label->font(), m_nameDis4, 120);
-        m_nameDis4_label->setText("- "+VolumeNameDis4+":");
-        m_nameDis4_label->adjustSize();
-        m_nameDis4_label->installEventFilter(this);
-        //m_nameDis4_label->setText("- "+m_nameDis4+":");
-        m_capacityDis4_label = new QLabel(this);
-        QString str_capacityDis4 = size_human(m_capacityDis4);
-        m_capacityDis4_label->setText("("+str_capacityDis4+")");
-        m_capacityDis4_label->setFont(QFont("Microsoft YaHei",fontSize));
-        m_capacityDis4_label->setObjectName("capacityLabel");
-        fourvolume_h_BoxLayout->addSpacing(50);
-        fourvolume_h_BoxLayout->setSpacing(0);
-        fourvolume_h_BoxLayout->addWidget(m_nameDis4_label);
-        fourvolume_h_BoxLayout->addWidget(m_capacityDis4_label);
-        fourvolume_h_BoxLayout->addStretch();
-        fourvolume_h_BoxLayout->setMargin(0);
-
-        disWidgetNumFour = new QWidget;
-        disWidgetNumFour->setFixedHeight(30);
-        disWidgetNumFour->setObjectName("OriginObjectOnly");
-        disWidgetNumFour->setLayout(fourvolume_h_BoxLayout);
-        disWidgetNumFour->installEventFilter(this);
-
-        main_V_BoxLayout->setContentsMargins(0,0,0,0);
-        main_V_BoxLayout->addLayout(drivename_H_BoxLayout);
-        if(m_pathDis1 != "")
-        {
-            main_V_BoxLayout->addWidget(disWidgetNumOne);
-        }
-
-        if(m_pathDis2 != "")
-        {
-            main_V_BoxLayout->addWidget(disWidgetNumTwo);
-        }
-
-        if(m_pathDis3 != "")
-        {
-            main_V_BoxLayout->addWidget(disWidgetNumThree);
-        }
+    main_V_BoxLayout->addStretch();
+    this->setLayout(main_V_BoxLayout);
+    this->setFixedSize(276,38 + 30 * qMax(1,m_partitions.size()));
 
-        if(m_pathDis4 != "")
-        {
-            main_V_BoxLayout->addWidget(disWidgetNumFour);
-        }
-
-        this->setLayout(main_V_BoxLayout);
-        this->setFixedSize(276,165);
-    }
-    qDebug()<<"4444";
+    //容量在后台采样，结果回来后只更新对应的标签
+    connect(CapacitySampler::instance(),&CapacitySampler::sampled,this,&QClickWidget::onCapacitySampled);
+    connect(CapacitySampler::instance(),&CapacitySampler::timedOut,this,&QClickWidget::onCapacityTimedOut);
     this->setAttribute(Qt::WA_TranslucentBackground, true);
     qDebug()<<"qlcked overeend";
 }
@@ -600,8 +200,96 @@ void QClickWidget::initThemeMode()
     }
 }
 
+//通过 UDisks2 异步卸载并弹出整个驱动器，界面不会卡住
+void QClickWidget::ejectDrive(bool force)
+{
+    if(m_device.isEmpty())
+    {
+        char *devPath = g_drive_get_identifier(m_Drive,G_DRIVE_IDENTIFIER_KIND_UNIX_DEVICE);
+        m_device = QString(devPath);
+        g_free(devPath);
+    }
+    if(m_device.isEmpty())
+    {
+        //没有设备文件就无法交给 UDisks2，直接提示失败
+        qWarning()<<"eject"<<m_driveName<<"failed: no unix device";
+        m_eject = new ejectInterface(this,m_driveName,EJECTFAILED);
+        m_eject->show();
+        return;
+    }
+    //面板重建列表时，之前的弹出可能还在进行
+    if(EjectEngine::instance()->isBusy(m_device))
+        return;
+    if(EjectEngine::instance()->eject(m_device,force))
+        m_eject_button->setEnabled(false);
+}
+
+void QClickWidget::onEjectProgress(const QString &device, EjectEngine::Stage stage, int done, int total)
+{
+    if(device != m_device)
+        return;
+    m_eject_button->setEnabled(false);
+    switch(stage)
+    {
+    case EjectEngine::Resolving:
+        m_eject_button->setToolTip(tr("弹出"));
+        break;
+    case EjectEngine::Unmounting:
+        m_eject_button->setToolTip(tr("unmounting %1/%2").arg(done + 1).arg(total));
+        break;
+    case EjectEngine::Ejecting:
+    case EjectEngine::PoweringOff:
+        m_eject_button->setToolTip(tr("ejecting"));
+        break;
+    }
+}
+
+void QClickWidget::onEjectFinished(const QString &device)
+{
+    if(device != m_device)
+        return;
+    m_eject_button->setEnabled(true);
+    m_eject_button->setToolTip(tr("弹出"));
+    findGDriveList()->removeOne(m_Drive);
+    char *name = g_drive_get_name(m_Drive);
+    m_eject = new ejectInterface(this,name,NORMALDEVICE);
+    g_free(name);
+    m_eject->show();
+}
+
+void QClickWidget::onEjectFailed(const QString &device, const QString &error, bool busy, const QStringList &busyProcesses)
+{
+    if(device != m_device)
+        return;
+    m_eject_button->setEnabled(true);
+    m_eject_button->setToolTip(tr("弹出"));
+    qWarning()<<"eject"<<device<<"failed:"<<error<<busyProcesses;
+
+    //只有设备忙才值得强制卸载，其他错误(取消授权、设备不存在等)直接提示
+    if(!busy)
+    {
+        m_eject = new ejectInterface(this,error,EJECTFAILED);
+        m_eject->show();
+        return;
+    }
+
+    if(chooseDialog == nullptr)
+    {
+        chooseDialog = new interactiveDialog(this);
+        connect(chooseDialog,&interactiveDialog::FORCESIG,this,[=]()
+        {
+            ejectDrive(true);
+            chooseDialog->close();
+        });
+    }
+    chooseDialog->setBusyProcesses(busyProcesses);
+    chooseDialog->show();
+    chooseDialog->setFocus();
+}
+
 QClickWidget::~QClickWidget()
 {
+    stopSampling();
     if(chooseDialog)
         delete chooseDialog;
     if(gpartedface)
@@ -610,8 +298,8 @@ QClickWidget::~QClickWidget()
 
 void QClickWidget::mouseClicked()
 {
-    QProcess::startDetached("peony "+m_pathDis1);
-    this->topLevelWidget()->hide();
+    if(!m_partitions.isEmpty())
+        openVolume(0);
 }
 
 
@@ -625,34 +313,78 @@ void QClickWidget::mouseReleaseEvent(QMouseEvent *ev)
     if(mousePos == QPoint(ev->x(), ev->y())) Q_EMIT clicked();
 }
 
-//click the first area to show the interface
-void QClickWidget::on_volume1_clicked()
+//click the area of a volume to show it in the file manager
+void QClickWidget::openVolume(int index)
 {
-    QString aaa = "peony "+m_pathDis1;
-    QProcess::startDetached(aaa.toUtf8().data());
+    QProcess::startDetached("peony",QStringList()<<m_partitions.at(index).uri);
     this->topLevelWidget()->hide();
 }
 
-//click the second area to show the interface
-void QClickWidget::on_volume2_clicked()
+//the used and total size of a volume,sampled in the background
+QString QClickWidget::capacityText(const DeviceModel::Partition &partition)
 {
-    QString aaa = "peony "+m_pathDis2;
-    QProcess::startDetached(aaa.toUtf8().data());
-    this->topLevelWidget()->hide();
+    CapacitySampler::Usage usage = CapacitySampler::instance()->usage(partition.path);
+    if(usage.valid && usage.total > 0)
+    {
+        QString used = usage.used() > 0 ? size_human(usage.used()).trimmed() : QString("0");
+        return "("+used+"/"+size_human(usage.total).trimmed()+")";
+    }
+    //采样结果还没回来
+    if(partition.capacity == 0 && !partition.path.isEmpty())
+        return QString();
+    return "("+size_human(partition.capacity)+")";
 }
 
-//click the third area to show the interface
-void QClickWidget::on_volume3_clicked()
+void QClickWidget::onCapacitySampled(const QString &path, const CapacitySampler::Usage &usage)
 {
-    QProcess::startDetached("peony "+m_pathDis3);
-    this->topLevelWidget()->hide();
+    Q_UNUSED(usage)
+    for(int i = 0; i < m_partitions.size(); i++)
+    {
+        if(m_partitions.at(i).path == path)
+        {
+            m_capacityLabels.at(i)->setToolTip(QString());
+            m_capacityLabels.at(i)->setText(capacityText(m_partitions.at(i)));
+        }
+    }
 }
 
-//click the forth area to show the interface
-void QClickWidget::on_volume4_clicked()
+//挂载点没有响应，有旧结果就继续显示，没有就提示一下
+void QClickWidget::onCapacityTimedOut(const QString &path)
 {
-    QProcess::startDetached("peony "+m_pathDis4);
-    this->topLevelWidget()->hide();
+    for(int i = 0; i < m_partitions.size(); i++)
+    {
+        if(m_partitions.at(i).path != path)
+            continue;
+        m_capacityLabels.at(i)->setToolTip(tr("not responding"));
+        if(!CapacitySampler::instance()->usage(path).valid)
+            m_capacityLabels.at(i)->setText("("+tr("not responding")+")");
+    }
+}
+
+//弹窗显示期间定时刷新容量，隐藏后就停下
+void QClickWidget::showEvent(QShowEvent *event)
+{
+    QWidget::showEvent(event);
+    if(m_sampling)
+        return;
+    m_sampling = true;
+    for(const DeviceModel::Partition &partition : m_partitions)
+        CapacitySampler::instance()->subscribe(partition.path);
+}
+
+void QClickWidget::hideEvent(QHideEvent *event)
+{
+    QWidget::hideEvent(event);
+    stopSampling();
+}
+
+void QClickWidget::stopSampling()
+{
+    if(!m_sampling)
+        return;
+    m_sampling = false;
+    for(const DeviceModel::Partition &partition : m_partitions)
+        CapacitySampler::instance()->unsubscribe(partition.path);
 }
 
 void QClickWidget::switchWidgetClicked()
@@ -861,112 +593,32 @@ bool QClickWidget::eventFilter(QObject *obj, QEvent *event)
         }
     }
 
-    if(obj == disWidgetNumOne)
-    {
-       if(event->type() == QEvent::Enter)
-       {
-           if(currentThemeMode == "ukui-dark" || currentThemeMode == "ukui-black" || currentThemeMode == "ukui-default")
-           {
-               disWidgetNumOne->setStyleSheet(
-                           "QWidget#OriginObjectOnly{background:rgba(255,255,255,0.12);}");
-           }
-           else
-           {
-               disWidgetNumOne->setStyleSheet(
-                           "QWidget#OriginObjectOnly{background:rgba(0,0,0,0.12);}");
-           }
-       }
-
-       if(event->type() == QEvent::Leave)
-       {
-           disWidgetNumOne->setStyleSheet("");
-
-       }
-
-       if(event->type() == QEvent::MouseButtonPress)
-       {
-           on_volume1_clicked();
-       }
-    }
-
-    if(obj == disWidgetNumTwo)
+    int index = m_volumeWidgets.indexOf(qobject_cast<QWidget *>(obj));
+    if(index >= 0)
     {
-        if(event->type() == QEvent::Enter )
-        {
-            if(currentThemeMode == "ukui-dark" || currentThemeMode == "ukui-black" || currentThemeMode == "ukui-default")
-            {
-                disWidgetNumTwo->setStyleSheet(
-                            "QWidget#OriginObjectOnly{background:rgba(255,255,255,0.12);}");
-            }
-            else
-            {
-                disWidgetNumTwo->setStyleSheet(
-                            "QWidget#OriginObjectOnly{background:rgba(0,0,0,0.12);}");
-            }
-        }
-
-        if(event->type() == QEvent::Leave)
-        {
-            disWidgetNumTwo->setStyleSheet("");
-        }
-
-        if(event->type() == QEvent::MouseButtonPress)
-        {
-            on_volume2_clicked();
-        }
-    }
-
-    if(obj == disWidgetNumThree)
-    {
-        if(event->type() == QEvent::Enter )
-        {
-            if(currentThemeMode == "ukui-dark" || currentThemeMode == "ukui-black" || currentThemeMode == "ukui-default")
-            {
-                disWidgetNumThree->setStyleSheet(
-                            "QWidget#OriginObjectOnly{background:rgba(255,255,255,0.12);}");
-            }
-            else
-            {
-                disWidgetNumThree->setStyleSheet(
-                            "QWidget#OriginObjectOnly{background:rgba(0,0,0,0.12);}");
-            }
-        }
-
-        if(event->type() == QEvent::Leave)
-        {
-            disWidgetNumThree->setStyleSheet("");
-        }
-
-        if(event->type() == QEvent::MouseButtonPress)
-        {
-            on_volume3_clicked();
-        }
-    }
-
-    if(obj == disWidgetNumFour)
-    {
-        if(event->type() == QEvent::Enter )
+        QWidget *volumeWidget = m_volumeWidgets.at(index);
+        if(event->type() == QEvent::Enter)
         {
             if(currentThemeMode == "ukui-dark" || currentThemeMode == "ukui-black" || currentThemeMode == "ukui-default")
             {
-                disWidgetNumFour->setStyleSheet(
+                volumeWidget->setStyleSheet(
                             "QWidget#OriginObjectOnly{background:rgba(255,255,255,0.12);}");
             }
             else
             {
-                disWidgetNumFour->setStyleSheet(
+                volumeWidget->setStyleSheet(
                             "QWidget#OriginObjectOnly{background:rgba(0,0,0,0.12);}");
             }
         }
 
         if(event->type() == QEvent::Leave)
         {
-            disWidgetNumFour->setStyleSheet("");
+            volumeWidget->setStyleSheet("");
         }
 
         if(event->type() == QEvent::MouseButtonPress)
         {
-            on_volume4_clicked();
+            openVolume(index);
         }
     }
 
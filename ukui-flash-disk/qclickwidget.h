@@ -37,28 +37,19 @@
 #include "UnionVariable.h"
 #include "interactivedialog.h"
 #include "gpartedinterface.h"
+#include "devicemodel.h"
+#include "capacitysampler.h"
+#include "ejectengine.h"
 class MainWindow;
 class QClickWidget : public QWidget
 {
     Q_OBJECT
 public:
     explicit QClickWidget(QWidget *parent = nullptr,
-                          int num = 0,
                           GDrive *Drive=NULL,
                           GVolume *Volume=NULL,
                           QString driveName=NULL,
-                          QString nameDis1=NULL,
-                          QString nameDis2 =NULL,
-                          QString nameDis3 = NULL,
-                          QString nameDis4 = NULL,
-                          qlonglong capacityDis1=NULL,
-                          qlonglong capacityDis2=NULL,
-                          qlonglong capacityDis3=NULL,
-                          qlonglong capacityDis4=NULL,
-                          QString pathDis1=NULL,
-                          QString pathDis2=NULL,
-                          QString pathDis3=NULL,
-                          QString pathDis4=NULL);
+                          const QList<DeviceModel::Partition> &partitions = QList<DeviceModel::Partition>());
     ~QClickWidget();
 public Q_SLOTS:
     void mouseClicked();
@@ -71,36 +62,17 @@ protected:
 private:
     QIcon imgIcon;
     QString m_driveName;
-    QString m_nameDis1;
-    QString m_nameDis2;
-    QString m_nameDis3;
-    QString m_nameDis4;
-    qlonglong m_capacityDis1;
-    qlonglong m_capacityDis2;
-    qlonglong m_capacityDis3;
-    qlonglong m_capacityDis4;
-    QString m_pathDis1;
-    QString m_pathDis2;
-    QString m_pathDis3;
-    QString m_pathDis4;
+    QList<DeviceModel::Partition> m_partitions;
     MainWindow *m_mainwindow;
     QPoint mousePos;
-    int m_Num;
     GDrive *m_Drive;
+    QString m_device;
     QLabel *image_show_label;
     QLabel *m_driveName_label;
-    ClickLabel *m_nameDis1_label;
-    ClickLabel *m_nameDis2_label;
-    ClickLabel *m_nameDis3_label;
-    ClickLabel *m_nameDis4_label;
-    QLabel *m_capacityDis1_label;
-    QLabel *m_capacityDis2_label;
-    QLabel *m_capacityDis3_label;
-    QLabel *m_capacityDis4_label;
-    QWidget *disWidgetNumOne;
-    QWidget *disWidgetNumTwo;
-    QWidget *disWidgetNumThree;
-    QWidget *disWidgetNumFour;
+    //和 m_partitions 一一对应
+    QList<QWidget *> m_volumeWidgets;
+    QList<QLabel *> m_capacityLabels;
+    bool m_sampling = false;
 
     QGSettings *fontSettings = nullptr;
     QGSettings *qtSettings = nullptr;
@@ -113,25 +85,30 @@ public:
     ejectInterface *m_eject = nullptr;
     interactiveDialog *chooseDialog = nullptr;
     gpartedInterface *gpartedface = nullptr;
-    bool ifSucess;
-    int flagType;
 Q_SIGNALS:
     void clicked();
     void clickedConvert();
     void noDeviceSig();
 
 private Q_SLOTS:
-    void on_volume1_clicked();
-    void on_volume2_clicked();
-    void on_volume3_clicked();
-    void on_volume4_clicked();
     void switchWidgetClicked();
+    void onCapacitySampled(const QString &path, const CapacitySampler::Usage &usage);
+    void onCapacityTimedOut(const QString &path);
+    void onEjectFinished(const QString &device);
+    void onEjectProgress(const QString &device, EjectEngine::Stage stage, int done, int total);
+    void onEjectFailed(const QString &device, const QString &error, bool busy, const QStringList &busyProcesses);
 private:
+    void ejectDrive(bool force);
+    void openVolume(int index);
+    void stopSampling();
+    QString capacityText(const DeviceModel::Partition &partition);
     QString size_human(qlonglong capacity);
     QPixmap drawSymbolicColoredPixmap(const QPixmap &source);
 protected:
     bool eventFilter(QObject *obj, QEvent *event);
     void resizeEvent(QResizeEvent *event);
+    void showEvent(QShowEvent *event);
+    void hideEvent(QHideEvent *event);
 public:
     void initFontSize();
     void initThemeMode();